@@ -0,0 +1,16 @@
+/*
+ * cmd.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Milos Lazic
+ */
+
+#ifndef CMD_CMD_H_
+#define CMD_CMD_H_
+
+#include "cmd_defs.h"
+#include "cmd_proto.h"
+
+
+
+#endif /* CMD_CMD_H_ */
@@ -0,0 +1,206 @@
+/*
+ * cmd_defs.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Milos Lazic
+ *
+ *  Serial command channel (UART0) frame format:
+ *
+ *      SOF | LEN | ID | PAYLOAD (LEN-1 bytes) | CRC
+ *
+ *      SOF     - CMD_FRAME_SOF
+ *      LEN     - number of bytes in ID and PAYLOAD
+ *      ID      - command identifier (CMD_id_type)
+ *      PAYLOAD - little-endian arguments; floats are IEEE-754 single
+ *      CRC     - CRC-8 (polynomial 0x07, initial value 0) over LEN, ID
+ *                and PAYLOAD
+ *
+ *  Replies (eCMD_ID_STATS, eCMD_ID_BBOX, eCMD_ID_SCOPE) use the same format. Outside a frame the
+ *  legacy keys 'a' and 'd' step the set point by +/- CMD_SP_STEP. Set points are targets of the
+ *  trajectory generator (traj_defs.h); the balance reference moves to them within its limits.
+ */
+
+#ifndef CMD_CMD_DEFS_H_
+#define CMD_CMD_DEFS_H_
+
+
+#include <stdlib.h>
+#include <stdint.h>
+#include "../log/log_defs.h"
+#include "../exc/exc_defs.h"
+#include "../traj/traj_defs.h"
+#include "../lqr/lqr_defs.h"
+
+
+#define CMD_FRAME_SOF    0xA5
+#define CMD_MAX_LEN      40      /* largest LEN accepted; eCMD_ID_SET_GAINS of up to 8 states */
+#define CMD_BBOX_CHUNK   240     /* image bytes per eCMD_ID_BBOX/eCMD_ID_SCOPE frame */
+#define CMD_TX_MAX_LEN   (1 + 4 + CMD_BBOX_CHUNK)  /* largest LEN sent */
+#define CMD_NUM_GAINS    LQR_MAX_STATE  /* LQR state feedback gains carried by eCMD_ID_SET_GAINS */
+
+#define CMD_QUEUE_LEN    8       /* command queue depth; power of two */
+#define CMD_DRAIN_MAX    2       /* commands applied per control period */
+
+#define CMD_SP_LIMIT     0.25f   /* largest set point magnitude accepted (m) */
+#define CMD_SP_STEP      0.15f   /* set point step of the legacy 'a'/'d' keys (m) */
+
+#define CMD_BB_DUMP      0       /* eCMD_ID_BB_CTRL: freeze (if recording) and dump */
+#define CMD_BB_REARM     1       /* eCMD_ID_BB_CTRL: discard the image, record again */
+
+#define CMD_ILC_START    0       /* eCMD_ID_ILC: start a learning trial */
+#define CMD_ILC_STOP     1       /* eCMD_ID_ILC: abandon the running trial */
+#define CMD_ILC_RESET    2       /* eCMD_ID_ILC: discard the learned correction */
+
+
+/* Name: CMD_id_type
+ *
+ * Description: command identifiers and payloads
+ *
+ * Members: eCMD_ID_SET_SETPOINT - float set point (m)
+ *          eCMD_ID_SET_GAINS    - CMD_NUM_GAINS float gains, float Nbar
+ *          eCMD_ID_SET_CTRL     - uint8 balance controller (fsm_ctrl_t)
+ *          eCMD_ID_GET_STATS    - no payload; replied to with
+ *                                 eCMD_ID_STATS
+ *          eCMD_ID_BB_CTRL      - uint8 black box operation (CMD_BB_DUMP,
+ *                                 CMD_BB_REARM)
+ *          eCMD_ID_SCOPE_ARM    - scope capture request (LOG_sc_cfg_type):
+ *                                 uint8 channel mask (0 stops), uint8
+ *                                 trigger source, uint8 trigger channel,
+ *                                 uint8 edge/command ID, int16 level,
+ *                                 uint16 pre-trigger samples, uint16
+ *                                 decimation
+ *          eCMD_ID_EXCITE       - excitation request (EXC_cfg_type): uint8
+ *                                 signal, uint8 amplitude (%), uint16 p1,
+ *                                 uint16 p2, uint32 length (control
+ *                                 periods; 0 cancels)
+ *          eCMD_ID_TRAJ_LIMITS  - trajectory limits (TRAJ_lim_type): float
+ *                                 velocity (m/s), float acceleration
+ *                                 (m/s^2), float jerk (m/s^3)
+ *          eCMD_ID_ILC          - learning control (ilc_defs.h): uint8
+ *                                 operation (CMD_ILC_START, CMD_ILC_STOP,
+ *                                 CMD_ILC_RESET), uint16 trial length
+ *                                 (samples; CMD_ILC_START only)
+ *          eCMD_ID_STATS        - reply: uint8 FSM state, uint8 balance
+ *                                 controller, uint32 frames received,
+ *                                 uint32 frames rejected, uint32 commands
+ *                                 dropped (queue full), uint32 collision
+ *                                 warnings, float set point, uint64
+ *                                 timestamp (us, SYSTIME_ToUs) of the
+ *                                 control period that took the snapshot,
+ *                                 uint32 control periods run by the
+ *                                 event-triggered LQR, uint32 of which
+ *                                 recomputed the output, uint32 learning
+ *                                 trials completed, float RMS position
+ *                                 error of the latest trial (m), uint32
+ *                                 eCMD_ID_ILC operations refused
+ *          eCMD_ID_BBOX         - black box dump: uint32 image offset, up
+ *                                 to CMD_BBOX_CHUNK image bytes (log_defs.h);
+ *                                 sent unsolicited after a fault or on
+ *                                 CMD_BB_DUMP, in order, ending with the
+ *                                 last byte of the image
+ *          eCMD_ID_SCOPE        - scope capture, as eCMD_ID_BBOX; sent
+ *                                 unsolicited once the capture completes
+ *          eCMD_ID_STEP_SETPOINT - internal; generated by the legacy keys,
+ *                                 float set point step (m)
+ *
+ * Notes:
+ *
+ */
+typedef enum
+{
+	eCMD_ID_SET_SETPOINT = 0x01,
+	eCMD_ID_SET_GAINS = 0x02,
+	eCMD_ID_SET_CTRL = 0x03,
+	eCMD_ID_GET_STATS = 0x04,
+	eCMD_ID_BB_CTRL = 0x05,
+	eCMD_ID_SCOPE_ARM = 0x06,
+	eCMD_ID_EXCITE = 0x07,
+	eCMD_ID_TRAJ_LIMITS = 0x08,
+	eCMD_ID_ILC = 0x09,
+	eCMD_ID_STATS = 0x84,
+	eCMD_ID_BBOX = 0x85,
+	eCMD_ID_SCOPE = 0x86,
+	eCMD_ID_STEP_SETPOINT = 0xF0,
+} CMD_id_type;
+
+
+/* Name: CMD_type
+ *
+ * Description: parsed and validated command, as queued between the UART
+ *              receive interrupt and the control period
+ *
+ * Members: id  - command identifier
+ *          arg - command arguments (member selected by id)
+ *
+ * Notes:
+ *
+ */
+struct CMD_type
+{
+	uint8_t id;
+	union
+	{
+		float sp;
+		struct
+		{
+			float K[CMD_NUM_GAINS];
+			float Nbar;
+		} gains;
+		uint8_t ctrl;
+		uint8_t bb_op;
+		struct LOG_sc_cfg_type scope;
+		struct EXC_cfg_type exc;
+		struct TRAJ_lim_type traj;
+		struct
+		{
+			uint8_t op;
+			uint16_t len;
+		} ilc;
+	} arg;
+};
+
+
+/* Name: CMD_queue_type
+ *
+ * Description: single-producer single-consumer command queue
+ *
+ * Members: slot - command storage
+ *          head - index of the next slot to write; written only by the
+ *                 producer (UART receive interrupt)
+ *          tail - index of the next slot to read; written only by the
+ *                 consumer (control period)
+ *
+ * Notes: head and tail run freely and are reduced modulo CMD_QUEUE_LEN;
+ *        the queue is full when head - tail == CMD_QUEUE_LEN. A slot is
+ *        filled before head is advanced past it, and released only after
+ *        it has been copied out, so neither side ever waits or locks.
+ *
+ */
+struct CMD_queue_type
+{
+	volatile struct CMD_type slot[CMD_QUEUE_LEN];
+	volatile uint32_t head;
+	volatile uint32_t tail;
+};
+
+
+/* Name: CMD_stats_type
+ *
+ * Description: command channel statistics
+ *
+ * Members: rx_frames  - frames received with a valid CRC
+ *          rx_errors  - frames rejected (CRC, length or argument check)
+ *          q_drops    - valid commands dropped because the queue was full
+ *
+ * Notes: written by the UART receive interrupt only
+ *
+ */
+struct CMD_stats_type
+{
+	volatile uint32_t rx_frames;
+	volatile uint32_t rx_errors;
+	volatile uint32_t q_drops;
+};
+
+
+#endif /* CMD_CMD_DEFS_H_ */
@@ -0,0 +1,675 @@
+/*
+ * cmd_proc.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Milos Lazic
+ *
+ *  Serial command channel: frame parser (UART receive interrupt), command
+ *  execution (control period; new gains in the background) and statistics
+ *  reply (background).
+ */
+
+#include <string.h>
+#include "cmd_defs.h"
+#include "cmd_proto.h"
+#include "../fsm/fsm.h"
+#include "../lqr/lqr.h"
+#include "../log/log.h"
+#include "../exc/exc.h"
+#include "../traj/traj.h"
+#include "../ilc/ilc.h"
+#include "../sys/systime/systime.h"
+
+
+#define CMD_FLOAT_MAX 1.0e6f     /* largest argument magnitude accepted */
+
+
+/* Name: CMD_rx_state_type
+ *
+ * Description: frame parser states
+ *
+ * Members: eCMD_RX_SOF  - waiting for the start of frame byte
+ *          eCMD_RX_LEN  - waiting for the length byte
+ *          eCMD_RX_BODY - receiving ID and payload
+ *          eCMD_RX_CRC  - waiting for the CRC byte
+ *
+ * Notes:
+ *
+ */
+typedef enum
+{
+	eCMD_RX_SOF = 0,
+	eCMD_RX_LEN,
+	eCMD_RX_BODY,
+	eCMD_RX_CRC,
+} CMD_rx_state_type;
+
+
+/* Name: CMD_rx_type
+ *
+ * Description: frame parser state (UART receive interrupt context)
+ *
+ * Members: state - parser state
+ *          len   - LEN byte of the frame being received
+ *          idx   - number of body bytes received
+ *          crc   - running CRC
+ *          body  - ID and payload bytes
+ *
+ * Notes:
+ *
+ */
+struct CMD_rx_type
+{
+	CMD_rx_state_type state;
+	uint8_t len;
+	uint8_t idx;
+	uint8_t crc;
+	uint8_t body[CMD_MAX_LEN];
+};
+
+
+/* Name: CMD_reply_type
+ *
+ * Description: statistics snapshot taken by the control period for the
+ *              background to send
+ *
+ * Members: pending - non-zero while the snapshot waits to be sent; set by
+ *                    the control period, cleared by the background
+ *          ...     - eCMD_ID_STATS reply fields
+ *
+ * Notes:
+ *
+ */
+struct CMD_reply_type
+{
+	volatile uint32_t pending;
+	uint8_t state;
+	uint8_t ctrl;
+	uint32_t rx_frames;
+	uint32_t rx_errors;
+	uint32_t q_drops;
+	uint32_t warn_count;
+	float sp;
+	uint64_t t_us;
+	uint32_t evt_ticks;
+	uint32_t evt_updates;
+	uint32_t ilc_trials;
+	float ilc_e_rms;
+	uint32_t ilc_refused;
+};
+
+
+/* Name: CMD_gains_type
+ *
+ * Description: eCMD_ID_SET_GAINS parked by the control period for the
+ *              background to apply
+ *
+ * Members: pending - non-zero while the gains wait to be applied; set by
+ *                    the control period, cleared by the background
+ *          K       - state feedback gains
+ *          Nbar    - pre-compensation constant
+ *
+ * Notes: a single slot; the next eCMD_ID_SET_GAINS waits in the command
+ *        queue until it is free
+ *
+ */
+struct CMD_gains_type
+{
+	volatile uint32_t pending;
+	float K[CMD_NUM_GAINS];
+	float Nbar;
+};
+
+
+static struct CMD_rx_type cmd_rx = { .state = eCMD_RX_SOF };
+static struct CMD_stats_type cmd_stats = { 0 };
+static struct CMD_reply_type cmd_reply = { .pending = 0 };
+static struct CMD_gains_type cmd_gains = { .pending = 0 };
+static uint32_t cmd_bbox_ofs = 0;   /* next black box image offset to send */
+static uint32_t cmd_scope_ofs = 0;  /* next scope image offset to send */
+static uint32_t cmd_ilc_refused = 0; /* eCMD_ID_ILC operations refused (control period) */
+
+
+/*
+ * Name: CMD_get_float
+ *
+ * Descr: Decodes a little-endian IEEE-754 single from a byte buffer
+ *
+ * Args:     buf - encoded value
+ *           val - storage for the decoded value
+ *
+ * Return:   0 if the value is finite and within +/- CMD_FLOAT_MAX,
+ *           -1 otherwise
+ *
+ * Notes:
+ *
+ */
+static int CMD_get_float( const uint8_t *buf, float *val)
+{
+	uint32_t u = (uint32_t)buf[0] | ((uint32_t)buf[1] << 8) |
+	             ((uint32_t)buf[2] << 16) | ((uint32_t)buf[3] << 24);
+
+	memcpy( val, &u, sizeof(*val));
+
+	/* rejects NaN (all comparisons false) and infinities */
+	return ( *val <= CMD_FLOAT_MAX && *val >= -CMD_FLOAT_MAX) ? 0 : -1;
+}
+
+
+static void CMD_put_u32( uint8_t *buf, uint32_t u)
+{
+	buf[0] = (uint8_t)u;
+	buf[1] = (uint8_t)(u >> 8);
+	buf[2] = (uint8_t)(u >> 16);
+	buf[3] = (uint8_t)(u >> 24);
+}
+
+
+/*
+ * Name: CMD_decode
+ *
+ * Descr: Validates a received frame body and converts it to a command
+ *
+ * Args:     body - ID and payload bytes
+ *           len  - number of bytes in body
+ *           cmd  - storage for the command
+ *
+ * Return:   0 if the body holds a valid command, -1 otherwise
+ *
+ * Notes:
+ *
+ */
+static int CMD_decode( const uint8_t *body, uint8_t len, struct CMD_type *cmd)
+{
+	const uint8_t *arg = &body[1];
+	uint32_t i;
+
+	cmd->id = body[0];
+
+	switch ( cmd->id)
+	{
+	case eCMD_ID_SET_SETPOINT:
+		if ( len != 1 + 4 || CMD_get_float( arg, &cmd->arg.sp))
+			return -1;
+		return ( cmd->arg.sp <= CMD_SP_LIMIT && cmd->arg.sp >= -CMD_SP_LIMIT) ? 0 : -1;
+
+	case eCMD_ID_SET_GAINS:
+		if ( len != 1 + 4*(CMD_NUM_GAINS + 1))
+			return -1;
+		for ( i = 0; i < CMD_NUM_GAINS; i++)
+			if ( CMD_get_float( &arg[4*i], &cmd->arg.gains.K[i]))
+				return -1;
+		return CMD_get_float( &arg[4*CMD_NUM_GAINS], &cmd->arg.gains.Nbar);
+
+	case eCMD_ID_SET_CTRL:
+		if ( len != 1 + 1 || arg[0] >= eFSM_CTRL_MAX)
+			return -1;
+		cmd->arg.ctrl = arg[0];
+		return 0;
+
+	case eCMD_ID_GET_STATS:
+		return ( len == 1) ? 0 : -1;
+
+	case eCMD_ID_BB_CTRL:
+		if ( len != 1 + 1 || arg[0] > CMD_BB_REARM)
+			return -1;
+		cmd->arg.bb_op = arg[0];
+		return 0;
+
+	case eCMD_ID_SCOPE_ARM:
+		if ( len != 1 + 10)
+			return -1;
+		cmd->arg.scope.mask = arg[0];
+		cmd->arg.scope.trig = arg[1];
+		cmd->arg.scope.chan = arg[2];
+		cmd->arg.scope.arg = arg[3];
+		cmd->arg.scope.level = (int16_t)(arg[4] | (arg[5] << 8));
+		cmd->arg.scope.pre = (uint16_t)(arg[6] | (arg[7] << 8));
+		cmd->arg.scope.decim = (uint16_t)(arg[8] | (arg[9] << 8));
+		return ( cmd->arg.scope.trig < eLOG_SC_TRIG_MAX &&
+		         cmd->arg.scope.chan < eLOG_SC_CH_MAX &&
+		         cmd->arg.scope.decim != 0) ? 0 : -1;
+
+	case eCMD_ID_EXCITE:
+		if ( len != 1 + 10)
+			return -1;
+		cmd->arg.exc.kind = arg[0];
+		cmd->arg.exc.amp = arg[1];
+		cmd->arg.exc.p1 = (uint16_t)(arg[2] | (arg[3] << 8));
+		cmd->arg.exc.p2 = (uint16_t)(arg[4] | (arg[5] << 8));
+		cmd->arg.exc.len = (uint32_t)arg[6] | ((uint32_t)arg[7] << 8) |
+		                   ((uint32_t)arg[8] << 16) | ((uint32_t)arg[9] << 24);
+		return ( cmd->arg.exc.kind < eEXC_MAX && cmd->arg.exc.amp <= EXC_AMP_MAX) ? 0 : -1;
+
+	case eCMD_ID_TRAJ_LIMITS:
+		if ( len != 1 + 4*3 || CMD_get_float( &arg[0], &cmd->arg.traj.v_max) ||
+		     CMD_get_float( &arg[4], &cmd->arg.traj.a_max) ||
+		     CMD_get_float( &arg[8], &cmd->arg.traj.j_max))
+			return -1;
+		return ( cmd->arg.traj.v_max > 0 && cmd->arg.traj.v_max <= TRAJ_LIM_MAX &&
+		         cmd->arg.traj.a_max > 0 && cmd->arg.traj.a_max <= TRAJ_LIM_MAX &&
+		         cmd->arg.traj.j_max > 0 && cmd->arg.traj.j_max <= TRAJ_LIM_MAX) ? 0 : -1;
+
+	case eCMD_ID_ILC:
+		if ( len != 1 + 3 || arg[0] > CMD_ILC_RESET)
+			return -1;
+		cmd->arg.ilc.op = arg[0];
+		cmd->arg.ilc.len = (uint16_t)(arg[1] | (arg[2] << 8));
+		return 0;
+
+	default:
+		break;
+	}
+
+	return -1;
+}
+
+
+/*
+ * Name: CMD_RxByte
+ *
+ * Descr: Frame parser; consumes one received byte and queues the command
+ *        once a complete, valid frame has been received
+ *
+ * Args:     data - received byte
+ *
+ * Return:   none
+ *
+ * Notes: Called from the UART receive interrupt (queue producer). Bytes
+ *        outside a frame other than CMD_FRAME_SOF and the legacy 'a'/'d'
+ *        keys are ignored.
+ *
+ */
+void CMD_RxByte( uint8_t data)
+{
+	struct CMD_type cmd;
+
+	switch ( cmd_rx.state)
+	{
+	case eCMD_RX_SOF:
+		if ( data == CMD_FRAME_SOF)
+		{
+			cmd_rx.state = eCMD_RX_LEN;
+		}
+		else if ( data == 'a' || data == 'd')
+		{
+			cmd.id = eCMD_ID_STEP_SETPOINT;
+			cmd.arg.sp = ( data == 'a') ? CMD_SP_STEP : -CMD_SP_STEP;
+			if ( CMD_Push( &cmd))
+				cmd_stats.q_drops++;
+		}
+		break;
+
+	case eCMD_RX_LEN:
+		if ( data == 0 || data > CMD_MAX_LEN)
+		{
+			cmd_stats.rx_errors++;
+			cmd_rx.state = eCMD_RX_SOF;
+			break;
+		}
+		cmd_rx.len = data;
+		cmd_rx.idx = 0;
+		cmd_rx.crc = CMD_crc8( 0, &data, 1);
+		cmd_rx.state = eCMD_RX_BODY;
+		break;
+
+	case eCMD_RX_BODY:
+		cmd_rx.body[cmd_rx.idx++] = data;
+		if ( cmd_rx.idx == cmd_rx.len)
+		{
+			cmd_rx.crc = CMD_crc8( cmd_rx.crc, cmd_rx.body, cmd_rx.len);
+			cmd_rx.state = eCMD_RX_CRC;
+		}
+		break;
+
+	case eCMD_RX_CRC:
+	default:
+		cmd_rx.state = eCMD_RX_SOF;
+
+		if ( data != cmd_rx.crc || CMD_decode( cmd_rx.body, cmd_rx.len, &cmd))
+		{
+			cmd_stats.rx_errors++;
+			break;
+		}
+
+		cmd_stats.rx_frames++;
+		if ( CMD_Push( &cmd))
+			cmd_stats.q_drops++;
+		break;
+	}
+}
+
+
+/*
+ * Name: CMD_Drain
+ *
+ * Descr: Applies up to CMD_DRAIN_MAX queued commands
+ *
+ * Args:     none
+ *
+ * Return:   none
+ *
+ * Notes: Called once per control period, before FSM_Run (queue consumer);
+ *        every parameter update therefore happens at the same point of
+ *        the control period and never concurrently with a controller.
+ *        New gains are parked for CMD_Apply: writing the parameter bank
+ *        (LQR_Balance_SetParams) is background work, the control period
+ *        sees only its publish.
+ *
+ */
+void CMD_Drain( void)
+{
+	struct CMD_type cmd;
+	uint32_t n;
+	float sp;
+
+	for ( n = 0; n < CMD_DRAIN_MAX && CMD_Peek( &cmd) == 0; n++)
+	{
+		/* gains wait in the queue while the previous ones are applied */
+		if ( cmd.id == eCMD_ID_SET_GAINS && cmd_gains.pending)
+			break;
+		(void) CMD_Pop( &cmd);
+
+		LOG_BB_Event( eLOG_EV_CMD, cmd.id);
+		LOG_SC_Command( cmd.id);
+
+		switch ( cmd.id)
+		{
+		case eCMD_ID_SET_SETPOINT:
+			TRAJ_SetTarget( cmd.arg.sp);
+			break;
+
+		case eCMD_ID_STEP_SETPOINT:
+			sp = TRAJ_GetTarget() + cmd.arg.sp;
+			if ( sp > CMD_SP_LIMIT)
+				sp = CMD_SP_LIMIT;
+			else if ( sp < -CMD_SP_LIMIT)
+				sp = -CMD_SP_LIMIT;
+			TRAJ_SetTarget( sp);
+			break;
+
+		case eCMD_ID_SET_GAINS:
+			memcpy( cmd_gains.K, cmd.arg.gains.K, sizeof(cmd_gains.K));
+			cmd_gains.Nbar = cmd.arg.gains.Nbar;
+			cmd_gains.pending = 1;
+			break;
+
+		case eCMD_ID_SET_CTRL:
+			FSM_SetBalanceCtrl( (fsm_ctrl_t)cmd.arg.ctrl);
+			break;
+
+		case eCMD_ID_GET_STATS:
+			/* a request arriving while the previous reply is unsent
+			 * is answered by that reply */
+			if ( cmd_reply.pending)
+				break;
+			cmd_reply.state = (uint8_t)FSM_GetState();
+			cmd_reply.ctrl = (uint8_t)FSM_GetBalanceCtrl();
+			cmd_reply.rx_frames = cmd_stats.rx_frames;
+			cmd_reply.rx_errors = cmd_stats.rx_errors;
+			cmd_reply.q_drops = cmd_stats.q_drops;
+			cmd_reply.warn_count = FSM_CW_GetWarnCount();
+			cmd_reply.sp = LQR_Balance_GetSetPoint();
+			cmd_reply.t_us = SYSTIME_ToUs(SYSTIME_Now());
+			LQR_Balance_GetEventStats( &cmd_reply.evt_ticks, &cmd_reply.evt_updates);
+			ILC_GetStats( &cmd_reply.ilc_trials, &cmd_reply.ilc_e_rms);
+			cmd_reply.ilc_refused = cmd_ilc_refused;
+			cmd_reply.pending = 1;
+			break;
+
+		case eCMD_ID_BB_CTRL:
+			if ( cmd.arg.bb_op == CMD_BB_REARM)
+				LOG_BB_Rearm();
+			else
+				LOG_BB_RequestDump();
+			break;
+
+		case eCMD_ID_SCOPE_ARM:
+			(void) LOG_SC_Arm( &cmd.arg.scope);
+			break;
+
+		case eCMD_ID_EXCITE:
+			(void) EXC_Request( &cmd.arg.exc);
+			break;
+
+		case eCMD_ID_TRAJ_LIMITS:
+			(void) TRAJ_SetLimits( &cmd.arg.traj);
+			break;
+
+		case eCMD_ID_ILC:
+			/* a start while a trial runs or is being learned from, or
+			 * under the fuzzy controller (no set point to follow), and
+			 * a reset while a trial runs, are refused and counted */
+			if ( cmd.arg.ilc.op == CMD_ILC_START)
+			{
+				if ( FSM_GetBalanceCtrl() == eFSM_CTRL_FL || ILC_Start( cmd.arg.ilc.len))
+					cmd_ilc_refused++;
+			}
+			else if ( cmd.arg.ilc.op == CMD_ILC_STOP)
+				ILC_Stop();
+			else if ( ILC_Reset())
+				cmd_ilc_refused++;
+			break;
+
+		default:
+			break;
+		}
+	}
+}
+
+
+/*
+ * Name: CMD_Apply
+ *
+ * Descr: Applies the gains parked by CMD_Drain
+ *
+ * Args:     none
+ *
+ * Return:   none
+ *
+ * Notes: Called from the background context, the single writer of the
+ *        parameter banks (LQR_Balance_SetParams); the bank copy and the
+ *        event trigger design run there, preempted by the control period,
+ *        which keeps reading the active bank until the new one is
+ *        published.
+ *
+ */
+void CMD_Apply( void)
+{
+	if ( !cmd_gains.pending)
+		return;
+
+	LQR_Balance_SetGains( cmd_gains.K, cmd_gains.Nbar);
+	cmd_gains.pending = 0;
+}
+
+
+/*
+ * Name: CMD_StatsFrame
+ *
+ * Descr: Encodes the pending statistics reply
+ *
+ * Args:     buf - frame storage
+ *           len - size of buf
+ *
+ * Return:   frame length in bytes, 0 if no reply is pending or buf is
+ *           too small
+ *
+ * Notes: Called from the background context, which owns UART transmit;
+ *        the reply is released once encoded.
+ *
+ */
+size_t CMD_StatsFrame( uint8_t *buf, size_t len)
+{
+	const size_t body_len = 1 + 2 + 4*4 + 4 + 8 + 2*4 + 3*4;
+	uint32_t u;
+
+	if ( !cmd_reply.pending || len < body_len + 3)
+		return 0;
+
+	buf[0] = CMD_FRAME_SOF;
+	buf[1] = (uint8_t)body_len;
+	buf[2] = eCMD_ID_STATS;
+	buf[3] = cmd_reply.state;
+	buf[4] = cmd_reply.ctrl;
+	CMD_put_u32( &buf[5], cmd_reply.rx_frames);
+	CMD_put_u32( &buf[9], cmd_reply.rx_errors);
+	CMD_put_u32( &buf[13], cmd_reply.q_drops);
+	CMD_put_u32( &buf[17], cmd_reply.warn_count);
+	memcpy( &u, &cmd_reply.sp, sizeof(u));
+	CMD_put_u32( &buf[21], u);
+	CMD_put_u32( &buf[25], (uint32_t)cmd_reply.t_us);
+	CMD_put_u32( &buf[29], (uint32_t)(cmd_reply.t_us >> 32));
+	CMD_put_u32( &buf[33], cmd_reply.evt_ticks);
+	CMD_put_u32( &buf[37], cmd_reply.evt_updates);
+	CMD_put_u32( &buf[41], cmd_reply.ilc_trials);
+	memcpy( &u, &cmd_reply.ilc_e_rms, sizeof(u));
+	CMD_put_u32( &buf[45], u);
+	CMD_put_u32( &buf[49], cmd_reply.ilc_refused);
+	buf[53] = CMD_crc8( 0, &buf[1], body_len + 1);
+
+	cmd_reply.pending = 0;
+
+	return body_len + 3;
+}
+
+
+/*
+ * Name: CMD_chunk_frame
+ *
+ * Descr: Encodes one chunk of an image (black box, scope) as a frame:
+ *        uint32 image offset followed by up to CMD_BBOX_CHUNK image bytes
+ *
+ * Args:     id   - frame ID
+ *           ofs  - image offset of the chunk
+ *           read - image read routine
+ *           buf  - frame storage
+ *           len  - size of buf
+ *           n    - storage for the number of image bytes in the frame
+ *
+ * Return:   frame length in bytes, 0 if buf is too small
+ *
+ * Notes:
+ *
+ */
+static size_t CMD_chunk_frame( uint8_t id, uint32_t ofs,
+                               size_t (*read)( uint32_t, uint8_t *, size_t),
+                               uint8_t *buf, size_t len, size_t *n)
+{
+	if ( len < 1 + 4 + 3 + 1)
+		return 0;
+
+	*n = len - (1 + 4 + 3);
+	if ( *n > CMD_BBOX_CHUNK)
+		*n = CMD_BBOX_CHUNK;
+
+	*n = read( ofs, &buf[7], *n);
+	buf[0] = CMD_FRAME_SOF;
+	buf[1] = (uint8_t)(1 + 4 + *n);
+	buf[2] = id;
+	CMD_put_u32( &buf[3], ofs);
+	buf[7 + *n] = CMD_crc8( 0, &buf[1], 1 + 1 + 4 + *n);
+
+	return 1 + 4 + *n + 3;
+}
+
+
+/*
+ * Name: CMD_BBoxFrame
+ *
+ * Descr: Encodes the next frame of a black box dump
+ *
+ * Args:     buf - frame storage
+ *           len - size of buf
+ *
+ * Return:   frame length in bytes, 0 if no dump is pending or buf is too
+ *           small
+ *
+ * Notes: Background context; one frame per call, in image order. The
+ *        request is released after the last frame; a request repeated
+ *        during a dump is served by that dump.
+ *
+ */
+size_t CMD_BBoxFrame( uint8_t *buf, size_t len)
+{
+	size_t n;
+
+	if ( !LOG_BB_DumpPending())
+	{
+		/* none requested, or abandoned by a rearm */
+		cmd_bbox_ofs = 0;
+		return 0;
+	}
+
+	len = CMD_chunk_frame( eCMD_ID_BBOX, cmd_bbox_ofs, LOG_BB_ImageRead, buf, len, &n);
+	if ( len == 0)
+		return 0;
+
+	cmd_bbox_ofs += n;
+	if ( n == 0 || cmd_bbox_ofs >= LOG_BB_ImageSize())
+	{
+		cmd_bbox_ofs = 0;
+		LOG_BB_DumpDone();
+	}
+
+	return len;
+}
+
+
+/*
+ * Name: CMD_ScopeFrame
+ *
+ * Descr: Encodes the next frame of a completed scope capture
+ *
+ * Args:     buf - frame storage
+ *           len - size of buf
+ *
+ * Return:   frame length in bytes, 0 if no capture is complete or buf is
+ *           too small
+ *
+ * Notes: Background context; one frame per call, in image order. The
+ *        capture is released after the last frame.
+ *
+ */
+size_t CMD_ScopeFrame( uint8_t *buf, size_t len)
+{
+	size_t n;
+
+	if ( !LOG_SC_Done())
+	{
+		/* none complete, or abandoned by a new request */
+		cmd_scope_ofs = 0;
+		return 0;
+	}
+
+	len = CMD_chunk_frame( eCMD_ID_SCOPE, cmd_scope_ofs, LOG_SC_ImageRead, buf, len, &n);
+	if ( len == 0)
+		return 0;
+
+	cmd_scope_ofs += n;
+	if ( n == 0 || cmd_scope_ofs >= LOG_SC_ImageSize())
+	{
+		cmd_scope_ofs = 0;
+		LOG_SC_Release();
+	}
+
+	return len;
+}
+
+
+/*
+ * Name: CMD_GetStats
+ *
+ * Descr: Routine to read the command channel statistics
+ *
+ * Args:     none
+ *
+ * Return:   pointer to statistics
+ *
+ * Notes:
+ *
+ */
+const struct CMD_stats_type *CMD_GetStats( void)
+{
+	return &cmd_stats;
+}
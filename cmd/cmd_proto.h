@@ -0,0 +1,32 @@
+/*
+ * cmd_proto.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Milos Lazic
+ */
+
+#ifndef CMD_CMD_PROTO_H_
+#define CMD_CMD_PROTO_H_
+
+
+#include <stdint.h>
+#include "cmd_defs.h"
+
+
+/* module scope routines */
+extern int CMD_Push( const struct CMD_type *cmd);
+extern int CMD_Pop( struct CMD_type *cmd);
+extern int CMD_Peek( struct CMD_type *cmd);
+extern uint8_t CMD_crc8( uint8_t crc, const uint8_t *buf, size_t len);
+
+/* global scope routines */
+extern void CMD_RxByte( uint8_t data);
+extern void CMD_Drain( void);
+extern void CMD_Apply( void);
+extern size_t CMD_StatsFrame( uint8_t *buf, size_t len);
+extern size_t CMD_BBoxFrame( uint8_t *buf, size_t len);
+extern size_t CMD_ScopeFrame( uint8_t *buf, size_t len);
+extern const struct CMD_stats_type *CMD_GetStats( void);
+
+
+#endif /* CMD_CMD_PROTO_H_ */
@@ -0,0 +1,126 @@
+/*
+ * cmd_utils.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Milos Lazic
+ */
+
+#include "cmd_defs.h"
+#include "cmd_proto.h"
+
+
+// queue between the UART receive interrupt (producer) and the control
+// period (consumer)
+static struct CMD_queue_type cmd_queue =
+{
+		.head = 0,
+		.tail = 0,
+};
+
+
+/*
+ * Name: CMD_Push
+ *
+ * Descr: Appends a command to the command queue
+ *
+ * Args:     cmd - command to append
+ *
+ * Return:   0 on success, -1 if the queue is full
+ *
+ * Notes: Producer side; called from the UART receive interrupt only.
+ *        Wait-free: the slot is written before head is published.
+ *
+ */
+int CMD_Push( const struct CMD_type *cmd)
+{
+	uint32_t head = cmd_queue.head;
+
+	if ( head - cmd_queue.tail >= CMD_QUEUE_LEN)
+		return -1;
+
+	cmd_queue.slot[head & (CMD_QUEUE_LEN - 1)] = *cmd;
+	cmd_queue.head = head + 1;
+
+	return 0;
+}
+
+
+/*
+ * Name: CMD_Pop
+ *
+ * Descr: Removes the oldest command from the command queue
+ *
+ * Args:     cmd - storage for the removed command
+ *
+ * Return:   0 on success, -1 if the queue is empty
+ *
+ * Notes: Consumer side; called from the control period only. Wait-free:
+ *        the slot is copied out before tail releases it.
+ *
+ */
+int CMD_Pop( struct CMD_type *cmd)
+{
+	uint32_t tail = cmd_queue.tail;
+
+	if ( tail == cmd_queue.head)
+		return -1;
+
+	*cmd = cmd_queue.slot[tail & (CMD_QUEUE_LEN - 1)];
+	cmd_queue.tail = tail + 1;
+
+	return 0;
+}
+
+
+/*
+ * Name: CMD_Peek
+ *
+ * Descr: Copies the oldest command of the command queue, leaving it queued
+ *
+ * Args:     cmd - storage for the copied command
+ *
+ * Return:   0 on success, -1 if the queue is empty
+ *
+ * Notes: Consumer side; called from the control period only.
+ *
+ */
+int CMD_Peek( struct CMD_type *cmd)
+{
+	uint32_t tail = cmd_queue.tail;
+
+	if ( tail == cmd_queue.head)
+		return -1;
+
+	*cmd = cmd_queue.slot[tail & (CMD_QUEUE_LEN - 1)];
+
+	return 0;
+}
+
+
+/*
+ * Name: CMD_crc8
+ *
+ * Descr: Updates a CRC-8 (polynomial 0x07) over a buffer
+ *
+ * Args:     crc - CRC of the preceding bytes (0 initially)
+ *           buf - bytes to add
+ *           len - number of bytes
+ *
+ * Return:   updated CRC
+ *
+ * Notes:
+ *
+ */
+uint8_t CMD_crc8( uint8_t crc, const uint8_t *buf, size_t len)
+{
+	uint32_t bit;
+
+	while ( len--)
+	{
+		crc ^= *buf++;
+		for ( bit = 0; bit < 8; bit++)
+			crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+	}
+
+	return crc;
+}
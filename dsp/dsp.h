@@ -0,0 +1,16 @@
+/*
+ * dsp.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Milos Lazic
+ */
+
+#ifndef DSP_DSP_H_
+#define DSP_DSP_H_
+
+#include "dsp_defs.h"
+#include "dsp_proto.h"
+
+
+
+#endif /* DSP_DSP_H_ */
@@ -0,0 +1,257 @@
+/*
+ * dsp_biquad.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Milos Lazic
+ *
+ *  Biquad cascades (see dsp_defs.h). The float version is transposed
+ *  direct form II (two states per stage); the fixed point versions are
+ *  direct form I, which keeps a single wide accumulator per stage and
+ *  cannot overflow internally, only at the saturated output.
+ */
+
+#include "dsp.h"
+
+
+/*
+ * Name: DSP_BQ_F_Run
+ *
+ * Descr: Filters one sample through a float biquad cascade
+ *
+ * Args:     f - filter
+ *           x - input sample
+ *
+ * Return:   output sample
+ *
+ * Notes: 5 multiply-accumulates per stage
+ *
+ */
+float DSP_BQ_F_Run( struct DSP_bq_f_type *f, float x)
+{
+	const float *c = f->coef;
+	float *s = f->st;
+	float y;
+	uint32_t i;
+
+	for ( i = 0; i < f->n_st; i++, c += DSP_BQ_COEFS, s += 2)
+	{
+		y = c[0]*x + s[0];
+		s[0] = c[1]*x - c[3]*y + s[1];
+		s[1] = c[2]*x - c[4]*y;
+		x = y;
+	}
+
+	return x;
+}
+
+
+/*
+ * Name: DSP_BQ_Q31_Run
+ *
+ * Descr: Filters one sample through a Q31 biquad cascade
+ *
+ * Args:     f - filter
+ *           x - input sample, Q31
+ *
+ * Return:   output sample, Q31, saturated
+ *
+ * Notes: 5 32x32->64 multiply-accumulates per stage
+ *
+ */
+int32_t DSP_BQ_Q31_Run( struct DSP_bq_q31_type *f, int32_t x)
+{
+	const int32_t *c = f->coef;
+	int32_t *s = f->st;
+	uint32_t sh = 31 - f->shift;
+	int64_t acc;
+	int32_t y;
+	uint32_t i;
+
+	for ( i = 0; i < f->n_st; i++, c += DSP_BQ_COEFS, s += 4)
+	{
+		acc = (int64_t)1 << (sh - 1);
+		acc += (int64_t)c[0]*x;
+		acc += (int64_t)c[1]*s[0];
+		acc += (int64_t)c[2]*s[1];
+		acc -= (int64_t)c[3]*s[2];
+		acc -= (int64_t)c[4]*s[3];
+		y = DSP_sat_q31( acc >> sh);
+
+		s[1] = s[0];
+		s[0] = x;
+		s[3] = s[2];
+		s[2] = y;
+		x = y;
+	}
+
+	return x;
+}
+
+
+/*
+ * Name: DSP_BQ_Q15_Run
+ *
+ * Descr: Filters one sample through a Q15 biquad cascade
+ *
+ * Args:     f - filter
+ *           x - input sample, Q15
+ *
+ * Return:   output sample, Q15, saturated
+ *
+ * Notes: 5 16x16 multiply-accumulates per stage into a 64-bit accumulator
+ *
+ */
+int16_t DSP_BQ_Q15_Run( struct DSP_bq_q15_type *f, int16_t x)
+{
+	const int16_t *c = f->coef;
+	int16_t *s = f->st;
+	uint32_t sh = 15 - f->shift;
+	int64_t acc;
+	int16_t y;
+	uint32_t i;
+
+	for ( i = 0; i < f->n_st; i++, c += DSP_BQ_COEFS, s += 4)
+	{
+		acc = (int64_t)1 << (sh - 1);
+		acc += (int32_t)c[0]*x;
+		acc += (int32_t)c[1]*s[0];
+		acc += (int32_t)c[2]*s[1];
+		acc -= (int32_t)c[3]*s[2];
+		acc -= (int32_t)c[4]*s[3];
+		y = DSP_sat_q15( acc >> sh);
+
+		s[1] = s[0];
+		s[0] = x;
+		s[3] = s[2];
+		s[2] = y;
+		x = y;
+	}
+
+	return x;
+}
+
+
+/*
+ * Name: DSP_bq_dc
+ *
+ * Descr: DC gain of a biquad stage
+ *
+ * Args:     c   - stage coefficients, as stored
+ *           one - stored value of 1.0
+ *
+ * Return:   DC gain, 0 if the stage has a pole at DC
+ *
+ * Notes:
+ *
+ */
+static float DSP_bq_dc( const float *c, float one)
+{
+	float den = one + c[3] + c[4];
+
+	if ( den > -1e-9f*one && den < 1e-9f*one)
+		return 0.0f;
+
+	return ( c[0] + c[1] + c[2])/den;
+}
+
+
+/*
+ * Name: DSP_BQ_F_Prime
+ *
+ * Descr: Sets a float biquad cascade to its steady state for a constant
+ *        input
+ *
+ * Args:     f - filter
+ *           x - input level
+ *
+ * Return:   none
+ *
+ * Notes: Avoids the start-up transient of a filter switched in on a
+ *        signal far from zero
+ *
+ */
+void DSP_BQ_F_Prime( struct DSP_bq_f_type *f, float x)
+{
+	const float *c = f->coef;
+	float *s = f->st;
+	float y;
+	uint32_t i;
+
+	for ( i = 0; i < f->n_st; i++, c += DSP_BQ_COEFS, s += 2)
+	{
+		y = DSP_bq_dc( c, 1.0f)*x;
+		s[1] = c[2]*x - c[4]*y;
+		s[0] = c[1]*x - c[3]*y + s[1];
+		x = y;
+	}
+}
+
+
+/*
+ * Name: DSP_BQ_Q31_Prime
+ *
+ * Descr: Sets a Q31 biquad cascade to its steady state for a constant
+ *        input
+ *
+ * Args:     f - filter
+ *           x - input level, Q31
+ *
+ * Return:   none
+ *
+ * Notes:
+ *
+ */
+void DSP_BQ_Q31_Prime( struct DSP_bq_q31_type *f, int32_t x)
+{
+	const int32_t *c = f->coef;
+	int32_t *s = f->st;
+	float cf[DSP_BQ_COEFS];
+	int32_t y;
+	uint32_t i, k;
+
+	for ( i = 0; i < f->n_st; i++, c += DSP_BQ_COEFS, s += 4)
+	{
+		for ( k = 0; k < DSP_BQ_COEFS; k++)
+			cf[k] = (float)c[k];
+
+		y = DSP_sat_q31( (int64_t)(DSP_bq_dc( cf, (float)(1ul << (31 - f->shift)))*(float)x));
+		s[0] = s[1] = x;
+		s[2] = s[3] = y;
+		x = y;
+	}
+}
+
+
+/*
+ * Name: DSP_BQ_Q15_Prime
+ *
+ * Descr: Sets a Q15 biquad cascade to its steady state for a constant
+ *        input
+ *
+ * Args:     f - filter
+ *           x - input level, Q15
+ *
+ * Return:   none
+ *
+ * Notes:
+ *
+ */
+void DSP_BQ_Q15_Prime( struct DSP_bq_q15_type *f, int16_t x)
+{
+	const int16_t *c = f->coef;
+	int16_t *s = f->st;
+	float cf[DSP_BQ_COEFS];
+	int16_t y;
+	uint32_t i, k;
+
+	for ( i = 0; i < f->n_st; i++, c += DSP_BQ_COEFS, s += 4)
+	{
+		for ( k = 0; k < DSP_BQ_COEFS; k++)
+			cf[k] = (float)c[k];
+
+		y = DSP_sat_q15( (int64_t)(DSP_bq_dc( cf, (float)(1ul << (15 - f->shift)))*(float)x));
+		s[0] = s[1] = x;
+		s[2] = s[3] = y;
+		x = y;
+	}
+}
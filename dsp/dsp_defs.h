@@ -0,0 +1,196 @@
+/*
+ * dsp_defs.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Milos Lazic
+ *
+ *  Fixed cost filters for encoder and actuator signals: cascaded biquads
+ *  (low-pass, notch, ...) and FIR filters (Savitzky-Golay
+ *  differentiators, ...), each in float, Q31 and Q15. Coefficients are
+ *  designed on the host (host/dsp_design), which emits the objects below
+ *  ready to compile in.
+ *
+ *  Per-sample cost depends only on the filter length: no branches on the
+ *  data, no modulo (FIR delay lines are stored twice so the window is
+ *  always contiguous). The inner loops are plain multiply-accumulates
+ *  into a 64-bit (fixed point) or float accumulator, which the compiler
+ *  maps onto the M4 SMLAL/SMLALBB and VFMA instructions.
+ *
+ *  Fixed point coefficients carry a shift: a stored coefficient c means
+ *  c * 2^(shift - 31) (Q31) or c * 2^(shift - 15) (Q15), so coefficients
+ *  up to 2^shift in magnitude are representable. Outputs saturate.
+ */
+
+#ifndef DSP_DSP_DEFS_H_
+#define DSP_DSP_DEFS_H_
+
+
+#include <stdlib.h>
+#include <stdint.h>
+
+
+#define DSP_BQ_COEFS   5   /* coefficients per biquad stage: b0, b1, b2, a1, a2 */
+
+
+/* Name: DSP_kind_type
+ *
+ * Description: filter implementations
+ *
+ * Members: eDSP_BQ_F    - biquad cascade, float, transposed direct form II
+ *          eDSP_BQ_Q31  - biquad cascade, Q31, direct form I
+ *          eDSP_BQ_Q15  - biquad cascade, Q15, direct form I
+ *          eDSP_FIR_F   - FIR, float
+ *          eDSP_FIR_Q31 - FIR, Q31
+ *          eDSP_FIR_Q15 - FIR, Q15
+ *
+ * Notes:
+ *
+ */
+typedef enum
+{
+	eDSP_BQ_F = 0,
+	eDSP_BQ_Q31,
+	eDSP_BQ_Q15,
+	eDSP_FIR_F,
+	eDSP_FIR_Q31,
+	eDSP_FIR_Q15,
+	eDSP_KIND_MAX,
+} DSP_kind_type;
+
+
+/* Name: DSP_bq_f_type
+ *
+ * Description: float biquad cascade
+ *
+ * Members: n_st - stages
+ *          coef - DSP_BQ_COEFS per stage; y = b0*x + b1*x1 + b2*x2 -
+ *                 a1*y1 - a2*y2
+ *          st   - state, 2 per stage
+ *
+ * Notes:
+ *
+ */
+struct DSP_bq_f_type
+{
+	uint32_t n_st;
+	const float *coef;
+	float *st;
+};
+
+
+/* Name: DSP_bq_q31_type
+ *
+ * Description: Q31 biquad cascade
+ *
+ * Members: n_st  - stages
+ *          shift - coefficient shift (see above)
+ *          coef  - DSP_BQ_COEFS per stage
+ *          st    - state, 4 per stage (x1, x2, y1, y2)
+ *
+ * Notes:
+ *
+ */
+struct DSP_bq_q31_type
+{
+	uint32_t n_st;
+	uint32_t shift;
+	const int32_t *coef;
+	int32_t *st;
+};
+
+
+/* Name: DSP_bq_q15_type
+ *
+ * Description: Q15 biquad cascade; as DSP_bq_q31_type
+ *
+ */
+struct DSP_bq_q15_type
+{
+	uint32_t n_st;
+	uint32_t shift;
+	const int16_t *coef;
+	int16_t *st;
+};
+
+
+/* Name: DSP_fir_f_type
+ *
+ * Description: float FIR filter
+ *
+ * Members: n    - taps
+ *          coef - coefficients, newest sample first
+ *          st   - delay line, 2*n entries
+ *          pos  - index of the newest sample in st
+ *
+ * Notes: every sample is stored at pos and pos + n, so st[pos .. pos+n-1]
+ *        always holds the window, newest first
+ *
+ */
+struct DSP_fir_f_type
+{
+	uint32_t n;
+	const float *coef;
+	float *st;
+	uint32_t pos;
+};
+
+
+/* Name: DSP_fir_q31_type
+ *
+ * Description: Q31 FIR filter; as DSP_fir_f_type, plus
+ *
+ * Members: shift - coefficient shift (see above)
+ *
+ */
+struct DSP_fir_q31_type
+{
+	uint32_t n;
+	uint32_t shift;
+	const int32_t *coef;
+	int32_t *st;
+	uint32_t pos;
+};
+
+
+/* Name: DSP_fir_q15_type
+ *
+ * Description: Q15 FIR filter; as DSP_fir_q31_type
+ *
+ */
+struct DSP_fir_q15_type
+{
+	uint32_t n;
+	uint32_t shift;
+	const int16_t *coef;
+	int16_t *st;
+	uint32_t pos;
+};
+
+
+/* Name: DSP_filt_type
+ *
+ * Description: filter plugged on a float signal (state channel,
+ *              controller output)
+ *
+ * Members: kind      - implementation (DSP_kind_type)
+ *          f         - filter object of that kind
+ *          in_scale  - signal to filter input (fixed point: signal value
+ *                      at full scale is 1/in_scale)
+ *          out_scale - filter output to signal (e.g. 1/(in_scale*dt) for
+ *                      a differentiator)
+ *          next      - next filter of a chain, NULL at the end
+ *
+ * Notes: float filters use the scales too (normally 1)
+ *
+ */
+struct DSP_filt_type
+{
+	DSP_kind_type kind;
+	void *f;
+	float in_scale;
+	float out_scale;
+	struct DSP_filt_type *next;
+};
+
+
+#endif /* DSP_DSP_DEFS_H_ */
@@ -0,0 +1,189 @@
+/*
+ * dsp_filt.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Milos Lazic
+ *
+ *  Filters plugged on float signals (struct DSP_filt_type): conversion
+ *  to and from the fixed point formats and chaining.
+ */
+
+#include "dsp.h"
+
+
+#define DSP_F_ONE_M   0.99999994f   /* largest float below 1.0 */
+
+
+/*
+ * Name: DSP_sat_q31
+ *
+ * Descr: Saturates a wide result to Q31
+ *
+ * Args:     v - value
+ *
+ * Return:   v limited to the int32_t range
+ *
+ * Notes:
+ *
+ */
+int32_t DSP_sat_q31( int64_t v)
+{
+	if ( v > INT32_MAX)
+		return INT32_MAX;
+	if ( v < -INT32_MAX)
+		return -INT32_MAX;
+
+	return (int32_t)v;
+}
+
+
+/*
+ * Name: DSP_sat_q15
+ *
+ * Descr: Saturates a wide result to Q15
+ *
+ * Args:     v - value
+ *
+ * Return:   v limited to the int16_t range
+ *
+ * Notes:
+ *
+ */
+int16_t DSP_sat_q15( int64_t v)
+{
+	if ( v > INT16_MAX)
+		return INT16_MAX;
+	if ( v < -INT16_MAX)
+		return -INT16_MAX;
+
+	return (int16_t)v;
+}
+
+
+/*
+ * Name: DSP_to_frac
+ *
+ * Descr: Scales a signal to the fixed point input range
+ *
+ * Args:     c - filter
+ *           x - signal value
+ *
+ * Return:   x*in_scale limited to [-1, 1)
+ *
+ * Notes: limiting in float keeps the conversion a single VCVT
+ *
+ */
+static float DSP_to_frac( const struct DSP_filt_type *c, float x)
+{
+	x *= c->in_scale;
+
+	if ( x > DSP_F_ONE_M)
+		return DSP_F_ONE_M;
+	if ( x < -DSP_F_ONE_M)
+		return -DSP_F_ONE_M;
+
+	return x;
+}
+
+
+/*
+ * Name: DSP_Run
+ *
+ * Descr: Filters one sample of a signal through a filter chain
+ *
+ * Args:     c - first filter, NULL for none
+ *           x - signal value
+ *
+ * Return:   filtered signal value
+ *
+ * Notes: Cost is fixed by the chain layout
+ *
+ */
+float DSP_Run( struct DSP_filt_type *c, float x)
+{
+	for ( ; c != NULL; c = c->next)
+	{
+		switch ( c->kind)
+		{
+		case eDSP_BQ_F:
+			x = DSP_BQ_F_Run( c->f, x*c->in_scale)*c->out_scale;
+			break;
+		case eDSP_BQ_Q31:
+			x = (float)DSP_BQ_Q31_Run( c->f, (int32_t)(DSP_to_frac( c, x)*2147483648.0f))*
+				(c->out_scale/2147483648.0f);
+			break;
+		case eDSP_BQ_Q15:
+			x = (float)DSP_BQ_Q15_Run( c->f, (int16_t)(DSP_to_frac( c, x)*32768.0f))*
+				(c->out_scale/32768.0f);
+			break;
+		case eDSP_FIR_F:
+			x = DSP_FIR_F_Run( c->f, x*c->in_scale)*c->out_scale;
+			break;
+		case eDSP_FIR_Q31:
+			x = (float)DSP_FIR_Q31_Run( c->f, (int32_t)(DSP_to_frac( c, x)*2147483648.0f))*
+				(c->out_scale/2147483648.0f);
+			break;
+		case eDSP_FIR_Q15:
+			x = (float)DSP_FIR_Q15_Run( c->f, (int16_t)(DSP_to_frac( c, x)*32768.0f))*
+				(c->out_scale/32768.0f);
+			break;
+		default:
+			break;
+		}
+	}
+
+	return x;
+}
+
+
+/*
+ * Name: DSP_Prime
+ *
+ * Descr: Sets a filter chain to its steady state for a constant signal
+ *
+ * Args:     c - first filter, NULL for none
+ *           x - signal level
+ *
+ * Return:   none
+ *
+ * Notes: Each filter is primed with the steady output of the previous
+ *        one, which a single run from the primed state gives.
+ *
+ */
+void DSP_Prime( struct DSP_filt_type *c, float x)
+{
+	struct DSP_filt_type *next;
+
+	for ( ; c != NULL; c = c->next)
+	{
+		switch ( c->kind)
+		{
+		case eDSP_BQ_F:
+			DSP_BQ_F_Prime( c->f, x*c->in_scale);
+			break;
+		case eDSP_BQ_Q31:
+			DSP_BQ_Q31_Prime( c->f, (int32_t)(DSP_to_frac( c, x)*2147483648.0f));
+			break;
+		case eDSP_BQ_Q15:
+			DSP_BQ_Q15_Prime( c->f, (int16_t)(DSP_to_frac( c, x)*32768.0f));
+			break;
+		case eDSP_FIR_F:
+			DSP_FIR_F_Prime( c->f, x*c->in_scale);
+			break;
+		case eDSP_FIR_Q31:
+			DSP_FIR_Q31_Prime( c->f, (int32_t)(DSP_to_frac( c, x)*2147483648.0f));
+			break;
+		case eDSP_FIR_Q15:
+			DSP_FIR_Q15_Prime( c->f, (int16_t)(DSP_to_frac( c, x)*32768.0f));
+			break;
+		default:
+			break;
+		}
+
+		/* steady output of this filter, without advancing the rest */
+		next = c->next;
+		c->next = NULL;
+		x = DSP_Run( c, x);
+		c->next = next;
+	}
+}
@@ -0,0 +1,176 @@
+/*
+ * dsp_fir.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Milos Lazic
+ *
+ *  FIR filters (see dsp_defs.h). The delay line holds every sample twice,
+ *  n entries apart, so the dot product always runs over one contiguous
+ *  window and the loop carries no wrap-around test.
+ */
+
+#include "dsp.h"
+
+
+/*
+ * Name: DSP_FIR_F_Run
+ *
+ * Descr: Filters one sample through a float FIR filter
+ *
+ * Args:     f - filter
+ *           x - input sample
+ *
+ * Return:   output sample
+ *
+ * Notes: n multiply-accumulates
+ *
+ */
+float DSP_FIR_F_Run( struct DSP_fir_f_type *f, float x)
+{
+	const float *c = f->coef;
+	const float *s;
+	float acc = 0.0f;
+	uint32_t i;
+
+	f->pos = ( f->pos == 0) ? f->n - 1 : f->pos - 1;
+	f->st[f->pos] = f->st[f->pos + f->n] = x;
+
+	s = &f->st[f->pos];
+	for ( i = 0; i < f->n; i++)
+		acc += c[i]*s[i];
+
+	return acc;
+}
+
+
+/*
+ * Name: DSP_FIR_Q31_Run
+ *
+ * Descr: Filters one sample through a Q31 FIR filter
+ *
+ * Args:     f - filter
+ *           x - input sample, Q31
+ *
+ * Return:   output sample, Q31, saturated
+ *
+ * Notes: n 32x32->64 multiply-accumulates
+ *
+ */
+int32_t DSP_FIR_Q31_Run( struct DSP_fir_q31_type *f, int32_t x)
+{
+	const int32_t *c = f->coef;
+	const int32_t *s;
+	uint32_t sh = 31 - f->shift;
+	int64_t acc = (int64_t)1 << (sh - 1);
+	uint32_t i;
+
+	f->pos = ( f->pos == 0) ? f->n - 1 : f->pos - 1;
+	f->st[f->pos] = f->st[f->pos + f->n] = x;
+
+	s = &f->st[f->pos];
+	for ( i = 0; i < f->n; i++)
+		acc += (int64_t)c[i]*s[i];
+
+	return DSP_sat_q31( acc >> sh);
+}
+
+
+/*
+ * Name: DSP_FIR_Q15_Run
+ *
+ * Descr: Filters one sample through a Q15 FIR filter
+ *
+ * Args:     f - filter
+ *           x - input sample, Q15
+ *
+ * Return:   output sample, Q15, saturated
+ *
+ * Notes: n 16x16 multiply-accumulates into a 64-bit accumulator
+ *
+ */
+int16_t DSP_FIR_Q15_Run( struct DSP_fir_q15_type *f, int16_t x)
+{
+	const int16_t *c = f->coef;
+	const int16_t *s;
+	uint32_t sh = 15 - f->shift;
+	int64_t acc = (int64_t)1 << (sh - 1);
+	uint32_t i;
+
+	f->pos = ( f->pos == 0) ? f->n - 1 : f->pos - 1;
+	f->st[f->pos] = f->st[f->pos + f->n] = x;
+
+	s = &f->st[f->pos];
+	for ( i = 0; i < f->n; i++)
+		acc += (int32_t)c[i]*s[i];
+
+	return DSP_sat_q15( acc >> sh);
+}
+
+
+/*
+ * Name: DSP_FIR_F_Prime
+ *
+ * Descr: Fills the delay line of a float FIR filter with a constant
+ *
+ * Args:     f - filter
+ *           x - input level
+ *
+ * Return:   none
+ *
+ * Notes: A differentiator then starts from zero rather than from a step
+ *
+ */
+void DSP_FIR_F_Prime( struct DSP_fir_f_type *f, float x)
+{
+	uint32_t i;
+
+	for ( i = 0; i < 2*f->n; i++)
+		f->st[i] = x;
+	f->pos = 0;
+}
+
+
+/*
+ * Name: DSP_FIR_Q31_Prime
+ *
+ * Descr: Fills the delay line of a Q31 FIR filter with a constant
+ *
+ * Args:     f - filter
+ *           x - input level, Q31
+ *
+ * Return:   none
+ *
+ * Notes:
+ *
+ */
+void DSP_FIR_Q31_Prime( struct DSP_fir_q31_type *f, int32_t x)
+{
+	uint32_t i;
+
+	for ( i = 0; i < 2*f->n; i++)
+		f->st[i] = x;
+	f->pos = 0;
+}
+
+
+/*
+ * Name: DSP_FIR_Q15_Prime
+ *
+ * Descr: Fills the delay line of a Q15 FIR filter with a constant
+ *
+ * Args:     f - filter
+ *           x - input level, Q15
+ *
+ * Return:   none
+ *
+ * Notes:
+ *
+ */
+void DSP_FIR_Q15_Prime( struct DSP_fir_q15_type *f, int16_t x)
+{
+	uint32_t i;
+
+	for ( i = 0; i < 2*f->n; i++)
+		f->st[i] = x;
+	f->pos = 0;
+}
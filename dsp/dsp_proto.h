@@ -0,0 +1,37 @@
+/*
+ * dsp_proto.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Milos Lazic
+ */
+
+#ifndef DSP_DSP_PROTO_H_
+#define DSP_DSP_PROTO_H_
+
+
+#include <stdint.h>
+#include "dsp_defs.h"
+
+
+/* module scope routines */
+extern int32_t DSP_sat_q31( int64_t v);
+extern int16_t DSP_sat_q15( int64_t v);
+
+/* global scope routines */
+extern float DSP_BQ_F_Run( struct DSP_bq_f_type *f, float x);
+extern int32_t DSP_BQ_Q31_Run( struct DSP_bq_q31_type *f, int32_t x);
+extern int16_t DSP_BQ_Q15_Run( struct DSP_bq_q15_type *f, int16_t x);
+extern void DSP_BQ_F_Prime( struct DSP_bq_f_type *f, float x);
+extern void DSP_BQ_Q31_Prime( struct DSP_bq_q31_type *f, int32_t x);
+extern void DSP_BQ_Q15_Prime( struct DSP_bq_q15_type *f, int16_t x);
+extern float DSP_FIR_F_Run( struct DSP_fir_f_type *f, float x);
+extern int32_t DSP_FIR_Q31_Run( struct DSP_fir_q31_type *f, int32_t x);
+extern int16_t DSP_FIR_Q15_Run( struct DSP_fir_q15_type *f, int16_t x);
+extern void DSP_FIR_F_Prime( struct DSP_fir_f_type *f, float x);
+extern void DSP_FIR_Q31_Prime( struct DSP_fir_q31_type *f, int32_t x);
+extern void DSP_FIR_Q15_Prime( struct DSP_fir_q15_type *f, int16_t x);
+extern float DSP_Run( struct DSP_filt_type *c, float x);
+extern void DSP_Prime( struct DSP_filt_type *c, float x);
+
+
+#endif /* DSP_DSP_PROTO_H_ */
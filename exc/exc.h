@@ -0,0 +1,16 @@
+/*
+ * exc.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Milos Lazic
+ */
+
+#ifndef EXC_EXC_H_
+#define EXC_EXC_H_
+
+#include "exc_defs.h"
+#include "exc_proto.h"
+
+
+
+#endif /* EXC_EXC_H_ */
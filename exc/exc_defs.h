@@ -0,0 +1,126 @@
+/*
+ * exc_defs.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Milos Lazic
+ *
+ *  Open-loop excitation of the cart drive for frequency response
+ *  measurement (exc_gen.c): eDEV_ESC0 is driven with a chirp or a PRBS
+ *  while the scope records QEI1 and the applied power at the control rate.
+ *
+ *  The per-period work is fixed: a chirp is a phase accumulator whose
+ *  increment grows geometrically (two 32 x 32 bit multiplies), read through
+ *  a quarter-wave sine table in flash; a PRBS is a Galois LFSR whose
+ *  feedback taps come from a table in flash. All floating point work
+ *  happens once, when the request is accepted.
+ */
+
+#ifndef EXC_EXC_DEFS_H_
+#define EXC_EXC_DEFS_H_
+
+
+#include <stdlib.h>
+#include <stdint.h>
+
+
+#define EXC_TICK_HZ    10000.0f  /* control rate (Hz); SysTick at 10 kHz */
+#define EXC_SIN_BITS   8         /* quarter-wave table: 2^EXC_SIN_BITS + 1 entries */
+#define EXC_AMP_MAX    50        /* largest excitation amplitude (% power) */
+#define EXC_F_SCALE    10        /* chirp frequency unit: 1/EXC_F_SCALE Hz */
+#define EXC_F_MAX      2000      /* highest chirp frequency (Hz) */
+#define EXC_PRBS_MIN   5         /* PRBS register lengths (bits) */
+#define EXC_PRBS_MAX   16
+
+/* centring: power (Q15) += EXC_KX_NUM * x (counts) >> EXC_KX_SHIFT, about
+ * 26 %/m; keeps the cart near the track centre below ~0.2 Hz. The applied
+ * power is recorded, so the loop does not bias the measured response. */
+#define EXC_KX_NUM     5
+#define EXC_KX_SHIFT   5
+
+
+/* Name: EXC_kind_type
+ *
+ * Description: excitation signals
+ *
+ * Members: eEXC_CHIRP - exponential sine sweep from f0 to f1 over the run
+ *                       (f0 == f1: fixed sine)
+ *          eEXC_PRBS  - maximum length binary sequence, +/- amplitude,
+ *                       held for a number of control periods per bit;
+ *                       periodic, period (2^order - 1) * hold
+ *
+ * Notes:
+ *
+ */
+typedef enum
+{
+	eEXC_CHIRP = 0,
+	eEXC_PRBS,
+	eEXC_MAX,
+} EXC_kind_type;
+
+
+/* Name: EXC_cfg_type
+ *
+ * Description: excitation request
+ *
+ * Members: kind - signal (EXC_kind_type)
+ *          amp  - amplitude (% power, 1 to EXC_AMP_MAX)
+ *          p1   - chirp: start frequency (1/EXC_F_SCALE Hz);
+ *                 PRBS: register length (EXC_PRBS_MIN to EXC_PRBS_MAX)
+ *          p2   - chirp: end frequency (1/EXC_F_SCALE Hz, >= p1);
+ *                 PRBS: control periods per bit (>= 1)
+ *          len  - run length (control periods); 0 cancels
+ *
+ * Notes:
+ *
+ */
+struct EXC_cfg_type
+{
+	uint8_t kind;
+	uint8_t amp;
+	uint16_t p1;
+	uint16_t p2;
+	uint32_t len;
+};
+
+
+/* Name: EXC_type
+ *
+ * Description: excitation generator state
+ *
+ * Members: pending - request accepted, waiting for STATE_EXCITE; set by
+ *                    EXC_Request, cleared when the run starts
+ *          cancel  - stop the running sequence at the next period
+ *          cfg     - request
+ *          amp_q15 - amplitude (Q15 power)
+ *          left    - control periods left in the run
+ *          phase   - chirp phase (2^32 per turn)
+ *          inc     - chirp phase increment per control period (32.32:
+ *                    the upper word is added to phase)
+ *          inc0    - chirp start increment (32.32)
+ *          rate    - chirp increment growth per control period (Q32)
+ *          lfsr    - PRBS register
+ *          taps    - PRBS feedback taps
+ *          hold    - PRBS control periods left on the current bit
+ *
+ * Notes:
+ *
+ */
+struct EXC_type
+{
+	volatile uint32_t pending;
+	volatile uint32_t cancel;
+	struct EXC_cfg_type cfg;
+	int32_t amp_q15;
+	uint32_t left;
+	uint32_t phase;
+	uint64_t inc;
+	uint64_t inc0;
+	uint32_t rate;
+	uint32_t lfsr;
+	uint32_t taps;
+	uint32_t hold;
+};
+
+
+#endif /* EXC_EXC_DEFS_H_ */
@@ -0,0 +1,203 @@
+/*
+ * exc_gen.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Milos Lazic
+ *
+ *  Excitation generator run in STATE_EXCITE (see exc_defs.h). A request
+ *  is accepted in any state and started by the FSM from STATE_SWINGUP,
+ *  i.e. after calibration; the run ends in STATE_CALIB, which re-homes
+ *  the cart. The collision predictor stays active throughout.
+ *
+ *  Recording: arm the scope (eCMD_ID_SCOPE_ARM) on channels x and power
+ *  with a LEVEL trigger, rising edge, on the state channel at
+ *  eFSM_STATE_EXCITE, then send eCMD_ID_EXCITE; host/frf/frf.c computes
+ *  the frequency response from the decoded capture(s). At full rate one
+ *  encoder count per period is 0.18 m/s, so the velocity is mostly
+ *  quantization noise; a decimation of about 10 (2048 samples of 1 ms)
+ *  covers belt modes up to a few hundred Hz with useful coherence.
+ */
+
+#include <math.h>
+#include "exc.h"
+#include "../fsm/fsm_defs.h"
+#include "../sys/device/device.h"
+
+
+static struct EXC_type exc = { .pending = 0, .cancel = 0, .left = 0 };
+
+
+/*
+ * Name: EXC_sin_q15
+ *
+ * Descr: Sine of a phase through the quarter-wave table
+ *
+ * Args:     phase - phase (2^32 per turn)
+ *
+ * Return:   sine, Q15
+ *
+ * Notes:
+ *
+ */
+static int32_t EXC_sin_q15( uint32_t phase)
+{
+	uint32_t i = ( phase >> (30 - EXC_SIN_BITS)) & ((1u << EXC_SIN_BITS) - 1);
+	int32_t s;
+
+	/* quadrants 1 and 3 run the table backwards, 2 and 3 negate */
+	s = ( phase & 0x40000000u) ? exc_sin_tab[(1u << EXC_SIN_BITS) - i] : exc_sin_tab[i];
+
+	return ( phase & 0x80000000u) ? -s : s;
+}
+
+
+/*
+ * Name: EXC_Request
+ *
+ * Descr: Validates and stores an excitation request
+ *
+ * Args:     cfg - request; len 0 cancels a pending or running excitation
+ *
+ * Return:   0 on success, -1 if the request is invalid
+ *
+ * Notes: Control period context (CMD_Drain). The chirp growth rate is
+ *        computed here, once, so that EXC_Run does integer work only. A
+ *        request during a run restarts it with the new signal.
+ *
+ */
+int EXC_Request( const struct EXC_cfg_type *cfg)
+{
+	double f0, f1, rate;
+
+	if ( cfg->len == 0)
+	{
+		exc.pending = 0;
+		exc.cancel = 1;
+		return 0;
+	}
+
+	if ( cfg->kind >= eEXC_MAX || cfg->amp == 0 || cfg->amp > EXC_AMP_MAX)
+		return -1;
+
+	if ( cfg->kind == eEXC_CHIRP)
+	{
+		f0 = (double)cfg->p1/EXC_F_SCALE;
+		f1 = (double)cfg->p2/EXC_F_SCALE;
+		if ( cfg->p1 == 0 || f1 < f0 || f1 > EXC_F_MAX)
+			return -1;
+
+		rate = exp( log( f1/f0)/cfg->len) - 1.0;
+		if ( rate >= 1.0)
+			return -1;
+
+		exc.inc0 = (uint64_t)(f0/EXC_TICK_HZ*18446744073709551616.0);
+		exc.rate = (uint32_t)(rate*4294967296.0 + 0.5);
+	}
+	else
+	{
+		if ( cfg->p1 < EXC_PRBS_MIN || cfg->p1 > EXC_PRBS_MAX || cfg->p2 == 0)
+			return -1;
+
+		exc.taps = exc_prbs_taps[cfg->p1];
+	}
+
+	exc.cfg = *cfg;
+	exc.amp_q15 = (int32_t)cfg->amp*32768/100;
+	exc.cancel = 0;
+	exc.pending = 1;
+
+	return 0;
+}
+
+
+/*
+ * Name: EXC_Pending
+ *
+ * Descr: Tells whether an accepted request waits to be started
+ *
+ * Args:     none
+ *
+ * Return:   non-zero if a request is pending
+ *
+ * Notes:
+ *
+ */
+uint32_t EXC_Pending( void)
+{
+	return exc.pending;
+}
+
+
+/*
+ * Name: EXC_Run
+ *
+ * Descr: Stages the next excitation sample as motor power
+ *
+ * Args:     none
+ *
+ * Return:   non-zero once the run is over (motor off)
+ *
+ * Notes: Called once per control period in STATE_EXCITE; starts a pending
+ *        request. Same instruction path every period: table lookups, two
+ *        32 x 32 bit multiplies, no floating point. The chirp increment is
+ *        kept in 32.32 so that the growth of the low order bits is not
+ *        truncated away each period (that loss compounds: 0.1 -> 10 Hz
+ *        over 100000 periods ended at 7.6 Hz); the sweep ends at p2.
+ *
+ */
+uint32_t EXC_Run( void)
+{
+	int32_t u, x;
+	uint32_t lsb;
+
+	if ( exc.pending)
+	{
+		exc.left = exc.cfg.len;
+		exc.phase = 0;
+		exc.inc = exc.inc0;
+		exc.lfsr = 1;
+		exc.hold = 1;
+		exc.pending = 0;
+		exc.cancel = 0;
+	}
+
+	if ( exc.cancel || exc.left == 0)
+	{
+		dev_ioctl(eDEV_ESC0, eESC_IOCTL_SET_POWER, 0);
+		return 1;
+	}
+	exc.left--;
+
+	if ( exc.cfg.kind == eEXC_CHIRP)
+	{
+		u = EXC_sin_q15( exc.phase);
+		exc.phase += (uint32_t)(exc.inc >> 32);
+		exc.inc += (exc.inc >> 32)*exc.rate + (((exc.inc & 0xFFFFFFFFu)*exc.rate) >> 32);
+	}
+	else
+	{
+		if ( --exc.hold == 0)
+		{
+			exc.hold = exc.cfg.p2;
+			lsb = exc.lfsr & 1;
+			exc.lfsr >>= 1;
+			if ( lsb)
+				exc.lfsr ^= exc.taps;
+		}
+		u = ( exc.lfsr & 1) ? 32767 : -32767;
+	}
+	u = ( u*exc.amp_q15) >> 15;
+
+	/* weak centring; pushes towards x = 0 */
+	x = (int32_t)dev_ioctl(eDEV_QEI1, eQEI_IOCTL_R_POS);
+	u += -FSM_CART_POWER_DIR * (( EXC_KX_NUM*x) >> EXC_KX_SHIFT);
+
+	if ( u > 32767)
+		u = 32767;
+	else if ( u < -32767)
+		u = -32767;
+
+	dev_ioctl(eDEV_ESC0, eESC_IOCTL_SET_POWER_Q15, u);
+
+	return 0;
+}
@@ -0,0 +1,26 @@
+/*
+ * exc_proto.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Milos Lazic
+ */
+
+#ifndef EXC_EXC_PROTO_H_
+#define EXC_EXC_PROTO_H_
+
+
+#include <stdint.h>
+#include "exc_defs.h"
+
+
+/* module scope data (exc_table.c) */
+extern const int16_t exc_sin_tab[(1u << EXC_SIN_BITS) + 1];
+extern const uint16_t exc_prbs_taps[EXC_PRBS_MAX + 1];
+
+/* global scope routines */
+extern int EXC_Request( const struct EXC_cfg_type *cfg);
+extern uint32_t EXC_Pending( void);
+extern uint32_t EXC_Run( void);
+
+
+#endif /* EXC_EXC_PROTO_H_ */
@@ -137,179 +137,169 @@ static const struct fl_mf_pt_type PL_mf_map[] = {
 #define PL_MF_MAP_LEN (sizeof(PL_mf_map)/sizeof(PL_mf_map[0]))
 
 
-/* membership functions for system input: error */
-struct fl_mf_type sysin_error_membership_functions[] =
+/* system inputs; membership functions (IMPORTANT: order of entries must match enumeration IO_MEMBERSHIP) */
+static DEV_STATE_CLASS struct fl_io_type System_Inputs[] =
 {
-		/* IMPORTANT: order of entries must match enumeration IO_MEMBERSHIP */
-		{ .name = "error_NL", .value = 0, .map = NL_mf_map, .map_len = NL_MF_MAP_LEN },
-		{ .name = "error_NM", .value = 0, .map = NM_mf_map, .map_len = NM_MF_MAP_LEN },
-		{ .name = "error_NS", .value = 0, .map = NS_mf_map, .map_len = NS_MF_MAP_LEN },
-		{ .name = "error_ZE", .value = 0, .map = ZE_mf_map, .map_len = ZE_MF_MAP_LEN },
-		{ .name = "error_PS", .value = 0, .map = PS_mf_map, .map_len = PS_MF_MAP_LEN },
-		{ .name = "error_PM", .value = 0, .map = PM_mf_map, .map_len = PM_MF_MAP_LEN },
-		{ .name = "error_PL", .value = 0, .map = PL_mf_map, .map_len = PL_MF_MAP_LEN },
-};
-#define SYSIN_ERROR_MAX_MF (sizeof(sysin_error_membership_functions)/sizeof(sysin_error_membership_functions[0]))
-
-
-/* membership functions for system input: derror (derivative of errror) */
-struct fl_mf_type sysin_derror_membership_functions[] =
-{
-		/* IMPORTANT: order of entries must match enumeration IO_MEMBERSHIP */
-		{ .name = "derror_NL", .value = 0, .map = NL_mf_map, .map_len = NL_MF_MAP_LEN },
-		{ .name = "derror_NM", .value = 0, .map = NM_mf_map, .map_len = NM_MF_MAP_LEN },
-		{ .name = "derror_NS", .value = 0, .map = NS_mf_map, .map_len = NS_MF_MAP_LEN },
-		{ .name = "derror_ZE", .value = 0, .map = ZE_mf_map, .map_len = ZE_MF_MAP_LEN },
-		{ .name = "derror_PS", .value = 0, .map = PS_mf_map, .map_len = PS_MF_MAP_LEN },
-		{ .name = "derror_PM", .value = 0, .map = PM_mf_map, .map_len = PM_MF_MAP_LEN },
-		{ .name = "derror_PL", .value = 0, .map = PL_mf_map, .map_len = PL_MF_MAP_LEN },
-};
-#define SYSIN_DERROR_MAX_MF (sizeof(sysin_derror_membership_functions)/sizeof(sysin_derror_membership_functions[0]))
-
-/* system inputs */
-static struct fl_io_type System_Inputs[] =
-{
-		{ .name = "error",   .value = 0, .membership_functions = sysin_error_membership_functions,  .num_membership_functions = SYSIN_ERROR_MAX_MF },
-		{ .name = "derror",  .value = 0, .membership_functions = sysin_derror_membership_functions, .num_membership_functions = SYSIN_DERROR_MAX_MF },
+		{ .name = "error", .value = 0, .num_membership_functions = eIOM_MAX,
+		  .membership_functions =
+			{
+				{ .name = "error_NL", .value = 0, .map = NL_mf_map, .map_len = NL_MF_MAP_LEN },
+				{ .name = "error_NM", .value = 0, .map = NM_mf_map, .map_len = NM_MF_MAP_LEN },
+				{ .name = "error_NS", .value = 0, .map = NS_mf_map, .map_len = NS_MF_MAP_LEN },
+				{ .name = "error_ZE", .value = 0, .map = ZE_mf_map, .map_len = ZE_MF_MAP_LEN },
+				{ .name = "error_PS", .value = 0, .map = PS_mf_map, .map_len = PS_MF_MAP_LEN },
+				{ .name = "error_PM", .value = 0, .map = PM_mf_map, .map_len = PM_MF_MAP_LEN },
+				{ .name = "error_PL", .value = 0, .map = PL_mf_map, .map_len = PL_MF_MAP_LEN },
+			},
+		},
+		{ .name = "derror", .value = 0, .num_membership_functions = eIOM_MAX,
+		  .membership_functions =
+			{
+				{ .name = "derror_NL", .value = 0, .map = NL_mf_map, .map_len = NL_MF_MAP_LEN },
+				{ .name = "derror_NM", .value = 0, .map = NM_mf_map, .map_len = NM_MF_MAP_LEN },
+				{ .name = "derror_NS", .value = 0, .map = NS_mf_map, .map_len = NS_MF_MAP_LEN },
+				{ .name = "derror_ZE", .value = 0, .map = ZE_mf_map, .map_len = ZE_MF_MAP_LEN },
+				{ .name = "derror_PS", .value = 0, .map = PS_mf_map, .map_len = PS_MF_MAP_LEN },
+				{ .name = "derror_PM", .value = 0, .map = PM_mf_map, .map_len = PM_MF_MAP_LEN },
+				{ .name = "derror_PL", .value = 0, .map = PL_mf_map, .map_len = PL_MF_MAP_LEN },
+			},
+		},
 };
 #define FLC_BALANCE_MAX_INPUTS (sizeof(System_Inputs)/sizeof(System_Inputs[0]))
 
 
 
-/* membership functions for system output: force */
-struct fl_mf_type sysout_force_membership_functions[] =
-{
-		/* IMPORTANT: order of entries must match enumeration IO_MEMBERSHIP */
-		{ .name = "force_NL", .value = 0, .map = NL_mf_map, .map_len = NL_MF_MAP_LEN },
-		{ .name = "force_NM", .value = 0, .map = NM_mf_map, .map_len = NM_MF_MAP_LEN },
-		{ .name = "force_NS", .value = 0, .map = NS_mf_map, .map_len = NS_MF_MAP_LEN },
-		{ .name = "force_ZE", .value = 0, .map = ZE_mf_map, .map_len = ZE_MF_MAP_LEN },
-		{ .name = "force_PS", .value = 0, .map = PS_mf_map, .map_len = PS_MF_MAP_LEN },
-		{ .name = "force_PM", .value = 0, .map = PM_mf_map, .map_len = PM_MF_MAP_LEN },
-		{ .name = "force_PL", .value = 0, .map = PL_mf_map, .map_len = PL_MF_MAP_LEN },
-};
-#define SYSOUT_FORCE_MAX_MF (sizeof(sysout_force_membership_functions)/sizeof(sysout_force_membership_functions[0]))
-
-/* system outputs */
-static struct fl_io_type System_Outputs[] =
+/* system outputs; membership functions (IMPORTANT: order of entries must match enumeration IO_MEMBERSHIP) */
+static DEV_STATE_CLASS struct fl_io_type System_Outputs[] =
 {
-		{ .name = "force", .value = 0, .membership_functions = sysout_force_membership_functions, .num_membership_functions = SYSOUT_FORCE_MAX_MF },
+		{ .name = "force", .value = 0, .num_membership_functions = eIOM_MAX,
+		  .membership_functions =
+			{
+				{ .name = "force_NL", .value = 0, .map = NL_mf_map, .map_len = NL_MF_MAP_LEN },
+				{ .name = "force_NM", .value = 0, .map = NM_mf_map, .map_len = NM_MF_MAP_LEN },
+				{ .name = "force_NS", .value = 0, .map = NS_mf_map, .map_len = NS_MF_MAP_LEN },
+				{ .name = "force_ZE", .value = 0, .map = ZE_mf_map, .map_len = ZE_MF_MAP_LEN },
+				{ .name = "force_PS", .value = 0, .map = PS_mf_map, .map_len = PS_MF_MAP_LEN },
+				{ .name = "force_PM", .value = 0, .map = PM_mf_map, .map_len = PM_MF_MAP_LEN },
+				{ .name = "force_PL", .value = 0, .map = PL_mf_map, .map_len = PL_MF_MAP_LEN },
+			},
+		},
 };
 #define FLC_BALANCE_MAX_OUTPUTS (sizeof(System_Outputs)/sizeof(System_Outputs[0]))
 
 
 
-const struct fl_rule_type Rule_Set[] = {
+static const struct fl_rule_type Rule_Set[] = {
 		/* IF (error is NL) AND (derror is NL) THEN (force is NL) */
-		{ .if_side_pvals = { &(sysin_error_membership_functions[eIOM_NL].value), &(sysin_derror_membership_functions[eIOM_NL].value) }, .then_side_pvals = &(sysout_force_membership_functions[eIOM_NL].value) },
+		{ .if_side_mf = { eIOM_NL, eIOM_NL }, .then_side_mf = eIOM_NL },
 		/* IF (error is NL) AND (derror is ZE) THEN (force is NL) */
-		{ .if_side_pvals = { &(sysin_error_membership_functions[eIOM_NL].value), &(sysin_derror_membership_functions[eIOM_ZE].value) }, .then_side_pvals = &(sysout_force_membership_functions[eIOM_NL].value) },
+		{ .if_side_mf = { eIOM_NL, eIOM_ZE }, .then_side_mf = eIOM_NL },
 		/* IF (error is NM) AND (derror is NM) THEN (force is NM) */
-		{ .if_side_pvals = { &(sysin_error_membership_functions[eIOM_NM].value), &(sysin_derror_membership_functions[eIOM_NM].value) }, .then_side_pvals = &(sysout_force_membership_functions[eIOM_NM].value) },
+		{ .if_side_mf = { eIOM_NM, eIOM_NM }, .then_side_mf = eIOM_NM },
 		/* IF (error is NM) AND (derror is ZE) THEN (force is NM) */
-		{ .if_side_pvals = { &(sysin_error_membership_functions[eIOM_NM].value), &(sysin_derror_membership_functions[eIOM_ZE].value) }, .then_side_pvals = &(sysout_force_membership_functions[eIOM_NM].value) },
+		{ .if_side_mf = { eIOM_NM, eIOM_ZE }, .then_side_mf = eIOM_NM },
 		/* IF (error is NS) AND (derror is NS) THEN (force is NS) */
-		{ .if_side_pvals = { &(sysin_error_membership_functions[eIOM_NS].value), &(sysin_derror_membership_functions[eIOM_NS].value) }, .then_side_pvals = &(sysout_force_membership_functions[eIOM_NS].value) },
+		{ .if_side_mf = { eIOM_NS, eIOM_NS }, .then_side_mf = eIOM_NS },
 		/* IF (error is NS) AND (derror is ZE) THEN (force is NS) */
-		{ .if_side_pvals = { &(sysin_error_membership_functions[eIOM_NS].value), &(sysin_derror_membership_functions[eIOM_ZE].value) }, .then_side_pvals = &(sysout_force_membership_functions[eIOM_NS].value) },
+		{ .if_side_mf = { eIOM_NS, eIOM_ZE }, .then_side_mf = eIOM_NS },
 		/* IF (error is ZE) AND (derror is NL) THEN (force is NL) */
-		{ .if_side_pvals = { &(sysin_error_membership_functions[eIOM_ZE].value), &(sysin_derror_membership_functions[eIOM_NL].value) }, .then_side_pvals = &(sysout_force_membership_functions[eIOM_NL].value) },
+		{ .if_side_mf = { eIOM_ZE, eIOM_NL }, .then_side_mf = eIOM_NL },
 		/* IF (error is ZE) AND (derror is NM) THEN (force is NM) */
-		{ .if_side_pvals = { &(sysin_error_membership_functions[eIOM_ZE].value), &(sysin_derror_membership_functions[eIOM_NM].value) }, .then_side_pvals = &(sysout_force_membership_functions[eIOM_NM].value) },
+		{ .if_side_mf = { eIOM_ZE, eIOM_NM }, .then_side_mf = eIOM_NM },
 		/* IF (error is ZE) AND (derror is NS) THEN (force is NS) */
-		{ .if_side_pvals = { &(sysin_error_membership_functions[eIOM_ZE].value), &(sysin_derror_membership_functions[eIOM_NS].value) }, .then_side_pvals = &(sysout_force_membership_functions[eIOM_NS].value) },
+		{ .if_side_mf = { eIOM_ZE, eIOM_NS }, .then_side_mf = eIOM_NS },
 		/* IF (error is ZE) AND (derror is ZE) THEN (force is ZE) */
-		{ .if_side_pvals = { &(sysin_error_membership_functions[eIOM_ZE].value), &(sysin_derror_membership_functions[eIOM_ZE].value) }, .then_side_pvals = &(sysout_force_membership_functions[eIOM_ZE].value) },
+		{ .if_side_mf = { eIOM_ZE, eIOM_ZE }, .then_side_mf = eIOM_ZE },
 		/* IF (error is ZE) AND (derror is PS) THEN (force is PS) */
-		{ .if_side_pvals = { &(sysin_error_membership_functions[eIOM_ZE].value), &(sysin_derror_membership_functions[eIOM_PS].value) }, .then_side_pvals = &(sysout_force_membership_functions[eIOM_PS].value) },
+		{ .if_side_mf = { eIOM_ZE, eIOM_PS }, .then_side_mf = eIOM_PS },
 		/* IF (error is ZE) AND (derror is PM) THEN (force is PM) */
-		{ .if_side_pvals = { &(sysin_error_membership_functions[eIOM_ZE].value), &(sysin_derror_membership_functions[eIOM_PM].value) }, .then_side_pvals = &(sysout_force_membership_functions[eIOM_PM].value) },
+		{ .if_side_mf = { eIOM_ZE, eIOM_PM }, .then_side_mf = eIOM_PM },
 		/* IF (error is ZE) AND (derror is PL) THEN (force is PL) */
-		{ .if_side_pvals = { &(sysin_error_membership_functions[eIOM_ZE].value), &(sysin_derror_membership_functions[eIOM_PL].value) }, .then_side_pvals = &(sysout_force_membership_functions[eIOM_PL].value) },
+		{ .if_side_mf = { eIOM_ZE, eIOM_PL }, .then_side_mf = eIOM_PL },
 		/* IF (error is PS) AND (derror is ZE) THEN (force is PS) */
-		{ .if_side_pvals = { &(sysin_error_membership_functions[eIOM_PS].value), &(sysin_derror_membership_functions[eIOM_ZE].value) }, .then_side_pvals = &(sysout_force_membership_functions[eIOM_PS].value) },
+		{ .if_side_mf = { eIOM_PS, eIOM_ZE }, .then_side_mf = eIOM_PS },
 		/* IF (error is PS) AND (derror is PS) THEN (force is PS) */
-		{ .if_side_pvals = { &(sysin_error_membership_functions[eIOM_PS].value), &(sysin_derror_membership_functions[eIOM_PS].value) }, .then_side_pvals = &(sysout_force_membership_functions[eIOM_PS].value) },
+		{ .if_side_mf = { eIOM_PS, eIOM_PS }, .then_side_mf = eIOM_PS },
 		/* IF (error is PM) AND (derror is ZE) THEN (force is PM) */
-		{ .if_side_pvals = { &(sysin_error_membership_functions[eIOM_PM].value), &(sysin_derror_membership_functions[eIOM_ZE].value) }, .then_side_pvals = &(sysout_force_membership_functions[eIOM_PM].value) },
+		{ .if_side_mf = { eIOM_PM, eIOM_ZE }, .then_side_mf = eIOM_PM },
 		/* IF (error is PM) AND (derror is PM) THEN (force is PM) */
-		{ .if_side_pvals = { &(sysin_error_membership_functions[eIOM_PM].value), &(sysin_derror_membership_functions[eIOM_PM].value) }, .then_side_pvals = &(sysout_force_membership_functions[eIOM_PM].value) },
+		{ .if_side_mf = { eIOM_PM, eIOM_PM }, .then_side_mf = eIOM_PM },
 		/* IF (error is PL) AND (derror is ZE) THEN (force is PL) */
-		{ .if_side_pvals = { &(sysin_error_membership_functions[eIOM_PL].value), &(sysin_derror_membership_functions[eIOM_ZE].value) }, .then_side_pvals = &(sysout_force_membership_functions[eIOM_PL].value) },
+		{ .if_side_mf = { eIOM_PL, eIOM_ZE }, .then_side_mf = eIOM_PL },
 		/* IF (error is PL) AND (derror is PL) THEN (force is PL) */
-		{ .if_side_pvals = { &(sysin_error_membership_functions[eIOM_PL].value), &(sysin_derror_membership_functions[eIOM_PL].value) }, .then_side_pvals = &(sysout_force_membership_functions[eIOM_PL].value) },
+		{ .if_side_mf = { eIOM_PL, eIOM_PL }, .then_side_mf = eIOM_PL },
 
 
 		/* IF (error is PL) AND (derror is NL) THEN (force is ZE) */
-		{ .if_side_pvals = { &(sysin_error_membership_functions[eIOM_PL].value), &(sysin_derror_membership_functions[eIOM_NL].value) }, .then_side_pvals = &(sysout_force_membership_functions[eIOM_ZE].value) },
+		{ .if_side_mf = { eIOM_PL, eIOM_NL }, .then_side_mf = eIOM_ZE },
 		/* IF (error is PM) AND (derror is NM) THEN (force is ZE) */
-		{ .if_side_pvals = { &(sysin_error_membership_functions[eIOM_PM].value), &(sysin_derror_membership_functions[eIOM_NM].value) }, .then_side_pvals = &(sysout_force_membership_functions[eIOM_ZE].value) },
+		{ .if_side_mf = { eIOM_PM, eIOM_NM }, .then_side_mf = eIOM_ZE },
 		/* IF (error is PS) AND (derror is NS) THEN (force is ZE) */
-		{ .if_side_pvals = { &(sysin_error_membership_functions[eIOM_PS].value), &(sysin_derror_membership_functions[eIOM_NS].value) }, .then_side_pvals = &(sysout_force_membership_functions[eIOM_ZE].value) },
+		{ .if_side_mf = { eIOM_PS, eIOM_NS }, .then_side_mf = eIOM_ZE },
 		/* IF (error is NS) AND (derror is PS) THEN (force is ZE) */
-		{ .if_side_pvals = { &(sysin_error_membership_functions[eIOM_NS].value), &(sysin_derror_membership_functions[eIOM_PS].value) }, .then_side_pvals = &(sysout_force_membership_functions[eIOM_ZE].value) },
+		{ .if_side_mf = { eIOM_NS, eIOM_PS }, .then_side_mf = eIOM_ZE },
 		/* IF (error is NM) AND (derror is PM) THEN (force is ZE) */
-		{ .if_side_pvals = { &(sysin_error_membership_functions[eIOM_NM].value), &(sysin_derror_membership_functions[eIOM_PM].value) }, .then_side_pvals = &(sysout_force_membership_functions[eIOM_ZE].value) },
+		{ .if_side_mf = { eIOM_NM, eIOM_PM }, .then_side_mf = eIOM_ZE },
 		/* IF (error is NL) AND (derror is PM) THEN (force is ZE) */
-		{ .if_side_pvals = { &(sysin_error_membership_functions[eIOM_NL].value), &(sysin_derror_membership_functions[eIOM_PL].value) }, .then_side_pvals = &(sysout_force_membership_functions[eIOM_ZE].value) },
+		{ .if_side_mf = { eIOM_NL, eIOM_PL }, .then_side_mf = eIOM_ZE },
 
 
 		/* IF (error is NM) AND (derror is NL) THEN (force is NL) */
-		{ .if_side_pvals = { &(sysin_error_membership_functions[eIOM_NM].value), &(sysin_derror_membership_functions[eIOM_NL].value) }, .then_side_pvals = &(sysout_force_membership_functions[eIOM_NL].value) },
+		{ .if_side_mf = { eIOM_NM, eIOM_NL }, .then_side_mf = eIOM_NL },
 		/* IF (error is NS) AND (derror is NL) THEN (force is NL) */
-		{ .if_side_pvals = { &(sysin_error_membership_functions[eIOM_NS].value), &(sysin_derror_membership_functions[eIOM_NL].value) }, .then_side_pvals = &(sysout_force_membership_functions[eIOM_NL].value) },
+		{ .if_side_mf = { eIOM_NS, eIOM_NL }, .then_side_mf = eIOM_NL },
 		/* IF (error is PS) AND (derror is NL) THEN (force is NM) */
-		{ .if_side_pvals = { &(sysin_error_membership_functions[eIOM_PS].value), &(sysin_derror_membership_functions[eIOM_NL].value) }, .then_side_pvals = &(sysout_force_membership_functions[eIOM_NM].value) },
+		{ .if_side_mf = { eIOM_PS, eIOM_NL }, .then_side_mf = eIOM_NM },
 		/* IF (error is PM) AND (derror is NL) THEN (force is NS) */
-		{ .if_side_pvals = { &(sysin_error_membership_functions[eIOM_PM].value), &(sysin_derror_membership_functions[eIOM_NL].value) }, .then_side_pvals = &(sysout_force_membership_functions[eIOM_NS].value) },
+		{ .if_side_mf = { eIOM_PM, eIOM_NL }, .then_side_mf = eIOM_NS },
 
 
 		/* IF (error is NM) AND (derror is PL) THEN (force is PS) */
-		{ .if_side_pvals = { &(sysin_error_membership_functions[eIOM_NM].value), &(sysin_derror_membership_functions[eIOM_PL].value) }, .then_side_pvals = &(sysout_force_membership_functions[eIOM_PS].value) },
+		{ .if_side_mf = { eIOM_NM, eIOM_PL }, .then_side_mf = eIOM_PS },
 		/* IF (error is NS) AND (derror is PL) THEN (force is PM) */
-		{ .if_side_pvals = { &(sysin_error_membership_functions[eIOM_NS].value), &(sysin_derror_membership_functions[eIOM_PL].value) }, .then_side_pvals = &(sysout_force_membership_functions[eIOM_PM].value) },
+		{ .if_side_mf = { eIOM_NS, eIOM_PL }, .then_side_mf = eIOM_PM },
 		/* IF (error is PS) AND (derror is PL) THEN (force is PL) */
-		{ .if_side_pvals = { &(sysin_error_membership_functions[eIOM_PS].value), &(sysin_derror_membership_functions[eIOM_PL].value) }, .then_side_pvals = &(sysout_force_membership_functions[eIOM_PL].value) },
+		{ .if_side_mf = { eIOM_PS, eIOM_PL }, .then_side_mf = eIOM_PL },
 		/* IF (error is PM) AND (derror is PL) THEN (force is PL) */
-		{ .if_side_pvals = { &(sysin_error_membership_functions[eIOM_PM].value), &(sysin_derror_membership_functions[eIOM_PL].value) }, .then_side_pvals = &(sysout_force_membership_functions[eIOM_PL].value) },
+		{ .if_side_mf = { eIOM_PM, eIOM_PL }, .then_side_mf = eIOM_PL },
 
 
 		/* IF (error is NL) AND (derror is NM) THEN (force is NL) */
-		{ .if_side_pvals = { &(sysin_error_membership_functions[eIOM_NL].value), &(sysin_derror_membership_functions[eIOM_NM].value) }, .then_side_pvals = &(sysout_force_membership_functions[eIOM_NL].value) },
+		{ .if_side_mf = { eIOM_NL, eIOM_NM }, .then_side_mf = eIOM_NL },
 		/* IF (error is NL) AND (derror is NS) THEN (force is NL) */
-		{ .if_side_pvals = { &(sysin_error_membership_functions[eIOM_NL].value), &(sysin_derror_membership_functions[eIOM_NS].value) }, .then_side_pvals = &(sysout_force_membership_functions[eIOM_NL].value) },
+		{ .if_side_mf = { eIOM_NL, eIOM_NS }, .then_side_mf = eIOM_NL },
 		/* IF (error is NL) AND (derror is PS) THEN (force is NM) */
-		{ .if_side_pvals = { &(sysin_error_membership_functions[eIOM_NL].value), &(sysin_derror_membership_functions[eIOM_PS].value) }, .then_side_pvals = &(sysout_force_membership_functions[eIOM_NM].value) },
+		{ .if_side_mf = { eIOM_NL, eIOM_PS }, .then_side_mf = eIOM_NM },
 		/* IF (error is NL) AND (derror is PM) THEN (force is NS) */
-		{ .if_side_pvals = { &(sysin_error_membership_functions[eIOM_NL].value), &(sysin_derror_membership_functions[eIOM_PM].value) }, .then_side_pvals = &(sysout_force_membership_functions[eIOM_NS].value) },
+		{ .if_side_mf = { eIOM_NL, eIOM_PM }, .then_side_mf = eIOM_NS },
 
 
 		/* IF (error is PL) AND (derror is NM) THEN (force is PS) */
-		{ .if_side_pvals = { &(sysin_error_membership_functions[eIOM_PL].value), &(sysin_derror_membership_functions[eIOM_NM].value) }, .then_side_pvals = &(sysout_force_membership_functions[eIOM_PS].value) },
+		{ .if_side_mf = { eIOM_PL, eIOM_NM }, .then_side_mf = eIOM_PS },
 		/* IF (error is PL) AND (derror is NS) THEN (force is PM) */
-		{ .if_side_pvals = { &(sysin_error_membership_functions[eIOM_PL].value), &(sysin_derror_membership_functions[eIOM_NS].value) }, .then_side_pvals = &(sysout_force_membership_functions[eIOM_PM].value) },
+		{ .if_side_mf = { eIOM_PL, eIOM_NS }, .then_side_mf = eIOM_PM },
 		/* IF (error is PL) AND (derror is PS) THEN (force is PL) */
-		{ .if_side_pvals = { &(sysin_error_membership_functions[eIOM_PL].value), &(sysin_derror_membership_functions[eIOM_PS].value) }, .then_side_pvals = &(sysout_force_membership_functions[eIOM_PL].value) },
+		{ .if_side_mf = { eIOM_PL, eIOM_PS }, .then_side_mf = eIOM_PL },
 		/* IF (error is PL) AND (derror is PM) THEN (force is PL) */
-		{ .if_side_pvals = { &(sysin_error_membership_functions[eIOM_PL].value), &(sysin_derror_membership_functions[eIOM_PM].value) }, .then_side_pvals = &(sysout_force_membership_functions[eIOM_PL].value) },
+		{ .if_side_mf = { eIOM_PL, eIOM_PM }, .then_side_mf = eIOM_PL },
 
 
 		/* IF (error is NS) AND (derror is NM) THEN (force is NM) */
-		{ .if_side_pvals = { &(sysin_error_membership_functions[eIOM_NS].value), &(sysin_derror_membership_functions[eIOM_NM].value) }, .then_side_pvals = &(sysout_force_membership_functions[eIOM_NM].value) },
+		{ .if_side_mf = { eIOM_NS, eIOM_NM }, .then_side_mf = eIOM_NM },
 		/* IF (error is PS) AND (derror is NM) THEN (force is NS) */
-		{ .if_side_pvals = { &(sysin_error_membership_functions[eIOM_PS].value), &(sysin_derror_membership_functions[eIOM_NM].value) }, .then_side_pvals = &(sysout_force_membership_functions[eIOM_NS].value) },
+		{ .if_side_mf = { eIOM_PS, eIOM_NM }, .then_side_mf = eIOM_NS },
 		/* IF (error is NM) AND (derror is NS) THEN (force is NM) */
-		{ .if_side_pvals = { &(sysin_error_membership_functions[eIOM_NM].value), &(sysin_derror_membership_functions[eIOM_NS].value) }, .then_side_pvals = &(sysout_force_membership_functions[eIOM_NM].value) },
+		{ .if_side_mf = { eIOM_NM, eIOM_NS }, .then_side_mf = eIOM_NM },
 		/* IF (error is PM) AND (derror is NS) THEN (force is PS) */
-		{ .if_side_pvals = { &(sysin_error_membership_functions[eIOM_PM].value), &(sysin_derror_membership_functions[eIOM_NS].value) }, .then_side_pvals = &(sysout_force_membership_functions[eIOM_PS].value) },
+		{ .if_side_mf = { eIOM_PM, eIOM_NS }, .then_side_mf = eIOM_PS },
 		/* IF (error is NM) AND (derror is PS) THEN (force is NS) */
-		{ .if_side_pvals = { &(sysin_error_membership_functions[eIOM_NM].value), &(sysin_derror_membership_functions[eIOM_PS].value) }, .then_side_pvals = &(sysout_force_membership_functions[eIOM_NS].value) },
+		{ .if_side_mf = { eIOM_NM, eIOM_PS }, .then_side_mf = eIOM_NS },
 		/* IF (error is PM) AND (derror is PS) THEN (force is PM) */
-		{ .if_side_pvals = { &(sysin_error_membership_functions[eIOM_PM].value), &(sysin_derror_membership_functions[eIOM_PS].value) }, .then_side_pvals = &(sysout_force_membership_functions[eIOM_PM].value) },
+		{ .if_side_mf = { eIOM_PM, eIOM_PS }, .then_side_mf = eIOM_PM },
 		/* IF (error is NS) AND (derror is PM) THEN (force is PS) */
-		{ .if_side_pvals = { &(sysin_error_membership_functions[eIOM_NS].value), &(sysin_derror_membership_functions[eIOM_PM].value) }, .then_side_pvals = &(sysout_force_membership_functions[eIOM_PS].value) },
+		{ .if_side_mf = { eIOM_NS, eIOM_PM }, .then_side_mf = eIOM_PS },
 		/* IF (error is PS) AND (derror is PM) THEN (force is PM) */
-		{ .if_side_pvals = { &(sysin_error_membership_functions[eIOM_PS].value), &(sysin_derror_membership_functions[eIOM_PM].value) }, .then_side_pvals = &(sysout_force_membership_functions[eIOM_PM].value) },
+		{ .if_side_mf = { eIOM_PS, eIOM_PM }, .then_side_mf = eIOM_PM },
 };
 #define FLC_BALANCE_MAX_RULES (sizeof(Rule_Set)/sizeof(Rule_Set[0]))
 
@@ -356,6 +346,8 @@ static void flcBalance_RuleEvaluation( void)
 {
 	int32_t idx_rule = 0, idx_out = 0, idx_mf;
 	struct fl_io_type *p_out = System_Outputs;
+	const struct fl_rule_type *p_rule;
+	struct fl_mf_type *p_mf;
 
 	// reset all output fuzzy variables
 
@@ -376,10 +368,13 @@ static void flcBalance_RuleEvaluation( void)
 	// for each controller rule
 	while( idx_rule < FLC_BALANCE_MAX_RULES)
 	{
+		p_rule = &Rule_Set[idx_rule];
+		p_mf = &p_out[eSO_FORCE].membership_functions[p_rule->then_side_mf];
+
 		/* OUT_STRENGTH = OUT_STRENGTH & (IN1_STRENGTH | IN2_STRENGHT) */
-		*(Rule_Set[idx_rule].then_side_pvals) = fl_OR( *(Rule_Set[idx_rule].then_side_pvals),
-				                                     fl_AND( *(Rule_Set[idx_rule].if_side_pvals[0]),
-				                                    		 *(Rule_Set[idx_rule].if_side_pvals[1])));
+		p_mf->value = fl_OR( p_mf->value,
+		                     fl_AND( System_Inputs[eSI_ERROR].membership_functions[p_rule->if_side_mf[0]].value,
+		                             System_Inputs[eSI_DERROR].membership_functions[p_rule->if_side_mf[1]].value));
 		idx_rule++;
 	}
 
@@ -16,6 +16,7 @@
 #define MIN_INPUT       0
 #define MAX_OUTPUT    255
 #define MIN_OUTPUT      0
+#define MAX_MF          7   /* membership functions per system input/output */
 
 /* FL module data structure prototypes */
 struct fl_io_type;
@@ -39,26 +40,6 @@ struct fl_mf_pt_type {
 };
 
 
-/* Name: fl_io_type
- * Description: controller I/O type
- * Members: name                     - name of system input/output
- *          value                    - current value of system input/output
- *          membership_functions     - pointer to array of membership functions
- *                                     (fuzzy sets) into which the input is classified
- *          num_membership_functions - number of entries in membership function
- *                                     array
- *
- *  Notes:
- */
-struct fl_io_type {
-	const char name[MAXNAME];
-	int32_t value;
-	struct fl_mf_type *membership_functions;
-	const size_t num_membership_functions;
-};
-
-
-
 /* Name: fl_mf_type
  * Description: fuzzy set membership function type
  * Members: name       - name of membership function
@@ -77,24 +58,43 @@ struct fl_mf_type {
 
 
 
+/* Name: fl_io_type
+ * Description: controller I/O type
+ * Members: name                     - name of system input/output
+ *          value                    - current value of system input/output
+ *          membership_functions     - membership functions (fuzzy sets)
+ *                                     into which the input is classified
+ *          num_membership_functions - number of entries used in membership
+ *                                     function array
+ *
+ *  Notes: - the membership functions are held by value, so that an I/O
+ *           (and a controller built of them) owns its state and needs no
+ *           pointers into other state; see DEV_STATE_CLASS
+ */
+struct fl_io_type {
+	const char name[MAXNAME];
+	int32_t value;
+	struct fl_mf_type membership_functions[MAX_MF];
+	const size_t num_membership_functions;
+};
+
+
+
 /* Name: fl_rule_type
  * Description: fuzzy logic rule type
- * Members: if_side_pvals     - pointers to buffers containing values of
- *                              conditions for IF side of rule evaluation
- *                              expression
- *          then_side_pvals   - pointer to buffer in which to save the
- *                              result of the rule evaluation
+ * Members: if_side_mf     - indices of the membership functions (one per
+ *                           system input, in input order) whose values are
+ *                           the conditions of the IF side of the rule
+ *                           evaluation expression
+ *          then_side_mf   - index of the output membership function in
+ *                           which to save the result of the rule evaluation
  *
  *  Notes: - IF (condition1 AND condition2) THEN (output_level_N)
- *         - if_side_pvals array should be initialized to contain
- *           addresses of .value members in input membership function
- *           arrays
- *         - then_side_pvals should be initialized to contain address
- *           of .value member in an output membership function array
+ *         - rules of a controller with a single system output
  */
 struct fl_rule_type {
-	int32_t *if_side_pvals[2];
-	int32_t *then_side_pvals;
+	uint8_t if_side_mf[2];
+	uint8_t then_side_mf;
 };
 
 
@@ -6,108 +6,356 @@
  */
 
 
-#include "inc/tm4c123gh6pm.h"
 #include "fsm.h"
 #include "../sys/device/device.h"
+#include "../sys/systime/systime.h"
+#include "../swingup/swu.h"
+#include "../lqr/lqr.h"
+#include "../fl/fl.h"
+#include "../exc/exc.h"
+#include "../traj/traj.h"
+#include "../ilc/ilc.h"
 
 
-/* macros */
-#define PI    (3.14159265359)   /* pi */
-#define DIA   (60.4)            /* gear diamter (mm) */
-#define PPR   (2400)            /* encoder pulses per revolution */
-
-
-volatile int32_t sv_x;        /* state variable x (position along track) */
-volatile int32_t sv_xdot;     /* state variable xdot (velocity along track) */
-volatile int32_t sv_theta;    /* state variable theta (angular position of pendulum) */
-volatile int32_t sv_thetadot; /* state variable thetadot (angular veolcity of pendulum) */
-
-
-
+/*
+ * Name: init_state_function
+ * Descr: state function of STATE_INIT; motor off, both encoders zeroed
+ *        at the power-on position (refined by the calibration) and the
+ *        calibration sequence re-armed
+ * Args:     none
+ * Return:   none
+ * Notes:    called once from FSM_Init before the control period interrupt
+ *           is started
+ */
 static void init_state_function(void)
 {
-	int32_t sval = 0;
+	dev_ioctl(eDEV_ESC0, eESC_IOCTL_SET_POWER, 0);
 
-	// enable FPU
-	NVIC_CPAC_R |= (0xF << 20);
-
-	// call proximity sensor read subroutine
-	sval = dev_ioctl(eDEV_PRS0, 0); // returns cart distance in mm
-	/* MLAZIC_TBD: error checking required */
-#if 0
-	if ( sval > PRS_READMAX || sval < 0)
-	{
-		// handle error
-	}
-#endif
-
-	// initialize global state variable for track position (sv_x)
-	sv_x = (int32_t)((float)((sval/(PI*DIA))*PPR));
-	// initialize QEI_1_POS with sv_x
-	dev_ioctl(eDEV_QEI1, 1, sv_x);
+	dev_ioctl(eDEV_QEI0, eQEI_IOCTL_W_POS, 0);
+	dev_ioctl(eDEV_QEI1, eQEI_IOCTL_W_POS, 0);
 
+	FSM_Calib_Reset();
 }
 
 
 
 static fsm_event_t state_init_read_event(void)
 {
-	/* MLAZIC_TBD: start systick timer here? */
-
 	return eFSM_EVENT_DONE;
 }
 
 
+static fsm_event_t calib_event = eFSM_EVENT_NONE;
+
+static void state_calib_function(void)
+{
+	calib_event = FSM_Calib_Run();
+}
+
+
 /*
  * Name: state_calib_read_event
  * Descr: event detecting subroutine called while FSM is
  *        in STATE_CALIB (calibration state)
  * Args:     none
- * Return:   event type enumerator (from fsm_event_t enumeration)
- *           of highest-priority event detected
- * Notes:
+ * Return:   eFSM_EVENT_DONE once the calibration sequence has published
+ *           the track constants, eFSM_EVENT_FAIL if it failed,
+ *           eFSM_EVENT_NONE otherwise
+ * Notes:    reports the result of the previous control period's
+ *           calibration step
  */
 static fsm_event_t state_calib_read_event(void)
 {
-	/* MLAZIC_TBD: not yet implemented */
+	fsm_event_t event = calib_event;
 
+	calib_event = eFSM_EVENT_NONE;
+	return event;
+}
 
 
-	return eFSM_EVENT_NONE;
+static void state_swingup_function(void)
+{
+	(void) SWU_CtrlRun();
 }
 
 
+/*
+ * Name: state_swingup_read_event
+ * Descr: event detecting subroutine called while FSM is
+ *        in STATE_SWINGUP (swing-up state)
+ * Args:     none
+ * Return:   eFSM_EVENT_COLLISIONWARN if the cart cannot stop
+ *           before a track end, eFSM_EVENT_EXCITE if an excitation
+ *           run has been requested, eFSM_EVENT_DONE once the swing-up
+ *           controller has captured the pendulum (angle encoder
+ *           re-zeroed to upright), eFSM_EVENT_NONE otherwise
+ * Notes:
+ */
 static fsm_event_t state_swingup_read_event(void)
 {
-	/* MLAZIC_TBD: not yet implemented */
+	if ( FSM_CW_Predict() == eFSM_EVENT_COLLISIONWARN)
+		return eFSM_EVENT_COLLISIONWARN;
+
+	if ( EXC_Pending())
+		return eFSM_EVENT_EXCITE;
+
+	if ( SWU_GetStatus() == eSWU_STATUS_CAPTURED)
+		return eFSM_EVENT_DONE;
+
 	return eFSM_EVENT_NONE;
 }
 
 
+static volatile fsm_ctrl_t balance_ctrl = eFSM_CTRL_LQR;
+static fsm_ctrl_t balance_last = eFSM_CTRL_MAX;
+
+static void state_balance_function(void)
+{
+	fsm_ctrl_t ctrl = balance_ctrl;
+
+	/* the LQR state filters restart whenever the LQR takes over; all
+	 * LQR variants share them */
+	if ( FSM_GetStateTime() == FSM_GetTickTime())
+	{
+		balance_last = eFSM_CTRL_MAX;
+		/* a learning trial interrupted by a fall is abandoned */
+		ILC_Stop();
+	}
+	if ( ctrl != eFSM_CTRL_FL && ( balance_last == eFSM_CTRL_FL || balance_last == eFSM_CTRL_MAX))
+		LQR_Balance_Restart();
+	balance_last = ctrl;
+
+	/* the fuzzy controller does not follow the set point; a learning
+	 * trial has nothing to learn from it */
+	if ( ctrl == eFSM_CTRL_FL)
+		ILC_Stop();
+
+	/* references of this period (set point trajectory) */
+	TRAJ_Run();
+
+	if ( ctrl == eFSM_CTRL_FL)
+		flcBalance_Run();
+	else if ( ctrl == eFSM_CTRL_LQR_EVT)
+		LQR_Balance_CtrlRunEvt();
+	else if ( ctrl == eFSM_CTRL_LQI)
+		LQR_Balance_CtrlRunLQI();
+	else
+		LQR_Balance_CtrlRun();
+}
+
+
 static fsm_event_t state_balance_read_event(void)
 {
-	/* MLAZIC_TBD: not yet implemented */
-	return eFSM_EVENT_NONE;
+	return FSM_CW_Predict();
+}
+
+
+static fsm_event_t emgbrake_event = eFSM_EVENT_NONE;
+
+static void state_emgbrake_function(void)
+{
+	emgbrake_event = FSM_CW_BrakeRun();
 }
 
 
+/*
+ * Name: state_emgbrake_read_event
+ * Descr: event detecting subroutine called while FSM is
+ *        in STATE_EMGBRAKE (emergency braking state)
+ * Args:     none
+ * Return:   eFSM_EVENT_DONE once the braking profile has stopped
+ *           the cart, eFSM_EVENT_NONE otherwise
+ * Notes:    reports the result of the previous control period's
+ *           braking profile
+ */
 static fsm_event_t state_emgbrake_read_event(void)
 {
-	/* MLAZIC_TBD: not yet implemented */
-	return eFSM_EVENT_NONE;
+	fsm_event_t event = emgbrake_event;
+
+	emgbrake_event = eFSM_EVENT_NONE;
+	return event;
+}
+
+
+static fsm_event_t excite_event = eFSM_EVENT_NONE;
+
+static void state_excite_function(void)
+{
+	excite_event = EXC_Run() ? eFSM_EVENT_DONE : eFSM_EVENT_NONE;
+}
+
+
+/*
+ * Name: state_excite_read_event
+ * Descr: event detecting subroutine called while FSM is
+ *        in STATE_EXCITE (open-loop excitation run)
+ * Args:     none
+ * Return:   eFSM_EVENT_COLLISIONWARN if the cart cannot stop
+ *           before a track end, eFSM_EVENT_DONE once the previous
+ *           control period ended the run, eFSM_EVENT_NONE otherwise
+ * Notes:
+ */
+static fsm_event_t state_excite_read_event(void)
+{
+	fsm_event_t event = excite_event;
+
+	excite_event = eFSM_EVENT_NONE;
+	if ( FSM_CW_Predict() == eFSM_EVENT_COLLISIONWARN)
+		return eFSM_EVENT_COLLISIONWARN;
+
+	return event;
 }
 
 
 
 struct fsm_state_struct FSM[eFSM_STATE_MAX] = {
-                                                                                        /* eFSM_EVENT_NONE     eFSM_EVENT_DONE   eFSM_EVENT_FAIL  eFSM_EVENT_COLLISIONWARN*/
-		/* eFSM_STATE_INIT */       { init_state_function, state_init_read_event,     {      eFSM_STATE_INV,   eFSM_STATE_CALIB,   eFSM_STATE_INV,      eFSM_STATE_INV} },
-		/* eFSM_STATE_CALIB */      { NULL, state_calib_read_event,                   {    eFSM_STATE_CALIB, eFSM_STATE_SWINGUP,   eFSM_STATE_INV,      eFSM_STATE_INV} },
-		/* eFSM_STATE_SWINGUP */    { NULL, state_swingup_read_event,                 {  eFSM_STATE_SWINGUP, eFSM_STATE_BALANCE,   eFSM_STATE_INV, eFSM_STATE_EMGBRAKE} },
-		/* eFSM_STATE_BALANCE */    { NULL, state_balance_read_event,                 {  eFSM_STATE_BALANCE,     eFSM_STATE_INV, eFSM_STATE_CALIB, eFSM_STATE_EMGBRAKE} },
-		/* eFSM_STATE_EMGBRAKE */   { NULL, state_emgbrake_read_event,                { eFSM_STATE_EMGBRAKE,   eFSM_STATE_CALIB,   eFSM_STATE_INV,      eFSM_STATE_INV} },
+                                                                                         /*     eFSM_EVENT_NONE     eFSM_EVENT_DONE     eFSM_EVENT_FAIL eFSM_EVENT_COLLISIONWARN   eFSM_EVENT_EXCITE */
+		/* eFSM_STATE_INIT */       { init_state_function,     state_init_read_event,     {      eFSM_STATE_INV,    eFSM_STATE_CALIB,      eFSM_STATE_INV,      eFSM_STATE_INV,      eFSM_STATE_INV} },
+		/* eFSM_STATE_CALIB */      { state_calib_function,    state_calib_read_event,    {    eFSM_STATE_CALIB,  eFSM_STATE_SWINGUP,      eFSM_STATE_INV,      eFSM_STATE_INV,      eFSM_STATE_INV} },
+		/* eFSM_STATE_SWINGUP */    { state_swingup_function,  state_swingup_read_event,  {  eFSM_STATE_SWINGUP,  eFSM_STATE_BALANCE,      eFSM_STATE_INV, eFSM_STATE_EMGBRAKE,   eFSM_STATE_EXCITE} },
+		/* eFSM_STATE_BALANCE */    { state_balance_function,  state_balance_read_event,  {  eFSM_STATE_BALANCE,      eFSM_STATE_INV,    eFSM_STATE_CALIB, eFSM_STATE_EMGBRAKE,      eFSM_STATE_INV} },
+		/* eFSM_STATE_EMGBRAKE */   { state_emgbrake_function, state_emgbrake_read_event, { eFSM_STATE_EMGBRAKE,    eFSM_STATE_CALIB,      eFSM_STATE_INV,      eFSM_STATE_INV,      eFSM_STATE_INV} },
+		/* eFSM_STATE_EXCITE */     { state_excite_function,   state_excite_read_event,   {   eFSM_STATE_EXCITE,    eFSM_STATE_CALIB,      eFSM_STATE_INV, eFSM_STATE_EMGBRAKE,      eFSM_STATE_INV} },
 };
 
 
+static volatile fsm_state_t fsm_cur_state = eFSM_STATE_INIT;
+
+/* timestamps (SYSTIME_Now): start of the current control period (sample
+ * time of the sensor readings taken in it) and entry into the current
+ * state */
+static uint64_t fsm_t_tick = 0;
+static uint64_t fsm_t_state = 0;
+
+
+/*
+ * Name: FSM_Init
+ * Descr: put the FSM into STATE_INIT and run its state function
+ * Args:     none
+ * Return:   none
+ * Notes:    must be called after the devices are initialized and before
+ *           the control period interrupt is started; the first FSM_Run
+ *           moves on to STATE_CALIB
+ */
+void FSM_Init(void)
+{
+	fsm_cur_state = eFSM_STATE_INIT;
+	fsm_t_tick = fsm_t_state = SYSTIME_Now();
+	LQR_Balance_Init();
+	init_state_function();
+}
+
+
+/*
+ * Name: FSM_SetState
+ * Descr: force the FSM into a given state
+ * Args:     state - new state
+ * Return:   none
+ * Notes:    must not be called while FSM_Run may preempt the caller
+ *           (i.e. before the control period interrupt is started)
+ */
+void FSM_SetState(fsm_state_t state)
+{
+	fsm_cur_state = state;
+}
+
+
+/*
+ * Name: FSM_GetState
+ * Descr: read the current FSM state
+ * Args:     none
+ * Return:   current state
+ * Notes:
+ */
+fsm_state_t FSM_GetState(void)
+{
+	return fsm_cur_state;
+}
+
+
+/*
+ * Name: FSM_SetBalanceCtrl
+ * Descr: select the controller run in STATE_BALANCE
+ * Args:     ctrl - controller
+ * Return:   none
+ * Notes:    takes effect on the next control period
+ */
+void FSM_SetBalanceCtrl(fsm_ctrl_t ctrl)
+{
+	if ( ctrl < eFSM_CTRL_MAX)
+		balance_ctrl = ctrl;
+}
 
 
+/*
+ * Name: FSM_GetBalanceCtrl
+ * Descr: read the controller run in STATE_BALANCE
+ * Args:     none
+ * Return:   controller
+ * Notes:
+ */
+fsm_ctrl_t FSM_GetBalanceCtrl(void)
+{
+	return balance_ctrl;
+}
+
+
+/*
+ * Name: FSM_GetTickTime
+ * Descr: read the timestamp of the current control period
+ * Args:     none
+ * Return:   SYSTIME_Now at the start of the latest FSM_Run (cycles)
+ * Notes:    64-bit value written by the control period; read it from the
+ *           control period (or with it masked) to avoid a torn read
+ */
+uint64_t FSM_GetTickTime(void)
+{
+	return fsm_t_tick;
+}
+
+
+/*
+ * Name: FSM_GetStateTime
+ * Descr: read the timestamp of the latest state transition
+ * Args:     none
+ * Return:   control period timestamp (FSM_GetTickTime) of the transition
+ *           into the current state (cycles)
+ * Notes:    see FSM_GetTickTime
+ */
+uint64_t FSM_GetStateTime(void)
+{
+	return fsm_t_state;
+}
+
+
+/*
+ * Name: FSM_Run
+ * Descr: advance the FSM by one control period; reads the event of the
+ *        current state, takes the transition, then runs the state
+ *        function of the (new) state
+ * Args:     none
+ * Return:   none
+ * Notes:    called from the control period interrupt (SysTick); events are
+ *           read before the state function runs so that a transition takes
+ *           effect within the same control period. Transitions to
+ *           eFSM_STATE_INV are ignored.
+ */
+void FSM_Run(void)
+{
+	fsm_event_t event;
+	fsm_state_t next;
+
+	fsm_t_tick = SYSTIME_Now();
+
+	event = FSM[fsm_cur_state].state_event_read();
+	next = FSM[fsm_cur_state].state_transition_map[event];
+
+	if ( next != eFSM_STATE_INV && next != fsm_cur_state)
+	{
+		fsm_cur_state = next;
+		fsm_t_state = fsm_t_tick;
+	}
+
+	if ( FSM[fsm_cur_state].state_function != NULL)
+		FSM[fsm_cur_state].state_function();
+}
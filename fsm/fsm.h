@@ -14,4 +14,27 @@
 #include "fsm_defs.h"
 
 
+extern void FSM_Init(void);
+extern void FSM_SetState(fsm_state_t state);
+extern fsm_state_t FSM_GetState(void);
+extern void FSM_SetBalanceCtrl(fsm_ctrl_t ctrl);
+extern fsm_ctrl_t FSM_GetBalanceCtrl(void);
+extern void FSM_Run(void);
+extern uint64_t FSM_GetTickTime(void);
+extern uint64_t FSM_GetStateTime(void);
+
+/* fsm_collision.c */
+extern void FSM_CW_SetTrack(float x_min, float x_max, float prs_x0, float prs_scale);
+extern void FSM_CW_PrsUpdate(int32_t dist_mm);
+extern fsm_event_t FSM_CW_Predict(void);
+extern fsm_event_t FSM_CW_BrakeRun(void);
+extern uint32_t FSM_CW_GetWarnCount(void);
+
+/* fsm_calib.c */
+extern void FSM_Calib_Reset(void);
+extern fsm_event_t FSM_Calib_Run(void);
+extern void FSM_Calib_PrsSample(int32_t dist_mm, float x);
+extern const struct fsm_calib_type *FSM_Calib_Get(void);
+
+
 #endif /* FSM_FSM_H_ */
@@ -0,0 +1,415 @@
+/*
+ * fsm_calib.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Milos Lazic
+ *
+ *  Automated track calibration (eFSM_STATE_CALIB state function): finds
+ *  both end stops, centres the cart and re-zeroes the cart encoder (QEI1)
+ *  to the track centre, re-zeroes the pendulum encoder (QEI0) to the
+ *  hanging rest position and fits the ultrasonic sensor (PRS0) distance to
+ *  the encoder position by least squares.
+ */
+
+
+#include "fsm.h"
+#include "../sys/device/device.h"
+#include "../swingup/swu.h"
+
+
+/* macros */
+#define SHAFT_RADIUS   0.0069358f  /* belt pulley radius (m) */
+#define QEI_PPR        2400        /* encoder counts per revolution */
+#define CAL_M_PER_COUNT (2.0f*3.14159265359f*SHAFT_RADIUS/QEI_PPR)
+
+#define CAL_POWER      10          /* motor power while seeking the end stops (%) */
+#define CAL_V_STALL    0.01f       /* cart considered stalled below this speed (m/s) */
+#define CAL_MIN_TICKS  5000        /* control periods driven before stall detection is armed;
+                                      covers the 50 ms QEI velocity timer and motor start */
+#define CAL_STALL_TICKS 1000       /* control periods below CAL_V_STALL to accept an end stop */
+#define CAL_SEEK_TICKS 200000      /* end stop search timeout (control periods) */
+#define CAL_MIN_TRACK  0.2f        /* shortest plausible track (m) */
+
+#define CAL_CENTER_GAIN 50.0f      /* centering power per unit position error (% per m) */
+
+#define CAL_SETTLE_TICKS 5000      /* wait for the cart motion to decay (control periods) */
+#define CAL_REST_TICKS 15000       /* pendulum angle observation window; longer than one
+                                      swing period so that the middle of the observed
+                                      range is the rest position (control periods) */
+#define CAL_REST_SPAN  100         /* largest pendulum swing accepted (counts, peak to peak) */
+
+#define CAL_PRS_MIN_SAMPLES 8      /* fewest ultrasonic samples for a valid fit */
+#define CAL_PRS_MIN_SPAN 0.1f      /* shortest encoder span covered by the samples (m) */
+
+#define CAL_SWU_MARGIN 0.24f       /* distance between swing-up pumping limit and end stop; covers
+                                      the cart overshoot past the limit plus the collision
+                                      predictor stopping distance (m) */
+#define CAL_SWU_MIN_LIMIT 0.05f    /* smallest swing-up pumping limit (m) */
+
+
+/* Name: fsm_cal_phase_type
+ *
+ * Description: calibration sequence phases
+ *
+ * Members: eCAL_PHASE_IDLE     - not started; entered again once the
+ *                                result has been reported
+ *          eCAL_PHASE_SEEK_MIN - driving towards the negative end stop
+ *          eCAL_PHASE_SEEK_MAX - driving towards the positive end stop
+ *          eCAL_PHASE_CENTER   - driving back to the middle of the track
+ *          eCAL_PHASE_SETTLE   - motor off, observing the pendulum swing
+ *          eCAL_PHASE_DONE     - calibration constants published
+ *          eCAL_PHASE_FAULT    - end stop not found or implausible track;
+ *                                motor off until reset
+ */
+typedef enum
+{
+	eCAL_PHASE_IDLE = 0,
+	eCAL_PHASE_SEEK_MIN,
+	eCAL_PHASE_SEEK_MAX,
+	eCAL_PHASE_CENTER,
+	eCAL_PHASE_SETTLE,
+	eCAL_PHASE_DONE,
+	eCAL_PHASE_FAULT,
+} fsm_cal_phase_type;
+
+
+/* Name: fsm_cal_type
+ *
+ * Description: calibration sequence state
+ *
+ * Members: phase      - current phase
+ *          ticks      - control periods spent in the current phase
+ *          stall      - consecutive control periods below CAL_V_STALL
+ *          min_cnt    - raw QEI1 count at the negative end stop
+ *          max_cnt    - raw QEI1 count at the positive end stop
+ *          th_min,
+ *          th_max     - pendulum angle range over the rest window (counts)
+ *          sampling   - non-zero while ultrasonic samples are accumulated;
+ *                       read by the background context
+ *          n, sx, sy,
+ *          sxx, sxy   - least squares sums of encoder position x (m) and
+ *                       ultrasonic distance y (mm); written by the
+ *                       background context while sampling is set
+ *          x_lo, x_hi - encoder span covered by the samples (m)
+ *          result     - published calibration constants
+ */
+struct fsm_cal_type
+{
+	fsm_cal_phase_type phase;
+	uint32_t ticks;
+	uint32_t stall;
+	int32_t min_cnt;
+	int32_t max_cnt;
+	int32_t th_min;
+	int32_t th_max;
+	volatile uint32_t sampling;
+	uint32_t n;
+	float sx;
+	float sy;
+	float sxx;
+	float sxy;
+	float x_lo;
+	float x_hi;
+	struct fsm_calib_type result;
+};
+
+
+static struct fsm_cal_type cal =
+{
+		.phase = eCAL_PHASE_IDLE,
+		.sampling = 0,
+		.result = { .valid = 0 },
+};
+
+
+/*
+ * Name: cal_seek
+ * Descr: drive the cart towards one end stop and detect the stall
+ * Args:     dir - -1 towards the negative end stop, +1 towards the positive
+ *           xdot - cart velocity (m/s)
+ * Return:   1 once the cart has stalled against the end stop, 0 otherwise
+ * Notes:
+ */
+static int cal_seek(int dir, float xdot)
+{
+	dev_ioctl(eDEV_ESC0, eESC_IOCTL_SET_POWER, dir * FSM_CART_POWER_DIR * CAL_POWER);
+
+	if ( ++cal.ticks < CAL_MIN_TICKS)
+		return 0;
+
+	if ( xdot < CAL_V_STALL && xdot > -CAL_V_STALL)
+		cal.stall++;
+	else
+		cal.stall = 0;
+
+	return cal.stall >= CAL_STALL_TICKS;
+}
+
+
+/*
+ * Name: cal_next_phase
+ * Descr: enter a new phase
+ * Args:     phase - phase to enter
+ * Return:   none
+ * Notes:
+ */
+static void cal_next_phase(fsm_cal_phase_type phase)
+{
+	cal.phase = phase;
+	cal.ticks = 0;
+	cal.stall = 0;
+}
+
+
+/*
+ * Name: cal_fault
+ * Descr: stop the motor and hold the calibration in eCAL_PHASE_FAULT
+ * Args:     none
+ * Return:   eFSM_EVENT_FAIL
+ * Notes:
+ */
+static fsm_event_t cal_fault(void)
+{
+	dev_ioctl(eDEV_ESC0, eESC_IOCTL_SET_POWER, 0);
+	cal.sampling = 0;
+	cal_next_phase(eCAL_PHASE_FAULT);
+
+	return eFSM_EVENT_FAIL;
+}
+
+
+/*
+ * Name: cal_publish
+ * Descr: re-zero both encoders, complete the ultrasonic fit and hand the
+ *        calibration constants to the collision predictor and swing-up
+ *        controller
+ * Args:     x_cnt  - current raw QEI1 count
+ *           th_cnt - current QEI0 count
+ * Return:   none
+ * Notes:
+ */
+static void cal_publish(int32_t x_cnt, int32_t th_cnt)
+{
+	struct fsm_calib_type *r = &cal.result;
+	int32_t center_cnt = cal.min_cnt + (cal.max_cnt - cal.min_cnt)/2;
+	float x_center = (float)center_cnt * CAL_M_PER_COUNT;
+	float n, det, a, b, half;
+
+	/* re-zero the encoders: cart to the track centre, pendulum to the
+	 * middle of its residual swing */
+	r->th_zero_ofs = cal.th_min + (cal.th_max - cal.th_min)/2;
+	dev_ioctl(eDEV_QEI0, eQEI_IOCTL_W_POS, th_cnt - r->th_zero_ofs);
+	dev_ioctl(eDEV_QEI1, eQEI_IOCTL_W_POS, x_cnt - center_cnt);
+
+	r->x_min = (float)(cal.min_cnt - center_cnt) * CAL_M_PER_COUNT;
+	r->x_max = (float)(cal.max_cnt - center_cnt) * CAL_M_PER_COUNT;
+
+	/* y = a*x + b fitted in the raw frame; invert and shift to the new
+	 * frame: x' = (y - b)/a - x_center */
+	r->prs_samples = cal.n;
+	r->prs_scale = 0;
+	r->prs_x0 = 0;
+	n = (float)cal.n;
+	det = n*cal.sxx - cal.sx*cal.sx;
+	if ( cal.n >= CAL_PRS_MIN_SAMPLES && (cal.x_hi - cal.x_lo) >= CAL_PRS_MIN_SPAN && det > 0)
+	{
+		a = (n*cal.sxy - cal.sx*cal.sy)/det;
+		b = (cal.sy - a*cal.sx)/n;
+		if ( a != 0)
+		{
+			r->prs_scale = 1.0f/a;
+			r->prs_x0 = -b/a - x_center;
+		}
+	}
+
+	r->valid = 1;
+
+	FSM_CW_SetTrack(r->x_min, r->x_max, r->prs_x0, r->prs_scale);
+
+	half = ( r->x_max < -r->x_min) ? r->x_max : -r->x_min;
+	half -= CAL_SWU_MARGIN;
+	SWU_SetXLimit( (half > CAL_SWU_MIN_LIMIT) ? half : CAL_SWU_MIN_LIMIT);
+	SWU_Reset();
+}
+
+
+/*
+ * Name: FSM_Calib_Reset
+ * Descr: restart the calibration sequence from the beginning
+ * Args:     none
+ * Return:   none
+ * Notes:    the most recent calibration constants remain published
+ */
+void FSM_Calib_Reset(void)
+{
+	cal.sampling = 0;
+	cal_next_phase(eCAL_PHASE_IDLE);
+}
+
+
+/*
+ * Name: FSM_Calib_Run
+ * Descr: calibration sequence; called once per control period while the
+ *        FSM is in STATE_CALIB
+ * Args:     none
+ * Return:   eFSM_EVENT_DONE once the calibration constants have been
+ *           published, eFSM_EVENT_FAIL if an end stop was not found or the
+ *           track is implausibly short, eFSM_EVENT_NONE otherwise
+ * Notes:    the sequence restarts from the beginning on the control period
+ *           after it has reported eFSM_EVENT_DONE, so re-entering
+ *           STATE_CALIB (e.g. after an emergency stop) recalibrates.
+ *           The pendulum must hang free; it is re-zeroed to rest.
+ */
+fsm_event_t FSM_Calib_Run(void)
+{
+	int32_t x_cnt, th_cnt;
+	float xdot, err, power;
+
+	x_cnt = dev_ioctl(eDEV_QEI1, eQEI_IOCTL_R_POS);
+	th_cnt = dev_ioctl(eDEV_QEI0, eQEI_IOCTL_R_POS);
+	(void) dev_ioctl(eDEV_QEI1, eQEI_IOCTL_R_VEL_RAD, &xdot);
+	xdot *= SHAFT_RADIUS;
+
+	switch(cal.phase)
+	{
+	case eCAL_PHASE_DONE:
+	case eCAL_PHASE_IDLE:
+		/* start over; ultrasonic samples are collected while the cart
+		 * sweeps the track */
+		cal.sampling = 0;
+		cal.n = 0;
+		cal.sx = cal.sy = cal.sxx = cal.sxy = 0;
+		cal.x_lo = cal.x_hi = (float)x_cnt * CAL_M_PER_COUNT;
+		cal.sampling = 1;
+		cal_next_phase(eCAL_PHASE_SEEK_MIN);
+		break;
+
+	case eCAL_PHASE_SEEK_MIN:
+		if ( cal_seek(-1, xdot))
+		{
+			cal.min_cnt = x_cnt;
+			cal_next_phase(eCAL_PHASE_SEEK_MAX);
+		}
+		else if ( cal.ticks >= CAL_SEEK_TICKS)
+			return cal_fault();
+		break;
+
+	case eCAL_PHASE_SEEK_MAX:
+		if ( cal_seek(1, xdot))
+		{
+			cal.max_cnt = x_cnt;
+			if ( (float)(cal.max_cnt - cal.min_cnt)*CAL_M_PER_COUNT < CAL_MIN_TRACK)
+				return cal_fault();
+			cal_next_phase(eCAL_PHASE_CENTER);
+		}
+		else if ( cal.ticks >= CAL_SEEK_TICKS)
+			return cal_fault();
+		break;
+
+	case eCAL_PHASE_CENTER:
+		/* proportional approach; finished once the cart has stopped (on
+		 * target or held by friction); the remaining offset is removed
+		 * when QEI1 is re-zeroed */
+		err = (float)(cal.min_cnt + (cal.max_cnt - cal.min_cnt)/2 - x_cnt) * CAL_M_PER_COUNT;
+		power = CAL_CENTER_GAIN * err;
+		if ( power > CAL_POWER)
+			power = CAL_POWER;
+		else if ( power < -CAL_POWER)
+			power = -CAL_POWER;
+		dev_ioctl(eDEV_ESC0, eESC_IOCTL_SET_POWER_F, FSM_CART_POWER_DIR * power);
+
+		if ( ++cal.ticks >= CAL_MIN_TICKS)
+		{
+			if ( xdot < CAL_V_STALL && xdot > -CAL_V_STALL)
+				cal.stall++;
+			else
+				cal.stall = 0;
+		}
+
+		if ( cal.stall >= CAL_STALL_TICKS || cal.ticks >= CAL_SEEK_TICKS)
+		{
+			dev_ioctl(eDEV_ESC0, eESC_IOCTL_SET_POWER, 0);
+			cal.sampling = 0;
+			cal_next_phase(eCAL_PHASE_SETTLE);
+		}
+		break;
+
+	case eCAL_PHASE_SETTLE:
+		if ( ++cal.ticks <= CAL_SETTLE_TICKS)
+		{
+			cal.th_min = cal.th_max = th_cnt;
+			break;
+		}
+
+		if ( th_cnt < cal.th_min)
+			cal.th_min = th_cnt;
+		if ( th_cnt > cal.th_max)
+			cal.th_max = th_cnt;
+
+		if ( cal.ticks < CAL_SETTLE_TICKS + CAL_REST_TICKS)
+			break;
+
+		/* swinging too far to trust the range; observe another window */
+		if ( cal.th_max - cal.th_min > CAL_REST_SPAN)
+		{
+			cal.ticks = 0;
+			break;
+		}
+
+		cal_publish(x_cnt, th_cnt);
+		cal_next_phase(eCAL_PHASE_DONE);
+		return eFSM_EVENT_DONE;
+
+	case eCAL_PHASE_FAULT:
+	default:
+		dev_ioctl(eDEV_ESC0, eESC_IOCTL_SET_POWER, 0);
+		return eFSM_EVENT_FAIL;
+	}
+
+	return eFSM_EVENT_NONE;
+}
+
+
+/*
+ * Name: FSM_Calib_PrsSample
+ * Descr: add an ultrasonic distance measurement to the calibration fit
+ * Args:     dist_mm - distance returned by ePRS_IOCTL_DISTMSR (mm)
+ *           x       - cart encoder position sampled with the measurement (m)
+ * Return:   none
+ * Notes:    called from the background context (see FSM_CW_PrsUpdate);
+ *           ignored unless the cart is sweeping the track in STATE_CALIB.
+ *           The sums are only read by the control period interrupt after
+ *           sampling has been cleared.
+ */
+void FSM_Calib_PrsSample(int32_t dist_mm, float x)
+{
+	float y = (float)dist_mm;
+
+	if ( !cal.sampling)
+		return;
+
+	cal.n++;
+	cal.sx += x;
+	cal.sy += y;
+	cal.sxx += x*x;
+	cal.sxy += x*y;
+
+	if ( x < cal.x_lo)
+		cal.x_lo = x;
+	if ( x > cal.x_hi)
+		cal.x_hi = x;
+}
+
+
+/*
+ * Name: FSM_Calib_Get
+ * Descr: read the most recent calibration constants
+ * Args:     none
+ * Return:   pointer to calibration constants; valid member is zero until
+ *           a calibration has completed
+ * Notes:
+ */
+const struct fsm_calib_type *FSM_Calib_Get(void)
+{
+	return &cal.result;
+}
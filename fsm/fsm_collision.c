@@ -0,0 +1,260 @@
+/*
+ * fsm_collision.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Milos Lazic
+ *
+ *  Track end collision prediction (source of eFSM_EVENT_COLLISIONWARN)
+ *  and emergency braking profile (eFSM_STATE_EMGBRAKE state function).
+ */
+
+
+#include "fsm.h"
+#include "../sys/device/device.h"
+#include "../sys/systime/systime.h"
+
+
+/* macros */
+#define SHAFT_RADIUS   0.0069358f  /* belt pulley radius (m) */
+
+/* default track geometry in the cart encoder (QEI1) frame, relative to the
+ * cart position at power-on; replaced by FSM_CW_SetTrack once calibrated */
+#define CW_TRACK_HALF  0.35f       /* distance from power-on position to each end stop (m) */
+
+/* default ultrasonic sensor (PRS0) mapping: the sensor faces the cart from
+ * the negative end stop, i.e. x = x_min + distance */
+#define CW_PRS_X0      (-CW_TRACK_HALF)  /* encoder position at which PRS reads 0 (m) */
+#define CW_PRS_SCALE   (0.001f)          /* encoder position change per PRS distance unit (m/mm) */
+#define CW_PRS_TOL     0.02f       /* PRS/encoder disagreement tolerated before using the PRS position (m) */
+#define CW_PRS_MAX_AGE SYSTIME_SEC(0.25)  /* PRS measurements older than this are ignored (cycles) */
+
+#define CW_A_BRAKE     10.0f       /* guaranteed braking deceleration (m/s^2) */
+#define CW_T_REACT     0.03f       /* reaction time: velocity measurement lag + one control period (s) */
+#define CW_MARGIN      0.02f       /* stopping margin before the end stop (m) */
+
+#define CW_BRAKE_GAIN  200.0f      /* braking power per unit cart speed (% per m/s) */
+#define CW_BRAKE_MAX   100.0f      /* braking power limit (%) */
+#define CW_V_STOP      0.01f       /* cart considered stopped below this speed (m/s) */
+#define CW_STOP_TICKS  500         /* control periods below CW_V_STOP to end braking */
+
+
+/* Name: fsm_cw_type
+ *
+ * Description: collision predictor state
+ *
+ * Members: x_min, x_max - end stop positions in the QEI1 frame (m)
+ *          prs_x0       - QEI1 position at which the PRS distance reads 0 (m)
+ *          prs_scale    - QEI1 position change per PRS distance unit (m/mm,
+ *                         signed); 0 disables the ultrasonic cross-check
+ *          prs_ofs      - PRS position minus encoder position at the time of
+ *                         the latest PRS measurement (m); written by the
+ *                         background context, single 32-bit store
+ *          prs_t        - timestamp of the latest PRS measurement
+ *                         (SYSTIME_Now, cycles)
+ *          prs_valid    - non-zero once prs_ofs and prs_t hold a
+ *                         measurement; cleared by the background context
+ *                         while it updates them
+ *          prs_fault    - non-zero while the PRS and encoder disagree by more
+ *                         than CW_PRS_TOL
+ *          stop_ticks   - consecutive control periods spent below CW_V_STOP
+ *                         while braking
+ *          warn_count   - number of collision warnings raised
+ */
+struct fsm_cw_type
+{
+	float x_min;
+	float x_max;
+	float prs_x0;
+	float prs_scale;
+	volatile float prs_ofs;
+	volatile uint64_t prs_t;
+	volatile uint32_t prs_valid;
+	uint32_t prs_fault;
+	uint32_t stop_ticks;
+	uint32_t warn_count;
+};
+
+
+static struct fsm_cw_type cw =
+{
+		.x_min = -CW_TRACK_HALF,
+		.x_max = CW_TRACK_HALF,
+		.prs_x0 = CW_PRS_X0,
+		.prs_scale = CW_PRS_SCALE,
+		.prs_ofs = 0,
+		.prs_t = 0,
+		.prs_valid = 0,
+		.prs_fault = 0,
+		.stop_ticks = 0,
+		.warn_count = 0,
+};
+
+
+/*
+ * Name: FSM_CW_SetTrack
+ * Descr: set end stop positions and the ultrasonic sensor mapping
+ * Args:     x_min, x_max - end stop positions in the QEI1 frame (m)
+ *           prs_x0       - QEI1 position at which the PRS distance reads 0 (m)
+ *           prs_scale    - QEI1 position change per PRS distance unit
+ *                          (m/mm, signed); 0 disables the cross-check
+ * Return:   none
+ * Notes:    invalidates the latest PRS measurement
+ */
+void FSM_CW_SetTrack(float x_min, float x_max, float prs_x0, float prs_scale)
+{
+	cw.prs_valid = 0;
+	cw.x_min = x_min;
+	cw.x_max = x_max;
+	cw.prs_x0 = prs_x0;
+	cw.prs_scale = prs_scale;
+}
+
+
+/*
+ * Name: FSM_CW_PrsUpdate
+ * Descr: publish an ultrasonic distance measurement to the predictor
+ * Args:     dist_mm - distance returned by ePRS_IOCTL_DISTMSR (mm)
+ * Return:   none
+ * Notes:    called from the background context right after the (blocking)
+ *           PRS measurement. The measurement is stored as an offset from
+ *           the encoder position sampled here, so the predictor can advance
+ *           it with the encoder between measurements. The sample is
+ *           also passed to the calibration fit (FSM_Calib_PrsSample).
+ *           The measurement is stamped with the time it completed.
+ */
+void FSM_CW_PrsUpdate(int32_t dist_mm)
+{
+	uint64_t t = SYSTIME_Now();
+	float x;
+
+	if ( dist_mm < 0)
+		return;
+
+	(void) dev_ioctl(eDEV_QEI1, eQEI_IOCTL_R_POS_RAD, &x);
+	x *= SHAFT_RADIUS;
+
+	FSM_Calib_PrsSample(dist_mm, x);
+
+	if ( cw.prs_scale == 0)
+		return;
+
+	/* the control period skips the measurement while it is updated */
+	cw.prs_valid = 0;
+	cw.prs_ofs = (cw.prs_x0 + cw.prs_scale*(float)dist_mm) - x;
+	cw.prs_t = t;
+	cw.prs_valid = 1;
+}
+
+
+/*
+ * Name: FSM_CW_Predict
+ * Descr: per control period time-to-collision check; compares the
+ *        distance to the end stop ahead of the cart with the distance
+ *        needed to stop from the current velocity
+ * Args:     none
+ * Return:   eFSM_EVENT_COLLISIONWARN if the cart cannot stop before the
+ *           end stop (less margin) at CW_A_BRAKE, eFSM_EVENT_NONE otherwise
+ * Notes:    if the ultrasonic position disagrees with the encoder by more
+ *           than CW_PRS_TOL, the position closer to the end stop ahead is
+ *           used; PRS measurements older than CW_PRS_MAX_AGE are ignored
+ */
+fsm_event_t FSM_CW_Predict(void)
+{
+	float x, xdot, x_prs, speed, d_avail, d_stop;
+
+	(void) dev_ioctl(eDEV_QEI1, eQEI_IOCTL_R_POS_RAD, &x);
+	x *= SHAFT_RADIUS;
+	(void) dev_ioctl(eDEV_QEI1, eQEI_IOCTL_R_VEL_RAD, &xdot);
+	xdot *= SHAFT_RADIUS;
+
+	/* ultrasonic cross-check */
+	cw.prs_fault = 0;
+	if ( cw.prs_valid && FSM_GetTickTime() - cw.prs_t < CW_PRS_MAX_AGE)
+	{
+		x_prs = x + cw.prs_ofs;
+		if ( cw.prs_ofs > CW_PRS_TOL || cw.prs_ofs < -CW_PRS_TOL)
+		{
+			cw.prs_fault = 1;
+			if ( (xdot > 0 && x_prs > x) || (xdot < 0 && x_prs < x))
+				x = x_prs;
+		}
+	}
+
+	if ( xdot >= 0)
+	{
+		speed = xdot;
+		d_avail = cw.x_max - x;
+	}
+	else
+	{
+		speed = -xdot;
+		d_avail = x - cw.x_min;
+	}
+
+	/* distance covered during the reaction time plus braking distance */
+	d_stop = speed*CW_T_REACT + speed*speed*(0.5f/CW_A_BRAKE) + CW_MARGIN;
+
+	if ( d_stop >= d_avail)
+	{
+		/* arm the braking profile (see FSM_CW_BrakeRun) */
+		cw.stop_ticks = 0;
+		cw.warn_count++;
+		return eFSM_EVENT_COLLISIONWARN;
+	}
+
+	return eFSM_EVENT_NONE;
+}
+
+
+/*
+ * Name: FSM_CW_BrakeRun
+ * Descr: emergency braking profile; drives the motor against the cart
+ *        velocity with power proportional to speed (limited to
+ *        CW_BRAKE_MAX), then releases the motor once stopped
+ * Args:     none
+ * Return:   eFSM_EVENT_DONE once the cart has been stopped for
+ *           CW_STOP_TICKS control periods, eFSM_EVENT_NONE otherwise
+ * Notes:    called once per control period
+ */
+fsm_event_t FSM_CW_BrakeRun(void)
+{
+	float xdot, power;
+
+	(void) dev_ioctl(eDEV_QEI1, eQEI_IOCTL_R_VEL_RAD, &xdot);
+	xdot *= SHAFT_RADIUS;
+
+	if ( xdot < CW_V_STOP && xdot > -CW_V_STOP)
+	{
+		dev_ioctl(eDEV_ESC0, eESC_IOCTL_SET_POWER, 0);
+		if ( cw.stop_ticks < CW_STOP_TICKS)
+			cw.stop_ticks++;
+
+		return ( cw.stop_ticks == CW_STOP_TICKS) ? eFSM_EVENT_DONE : eFSM_EVENT_NONE;
+	}
+
+	cw.stop_ticks = 0;
+
+	power = CW_BRAKE_GAIN * xdot;
+	if ( power > CW_BRAKE_MAX)
+		power = CW_BRAKE_MAX;
+	else if ( power < -CW_BRAKE_MAX)
+		power = -CW_BRAKE_MAX;
+
+	/* oppose the motion */
+	dev_ioctl(eDEV_ESC0, eESC_IOCTL_SET_POWER_F, -FSM_CART_POWER_DIR * power);
+
+	return eFSM_EVENT_NONE;
+}
+
+
+/*
+ * Name: FSM_CW_GetWarnCount
+ * Descr: read the number of collision warnings raised since power-on
+ * Args:     none
+ * Return:   warning count
+ * Notes:
+ */
+uint32_t FSM_CW_GetWarnCount(void)
+{
+	return cw.warn_count;
+}
@@ -8,7 +8,10 @@
 #ifndef FSM_FSM_DEFS_H_
 #define FSM_FSM_DEFS_H_
 
-#define MAX_INPUT 10 /* MLAZIC_TBD: revise when state graph is defined */
+#define FSM_MAX_INPUT 10 /* MLAZIC_TBD: revise when state graph is defined */
+
+/* sign of the cart velocity (QEI1) produced by positive motor power */
+#define FSM_CART_POWER_DIR (-1)
 
 typedef enum {
 	eFSM_STATE_INIT = 0,
@@ -16,6 +19,7 @@ typedef enum {
 	eFSM_STATE_SWINGUP,
 	eFSM_STATE_BALANCE,
 	eFSM_STATE_EMGBRAKE,
+	eFSM_STATE_EXCITE,
 	eFSM_STATE_INV,
 	eFSM_STATE_MAX,
 } fsm_state_t;
@@ -26,10 +30,48 @@ typedef enum {
 	eFSM_EVENT_DONE,
 	eFSM_EVENT_FAIL,
 	eFSM_EVENT_COLLISIONWARN,
+	eFSM_EVENT_EXCITE,
 	eFSM_EVENT_MAX,
 } fsm_event_t;
 
 
+/* controller run in STATE_BALANCE */
+typedef enum {
+	eFSM_CTRL_LQR = 0,
+	eFSM_CTRL_FL,
+	eFSM_CTRL_LQR_EVT,   /* event-triggered LQR (LQR_Balance_CtrlRunEvt) */
+	eFSM_CTRL_LQI,       /* LQR with integral action (LQR_Balance_CtrlRunLQI) */
+	eFSM_CTRL_MAX,
+} fsm_ctrl_t;
+
+
+/* Name: fsm_calib_type
+ * Description: track calibration constants (result of STATE_CALIB)
+ * Members: valid       - non-zero once a calibration has completed
+ *          x_min       - negative end stop position (m, QEI1 frame)
+ *          x_max       - positive end stop position (m, QEI1 frame)
+ *          prs_x0      - QEI1 position at which the ultrasonic sensor
+ *                        distance reads 0 (m)
+ *          prs_scale   - QEI1 position change per unit of ultrasonic
+ *                        distance (m/mm, signed); 0 if the fit failed
+ *          prs_samples - number of ultrasonic samples used in the fit
+ *          th_zero_ofs - correction applied to the pendulum encoder
+ *                        zero (counts)
+ *
+ *  Notes: the QEI1 frame is re-zeroed to the centre of the track
+ */
+struct fsm_calib_type
+{
+	uint32_t valid;
+	float x_min;
+	float x_max;
+	float prs_x0;
+	float prs_scale;
+	uint32_t prs_samples;
+	int32_t th_zero_ofs;
+};
+
+
 struct fsm_state_struct
 {
 	void (*state_function)(void);
@@ -0,0 +1,159 @@
+/*
+ * bbox_decode.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Milos Lazic
+ *
+ *  Host tool decoding a black box dump (log/log_defs.h) from a raw
+ *  capture of the serial command channel (UART0 bytes as received, e.g.
+ *  "cat /dev/ttyACM0 > capture.bin"). eCMD_ID_BBOX frames with a valid
+ *  CRC are reassembled by offset; everything else in the capture is
+ *  skipped.
+ *
+ *  Output (stdout):
+ *      "# ..." lines  - image header and the event records
+ *      CSV            - sample,x,th,u: sample index, cart and pendulum
+ *                       encoder counts (QEI1, QEI0) and motor power
+ *                       (Q15, resolution 2^LOG_BB_U_SHIFT)
+ *
+ *  The image decoder (bbox_image.h) is shared with host/telem_rec.
+ *
+ *  Build (from repository root):
+ *      gcc -std=c99 -O2 -o bbox_decode host/bbox_decode/bbox_decode.c
+ *
+ *  Usage: bbox_decode capture.bin
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "bbox_image.h"
+#include "../../cmd/cmd_defs.h"
+
+
+static const char *bd_ev_name[] = { "?", "state", "cmd", "fault" };
+static const char *bd_cause_name[] = { "none", "brake", "fall", "manual" };
+
+
+static uint8_t bd_crc8( uint8_t crc, const uint8_t *buf, size_t len)
+{
+	uint32_t bit;
+
+	while ( len--)
+	{
+		crc ^= *buf++;
+		for ( bit = 0; bit < 8; bit++)
+			crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+	}
+
+	return crc;
+}
+
+
+static void bd_print( void *ctx, uint32_t t, int32_t x, int32_t th, int32_t u)
+{
+	(void)ctx;
+	printf( "%u,%d,%d,%d\n", t, x, th, u);
+}
+
+
+int main( int argc, char **argv)
+{
+	FILE *f;
+	uint8_t *cap, *img, *have;
+	long cap_len;
+	struct bd_hdr_type hdr;
+	uint32_t i, j, len, ofs, size = 0;
+	long n;
+	int rv;
+
+	if ( argc < 2)
+	{
+		fprintf( stderr, "usage: %s capture.bin\n", argv[0]);
+		return 2;
+	}
+
+	if ( (f = fopen( argv[1], "rb")) == NULL)
+	{
+		perror( argv[1]);
+		return 1;
+	}
+	fseek( f, 0, SEEK_END);
+	cap_len = ftell( f);
+	fseek( f, 0, SEEK_SET);
+	cap = malloc( cap_len > 0 ? cap_len : 1);
+	img = calloc( BD_IMAGE_MAX, 1);
+	have = calloc( BD_IMAGE_MAX, 1);
+	if ( cap == NULL || img == NULL || have == NULL ||
+	     fread( cap, 1, cap_len, f) != (size_t)cap_len)
+	{
+		fprintf( stderr, "cannot read %s\n", argv[1]);
+		return 1;
+	}
+	fclose( f);
+
+	/* frames: SOF | LEN | ID | PAYLOAD | CRC; a later copy of the same
+	 * offset (repeated dump) replaces an earlier one */
+	for ( i = 0; i + 3 <= (uint32_t)cap_len; i++)
+	{
+		if ( cap[i] != CMD_FRAME_SOF)
+			continue;
+		len = cap[i + 1];
+		if ( len < 1 + 4 || i + 3 + len > (uint32_t)cap_len || cap[i + 2] != eCMD_ID_BBOX)
+			continue;
+		if ( bd_crc8( 0, &cap[i + 1], len + 1) != cap[i + 2 + len])
+			continue;
+
+		ofs = bd_u32( &cap[i + 3]);
+		len -= 1 + 4;
+		if ( ofs == 0)
+			memset( have, 0, BD_IMAGE_MAX);
+		if ( ofs + len > BD_IMAGE_MAX)
+			continue;
+		memcpy( &img[ofs], &cap[i + 7], len);
+		memset( &have[ofs], 1, len);
+		if ( ofs + len > size)
+			size = ofs + len;
+		i += 2 + len + 4;
+	}
+
+	rv = bd_header( img, size, &hdr);
+	if ( rv == -1)
+	{
+		fprintf( stderr, "no black box image in %s\n", argv[1]);
+		return 1;
+	}
+	if ( rv)
+	{
+		fprintf( stderr, "image header does not match log_defs.h\n");
+		return 1;
+	}
+	for ( i = 0, j = 0; i < hdr.size; i++)
+		j += !have[i];
+	if ( j)
+		fprintf( stderr, "warning: %u of %u image bytes missing\n", j, hdr.size);
+
+	printf( "# cause %s, %u samples, trigger at sample %u (t = %llu us)\n",
+	        hdr.cause < 4 ? bd_cause_name[hdr.cause] : "?", hdr.samples, hdr.trig,
+	        (unsigned long long)hdr.t_us);
+	for ( i = 0; i < hdr.n_ev; i++)
+	{
+		const uint8_t *ev = bd_event( img, i);
+		printf( "# event %u %s %u\n", bd_u32( ev), ev[4] < 4 ? bd_ev_name[ev[4]] : "?", ev[5]);
+	}
+
+	printf( "sample,x,th,u\n");
+	for ( i = 0; i < hdr.n_pg; i++)
+	{
+		n = bd_page( bd_page_ptr( img, &hdr, i), hdr.pg_size, hdr.samples, bd_print, NULL);
+		if ( n < 0)
+			fprintf( stderr, "warning: page %u is corrupt; decoded up to the error\n", i);
+	}
+
+	free( have);
+	free( img);
+	free( cap);
+
+	return 0;
+}
@@ -0,0 +1,255 @@
+/*
+ * bbox_image.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Milos Lazic
+ *
+ *  Black box image decoder (log/log_defs.h), shared by the host tools that
+ *  read black box dumps (bbox_decode, telem_rec). Header only: every
+ *  routine is static.
+ */
+
+#ifndef HOST_BBOX_DECODE_BBOX_IMAGE_H_
+#define HOST_BBOX_DECODE_BBOX_IMAGE_H_
+
+
+#include <stdint.h>
+#include "../../log/log_defs.h"
+
+
+#define BD_IMAGE_MAX  (LOG_BB_HDR_SIZE + LOG_BB_EVENTS*LOG_BB_EV_SIZE + LOG_BB_PAGES*LOG_BB_PAGE_SIZE)
+
+
+/* Name: bd_hdr_type
+ *
+ * Description: decoded black box image header
+ *
+ * Members: cause   - freeze cause (LOG_bb_cause_type)
+ *          n_ev    - event records in the image
+ *          n_pg    - pages in the image
+ *          pg_size - page size (bytes)
+ *          samples - samples recorded
+ *          trig    - sample at which the recorder was frozen
+ *          t_us    - trigger time (us, SYSTIME_ToUs)
+ *          size    - image size (bytes)
+ *
+ * Notes:
+ *
+ */
+struct bd_hdr_type
+{
+	uint32_t cause;
+	uint32_t n_ev;
+	uint32_t n_pg;
+	uint32_t pg_size;
+	uint32_t samples;
+	uint32_t trig;
+	uint64_t t_us;
+	uint32_t size;
+};
+
+
+struct bd_bits_type
+{
+	const uint8_t *buf;
+	uint32_t pos;
+	uint32_t end;
+};
+
+
+/* sample sink of bd_page: sample index, encoder counts (QEI1, QEI0) and
+ * motor power (Q15) */
+typedef void (*bd_emit_type)( void *ctx, uint32_t t, int32_t x, int32_t th, int32_t u);
+
+
+static uint32_t bd_u16( const uint8_t *p)
+{
+	return (uint32_t)p[0] | ((uint32_t)p[1] << 8);
+}
+
+
+static uint32_t bd_u32( const uint8_t *p)
+{
+	return bd_u16( p) | (bd_u16( &p[2]) << 16);
+}
+
+
+/* reads n (0..32) bits, least significant first; -1 past the end */
+static int bd_bits_get( struct bd_bits_type *b, uint32_t n, uint32_t *val)
+{
+	uint32_t i;
+
+	if ( b->end - b->pos < n)
+		return -1;
+
+	for ( i = 0, *val = 0; i < n; i++, b->pos++)
+		*val |= (uint32_t)((b->buf[b->pos >> 3] >> (b->pos & 7)) & 1) << i;
+
+	return 0;
+}
+
+
+/* mirror of LOG_rice_put */
+static int bd_rice_get( struct bd_bits_type *b, struct LOG_rice_type *r, int32_t *v)
+{
+	uint32_t k, q, bit, u;
+
+	for ( k = 0; (r->N << k) < r->A && k < LOG_RICE_KMAX; k++)
+		;
+
+	for ( q = 0; q < LOG_RICE_QMAX; q++)
+	{
+		if ( bd_bits_get( b, 1, &bit))
+			return -1;
+		if ( bit == 0)
+			break;
+	}
+
+	if ( q == LOG_RICE_QMAX)
+	{
+		if ( bd_bits_get( b, 32, &u))
+			return -1;
+	}
+	else
+	{
+		if ( bd_bits_get( b, k, &u))
+			return -1;
+		u |= q << k;
+	}
+
+	*v = (int32_t)(u >> 1) ^ -(int32_t)(u & 1);
+
+	r->A += ( u < 0xFFFF) ? u : 0xFFFF;
+	if ( ++r->N >= LOG_RICE_NMAX)
+	{
+		r->A >>= 1;
+		r->N >>= 1;
+	}
+
+	return 0;
+}
+
+
+/*
+ * Name: bd_header
+ *
+ * Descr: Decodes and checks the image header
+ *
+ * Args:     img  - image bytes
+ *           len  - bytes available in img
+ *           hdr  - storage for the header
+ *
+ * Return:   0 on success, -1 if img does not start a black box image, -2
+ *           if the header does not match log_defs.h
+ *
+ * Notes: hdr->size is valid on success; the image is complete once len
+ *        reaches it
+ *
+ */
+static int bd_header( const uint8_t *img, uint32_t len, struct bd_hdr_type *hdr)
+{
+	if ( len < LOG_BB_HDR_SIZE || bd_u32( img) != LOG_BB_MAGIC || img[4] != LOG_BB_VERSION)
+		return -1;
+
+	hdr->cause = img[5];
+	hdr->n_ev = bd_u16( &img[6]);
+	hdr->n_pg = bd_u16( &img[8]);
+	hdr->pg_size = bd_u16( &img[10]);
+	hdr->samples = bd_u32( &img[12]);
+	hdr->trig = bd_u32( &img[16]);
+	hdr->t_us = (uint64_t)bd_u32( &img[20]) | ((uint64_t)bd_u32( &img[24]) << 32);
+	if ( hdr->n_ev > LOG_BB_EVENTS || hdr->n_pg > LOG_BB_PAGES || hdr->pg_size != LOG_BB_PAGE_SIZE)
+		return -2;
+	hdr->size = LOG_BB_HDR_SIZE + hdr->n_ev*LOG_BB_EV_SIZE + hdr->n_pg*hdr->pg_size;
+
+	return 0;
+}
+
+
+/* event record i of an image: sample, type (LOG_ev_type) and argument */
+static const uint8_t *bd_event( const uint8_t *img, uint32_t i)
+{
+	return &img[LOG_BB_HDR_SIZE + i*LOG_BB_EV_SIZE];
+}
+
+
+/*
+ * Name: bd_page
+ *
+ * Descr: Decodes one page
+ *
+ * Args:     pg      - page bytes
+ *           size    - page size
+ *           samples - total number of samples recorded (padding of the
+ *                     last block is dropped)
+ *           emit    - sample sink, called in sample order
+ *           ctx     - passed to emit
+ *
+ * Return:   number of samples decoded, -1 if the page is corrupt
+ *
+ * Notes:
+ *
+ */
+static long bd_page( const uint8_t *pg, uint32_t size, uint32_t samples,
+                     bd_emit_type emit, void *ctx)
+{
+	struct bd_bits_type b = { &pg[LOG_BB_PAGE_HDR], 0, bd_u16( &pg[4]) };
+	struct LOG_rice_type rice[LOG_BB_CH];
+	int32_t r[LOG_BB_CH][LOG_BB_BLK];
+	uint32_t t = bd_u32( &pg[0]);
+	int32_t x1 = (int32_t)bd_u32( &pg[8]), x2 = (int32_t)bd_u32( &pg[12]);
+	int32_t th1 = (int32_t)bd_u32( &pg[16]), u1 = (int32_t)bd_u32( &pg[20]);
+	uint32_t ch, i, flag;
+	long n = 0;
+
+	if ( b.end > 8*(size - LOG_BB_PAGE_HDR))
+		return -1;
+
+	for ( ch = 0; ch < LOG_BB_CH; ch++)
+	{
+		rice[ch].A = LOG_RICE_A0;
+		rice[ch].N = 1;
+	}
+
+	while ( b.pos < b.end)
+	{
+		for ( ch = 0; ch < LOG_BB_CH; ch++)
+		{
+			if ( bd_bits_get( &b, 1, &flag))
+				return -1;
+			for ( i = 0; i < LOG_BB_BLK; i++)
+			{
+				r[ch][i] = 0;
+				if ( flag && bd_rice_get( &b, &rice[ch], &r[ch][i]))
+					return -1;
+			}
+		}
+
+		for ( i = 0; i < LOG_BB_BLK; i++, t++)
+		{
+			int32_t x = r[0][i] + 2*x1 - x2;
+
+			x2 = x1;
+			x1 = x;
+			th1 += r[1][i];
+			u1 += r[2][i];
+			if ( t < samples)
+			{
+				emit( ctx, t, x1, th1, u1*(1 << LOG_BB_U_SHIFT));
+				n++;
+			}
+		}
+	}
+
+	return n;
+}
+
+
+/* page i of an image */
+static const uint8_t *bd_page_ptr( const uint8_t *img, const struct bd_hdr_type *hdr, uint32_t i)
+{
+	return &img[LOG_BB_HDR_SIZE + hdr->n_ev*LOG_BB_EV_SIZE + i*hdr->pg_size];
+}
+
+
+#endif /* HOST_BBOX_DECODE_BBOX_IMAGE_H_ */
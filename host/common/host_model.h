@@ -0,0 +1,176 @@
+/*
+ * host_model.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Milos Lazic
+ *
+ *  Plant model routines shared by the host design tools (sys_ident,
+ *  lqi_design, robust): zero order hold discretization of a continuous
+ *  model, and the reader of the continuous model sys_ident prints
+ *  ("A = [...];", "B = [...];"). Header only: every routine is static
+ *  inline, so that a tool may use any of them.
+ */
+
+#ifndef HOST_COMMON_HOST_MODEL_H_
+#define HOST_COMMON_HOST_MODEL_H_
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+
+#define HM_NS     4        /* states of the sys_ident model (x, x', th, th') */
+#define HM_N_MAX  8        /* largest model hm_expm_zoh discretizes */
+
+
+/*
+ * Name: hm_expm_zoh
+ *
+ * Descr: Zero order hold discretization: [Ad Bd; 0 1] = expm([A B; 0 0]*ts)
+ *
+ * Args:     n      - model states (1 to HM_N_MAX)
+ *           A, B   - continuous model, A row major (n*n)
+ *           ts     - sample time (s)
+ *           Ad, Bd - storage for the discrete model, Ad row major
+ *
+ * Return:   none
+ *
+ * Notes: Taylor series with scaling and squaring
+ *
+ */
+static inline void hm_expm_zoh( int n, const double *A, const double *B, double ts,
+                                double *Ad, double *Bd)
+{
+	double M[HM_N_MAX + 1][HM_N_MAX + 1] = {{ 0 }}, E[HM_N_MAX + 1][HM_N_MAX + 1] = {{ 0 }};
+	double T[HM_N_MAX + 1][HM_N_MAX + 1], P[HM_N_MAX + 1][HM_N_MAX + 1], nrm = 0;
+	int N = n + 1, i, j, k, q, sq = 0;
+
+	for ( i = 0; i < n; i++)
+	{
+		for ( j = 0; j < n; j++)
+			M[i][j] = A[i*n + j]*ts;
+		M[i][n] = B[i]*ts;
+	}
+	for ( i = 0; i < N; i++)
+		for ( j = 0; j < N; j++)
+			nrm = fmax( nrm, fabs(M[i][j]));
+	while ( nrm > 0.1)
+	{
+		nrm *= 0.5;
+		sq++;
+	}
+	for ( i = 0; i < N; i++)
+		for ( j = 0; j < N; j++)
+			M[i][j] = ldexp( M[i][j], -sq);
+
+	/* E = I + M + M^2/2! + ... */
+	for ( i = 0; i < N; i++)
+	{
+		for ( j = 0; j < N; j++)
+			T[i][j] = ( i == j);
+		E[i][i] = 1;
+	}
+	for ( q = 1; q <= 12; q++)
+	{
+		for ( i = 0; i < N; i++)
+			for ( j = 0; j < N; j++)
+				for ( k = 0, P[i][j] = 0; k < N; k++)
+					P[i][j] += T[i][k]*M[k][j]/q;
+		memcpy( T, P, sizeof(T));
+		for ( i = 0; i < N; i++)
+			for ( j = 0; j < N; j++)
+				E[i][j] += T[i][j];
+	}
+	while ( sq--)
+	{
+		for ( i = 0; i < N; i++)
+			for ( j = 0; j < N; j++)
+				for ( k = 0, P[i][j] = 0; k < N; k++)
+					P[i][j] += E[i][k]*E[k][j];
+		memcpy( E, P, sizeof(E));
+	}
+
+	for ( i = 0; i < n; i++)
+	{
+		for ( j = 0; j < n; j++)
+			Ad[i*n + j] = E[i][j];
+		Bd[i] = E[i][n];
+	}
+}
+
+
+/* reads "name = [a b; c d];" rows into v (row major); returns values read */
+static inline int hm_parse( const char *s, double *v, int max)
+{
+	char *e;
+	int n = 0;
+
+	s = strchr( s, '[');
+	if ( s == NULL)
+		return 0;
+	for ( s++; *s && *s != ']' && n < max; )
+	{
+		if ( *s == ' ' || *s == '\t' || *s == ';' || *s == ',')
+		{
+			s++;
+			continue;
+		}
+		v[n] = strtod( s, &e);
+		if ( e == s)
+			break;
+		n++;
+		s = e;
+	}
+
+	return n;
+}
+
+
+/*
+ * Name: hm_read_model
+ *
+ * Descr: Reads the continuous model printed by sys_ident
+ *
+ * Args:     path - model file
+ *           A, B - storage for the model
+ *
+ * Return:   0 on success, -1 if the file cannot be read or holds no
+ *           HM_NS-state A and B (reported on stderr)
+ *
+ * Notes: the lines starting "A = [" and "B = ["; the discrete Ad, Bd and
+ *        comment lines are skipped
+ *
+ */
+static inline int hm_read_model( const char *path, double A[HM_NS][HM_NS], double B[HM_NS])
+{
+	char line[1024];
+	int got_a = 0, got_b = 0;
+	FILE *f = fopen( path, "r");
+
+	if ( f == NULL)
+	{
+		perror( path);
+		return -1;
+	}
+	while ( fgets( line, sizeof(line), f))
+	{
+		if ( strncmp( line, "A = [", 5) == 0)
+			got_a = ( hm_parse( line, &A[0][0], HM_NS*HM_NS) == HM_NS*HM_NS);
+		else if ( strncmp( line, "B = [", 5) == 0)
+			got_b = ( hm_parse( line, B, HM_NS) == HM_NS);
+	}
+	fclose( f);
+
+	if ( !got_a || !got_b)
+	{
+		fprintf( stderr, "%s: no %d-state continuous A, B (sys_ident output)\n", path, HM_NS);
+		return -1;
+	}
+
+	return 0;
+}
+
+
+#endif /* HOST_COMMON_HOST_MODEL_H_ */
@@ -0,0 +1,510 @@
+/*
+ * dsp_design.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Milos Lazic
+ *
+ *  Host tool designing the firmware filters (dsp/dsp_defs.h): prints a
+ *  filter object, coefficients quantized to the chosen format, ready to
+ *  compile in and plug with LQR_Balance_SetFilter.
+ *
+ *  Filters (one biquad cascade of any number of sections, or one FIR):
+ *    lp fc [q]       second order low-pass (q default 0.7071)
+ *    hp fc [q]       second order high-pass
+ *    notch f0 q      notch at f0, -3 dB bandwidth f0/q
+ *    bw order fc     Butterworth low-pass of any order (sections of the
+ *                    bilinear transform, prewarped at fc)
+ *    sg n p d [mid]  Savitzky-Golay FIR of n taps fitting a polynomial of
+ *                    order p, giving the d-th derivative (0 smooths) at the
+ *                    newest sample, or at the window centre with "mid"
+ *                    (linear phase, (n-1)/2 samples of delay); the newest
+ *                    sample end has no delay but more noise gain
+ *
+ *  Fixed point formats work on signal/range: in_scale is 1/range and
+ *  out_scale brings the result back to signal units (times fs^d for a
+ *  differentiator). The coefficient shift is the smallest that fits the
+ *  largest coefficient. The response and the stability are checked on
+ *  the quantized coefficients: Q15 is adequate for notches and corners
+ *  above about fs/100, lower corners need Q31 or float. A Q15
+ *  differentiator of an encoder position resolves range/32768 per sample,
+ *  i.e. range*fs/32768 in velocity; use Q31 or float for those.
+ *
+ *  Build (from repository root):
+ *      gcc -std=c99 -O2 -o dsp_design host/dsp_design/dsp_design.c -lm
+ *
+ *  Usage: dsp_design [-f float|q31|q15] [-s fs] [-r range] [-n name] [-g]
+ *                    filter ...
+ *      -f  format, default float
+ *      -s  sampling rate (Hz), default DD_FS (control rate)
+ *      -r  signal range of the fixed point formats, default 1
+ *      -n  C name of the filter object, default "filt"
+ *      -g  print the response of the quantized filter (CSV: f, mag_db,
+ *          phase_deg) instead of the code
+ *
+ *  Example, cart velocity from the cart position (range 0.5 m), and a
+ *  notch of a 120 Hz belt mode on the controller output (range 12 V):
+ *      dsp_design -f q31 -r 0.5 -n xdot_filt sg 16 2 1
+ *      dsp_design -f float -n vout_filt notch 120 4 lp 800
+ *  appended to lqr/lqr_rig_filt.c and listed in LQR_RIG_FILTERS
+ *  (lqr/lqr_rig.h) as ENTRY( eLQR_ST_XD, eLQR_ST_X, xdot_filt) and
+ *  ENTRY( LQR_FILT_OUT, 0, vout_filt); LQR_Balance_Init installs them.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <complex.h>
+
+
+#define DD_PI      3.14159265358979323846
+#define DD_FS      10000.0   /* control rate (Hz) */
+#define DD_MAX_BQ  16        /* biquad sections */
+#define DD_MAX_FIR 128       /* FIR taps */
+#define DD_MAX_P   8         /* Savitzky-Golay polynomial order */
+#define DD_RESP_N  200       /* response points (-g) */
+
+
+enum dd_fmt_type { DD_FLOAT = 0, DD_Q31, DD_Q15 };
+
+static const char *dd_fmt_name[] = { "float", "q31", "q15" };
+static const char *dd_fmt_ctype[] = { "float", "int32_t", "int16_t" };
+static const int dd_fmt_bits[] = { 0, 31, 15 };
+
+
+/* designed filter: biquad sections (b0 b1 b2 a1 a2) or FIR taps */
+struct dd_filt_type
+{
+	int fir;
+	int n;                          /* sections or taps */
+	double c[DD_MAX_BQ*5 > DD_MAX_FIR ? DD_MAX_BQ*5 : DD_MAX_FIR];
+	double q[DD_MAX_BQ*5 > DD_MAX_FIR ? DD_MAX_BQ*5 : DD_MAX_FIR];   /* quantized */
+	long iq[DD_MAX_BQ*5 > DD_MAX_FIR ? DD_MAX_BQ*5 : DD_MAX_FIR];
+	int shift;
+	int deriv;                      /* FIR derivative order */
+};
+
+
+static void dd_usage( void)
+{
+	fprintf( stderr,
+		"usage: dsp_design [-f float|q31|q15] [-s fs] [-r range] [-n name] [-g] filter ...\n"
+		"  lp fc [q] | hp fc [q] | notch f0 q | bw order fc  (biquad cascade)\n"
+		"  sg n p d [mid]                                    (FIR, alone)\n");
+	exit( 2);
+}
+
+
+static double dd_num( const char *s)
+{
+	char *end;
+	double v = strtod( s, &end);
+
+	if ( *s == '\0' || *end != '\0')
+	{
+		fprintf( stderr, "dsp_design: bad number '%s'\n", s);
+		exit( 2);
+	}
+	return v;
+}
+
+
+/* appends a biquad section normalized by a0 */
+static void dd_add_bq( struct dd_filt_type *f, double b0, double b1, double b2,
+                       double a0, double a1, double a2)
+{
+	double *c;
+
+	if ( f->n >= DD_MAX_BQ)
+	{
+		fprintf( stderr, "dsp_design: more than %d sections\n", DD_MAX_BQ);
+		exit( 2);
+	}
+	c = &f->c[5*f->n++];
+	c[0] = b0/a0; c[1] = b1/a0; c[2] = b2/a0; c[3] = a1/a0; c[4] = a2/a0;
+}
+
+
+/* second order sections of the bilinear transform (RBJ cookbook) */
+static void dd_rbj( struct dd_filt_type *f, int hp, double fc, double q, double fs)
+{
+	double w0 = 2.0*DD_PI*fc/fs, cw = cos( w0), al = sin( w0)/(2.0*q);
+
+	if ( hp)
+		dd_add_bq( f, (1 + cw)/2, -(1 + cw), (1 + cw)/2, 1 + al, -2*cw, 1 - al);
+	else
+		dd_add_bq( f, (1 - cw)/2, 1 - cw, (1 - cw)/2, 1 + al, -2*cw, 1 - al);
+}
+
+
+static void dd_notch( struct dd_filt_type *f, double f0, double q, double fs)
+{
+	double w0 = 2.0*DD_PI*f0/fs, cw = cos( w0), al = sin( w0)/(2.0*q);
+
+	dd_add_bq( f, 1, -2*cw, 1, 1 + al, -2*cw, 1 - al);
+}
+
+
+static void dd_butter( struct dd_filt_type *f, int order, double fc, double fs)
+{
+	double k = tan( DD_PI*fc/fs);
+	int i;
+
+	for ( i = 0; i < order/2; i++)
+		dd_rbj( f, 0, fc, 1.0/(2.0*cos( DD_PI*(2*i + 1)/(2.0*order))), fs);
+
+	/* odd order: first order section */
+	if ( order & 1)
+		dd_add_bq( f, k, k, 0, 1 + k, k - 1, 0);
+}
+
+
+/*
+ * Savitzky-Golay taps, newest sample first: least squares polynomial fit
+ * over the window, d-th derivative at the evaluation point (per sample^d)
+ */
+static void dd_sg( struct dd_filt_type *f, int n, int p, int d, int mid)
+{
+	double m[DD_MAX_P + 1][2*(DD_MAX_P + 1)];
+	double te = mid ? -(n - 1)/2.0 : 0.0, tau, piv, r, fact = 1.0;
+	int i, j, k, np = p + 1;
+
+	if ( n < 2 || n > DD_MAX_FIR || p < 0 || p > DD_MAX_P || p >= n || d < 0 || d > p)
+	{
+		fprintf( stderr, "dsp_design: sg needs 2 <= n <= %d, d <= p < n, p <= %d\n",
+			DD_MAX_FIR, DD_MAX_P);
+		exit( 2);
+	}
+
+	/* [V'V | I], tau = t - te with sample k at t = -k */
+	for ( i = 0; i < np; i++)
+		for ( j = 0; j < 2*np; j++)
+			m[i][j] = ( j - np == i) ? 1.0 : 0.0;
+	for ( k = 0; k < n; k++)
+	{
+		tau = -k - te;
+		for ( i = 0; i < np; i++)
+			for ( j = 0; j < np; j++)
+				m[i][j] += pow( tau, i + j);
+	}
+
+	/* Gauss-Jordan; V'V is positive definite */
+	for ( i = 0; i < np; i++)
+	{
+		piv = m[i][i];
+		for ( j = 0; j < 2*np; j++)
+			m[i][j] /= piv;
+		for ( k = 0; k < np; k++)
+		{
+			if ( k == i)
+				continue;
+			r = m[k][i];
+			for ( j = 0; j < 2*np; j++)
+				m[k][j] -= r*m[i][j];
+		}
+	}
+
+	for ( i = 2; i <= d; i++)
+		fact *= i;
+
+	f->fir = 1;
+	f->n = n;
+	f->deriv = d;
+	for ( k = 0; k < n; k++)
+	{
+		tau = -k - te;
+		r = 0.0;
+		for ( j = 0; j < np; j++)
+			r += m[d][np + j]*pow( tau, j);
+		f->c[k] = fact*r;
+	}
+}
+
+
+/* quantizes the coefficients; picks the shift */
+static void dd_quant( struct dd_filt_type *f, enum dd_fmt_type fmt)
+{
+	int nc = f->fir ? f->n : 5*f->n, i, bits = dd_fmt_bits[fmt];
+	double cmax = 0.0, one;
+	long lim;
+
+	for ( i = 0; i < nc; i++)
+		if ( fabs( f->c[i]) > cmax)
+			cmax = fabs( f->c[i]);
+
+	if ( fmt == DD_FLOAT)
+	{
+		f->shift = 0;
+		for ( i = 0; i < nc; i++)
+			f->q[i] = (float)f->c[i];
+		return;
+	}
+
+	lim = ( 1L << bits) - 1;
+	for ( f->shift = 0; f->shift < bits - 1; f->shift++)
+		if ( floor( cmax*ldexp( 1.0, bits - f->shift) + 0.5) <= lim)
+			break;
+
+	one = ldexp( 1.0, bits - f->shift);
+	for ( i = 0; i < nc; i++)
+	{
+		f->iq[i] = (long)floor( f->c[i]*one + 0.5);
+		f->q[i] = f->iq[i]/one;
+	}
+}
+
+
+/* response at f (Hz), designed (c = f->c) or quantized (c = f->q) */
+static double complex dd_resp( const struct dd_filt_type *f, const double *q, double fr, double fs)
+{
+	double complex z1 = cexp( -I*2.0*DD_PI*fr/fs), h = 1.0, acc = 0.0, zk = 1.0;
+	const double *c;
+	int i;
+
+	if ( f->fir)
+	{
+		for ( i = 0; i < f->n; i++, zk *= z1)
+			acc += q[i]*zk;
+		return acc;
+	}
+
+	for ( i = 0; i < f->n; i++)
+	{
+		c = &q[5*i];
+		h *= ( c[0] + c[1]*z1 + c[2]*z1*z1)/( 1.0 + c[3]*z1 + c[4]*z1*z1);
+	}
+	return h;
+}
+
+
+/* largest deviation (dB) of the quantized response from the design, up
+ * to fs/2 */
+static double dd_quant_err( const struct dd_filt_type *f, double fs)
+{
+	double fr, hd, hq, e, emax = 0.0;
+	int i;
+
+	for ( i = 0; i < DD_RESP_N; i++)
+	{
+		fr = fs/2*pow( 1e-4, 1.0 - (double)i/(DD_RESP_N - 1));
+		hd = cabs( dd_resp( f, f->c, fr, fs));
+		hq = cabs( dd_resp( f, f->q, fr, fs));
+		/* ignore stop band below -60 dB */
+		if ( hd < 1e-3*( f->fir ? fr/fs : 1.0) && hq < 1e-3*( f->fir ? fr/fs : 1.0))
+			continue;
+		e = fabs( 20.0*log10( ( hq + 1e-300)/( hd + 1e-300)));
+		emax = fmax( emax, e);
+	}
+	return emax;
+}
+
+
+/* prints a float constant that C reads as float */
+static void dd_print_f( double v)
+{
+	char buf[32];
+
+	snprintf( buf, sizeof( buf), "%.9g", v);
+	printf( "%s%sf", buf, strpbrk( buf, ".en") ? "" : ".0");
+}
+
+
+/* largest pole radius of the quantized cascade */
+static double dd_pole_r( const struct dd_filt_type *f)
+{
+	double a1, a2, disc, r, rmax = 0.0;
+	int i;
+
+	for ( i = 0; i < f->n; i++)
+	{
+		a1 = f->q[5*i + 3];
+		a2 = f->q[5*i + 4];
+		disc = a1*a1 - 4.0*a2;
+		if ( disc < 0.0)
+			r = sqrt( a2);
+		else
+			r = fmax( fabs( -a1 + sqrt( disc)), fabs( -a1 - sqrt( disc)))/2.0;
+		rmax = fmax( rmax, r);
+	}
+	return rmax;
+}
+
+
+static void dd_print_code( const struct dd_filt_type *f, enum dd_fmt_type fmt,
+                           const char *name, double in_scale, double out_scale,
+                           int argc, char **argv)
+{
+	static const char *kind_bq[] = { "eDSP_BQ_F", "eDSP_BQ_Q31", "eDSP_BQ_Q15" };
+	static const char *kind_fir[] = { "eDSP_FIR_F", "eDSP_FIR_Q31", "eDSP_FIR_Q15" };
+	static const char *sfx[] = { "f", "q31", "q15" };
+	int nc = f->fir ? f->n : 5*f->n, i;
+
+	printf( "/* dsp_design");
+	for ( i = 1; i < argc; i++)
+		printf( " %s", argv[i]);
+	printf( " */\n");
+
+	printf( "static const %s %s_coef[%d] =\n{", dd_fmt_ctype[fmt], name, nc);
+	for ( i = 0; i < nc; i++)
+	{
+		if ( i % ( f->fir ? 4 : 5) == 0)
+			printf( "\n\t");
+		if ( fmt == DD_FLOAT)
+		{
+			dd_print_f( f->q[i]);
+			printf( ",%s", ( i + 1) % ( f->fir ? 4 : 5) ? " " : "");
+		}
+		else
+			printf( "%ld,%s", f->iq[i], ( i + 1) % ( f->fir ? 4 : 5) ? " " : "");
+	}
+	printf( "\n};\n");
+
+	if ( f->fir)
+	{
+		printf( "static %s %s_st[%d];\n", dd_fmt_ctype[fmt], name, 2*f->n);
+		printf( "static struct DSP_fir_%s_type %s_fir = { .n = %d, ", sfx[fmt], name, f->n);
+		if ( fmt != DD_FLOAT)
+			printf( ".shift = %d, ", f->shift);
+		printf( ".coef = %s_coef, .st = %s_st, .pos = 0 };\n", name, name);
+		printf( "struct DSP_filt_type %s = { .kind = %s, .f = &%s_fir,\n", name, kind_fir[fmt], name);
+	}
+	else
+	{
+		printf( "static %s %s_st[%d];\n", dd_fmt_ctype[fmt], name, ( fmt == DD_FLOAT ? 2 : 4)*f->n);
+		printf( "static struct DSP_bq_%s_type %s_bq = { .n_st = %d, ", sfx[fmt], name, f->n);
+		if ( fmt != DD_FLOAT)
+			printf( ".shift = %d, ", f->shift);
+		printf( ".coef = %s_coef, .st = %s_st };\n", name, name);
+		printf( "struct DSP_filt_type %s = { .kind = %s, .f = &%s_bq,\n", name, kind_bq[fmt], name);
+	}
+	printf( "\t\t.in_scale = ");
+	dd_print_f( in_scale);
+	printf( ", .out_scale = ");
+	dd_print_f( out_scale);
+	printf( ", .next = NULL };\n");
+}
+
+
+int main( int argc, char **argv)
+{
+	static struct dd_filt_type f;
+	enum dd_fmt_type fmt = DD_FLOAT;
+	const char *name = "filt";
+	double fs = DD_FS, range = 1.0, in_scale, out_scale, fr, dc;
+	double complex h;
+	int resp = 0, a, i, sg = 0, mid;
+
+	for ( a = 1; a < argc && argv[a][0] == '-'; a++)
+	{
+		if ( strcmp( argv[a], "-g") == 0)
+		{
+			resp = 1;
+			continue;
+		}
+		if ( a + 1 >= argc)
+			dd_usage();
+		if ( strcmp( argv[a], "-f") == 0)
+		{
+			for ( i = 0; i < 3 && strcmp( argv[a + 1], dd_fmt_name[i]) != 0; i++)
+				;
+			if ( i == 3)
+				dd_usage();
+			fmt = (enum dd_fmt_type)i;
+		}
+		else if ( strcmp( argv[a], "-s") == 0)
+			fs = dd_num( argv[a + 1]);
+		else if ( strcmp( argv[a], "-r") == 0)
+			range = dd_num( argv[a + 1]);
+		else if ( strcmp( argv[a], "-n") == 0)
+			name = argv[a + 1];
+		else
+			dd_usage();
+		a++;
+	}
+	if ( a >= argc || fs <= 0.0 || range <= 0.0)
+		dd_usage();
+
+	/* filter sections */
+	while ( a < argc)
+	{
+		if ( strcmp( argv[a], "lp") == 0 || strcmp( argv[a], "hp") == 0)
+		{
+			if ( a + 1 >= argc)
+				dd_usage();
+			fr = dd_num( argv[a + 1]);
+			i = ( a + 2 < argc && strchr( "0123456789.", argv[a + 2][0]) != NULL);
+			if ( fr <= 0.0 || fr >= fs/2)
+				dd_usage();
+			dd_rbj( &f, argv[a][0] == 'h', fr, i ? dd_num( argv[a + 2]) : 0.70710678, fs);
+			a += 2 + i;
+		}
+		else if ( strcmp( argv[a], "notch") == 0)
+		{
+			if ( a + 2 >= argc || dd_num( argv[a + 1]) <= 0.0 || dd_num( argv[a + 1]) >= fs/2)
+				dd_usage();
+			dd_notch( &f, dd_num( argv[a + 1]), dd_num( argv[a + 2]), fs);
+			a += 3;
+		}
+		else if ( strcmp( argv[a], "bw") == 0)
+		{
+			if ( a + 2 >= argc || dd_num( argv[a + 1]) < 1 || dd_num( argv[a + 2]) >= fs/2)
+				dd_usage();
+			dd_butter( &f, (int)dd_num( argv[a + 1]), dd_num( argv[a + 2]), fs);
+			a += 3;
+		}
+		else if ( strcmp( argv[a], "sg") == 0)
+		{
+			if ( a + 3 >= argc || f.n != 0)
+				dd_usage();
+			mid = ( a + 4 < argc && strcmp( argv[a + 4], "mid") == 0);
+			dd_sg( &f, (int)dd_num( argv[a + 1]), (int)dd_num( argv[a + 2]),
+				(int)dd_num( argv[a + 3]), mid);
+			sg = 1;
+			a += 4 + mid;
+		}
+		else
+			dd_usage();
+
+		if ( sg && a < argc)
+			dd_usage();
+	}
+
+	dd_quant( &f, fmt);
+
+	if ( !f.fir && dd_pole_r( &f) >= 1.0)
+	{
+		fprintf( stderr, "dsp_design: quantized %s filter is unstable (pole radius %.6f); use %s\n",
+			dd_fmt_name[fmt], dd_pole_r( &f), fmt == DD_Q15 ? "q31 or float" : "float");
+		return 1;
+	}
+
+	in_scale = ( fmt == DD_FLOAT) ? 1.0 : 1.0/range;
+	out_scale = ( fmt == DD_FLOAT) ? 1.0 : range;
+	if ( f.fir)
+		out_scale *= pow( fs, f.deriv);
+
+	if ( resp)
+	{
+		printf( "f,mag_db,phase_deg\n");
+		for ( i = 0; i < DD_RESP_N; i++)
+		{
+			fr = fs/2*pow( 1e-4, 1.0 - (double)i/(DD_RESP_N - 1));
+			h = dd_resp( &f, f.q, fr, fs)*( f.fir ? pow( fs, f.deriv) : 1.0);
+			printf( "%.6g,%.4f,%.3f\n", fr, 20.0*log10( cabs( h) + 1e-300), carg( h)*180.0/DD_PI);
+		}
+		return 0;
+	}
+
+	dc = cabs( dd_resp( &f, f.q, 0.0, fs));
+	fprintf( stderr, "# %s, %d %s, shift %d, DC gain %.6g%s\n", dd_fmt_name[fmt], f.n,
+		f.fir ? "taps" : "sections", f.shift, dc, f.fir && f.deriv ? " (per sample^d)" : "");
+	if ( !f.fir)
+		fprintf( stderr, "# largest pole radius %.9f\n", dd_pole_r( &f));
+	if ( dd_quant_err( &f, fs) > 0.5)
+		fprintf( stderr, "# warning: quantized response off the design by up to %.2f dB; "
+			"use a wider format\n", dd_quant_err( &f, fs));
+
+	dd_print_code( &f, fmt, name, in_scale, out_scale, argc, argv);
+
+	return 0;
+}
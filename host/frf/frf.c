@@ -0,0 +1,538 @@
+/*
+ * frf.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Milos Lazic
+ *
+ *  Host tool for frequency response measurement of the cart drive
+ *  (exc/exc_gen.c): builds the eCMD_ID_EXCITE request frame and computes
+ *  the response from motor power to cart position, with coherence, from
+ *  one or more scope captures decoded by scope_decode (columns t, x,
+ *  power; x in QEI1 counts, power in Q15).
+ *
+ *  Method:
+ *    - the output is the cart velocity (first difference of x), which
+ *      removes the drift of the integrating plant; the position response
+ *      is recovered exactly from the difference operator
+ *    - averaged spectra over segments of every capture: Welch (Hann
+ *      window, 50 % overlap, radix-2 FFT) by default; with -p, one
+ *      rectangular segment per excitation period (PRBS: (2^order - 1) *
+ *      hold samples), which has no leakage for a periodic input
+ *    - H = Suy/Suu, coherence |Suy|^2/(Suu*Syy); coherence needs at
+ *      least two segments
+ *    - resonances: peaks of the velocity response that stand out by at
+ *      least FR_PROM_DB over the neighbouring valleys, where the median
+ *      coherence around the peak is at least FR_COH_MIN (a chirp sweeps
+ *      through a lightly damped mode quickly, so coherence dips right at
+ *      the peak); Q from the half-power points. The rigid body
+ *      response of the belt drive is a first order low-pass in velocity,
+ *      so any such peak is a belt or structural mode.
+ *
+ *  Output (stdout): "# ..." lines (settings, resonances), then CSV of
+ *  frequency (Hz), position response magnitude (dB re m/%) and phase
+ *  (deg), velocity response magnitude (dB re (m/s)/%), coherence and a
+ *  resonance flag.
+ *
+ *  Build (from repository root):
+ *      gcc -std=c99 -O2 -o frf host/frf/frf.c -lm
+ *
+ *  Usage:
+ *      frf excite kind amp p1 p2 len > /dev/ttyACM0
+ *          writes the request frame (see EXC_cfg_type)
+ *      frf [-n seg] [-p period] [-c cohmin] capture.csv ...
+ *
+ *  Example, 1 ms samples (scope decimation 10), capture starting with the
+ *  run: 30 % PRBS of order 9 at 10 control periods per bit (period 511
+ *  samples), or a 30 % chirp from 1 Hz to 150 Hz over 4 s:
+ *      scope_decode arm 0x11 1 6 1 5 0 10 > /dev/ttyACM0
+ *      frf excite 1 30 9 10 40950 > /dev/ttyACM0
+ *      ... scope_decode capture.bin > run.csv
+ *      frf -p 511 run.csv
+ *  or frf excite 0 30 10 1500 40000 and frf -n 512 run.csv ...
+ */
+
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include "../../cmd/cmd_defs.h"
+
+
+#define FR_PI        3.14159265358979323846
+#define FR_SEG       1024      /* Welch segment length (power of two) */
+#define FR_COH_MIN   0.8       /* coherence needed to report a resonance */
+#define FR_PROM_DB   3.0       /* resonance prominence (dB) */
+#define FR_COH_WIN   3         /* coherence median over +/- bins around a peak */
+#define FR_M_PER_CNT (2.0*FR_PI*0.0069358/2400.0)  /* QEI1 count (m); SHAFT_RADIUS, PPR */
+#define FR_PCT_PER_Q (100.0/32768.0)               /* Q15 power (%) */
+#define FR_MAX_COL   16
+
+
+/* signal pair of one capture */
+struct fr_sig_type
+{
+	double *u, *y;
+	size_t n;
+	double dt;
+};
+
+
+static uint8_t fr_crc8( uint8_t crc, const uint8_t *buf, size_t len)
+{
+	uint32_t bit;
+
+	while ( len--)
+	{
+		crc ^= *buf++;
+		for ( bit = 0; bit < 8; bit++)
+			crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+	}
+
+	return crc;
+}
+
+
+static int fr_cmp( const void *a, const void *b)
+{
+	double d = *(const double*)a - *(const double*)b;
+	return ( d > 0) - ( d < 0);
+}
+
+
+static int fr_excite( int argc, char **argv)
+{
+	uint8_t fr[3 + 1 + 10];
+	unsigned long v[5];
+	int i;
+
+	if ( argc != 7)
+	{
+		fprintf( stderr, "usage: %s excite kind amp p1 p2 len\n", argv[0]);
+		return 2;
+	}
+	for ( i = 0; i < 5; i++)
+		v[i] = strtoul( argv[2 + i], NULL, 0);
+
+	fr[0] = CMD_FRAME_SOF;
+	fr[1] = 1 + 10;
+	fr[2] = eCMD_ID_EXCITE;
+	fr[3] = (uint8_t)v[0];
+	fr[4] = (uint8_t)v[1];
+	fr[5] = (uint8_t)v[2];
+	fr[6] = (uint8_t)(v[2] >> 8);
+	fr[7] = (uint8_t)v[3];
+	fr[8] = (uint8_t)(v[3] >> 8);
+	for ( i = 0; i < 4; i++)
+		fr[9 + i] = (uint8_t)(v[4] >> 8*i);
+	fr[13] = fr_crc8( 0, &fr[1], fr[1] + 1);
+
+	return ( fwrite( fr, 1, sizeof(fr), stdout) == sizeof(fr)) ? 0 : 1;
+}
+
+
+/*
+ * Name: fr_read
+ *
+ * Descr: Reads the input and output columns of a decoded scope capture
+ *
+ * Args:     path - CSV file (scope_decode output)
+ *           s    - storage for the signals (allocated)
+ *
+ * Return:   0 on success, -1 on error
+ *
+ * Notes: output is converted to the cart velocity (m/s), input to % power
+ *
+ */
+static int fr_read( const char *path, struct fr_sig_type *s)
+{
+	FILE *f = fopen( path, "r");
+	char line[1024], *tok, *e;
+	int ci = -1, cx = -1, ct = -1, c, n_col = 0;
+	double v[FR_MAX_COL], x_last = 0, t0 = 0, t1 = 0;
+	size_t cap = 0, rows = 0;
+
+	memset( s, 0, sizeof(*s));
+	if ( f == NULL)
+	{
+		perror( path);
+		return -1;
+	}
+
+	while ( fgets( line, sizeof(line), f))
+	{
+		if ( line[0] == '#')
+			continue;
+
+		if ( n_col == 0)
+		{
+			for ( tok = strtok( line, ",\r\n"); tok && n_col < FR_MAX_COL; tok = strtok( NULL, ",\r\n"), n_col++)
+			{
+				if ( strcmp( tok, "t") == 0)
+					ct = n_col;
+				else if ( strcmp( tok, "x") == 0)
+					cx = n_col;
+				else if ( strcmp( tok, "power") == 0)
+					ci = n_col;
+			}
+			if ( ct < 0 || cx < 0 || ci < 0)
+			{
+				fprintf( stderr, "%s: needs columns t, x and power\n", path);
+				fclose( f);
+				return -1;
+			}
+			continue;
+		}
+
+		for ( c = 0, tok = line; c < n_col; c++, tok = e + 1)
+		{
+			v[c] = strtod( tok, &e);
+			if ( e == tok)
+				break;
+		}
+		if ( c < n_col)
+			continue;
+
+		if ( rows == 0)
+			t0 = v[ct];
+		else if ( rows == 1)
+			t1 = v[ct];
+
+		/* the first row only seeds the difference */
+		if ( rows++ > 0)
+		{
+			if ( s->n == cap)
+			{
+				cap = cap ? 2*cap : 4096;
+				s->u = realloc( s->u, cap*sizeof(double));
+				s->y = realloc( s->y, cap*sizeof(double));
+				if ( s->u == NULL || s->y == NULL)
+				{
+					fprintf( stderr, "out of memory\n");
+					exit( 1);
+				}
+			}
+			s->u[s->n] = v[ci]*FR_PCT_PER_Q;
+			s->y[s->n] = ( v[cx] - x_last)*FR_M_PER_CNT;
+			s->n++;
+		}
+		x_last = v[cx];
+	}
+	fclose( f);
+
+	if ( rows < 3 || t1 <= t0)
+	{
+		fprintf( stderr, "%s: no samples\n", path);
+		return -1;
+	}
+	s->dt = t1 - t0;
+	for ( rows = 0; rows < s->n; rows++)
+		s->y[rows] /= s->dt;
+
+	return 0;
+}
+
+
+/*
+ * Name: fr_fft
+ *
+ * Descr: In-place radix-2 FFT
+ *
+ * Args:     re, im - data (length n)
+ *           n      - length, power of two
+ *
+ * Return:   none
+ *
+ * Notes: forward transform, no scaling
+ *
+ */
+static void fr_fft( double *re, double *im, size_t n)
+{
+	size_t i, j, k, len;
+	double t, wr, wi, ur, ui, xr, xi;
+
+	for ( i = 1, j = 0; i < n; i++)
+	{
+		for ( k = n >> 1; j & k; k >>= 1)
+			j ^= k;
+		j |= k;
+		if ( i < j)
+		{
+			t = re[i]; re[i] = re[j]; re[j] = t;
+			t = im[i]; im[i] = im[j]; im[j] = t;
+		}
+	}
+
+	for ( len = 2; len <= n; len <<= 1)
+	{
+		for ( k = 0; k < len/2; k++)
+		{
+			wr = cos( -2*FR_PI*k/len);
+			wi = sin( -2*FR_PI*k/len);
+			for ( i = k; i < n; i += len)
+			{
+				j = i + len/2;
+				xr = re[j]*wr - im[j]*wi;
+				xi = re[j]*wi + im[j]*wr;
+				ur = re[i];
+				ui = im[i];
+				re[i] = ur + xr;
+				im[i] = ui + xi;
+				re[j] = ur - xr;
+				im[j] = ui - xi;
+			}
+		}
+	}
+}
+
+
+/*
+ * Name: fr_dft
+ *
+ * Descr: Direct DFT of bins 0 to n/2 (any length)
+ *
+ * Args:     x      - real data (length n)
+ *           n      - length
+ *           re, im - storage for n/2 + 1 bins
+ *           cs, sn - twiddle tables (length n)
+ *
+ * Return:   none
+ *
+ * Notes: periodic mode only; the period is rarely a power of two
+ *
+ */
+static void fr_dft( const double *x, size_t n, double *re, double *im,
+                    const double *cs, const double *sn)
+{
+	size_t k, i, p;
+
+	for ( k = 0; k <= n/2; k++)
+	{
+		re[k] = im[k] = 0;
+		for ( i = 0, p = 0; i < n; i++, p = ( p + k) % n)
+		{
+			re[k] += x[i]*cs[p];
+			im[k] -= x[i]*sn[p];
+		}
+	}
+}
+
+
+int main( int argc, char **argv)
+{
+	size_t seg = FR_SEG, period = 0, n, nb, k, i, s0, n_avg = 0, n_res = 0;
+	double coh_min = FR_COH_MIN, dt = 0;
+	double *w, *ur, *ui, *yr, *yi, *cs = NULL, *sn = NULL, *tmp;
+	double *suu, *syy, *sr, *si, *coh, *gv;
+	char *flag;
+	struct fr_sig_type sig;
+	int opt, a;
+
+	if ( argc > 1 && strcmp( argv[1], "excite") == 0)
+		return fr_excite( argc, argv);
+
+	while ( (opt = getopt( argc, argv, "n:p:c:")) != -1)
+	{
+		switch ( opt)
+		{
+		case 'n': seg = strtoul( optarg, NULL, 0); break;
+		case 'p': period = strtoul( optarg, NULL, 0); break;
+		case 'c': coh_min = atof( optarg); break;
+		default: goto usage;
+		}
+	}
+	if ( optind >= argc || seg < 16 || ( seg & (seg - 1)))
+		goto usage;
+
+	n = period ? period : seg;
+	nb = n/2 + 1;
+	w = malloc( n*sizeof(double));
+	ur = calloc( n, sizeof(double));
+	ui = calloc( n, sizeof(double));
+	yr = calloc( n, sizeof(double));
+	yi = calloc( n, sizeof(double));
+	tmp = calloc( n, sizeof(double));
+	suu = calloc( nb, sizeof(double));
+	syy = calloc( nb, sizeof(double));
+	sr = calloc( nb, sizeof(double));
+	si = calloc( nb, sizeof(double));
+	coh = calloc( nb, sizeof(double));
+	gv = calloc( nb, sizeof(double));
+	flag = calloc( nb, 1);
+	if ( period)
+	{
+		cs = malloc( n*sizeof(double));
+		sn = malloc( n*sizeof(double));
+	}
+	if ( !w || !ur || !ui || !yr || !yi || !tmp || !suu || !syy || !sr || !si || !coh || !gv ||
+	     !flag || ( period && ( !cs || !sn)))
+	{
+		fprintf( stderr, "out of memory\n");
+		return 1;
+	}
+	for ( i = 0; i < n; i++)
+	{
+		w[i] = period ? 1.0 : 0.5 - 0.5*cos( 2*FR_PI*i/n);
+		if ( period)
+		{
+			cs[i] = cos( 2*FR_PI*i/n);
+			sn[i] = sin( 2*FR_PI*i/n);
+		}
+	}
+
+	for ( a = optind; a < argc; a++)
+	{
+		if ( fr_read( argv[a], &sig))
+			return 1;
+		if ( dt == 0)
+			dt = sig.dt;
+		else if ( fabs( sig.dt - dt) > 1e-3*dt)
+		{
+			fprintf( stderr, "%s: sample time differs from the first capture\n", argv[a]);
+			return 1;
+		}
+
+		/* whole periods, or segments advancing by half a segment */
+		for ( s0 = 0; s0 + n <= sig.n; s0 += period ? n : n/2)
+		{
+			double mu = 0, my = 0;
+
+			for ( i = 0; i < n; i++)
+			{
+				mu += sig.u[s0 + i];
+				my += sig.y[s0 + i];
+			}
+			mu /= n;
+			my /= n;
+
+			if ( period)
+			{
+				for ( i = 0; i < n; i++)
+					tmp[i] = sig.u[s0 + i] - mu;
+				fr_dft( tmp, n, ur, ui, cs, sn);
+				for ( i = 0; i < n; i++)
+					tmp[i] = sig.y[s0 + i] - my;
+				fr_dft( tmp, n, yr, yi, cs, sn);
+			}
+			else
+			{
+				for ( i = 0; i < n; i++)
+				{
+					ur[i] = ( sig.u[s0 + i] - mu)*w[i];
+					yr[i] = ( sig.y[s0 + i] - my)*w[i];
+					ui[i] = yi[i] = 0;
+				}
+				fr_fft( ur, ui, n);
+				fr_fft( yr, yi, n);
+			}
+
+			for ( k = 0; k < nb; k++)
+			{
+				suu[k] += ur[k]*ur[k] + ui[k]*ui[k];
+				syy[k] += yr[k]*yr[k] + yi[k]*yi[k];
+				/* conj(U)*Y */
+				sr[k] += ur[k]*yr[k] + ui[k]*yi[k];
+				si[k] += ur[k]*yi[k] - ui[k]*yr[k];
+			}
+			n_avg++;
+		}
+
+		free( sig.u);
+		free( sig.y);
+	}
+
+	if ( n_avg == 0)
+	{
+		fprintf( stderr, "captures shorter than one segment (%zu samples)\n", n);
+		return 1;
+	}
+
+	/* velocity response magnitude and coherence */
+	for ( k = 1; k < nb; k++)
+	{
+		coh[k] = ( suu[k] > 0 && syy[k] > 0) ? ( sr[k]*sr[k] + si[k]*si[k])/( suu[k]*syy[k]) : 0;
+		gv[k] = ( suu[k] > 0) ? 10*log10( ( sr[k]*sr[k] + si[k]*si[k])/( suu[k]*suu[k]) + 1e-300) : -300;
+	}
+
+	/* resonances: prominent local maxima of the velocity response */
+	for ( k = 2; k + 2 < nb; k++)
+	{
+		size_t j;
+		double lo_l = gv[k], lo_r = gv[k], cw[2*FR_COH_WIN + 1];
+		size_t m = 0;
+
+		if ( n_avg < 2 || gv[k] < gv[k - 1] || gv[k] < gv[k + 1] ||
+		     gv[k] < gv[k - 2] || gv[k] < gv[k + 2])
+			continue;
+
+		for ( j = ( k > FR_COH_WIN) ? k - FR_COH_WIN : 1; j <= k + FR_COH_WIN && j < nb; j++)
+			cw[m++] = coh[j];
+		qsort( cw, m, sizeof(double), fr_cmp);
+		if ( cw[m/2] < coh_min)
+			continue;
+
+		for ( j = k; j > 1 && gv[j - 1] <= gv[k]; j--)
+			lo_l = fmin( lo_l, gv[j - 1]);
+		for ( j = k; j + 1 < nb && gv[j + 1] <= gv[k]; j++)
+			lo_r = fmin( lo_r, gv[j + 1]);
+		if ( gv[k] - lo_l < FR_PROM_DB || gv[k] - lo_r < FR_PROM_DB)
+			continue;
+
+		flag[k] = 1;
+		n_res++;
+	}
+
+	printf( "# %zu %s of %zu samples, fs %.1f Hz, resolution %.3f Hz\n", n_avg,
+	        period ? "periods" : "Hann segments", n, 1.0/dt, 1.0/( n*dt));
+	if ( n_avg < 2)
+		printf( "# single segment: coherence undefined, no resonance search\n");
+	for ( k = 0; k < nb; k++)
+	{
+		double f = k/( n*dt), f_lo, f_hi;
+		size_t j;
+
+		if ( !flag[k])
+			continue;
+		for ( j = k; j > 0 && gv[j] > gv[k] - 3.0; j--)
+			;
+		f_lo = j/( n*dt);
+		for ( j = k; j + 1 < nb && gv[j] > gv[k] - 3.0; j++)
+			;
+		f_hi = j/( n*dt);
+		printf( "# resonance %.2f Hz, %.1f dB re (m/s)/%%, Q %.1f\n",
+		        f, gv[k], ( f_hi > f_lo) ? f/( f_hi - f_lo) : 0.0);
+	}
+	if ( n_avg >= 2 && n_res == 0)
+		printf( "# no resonance found (coherence >= %.2f, prominence >= %.1f dB)\n", coh_min, FR_PROM_DB);
+
+	printf( "f,mag_db,phase_deg,vel_mag_db,coh,res\n");
+	for ( k = 1; k < nb; k++)
+	{
+		/* position = velocity * dt/(1 - exp(-j*w*dt)) */
+		double th = 2*FR_PI*k/n, hr, hi, dr, di, d2, pr, pi;
+
+		if ( suu[k] <= 0)
+			continue;
+		hr = sr[k]/suu[k];
+		hi = si[k]/suu[k];
+		dr = ( 1 - cos( th))/dt;
+		di = sin( th)/dt;
+		d2 = dr*dr + di*di;
+		pr = ( hr*dr + hi*di)/d2;
+		pi = ( hi*dr - hr*di)/d2;
+
+		printf( "%.4f,%.2f,%.1f,%.2f,%.3f,%d\n", k/( n*dt),
+		        10*log10( pr*pr + pi*pi + 1e-300), atan2( pi, pr)*180/FR_PI,
+		        gv[k], coh[k], flag[k]);
+	}
+
+	return 0;
+
+usage:
+	fprintf( stderr, "usage: %s [-n seg] [-p period] [-c cohmin] capture.csv ...\n"
+	         "       %s excite kind amp p1 p2 len\n", argv[0], argv[0]);
+	return 2;
+}
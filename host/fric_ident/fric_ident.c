@@ -0,0 +1,262 @@
+/*
+ * fric_ident.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Milos Lazic
+ *
+ *  Host tool estimating the dead band and friction compensation parameters
+ *  (struct LQR_fric_type, lqr_defs.h) from a logged open-loop run of the
+ *  cart, pendulum hanging.
+ *
+ *  Log: CSV lines "t,v,x" - time (s), motor voltage command (V) and cart
+ *  position (m), x measured in the direction driven by positive voltage
+ *  (i.e. -QEI1 counts * 2*pi*SHAFT_RADIUS/PPR). Lines that do not parse
+ *  (headers, comments) are skipped. The excitation should contain a slow
+ *  voltage ramp through zero (dead band) and steps or a chirp large
+ *  enough to move the cart at a range of speeds (friction).
+ *
+ *  Method:
+ *    - velocity and acceleration by central differences of x over +/- h
+ *    - still samples (|xdot| < FI_V_STILL): the breakaway voltage is the
+ *      FI_DB_PCTL percentile of |v|, i.e. the largest command that leaves
+ *      the cart stuck
+ *    - moving samples (|xdot| > FI_V_MOVE, |v| above breakaway): least
+ *      squares fit of
+ *          v = a*xdot' + b*xdot + c*sign(xdot) + d*sign(v)
+ *      then v_c = c (Coulomb friction), v_db = d (driver dead band) and
+ *      b_v = b - ke (back-emf is already part of the balance model); the
+ *      samples where the cart is braked (sign(v) != sign(xdot)) separate
+ *      c from d
+ *
+ *  Build (from repository root):
+ *      gcc -std=c99 -O2 -o fric_ident host/fric_ident/fric_ident.c -lm
+ *
+ *  Usage: fric_ident log.csv [h] [ke]
+ *      h  - differentiation half-window (s), default FI_H
+ *      ke - back-emf constant Kt/r (V per m/s), default FI_KE
+ *
+ *  The last line printed is the LQR_RIG_FRIC definition of lqr/lqr_rig.h
+ *  for the rig the log was taken on.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+
+#define FI_H         0.01     /* differentiation half-window (s) */
+#define FI_KE        2.884    /* back-emf constant Kt/r of the rig (V per m/s) */
+#define FI_V_MOVE    0.02     /* cart considered moving above this speed (m/s) */
+#define FI_V_STILL   0.002    /* cart considered stuck below this speed (m/s) */
+#define FI_DB_PCTL   0.95     /* breakaway percentile of |v| while stuck */
+#define FI_NP        4        /* number of fitted parameters */
+#define FI_V_EPS     0.01     /* suggested velocity blend band (m/s) */
+#define FI_E_EPS     0.1      /* suggested command blend band (V) */
+
+
+struct fi_sample_type
+{
+	double t, v, x;
+};
+
+
+static int fi_cmp( const void *a, const void *b)
+{
+	double d = *(const double*)a - *(const double*)b;
+	return ( d > 0) - ( d < 0);
+}
+
+
+/*
+ * Name: fi_solve
+ *
+ * Descr: Solves a FI_NP x FI_NP linear system by Gaussian elimination
+ *        with partial pivoting
+ *
+ * Args:     A - system matrix (destroyed)
+ *           b - right-hand side, replaced by the solution
+ *
+ * Return:   0 on success, -1 if A is singular
+ *
+ * Notes:
+ *
+ */
+static int fi_solve( double A[FI_NP][FI_NP], double b[FI_NP])
+{
+	int i, j, k, p;
+	double t;
+
+	for ( k = 0; k < FI_NP; k++)
+	{
+		p = k;
+		for ( i = k + 1; i < FI_NP; i++)
+			if ( fabs(A[i][k]) > fabs(A[p][k]))
+				p = i;
+		if ( fabs(A[p][k]) < 1e-12)
+			return -1;
+		for ( j = 0; j < FI_NP; j++)
+		{
+			t = A[k][j]; A[k][j] = A[p][j]; A[p][j] = t;
+		}
+		t = b[k]; b[k] = b[p]; b[p] = t;
+
+		for ( i = k + 1; i < FI_NP; i++)
+		{
+			t = A[i][k]/A[k][k];
+			for ( j = k; j < FI_NP; j++)
+				A[i][j] -= t*A[k][j];
+			b[i] -= t*b[k];
+		}
+	}
+
+	for ( k = FI_NP - 1; k >= 0; k--)
+	{
+		for ( j = k + 1; j < FI_NP; j++)
+			b[k] -= A[k][j]*b[j];
+		b[k] /= A[k][k];
+	}
+
+	return 0;
+}
+
+
+int main( int argc, char **argv)
+{
+	FILE *f;
+	char line[256];
+	struct fi_sample_type *s = NULL;
+	double *still = NULL;
+	size_t n = 0, cap = 0, n_move = 0, n_still = 0, i, lo, hi;
+	double h = ( argc > 2) ? atof(argv[2]) : FI_H;
+	double ke = ( argc > 3) ? atof(argv[3]) : FI_KE;
+	double A[FI_NP][FI_NP] = {{ 0 }}, b[FI_NP] = { 0 }, phi[FI_NP];
+	double xd, xdd, v_brk = 0, res = 0, r;
+	int j, k, pass;
+
+	if ( argc < 2 || h <= 0)
+	{
+		fprintf( stderr, "usage: %s log.csv [h] [ke]\n", argv[0]);
+		return 2;
+	}
+
+	if ( (f = fopen( argv[1], "r")) == NULL)
+	{
+		perror( argv[1]);
+		return 1;
+	}
+
+	while ( fgets( line, sizeof(line), f))
+	{
+		struct fi_sample_type e;
+
+		if ( sscanf( line, "%lf,%lf,%lf", &e.t, &e.v, &e.x) != 3)
+			continue;
+		if ( n == cap)
+		{
+			cap = cap ? 2*cap : 4096;
+			s = realloc( s, cap*sizeof(*s));
+			if ( s == NULL)
+			{
+				fclose( f);
+				fprintf( stderr, "out of memory\n");
+				return 1;
+			}
+		}
+		s[n++] = e;
+	}
+	fclose( f);
+
+	still = malloc( (n ? n : 1)*sizeof(*still));
+	if ( still == NULL)
+	{
+		fprintf( stderr, "out of memory\n");
+		return 1;
+	}
+
+	/* pass 0: breakaway voltage from the still samples; pass 1: fit
+	 * over the moving samples; lo/hi bracket t -/+ h */
+	for ( pass = 0; pass < 2; pass++)
+	{
+		if ( pass == 1)
+		{
+			if ( n_still < 10)
+			{
+				fprintf( stderr, "not enough still samples (%zu)\n", n_still);
+				return 1;
+			}
+			qsort( still, n_still, sizeof(*still), fi_cmp);
+			v_brk = still[(size_t)(FI_DB_PCTL*(n_still - 1))];
+		}
+
+		for ( i = 0, lo = 0, hi = 0; i < n; i++)
+		{
+			while ( s[lo].t < s[i].t - h)
+				lo++;
+			while ( hi + 1 < n && s[hi].t < s[i].t + h)
+				hi++;
+			if ( lo == i || hi == i || s[hi].t - s[i].t < 0.5*h || s[i].t - s[lo].t < 0.5*h)
+				continue;
+
+			xd = (s[hi].x - s[lo].x)/(s[hi].t - s[lo].t);
+
+			if ( pass == 0)
+			{
+				if ( fabs(xd) < FI_V_STILL)
+					still[n_still++] = fabs(s[i].v);
+				continue;
+			}
+
+			if ( fabs(xd) <= FI_V_MOVE || fabs(s[i].v) <= v_brk)
+				continue;
+
+			xdd = ((s[hi].x - s[i].x)/(s[hi].t - s[i].t) -
+			       (s[i].x - s[lo].x)/(s[i].t - s[lo].t)) / (0.5*(s[hi].t - s[lo].t));
+
+			phi[0] = xdd;
+			phi[1] = xd;
+			phi[2] = ( xd > 0) ? 1.0 : -1.0;
+			phi[3] = ( s[i].v > 0) ? 1.0 : -1.0;
+			for ( j = 0; j < FI_NP; j++)
+			{
+				for ( k = 0; k < FI_NP; k++)
+					A[j][k] += phi[j]*phi[k];
+				b[j] += phi[j]*s[i].v;
+			}
+			res += s[i].v*s[i].v;
+			n_move++;
+		}
+	}
+
+	if ( n_move < 10)
+	{
+		fprintf( stderr, "not enough moving samples (%zu)\n", n_move);
+		return 1;
+	}
+
+	/* residual = v'v - theta'(Phi'v), evaluated before b is overwritten */
+	for ( j = 0; j < FI_NP; j++)
+		phi[j] = b[j];
+	if ( fi_solve( A, b))
+	{
+		fprintf( stderr, "fit is singular; widen the excitation\n");
+		return 1;
+	}
+	for ( j = 0; j < FI_NP; j++)
+		res -= b[j]*phi[j];
+	r = sqrt( (res > 0 ? res : 0)/n_move);
+
+	printf( "# %zu samples: %zu moving, %zu still; fit rms %.4f V\n",
+	        n, n_move, n_still, r);
+	printf( "# v = %.5f*xdot' + %.4f*xdot + %.4f*sign(xdot) + %.4f*sign(v), ke = %.4f\n",
+	        b[0], b[1], b[2], b[3], ke);
+	printf( "# breakaway %.4f V (fit: v_db + v_c = %.4f V)\n", v_brk, b[2] + b[3]);
+	printf( "#define LQR_RIG_FRIC     { %.4ff, %.4ff, %.4ff, %.1ff, %.1ff }\n",
+	        b[3] > 0 ? b[3] : 0, b[2] > 0 ? b[2] : 0, b[1] - ke > 0 ? b[1] - ke : 0,
+	        1.0/FI_V_EPS, 1.0/FI_E_EPS);
+
+	free( still);
+	free( s);
+
+	return 0;
+}
@@ -0,0 +1,330 @@
+/*
+ * lqi_design.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Milos Lazic
+ *
+ *  Host tool designing the gains of the LQI balance controller
+ *  (LQR_Balance_CtrlRunLQI): the plant model augmented with the integral
+ *  of the cart position error is discretized at the control period and
+ *  the discrete algebraic Riccati equation is solved offline; the tool
+ *  prints the LQR_RIG_LQI_* definitions of the rig (lqr/lqr_rig.h) the
+ *  default parameter bank is built with.
+ *
+ *  Model: the continuous A, B printed by host/sys_ident (lines "A = [..]"
+ *  and "B = [..]", state [x; x'; th; th'], input V, controller encoder
+ *  frames); other lines are ignored, so the sys_ident output is read as
+ *  is. The augmented state is [x; x'; th; th'; xi], xi' = x - sp.
+ *
+ *  Weights (Bryson's rule): Q = diag(1/dz^2), dz the acceptable excursion
+ *  of each augmented state, R = 1/u_max^2. The integral weight sets how
+ *  fast a load offset is worked off. On the simulated plant the defaults
+ *  stay close to the hand-tuned LQR gains, with rate gains low enough
+ *  for the 50 ms QEI velocity period, and work a load offset off
+ *  in about 0.5 s.
+ *
+ *  Riccati equation: structure-preserving doubling, which converges in a
+ *  few tens of iterations where the plain recursion would need one per
+ *  control period of the slowest closed loop mode. The closed loop
+ *  spectral radius is checked on the discrete model.
+ *
+ *  Anti-windup: back-calculation, xi' = (x - sp) - aw*(u_sat - u) with
+ *  aw = 1/(Ki*Tt); Tt is the time constant with which the integrator
+ *  tracks the saturated output (-t).
+ *
+ *  Build (from repository root):
+ *      gcc -std=c99 -O2 -o lqi_design host/lqi_design/lqi_design.c -lm
+ *
+ *  Usage: lqi_design [-T ts] [-q dx,dxd,dth,dthd,dxi] [-u u_max] [-t tt]
+ *                    model.txt
+ *      ts    - control period (s), default LD_TS
+ *      dz    - acceptable excursions (m, m/s, rad, rad/s, m*s), default
+ *              LD_DZ
+ *      u_max - acceptable input (V), default LD_UMAX
+ *      tt    - anti-windup tracking time constant (s), default LD_TT
+ */
+
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include "../common/host_model.h"
+
+
+#define LD_NS      HM_NS    /* plant states */
+#define LD_N       (LD_NS + 1)   /* augmented states */
+#define LD_TS      0.0001   /* control period (s); SysTick at 10 kHz */
+#define LD_UMAX    12.0     /* actuator limit (V) */
+#define LD_TT      0.02     /* anti-windup tracking time constant (s) */
+#define LD_DZ      { 0.8, 2.0, 2.0, 10.0, 0.5 }
+#define LD_SDA_MAX 100      /* doubling iterations */
+#define LD_SDA_TOL 1e-12    /* relative change of the solution */
+#define LD_RHO_SQ  40       /* squarings of the spectral radius estimate */
+
+
+typedef double ld_mat_type[LD_N][LD_N];
+
+
+static void ld_mul( ld_mat_type C, ld_mat_type A, ld_mat_type B)
+{
+	ld_mat_type T;
+	int i, j, k;
+
+	for ( i = 0; i < LD_N; i++)
+		for ( j = 0; j < LD_N; j++)
+			for ( k = 0, T[i][j] = 0; k < LD_N; k++)
+				T[i][j] += A[i][k]*B[k][j];
+	memcpy( C, T, sizeof(T));
+}
+
+
+static void ld_trans( ld_mat_type C, ld_mat_type A)
+{
+	ld_mat_type T;
+	int i, j;
+
+	for ( i = 0; i < LD_N; i++)
+		for ( j = 0; j < LD_N; j++)
+			T[i][j] = A[j][i];
+	memcpy( C, T, sizeof(T));
+}
+
+
+static double ld_norm( ld_mat_type A)
+{
+	double n = 0;
+	int i, j;
+
+	for ( i = 0; i < LD_N; i++)
+		for ( j = 0; j < LD_N; j++)
+			n = fmax( n, fabs(A[i][j]));
+
+	return n;
+}
+
+
+/* Gauss-Jordan inverse with partial pivoting; -1 if singular */
+static int ld_inv( ld_mat_type C, ld_mat_type A)
+{
+	double M[LD_N][2*LD_N], t;
+	int i, j, k, p;
+
+	for ( i = 0; i < LD_N; i++)
+		for ( j = 0; j < LD_N; j++)
+		{
+			M[i][j] = A[i][j];
+			M[i][LD_N + j] = ( i == j);
+		}
+
+	for ( k = 0; k < LD_N; k++)
+	{
+		for ( p = k, i = k + 1; i < LD_N; i++)
+			if ( fabs(M[i][k]) > fabs(M[p][k]))
+				p = i;
+		if ( fabs(M[p][k]) < 1e-300)
+			return -1;
+		for ( j = 0; j < 2*LD_N; j++)
+		{
+			t = M[k][j];
+			M[k][j] = M[p][j];
+			M[p][j] = t;
+		}
+		for ( t = M[k][k], j = 0; j < 2*LD_N; j++)
+			M[k][j] /= t;
+		for ( i = 0; i < LD_N; i++)
+			if ( i != k)
+				for ( t = M[i][k], j = 0; j < 2*LD_N; j++)
+					M[i][j] -= t*M[k][j];
+	}
+
+	for ( i = 0; i < LD_N; i++)
+		for ( j = 0; j < LD_N; j++)
+			C[i][j] = M[i][LD_N + j];
+
+	return 0;
+}
+
+
+/*
+ * Solves P = A'PA - A'PB (R + B'PB)^-1 B'PA + Q by structure-preserving
+ * doubling; returns the iterations used, -1 if it fails to converge
+ */
+static int ld_dare( ld_mat_type A, double B[LD_N], ld_mat_type Q, double R, ld_mat_type P)
+{
+	ld_mat_type Ak, G, H, W, Wi, T, U, At;
+	double d;
+	int i, j, it;
+
+	memcpy( Ak, A, sizeof(Ak));
+	memcpy( H, Q, sizeof(H));
+	for ( i = 0; i < LD_N; i++)
+		for ( j = 0; j < LD_N; j++)
+			G[i][j] = B[i]*B[j]/R;
+
+	for ( it = 1; it <= LD_SDA_MAX; it++)
+	{
+		/* W = I + G*H */
+		ld_mul( W, G, H);
+		for ( i = 0; i < LD_N; i++)
+			W[i][i] += 1;
+		if ( ld_inv( Wi, W))
+			return -1;
+		ld_trans( At, Ak);
+
+		/* H += A'*H*W^-1*A */
+		ld_mul( T, H, Wi);
+		ld_mul( T, At, T);
+		ld_mul( T, T, Ak);
+		for ( d = 0, i = 0; i < LD_N; i++)
+			for ( j = 0; j < LD_N; j++)
+			{
+				H[i][j] += T[i][j];
+				d = fmax( d, fabs(T[i][j]));
+			}
+
+		/* G += A*W^-1*G*A' */
+		ld_mul( U, Wi, G);
+		ld_mul( U, Ak, U);
+		ld_mul( U, U, At);
+		for ( i = 0; i < LD_N; i++)
+			for ( j = 0; j < LD_N; j++)
+				G[i][j] += U[i][j];
+
+		/* A = A*W^-1*A */
+		ld_mul( T, Ak, Wi);
+		ld_mul( Ak, T, Ak);
+
+		if ( d <= LD_SDA_TOL*ld_norm( H))
+		{
+			memcpy( P, H, sizeof(H));
+			return it;
+		}
+	}
+
+	return -1;
+}
+
+
+/* spectral radius, from ||M^(2^n)||^(2^-n) with the scale kept as a log */
+static double ld_rho( ld_mat_type M)
+{
+	ld_mat_type T;
+	double lg = 0, n;
+	int i, j, k;
+
+	memcpy( T, M, sizeof(T));
+	for ( k = 0; k < LD_RHO_SQ; k++)
+	{
+		ld_mul( T, T, T);
+		n = ld_norm( T);
+		if ( n == 0)
+			return 0;
+		for ( i = 0; i < LD_N; i++)
+			for ( j = 0; j < LD_N; j++)
+				T[i][j] /= n;
+		lg = 2*lg + log( n);
+	}
+
+	return exp( ldexp( lg, -LD_RHO_SQ));
+}
+
+
+int main( int argc, char **argv)
+{
+	double A[LD_NS][LD_NS], B[LD_NS], dz[LD_N] = LD_DZ;
+	double ts = LD_TS, u_max = LD_UMAX, tt = LD_TT;
+	ld_mat_type Aa = {{ 0 }}, Ad, Q = {{ 0 }}, P, Acl;
+	double Ba[LD_N] = { 0 }, Bd[LD_N], K[LD_N], PB[LD_N], R, den, rho;
+	int opt, i, j, it;
+
+	while ( (opt = getopt( argc, argv, "T:q:u:t:")) != -1)
+	{
+		switch ( opt)
+		{
+		case 'T': ts = atof( optarg); break;
+		case 'q':
+			if ( sscanf( optarg, "%lf,%lf,%lf,%lf,%lf", &dz[0], &dz[1], &dz[2], &dz[3], &dz[4]) != LD_N)
+				goto usage;
+			break;
+		case 'u': u_max = atof( optarg); break;
+		case 't': tt = atof( optarg); break;
+		default: goto usage;
+		}
+	}
+	if ( argc - optind != 1 || ts <= 0 || u_max <= 0 || tt <= 0)
+		goto usage;
+	for ( i = 0; i < LD_N; i++)
+		if ( dz[i] <= 0)
+			goto usage;
+
+	if ( hm_read_model( argv[optind], A, B))
+		return 1;
+
+	/* augmented model, xi' = x */
+	for ( i = 0; i < LD_NS; i++)
+	{
+		for ( j = 0; j < LD_NS; j++)
+			Aa[i][j] = A[i][j];
+		Ba[i] = B[i];
+	}
+	Aa[LD_NS][0] = 1;
+	/* zero order hold of the augmented model */
+	hm_expm_zoh( LD_N, &Aa[0][0], Ba, ts, &Ad[0][0], Bd);
+
+	for ( i = 0; i < LD_N; i++)
+		Q[i][i] = 1/(dz[i]*dz[i]);
+	R = 1/(u_max*u_max);
+
+	it = ld_dare( Ad, Bd, Q, R, P);
+	if ( it < 0)
+	{
+		fprintf( stderr, "Riccati equation did not converge; is the model stabilizable?\n");
+		return 1;
+	}
+
+	/* K = (R + B'PB)^-1 B'PA */
+	for ( i = 0; i < LD_N; i++)
+		for ( j = 0, PB[i] = 0; j < LD_N; j++)
+			PB[i] += P[i][j]*Bd[j];
+	for ( i = 0, den = R; i < LD_N; i++)
+		den += Bd[i]*PB[i];
+	for ( j = 0; j < LD_N; j++)
+		for ( i = 0, K[j] = 0; i < LD_N; i++)
+			K[j] += PB[i]*Ad[i][j]/den;
+
+	for ( i = 0; i < LD_N; i++)
+		for ( j = 0; j < LD_N; j++)
+			Acl[i][j] = Ad[i][j] - Bd[i]*K[j];
+	rho = ld_rho( Acl);
+
+	printf( "# LQI design, Ts = %g s, dz = [%g %g %g %g %g], u_max = %g V, Tt = %g s\n",
+	        ts, dz[0], dz[1], dz[2], dz[3], dz[4], u_max, tt);
+	printf( "# Riccati: %d doubling iterations\n", it);
+	printf( "# closed loop spectral radius %.9f (slowest time constant %.3f s)\n",
+	        rho, ( rho < 1) ? -ts/log( rho) : INFINITY);
+	if ( rho >= 1)
+	{
+		fprintf( stderr, "closed loop is unstable\n");
+		return 1;
+	}
+	if ( K[LD_NS] == 0)
+	{
+		fprintf( stderr, "zero integral gain; the integral state is not weighted\n");
+		return 1;
+	}
+
+	printf( "#define LQR_RIG_LQI_K    { 0, %.6g, %.6g, %.6g, %.6g }\n", K[0], K[1], K[2], K[3]);
+	printf( "#define LQR_RIG_LQI_KI   %.6g\n", K[LD_NS]);
+	printf( "#define LQR_RIG_LQI_NBAR %.6g\n", K[0]);
+	printf( "#define LQR_RIG_LQI_AW   %.6g\n", 1/(K[LD_NS]*tt));
+
+	return 0;
+
+usage:
+	fprintf( stderr, "usage: %s [-T ts] [-q dx,dxd,dth,dthd,dxi] [-u u_max] [-t tt] model.txt\n",
+	         argv[0]);
+	return 2;
+}
@@ -0,0 +1,1042 @@
+/*
+ * robust.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Milos Lazic
+ *
+ *  Host tool checking the robustness of candidate balance gain sets
+ *  (K, Nbar of LQR_Balance_CtrlRun) before they are flashed or loaded
+ *  with eCMD_ID_SET_GAINS: closed loop eigenvalues, gain, phase and delay
+ *  margins and sensitivity peaks of every candidate, on the identified
+ *  model and on a Monte-Carlo set of perturbed plants; the candidates are
+ *  ranked by the margins they keep on most of the plants.
+ *
+ *  Model: the continuous A, B printed by host/sys_ident (lines "A = [..]"
+ *  and "B = [..]", state [x; x'; th; th'], input V, controller encoder
+ *  frames), as read by host/lqi_design.
+ *
+ *  Loop: u = Nbar*sp - K*x with the firmware state vector [i; x; x'; th;
+ *  th'] (i is not measured and reads zero, so K[0] has no effect),
+ *  sampled every ts and applied after a delay (sample to output, any
+ *  fraction of a period) through the zero order hold. The plant is
+ *  discretized exactly, delay included; the closed loop state adds the
+ *  outputs still in the delay line. The latency prediction of the
+ *  firmware (LQR_Balance_SetModel) is not modelled: the delay is what it
+ *  leaves uncompensated.
+ *
+ *  Analysis of a candidate on one plant:
+ *    - closed loop eigenvalues (Hessenberg reduction, shifted QR); the
+ *      loop is stable if all lie inside the unit circle
+ *    - loop transfer function L = K*(zI - Ad)^-1*Bd(z), broken at the
+ *      plant input, on a logarithmic grid up to the Nyquist frequency;
+ *      crossings are interpolated between grid points
+ *    - gain margins: the range of loop gain factors that keeps the loop
+ *      stable, from the crossings of the negative real axis (the plant is
+ *      open loop unstable, so there is a lower as well as an upper margin)
+ *    - phase margin: the smallest phase shift, lag or lead, at a gain
+ *      crossover; delay margin: the smallest added delay that brings a
+ *      gain crossover onto -1
+ *    - sensitivity peaks Ms = max|1/(1 + L)| and Mt = max|L/(1 + L)|
+ *    - DC tracking: steady state cart position per unit set point (1
+ *      with a matched Nbar)
+ *
+ *  Monte-Carlo: every coefficient of the dynamic rows of A and B (x'' and
+ *  th'') is scaled by 1 + u*N(0,1), the delay is drawn uniformly within
+ *  +/- spread; the plant set is drawn once (seed -s) and shared by all
+ *  candidates, so the ranking compares them on the same plants. The
+ *  response of every plant to its input is computed once on the grid;
+ *  per candidate only the product with K remains, and the candidates
+ *  are spread over all cores.
+ *
+ *  Quantile: every margin is reported as the value the share q (-q) of
+ *  the plants, nominal included, meet or better; an unstable plant counts
+ *  as no margin (0 dB, 0 deg, 0 s, infinite Ms, Mt). q = 1 gives the
+ *  worst case, which a few unlucky draws dominate. The DC tracking gain is
+ *  the one farthest from 1 over the stable plants.
+ *
+ *  Ranking: Ms at the quantile, then the share of stable plants.
+ *
+ *  Candidates: one per line, K0 K1 K2 K3 K4 Nbar (blank, comma or tab
+ *  separated; '#' starts a comment), or a single -k set; without either
+ *  the compiled-in gains (lqr/lqr_rig.h) are checked.
+ *
+ *  Output (stdout): "# ..." lines (settings, throughput, the nominal
+ *  eigenvalues and margins of the best candidate), then CSV of the
+ *  ranked candidates, margins at the quantile: rank, line, stable plants
+ *  (%), nominal spectral radius, lower and upper gain margin (dB),
+ *  phase margin (deg), delay margin (ms), Ms, Mt, DC tracking gain, K0..K4,
+ *  Nbar.
+ *
+ *  Build (from repository root):
+ *      gcc -std=c99 -O2 -pthread -o robust host/robust/robust.c -lm
+ *
+ *  Usage: robust [-T ts] [-d delay] [-D spread] [-u unc] [-n plants]
+ *                [-q quant] [-s seed] [-j threads] [-t top]
+ *                [-k k0,k1,k2,k3,k4,nbar] model.txt [candidates.txt|-]
+ *      ts      - control period (s), default RB_TS
+ *      delay   - sample to output delay (s), default RB_DELAY
+ *      spread  - delay uncertainty, +/- (s), default RB_DELAY_SPREAD
+ *      unc     - relative standard deviation of the model coefficients,
+ *                default RB_UNC
+ *      plants  - perturbed plants besides the nominal, default RB_PLANTS
+ *      quant   - share of the plants the margins hold for, default
+ *                RB_QUANT
+ *      threads - default: all online processors
+ *      top     - candidates printed, 0 for all, default RB_TOP
+ */
+
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <float.h>
+#include <math.h>
+#include <complex.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include "../../lqr/lqr_rig.h"
+#include "../common/host_model.h"
+
+
+#define RB_NS           HM_NS    /* plant states */
+#define RB_NK           5        /* firmware gains (i, x, x', th, th') */
+#define RB_TS           0.0001   /* control period (s); SysTick at 10 kHz */
+#define RB_DELAY        0.0001   /* sample to output delay (s) */
+#define RB_DELAY_SPREAD 0.0001   /* delay uncertainty, +/- (s) */
+#define RB_UNC          0.1      /* relative standard deviation of the model coefficients */
+#define RB_PLANTS       200      /* perturbed plants */
+#define RB_QUANT        0.9      /* share of the plants the reported margins hold for */
+#define RB_TOP          10       /* candidates printed */
+#define RB_M_MAX        32       /* longest delay (control periods) */
+#define RB_N_MAX        (RB_NS + RB_M_MAX + 1)   /* closed loop states */
+#define RB_NW           400      /* frequency grid points */
+#define RB_W_MIN        0.01     /* lowest grid frequency (rad/s) */
+#define RB_QR_ITS       60       /* QR iterations per eigenvalue */
+#define RB_THR_MAX      256      /* worker threads */
+#define RB_BLOCK        32       /* candidates analysed together, plant by plant */
+
+
+typedef double rb_mat_type[RB_N_MAX][RB_N_MAX];
+
+
+/* Name: rb_plant_type
+ *
+ * Description: one discretized plant of the Monte-Carlo set
+ *
+ * Members: Ad - state transition over a control period
+ *          B0 - input of the output applied m periods ago
+ *          B1 - input of the output applied m + 1 periods ago (fraction
+ *               of a period of delay)
+ *          m  - whole periods of delay
+ *          gr - response of the states to the plant input on the grid,
+ *          gi   (zI - Ad)^-1*(B0*z^-m + B1*z^-(m+1)); real and imaginary
+ *               parts, state by state, so that the products with K
+ *               vectorize
+ *
+ * Notes:
+ *
+ */
+struct rb_plant_type
+{
+	double Ad[RB_NS][RB_NS];
+	double B0[RB_NS];
+	double B1[RB_NS];
+	int m;
+	double gr[RB_NS][RB_NW];
+	double gi[RB_NS][RB_NW];
+};
+
+
+/* Name: rb_res_type
+ *
+ * Description: analysis of a candidate; per plant, or at the quantile
+ *              over all plants
+ *
+ * Members: n_stable - stable plants
+ *          rho      - spectral radius of the nominal closed loop
+ *          gm_lo    - lower gain margin (factor, < 1; 0 if none)
+ *          gm_hi    - upper gain margin (factor, > 1; inf if none)
+ *          pm       - phase margin (rad)
+ *          dm       - delay margin (s)
+ *          ms       - sensitivity peak
+ *          mt       - complementary sensitivity peak
+ *          dc       - DC tracking gain
+ *
+ * Notes:
+ *
+ */
+struct rb_res_type
+{
+	int n_stable;
+	double rho;
+	double gm_lo;
+	double gm_hi;
+	double pm;
+	double dm;
+	double ms;
+	double mt;
+	double dc;
+};
+
+
+struct rb_cand_type
+{
+	int line;
+	double K[RB_NK];
+	double Nbar;
+	struct rb_res_type r;
+};
+
+
+static struct
+{
+	double ts;
+	double q;
+	double w[RB_NW];
+	struct rb_plant_type *plant;
+	int n_plant;
+	struct rb_cand_type *cand;
+	size_t n_cand;
+	int n_thr;
+} rb;
+
+
+/* solves M*x = b in place (x returned in b), partial pivoting; -1 if singular */
+static int rb_solve_c( double complex M[RB_NS][RB_NS], double complex b[RB_NS])
+{
+	double complex t;
+	int i, j, k, p;
+
+	for ( k = 0; k < RB_NS; k++)
+	{
+		for ( p = k, i = k + 1; i < RB_NS; i++)
+			if ( cabs( M[i][k]) > cabs( M[p][k]))
+				p = i;
+		if ( M[p][k] == 0)
+			return -1;
+		for ( j = k; j < RB_NS; j++)
+		{
+			t = M[k][j];
+			M[k][j] = M[p][j];
+			M[p][j] = t;
+		}
+		t = b[k];
+		b[k] = b[p];
+		b[p] = t;
+		for ( i = k + 1; i < RB_NS; i++)
+		{
+			t = M[i][k]/M[k][k];
+			for ( j = k; j < RB_NS; j++)
+				M[i][j] -= t*M[k][j];
+			b[i] -= t*b[k];
+		}
+	}
+	for ( k = RB_NS - 1; k >= 0; k--)
+	{
+		for ( j = k + 1; j < RB_NS; j++)
+			b[k] -= M[k][j]*b[j];
+		b[k] /= M[k][k];
+	}
+
+	return 0;
+}
+
+
+/*
+ * Discretizes the plant with the delay and computes its input response
+ * on the grid; -1 if the delay is out of range
+ */
+static int rb_plant_init( struct rb_plant_type *p, double A[RB_NS][RB_NS], double B[RB_NS],
+                          double delay)
+{
+	double E0[RB_NS][RB_NS], E1[RB_NS][RB_NS], G0[RB_NS], G1[RB_NS], f;
+	double complex M[RB_NS][RB_NS], g[RB_NS], z, zm;
+	int i, j, k;
+
+	if ( !( delay >= 0) || delay >= RB_M_MAX*rb.ts)
+		return -1;
+
+	/* delay = (m + f)*ts: over a period, the output of m + 1 periods ago
+	 * is applied for f*ts, then the output of m periods ago */
+	p->m = (int)( delay/rb.ts);
+	f = delay/rb.ts - p->m;
+
+	hm_expm_zoh( RB_NS, &A[0][0], B, ( 1 - f)*rb.ts, &E0[0][0], G0);
+	hm_expm_zoh( RB_NS, &A[0][0], B, f*rb.ts, &E1[0][0], G1);
+	for ( i = 0; i < RB_NS; i++)
+	{
+		p->B0[i] = G0[i];
+		p->B1[i] = 0;
+		for ( j = 0; j < RB_NS; j++)
+		{
+			p->B1[i] += E0[i][j]*G1[j];
+			for ( k = 0, p->Ad[i][j] = 0; k < RB_NS; k++)
+				p->Ad[i][j] += E0[i][k]*E1[k][j];
+		}
+	}
+
+	for ( k = 0; k < RB_NW; k++)
+	{
+		z = cexp( I*rb.w[k]*rb.ts);
+		zm = cpow( z, -p->m);
+		for ( i = 0; i < RB_NS; i++)
+		{
+			for ( j = 0; j < RB_NS; j++)
+				M[i][j] = ( i == j)*z - p->Ad[i][j];
+			g[i] = ( p->B0[i] + p->B1[i]/z)*zm;
+		}
+		if ( rb_solve_c( M, g))
+			return -1;
+		for ( i = 0; i < RB_NS; i++)
+		{
+			p->gr[i][k] = creal( g[i]);
+			p->gi[i][k] = cimag( g[i]);
+		}
+	}
+
+	return 0;
+}
+
+
+/* closed loop state [x; u(k-1) .. u(k-m-1)]; returns its size */
+static int rb_closed_loop( const double *K, const struct rb_plant_type *p, rb_mat_type H)
+{
+	int n = RB_NS + p->m + 1, i, j;
+
+	for ( i = 0; i < n; i++)
+		for ( j = 0; j < n; j++)
+			H[i][j] = 0;
+
+	for ( i = 0; i < RB_NS; i++)
+	{
+		for ( j = 0; j < RB_NS; j++)
+			H[i][j] = p->Ad[i][j];
+		if ( p->m == 0)
+			for ( j = 0; j < RB_NS; j++)
+				H[i][j] -= p->B0[i]*K[j];
+		else
+			H[i][RB_NS + p->m - 1] = p->B0[i];
+		H[i][RB_NS + p->m] = p->B1[i];
+	}
+
+	/* u(k) = -K*x(k) enters the delay line, which shifts by one */
+	for ( j = 0; j < RB_NS; j++)
+		H[RB_NS][j] = -K[j];
+	for ( i = RB_NS + 1; i < n; i++)
+		H[i][i - 1] = 1;
+
+	return n;
+}
+
+
+/* reduction to upper Hessenberg form by elementary similarity
+ * transformations with pivoting */
+static void rb_hess( rb_mat_type H, int n)
+{
+	double t, f;
+	int i, j, k, p;
+
+	for ( k = 1; k < n - 1; k++)
+	{
+		for ( p = k, i = k + 1; i < n; i++)
+			if ( fabs(H[i][k-1]) > fabs(H[p][k-1]))
+				p = i;
+		if ( H[p][k-1] == 0)
+			continue;
+		if ( p != k)
+		{
+			for ( j = 0; j < n; j++)
+			{
+				t = H[p][j];
+				H[p][j] = H[k][j];
+				H[k][j] = t;
+			}
+			for ( i = 0; i < n; i++)
+			{
+				t = H[i][p];
+				H[i][p] = H[i][k];
+				H[i][k] = t;
+			}
+		}
+		for ( i = k + 1; i < n; i++)
+		{
+			f = H[i][k-1]/H[k][k-1];
+			if ( f == 0)
+				continue;
+			/* row i -= f*row k, then column k += f*column i */
+			for ( j = k - 1; j < n; j++)
+				H[i][j] -= f*H[k][j];
+			for ( j = 0; j < n; j++)
+				H[j][k] += f*H[j][i];
+			H[i][k-1] = 0;
+		}
+	}
+}
+
+
+/* L1 norm of a complex number; cheaper than cabs for comparisons */
+#define RB_CNORM1(z) ( fabs(creal( z)) + fabs(cimag( z)))
+
+
+/* rotation [c s; -conj(s) c] taking [a; b] to [r; 0]; the entries are
+ * of the order of the matrix norm, so the squares cannot overflow */
+static void rb_givens( double complex a, double complex b, double *c, double complex *s)
+{
+	double a2 = creal( a)*creal( a) + cimag( a)*cimag( a);
+	double b2 = creal( b)*creal( b) + cimag( b)*cimag( b);
+	double aa = sqrt( a2), r = sqrt( a2 + b2);
+
+	if ( r == 0)
+	{
+		*c = 1;
+		*s = 0;
+	}
+	else if ( aa == 0)
+	{
+		*c = 0;
+		*s = 1;
+	}
+	else
+	{
+		*c = aa/r;
+		*s = ( a/aa)*conj( b)/r;
+	}
+}
+
+
+/*
+ * Eigenvalues of H (destroyed): Hessenberg reduction, then complex QR
+ * steps with Wilkinson shifts and deflation; -1 if an eigenvalue fails
+ * to converge
+ */
+static int rb_eig( rb_mat_type H, int n, double complex *ev)
+{
+	double complex A[RB_N_MAX][RB_N_MAX], sn[RB_N_MAX], a, b, c, d, t, disc, den, mu, t1, t2;
+	double cs[RB_N_MAX], nrm = 0, tol;
+	int hi, lo, i, j, k, its = 0;
+
+	rb_hess( H, n);
+	for ( i = 0; i < n; i++)
+		for ( j = 0; j < n; j++)
+		{
+			A[i][j] = H[i][j];
+			nrm = fmax( nrm, fabs(H[i][j]));
+		}
+
+	for ( hi = n - 1; hi >= 0; )
+	{
+		for ( lo = hi; lo > 0; lo--)
+		{
+			tol = RB_CNORM1( A[lo][lo]) + RB_CNORM1( A[lo-1][lo-1]);
+			if ( RB_CNORM1( A[lo][lo-1]) <= DBL_EPSILON*( ( tol > 0) ? tol : nrm))
+			{
+				A[lo][lo-1] = 0;
+				break;
+			}
+		}
+		if ( lo == hi)
+		{
+			ev[hi] = A[hi][hi];
+			hi--;
+			its = 0;
+			continue;
+		}
+		if ( ++its > RB_QR_ITS)
+			return -1;
+
+		/* eigenvalue of the trailing 2x2 block closer to its last entry;
+		 * an exceptional shift now and then breaks cycles */
+		a = A[hi-1][hi-1];
+		b = A[hi-1][hi];
+		c = A[hi][hi-1];
+		d = A[hi][hi];
+		t = 0.5*( a - d);
+		disc = csqrt( t*t + b*c);
+		den = ( RB_CNORM1( t + disc) >= RB_CNORM1( t - disc)) ? t + disc : t - disc;
+		mu = ( den != 0) ? d - b*c*conj( den)/( creal( den)*creal( den) + cimag( den)*cimag( den)) : d;
+		if ( its % 10 == 0)
+			mu = d + RB_CNORM1( c);
+
+		for ( i = lo; i <= hi; i++)
+			A[i][i] -= mu;
+		for ( k = lo; k < hi; k++)
+		{
+			rb_givens( A[k][k], A[k+1][k], &cs[k], &sn[k]);
+			for ( j = k; j <= hi; j++)
+			{
+				t1 = A[k][j];
+				t2 = A[k+1][j];
+				A[k][j] = cs[k]*t1 + sn[k]*t2;
+				A[k+1][j] = -conj( sn[k])*t1 + cs[k]*t2;
+			}
+		}
+		for ( k = lo; k < hi; k++)
+			for ( i = lo; i <= k + 1; i++)
+			{
+				t1 = A[i][k];
+				t2 = A[i][k+1];
+				A[i][k] = cs[k]*t1 + conj( sn[k])*t2;
+				A[i][k+1] = -sn[k]*t1 + cs[k]*t2;
+			}
+		for ( i = lo; i <= hi; i++)
+			A[i][i] += mu;
+	}
+
+	return 0;
+}
+
+
+/* steady state cart position per unit set point; NaN if singular */
+static double rb_dc( const double *K, double Nbar, const struct rb_plant_type *p)
+{
+	double complex M[RB_NS][RB_NS], x[RB_NS];
+	int i, j;
+
+	/* (I - Ad + Bd*K)*x = Bd*Nbar, Bd = B0 + B1 */
+	for ( i = 0; i < RB_NS; i++)
+	{
+		for ( j = 0; j < RB_NS; j++)
+			M[i][j] = ( i == j) - p->Ad[i][j] + ( p->B0[i] + p->B1[i])*K[j];
+		x[i] = ( p->B0[i] + p->B1[i])*Nbar;
+	}
+	if ( rb_solve_c( M, x))
+		return NAN;
+
+	return creal( x[0]);
+}
+
+
+/* margins and sensitivity peaks of a stable loop on one plant */
+static void rb_margins( const double *K, const struct rb_plant_type *p, struct rb_res_type *r)
+{
+	double Lr[RB_NW], Li[RB_NW], a2[RB_NW], d2[RB_NW], t2[RB_NW];
+	double s2 = INFINITY, tm = 0, t, kc, re, ph, wc;
+	double complex Lk, Ln;
+	unsigned char cr[RB_NW];
+	int k;
+
+	r->gm_lo = 0;
+	r->gm_hi = INFINITY;
+	r->pm = INFINITY;
+	r->dm = INFINITY;
+
+	/* L = K*g and the squared magnitudes of L and 1 + L; the plain
+	 * passes vectorize, roots only at the end and at crossings */
+	for ( k = 0; k < RB_NW; k++)
+	{
+		Lr[k] = K[0]*p->gr[0][k] + K[1]*p->gr[1][k] + K[2]*p->gr[2][k] + K[3]*p->gr[3][k];
+		Li[k] = K[0]*p->gi[0][k] + K[1]*p->gi[1][k] + K[2]*p->gi[2][k] + K[3]*p->gi[3][k];
+		a2[k] = Lr[k]*Lr[k] + Li[k]*Li[k];
+		d2[k] = a2[k] + 2*Lr[k] + 1;
+		t2[k] = a2[k]/d2[k];
+	}
+	for ( k = 0; k < RB_NW; k++)
+	{
+		s2 = ( d2[k] < s2) ? d2[k] : s2;
+		tm = ( t2[k] > tm) ? t2[k] : tm;
+	}
+	r->ms = 1/sqrt( s2);
+	r->mt = sqrt( tm);
+
+	/* crossings between grid points: bit 0 negative real axis (sign of
+	 * the imaginary part), bit 1 unit circle */
+	for ( k = 0; k < RB_NW - 1; k++)
+		cr[k] = ( ( Li[k] < 0) ^ ( Li[k+1] < 0)) | ( ( ( a2[k] < 1) ^ ( a2[k+1] < 1)) << 1);
+	cr[RB_NW - 1] = 0;
+
+	for ( k = 0; k < RB_NW; k++)
+	{
+		if ( cr[k] == 0 && k < RB_NW - 1)
+			continue;
+
+		/* negative real axis: the loop gain factor kc puts L on -1; L is
+		 * real at the Nyquist frequency */
+		kc = 0;
+		if ( k == RB_NW - 1)
+		{
+			if ( Lr[k] < 0)
+				kc = -1/Lr[k];
+		}
+		else if ( cr[k] & 1)
+		{
+			t = Li[k]/( Li[k] - Li[k+1]);
+			re = Lr[k] + t*( Lr[k+1] - Lr[k]);
+			if ( re < 0)
+				kc = -1/re;
+		}
+		if ( kc > 1)
+			r->gm_hi = fmin( r->gm_hi, kc);
+		else if ( kc > 0)
+			r->gm_lo = fmax( r->gm_lo, kc);
+
+		/* gain crossover: phase distance to -1, and the delay that
+		 * closes it (lag only) */
+		if ( cr[k] & 2)
+		{
+			Lk = Lr[k] + I*Li[k];
+			Ln = Lr[k+1] + I*Li[k+1];
+			t = log( a2[k])/( log( a2[k]) - log( a2[k+1]));
+			ph = carg( Lk) + t*carg( Ln*conj( Lk)) + M_PI;
+			ph = remainder( ph, 2*M_PI);
+			wc = rb.w[k]*pow( rb.w[k+1]/rb.w[k], t);
+			r->pm = fmin( r->pm, fabs(ph));
+			r->dm = fmin( r->dm, ( ( ph < 0) ? ph + 2*M_PI : ph)/wc);
+		}
+	}
+}
+
+
+static int rb_cmp_d( const void *a, const void *b)
+{
+	double x = *(const double *)a, y = *(const double *)b;
+
+	return ( x > y) - ( x < y);
+}
+
+
+/* value met or bettered by the share rb.q of v (larger is worse if up) */
+static double rb_quant( double *v, int n, int up)
+{
+	int k = (int)ceil( rb.q*n) - 1;
+
+	if ( k < 0)
+		k = 0;
+	qsort( v, n, sizeof(*v), rb_cmp_d);
+
+	return up ? v[k] : v[n - 1 - k];
+}
+
+
+/* scratch of a candidate: the margins of every plant */
+struct rb_scr_type
+{
+	double *gl, *gh, *pm, *dm, *ms, *mt;
+};
+
+
+/* analysis of a candidate on plant j */
+static void rb_eval_plant( struct rb_cand_type *c, int j, struct rb_scr_type *m)
+{
+	rb_mat_type H;
+	double complex ev[RB_N_MAX];
+	struct rb_res_type pr, *r = &c->r;
+	const double *K = &c->K[1];
+	double rho, dc;
+	int n, i;
+
+	/* unstable: no margin */
+	m->gl[j] = m->gh[j] = 1;
+	m->pm[j] = m->dm[j] = 0;
+	m->ms[j] = m->mt[j] = INFINITY;
+
+	n = rb_closed_loop( K, &rb.plant[j], H);
+	if ( rb_eig( H, n, ev))
+		return;
+	for ( i = 0, rho = 0; i < n; i++)
+		rho = fmax( rho, cabs( ev[i]));
+	if ( j == 0)
+		r->rho = rho;
+	if ( rho >= 1)
+		return;
+
+	r->n_stable++;
+	rb_margins( K, &rb.plant[j], &pr);
+	m->gl[j] = pr.gm_lo;
+	m->gh[j] = pr.gm_hi;
+	m->pm[j] = pr.pm;
+	m->dm[j] = pr.dm;
+	m->ms[j] = pr.ms;
+	m->mt[j] = pr.mt;
+	dc = rb_dc( K, c->Nbar, &rb.plant[j]);
+	if ( !( fabs(r->dc - 1) >= fabs(dc - 1)))
+		r->dc = dc;
+}
+
+
+/*
+ * Analyses a block of candidates: plants in the outer loop, so that the
+ * response of a plant is read from memory once per block; then the
+ * margins at the quantile
+ */
+static void rb_eval_block( struct rb_cand_type *c, int n, struct rb_scr_type *m)
+{
+	int i, j;
+
+	for ( i = 0; i < n; i++)
+	{
+		c[i].r.n_stable = 0;
+		c[i].r.rho = NAN;
+		c[i].r.dc = NAN;
+	}
+
+	for ( j = 0; j < rb.n_plant; j++)
+		for ( i = 0; i < n; i++)
+			rb_eval_plant( &c[i], j, &m[i]);
+
+	for ( i = 0; i < n; i++)
+	{
+		c[i].r.gm_lo = rb_quant( m[i].gl, rb.n_plant, 1);
+		c[i].r.gm_hi = rb_quant( m[i].gh, rb.n_plant, 0);
+		c[i].r.pm = rb_quant( m[i].pm, rb.n_plant, 0);
+		c[i].r.dm = rb_quant( m[i].dm, rb.n_plant, 0);
+		c[i].r.ms = rb_quant( m[i].ms, rb.n_plant, 1);
+		c[i].r.mt = rb_quant( m[i].mt, rb.n_plant, 1);
+	}
+}
+
+
+static void *rb_worker( void *arg)
+{
+	struct rb_scr_type m[RB_BLOCK];
+	double *buf = malloc( RB_BLOCK*6*rb.n_plant*sizeof(*buf));
+	size_t i;
+	int k;
+
+	if ( buf == NULL)
+		return arg;
+	for ( k = 0; k < RB_BLOCK; k++)
+	{
+		m[k].gl = buf + 6*k*rb.n_plant;
+		m[k].gh = m[k].gl + rb.n_plant;
+		m[k].pm = m[k].gh + rb.n_plant;
+		m[k].dm = m[k].pm + rb.n_plant;
+		m[k].ms = m[k].dm + rb.n_plant;
+		m[k].mt = m[k].ms + rb.n_plant;
+	}
+
+	for ( i = (size_t)(intptr_t)arg*RB_BLOCK; i < rb.n_cand; i += (size_t)rb.n_thr*RB_BLOCK)
+		rb_eval_block( &rb.cand[i], ( rb.n_cand - i < RB_BLOCK) ? (int)( rb.n_cand - i) : RB_BLOCK, m);
+	free( buf);
+
+	return NULL;
+}
+
+
+/* lower Ms at the quantile first, then more stable plants */
+static int rb_rank( const void *a, const void *b)
+{
+	const struct rb_cand_type *x = a, *y = b;
+
+	if ( x->r.ms != y->r.ms)
+		return ( x->r.ms < y->r.ms) ? -1 : 1;
+	if ( x->r.n_stable != y->r.n_stable)
+		return ( x->r.n_stable > y->r.n_stable) ? -1 : 1;
+
+	return ( x->line > y->line) - ( x->line < y->line);
+}
+
+
+/* uniform deviate in (0, 1) (xorshift64*) */
+static double rb_randu( uint64_t *s)
+{
+	*s ^= *s >> 12;
+	*s ^= *s << 25;
+	*s ^= *s >> 27;
+
+	return ( ( *s*0x2545F4914F6CDD1Dull >> 11) + 0.5)*( 1.0/9007199254740992.0);
+}
+
+
+/* standard normal deviate (Box-Muller) */
+static double rb_randn( uint64_t *s)
+{
+	double u = rb_randu( s);
+
+	return sqrt( -2*log( u))*cos( 2*M_PI*rb_randu( s));
+}
+
+
+/* reads numbers separated by blanks, commas, semicolons; returns values read */
+static int rb_parse( const char *s, double *v, int max)
+{
+	char *e;
+	int n = 0;
+
+	while ( *s && n < max)
+	{
+		if ( *s == ' ' || *s == '\t' || *s == ';' || *s == ',' || *s == '[')
+		{
+			s++;
+			continue;
+		}
+		v[n] = strtod( s, &e);
+		if ( e == s)
+			break;
+		n++;
+		s = e;
+	}
+
+	return n;
+}
+
+
+static int rb_add_cand( int line, const double *v)
+{
+	static size_t cap;
+	struct rb_cand_type *c;
+
+	if ( rb.n_cand == cap)
+	{
+		cap = cap ? 2*cap : 1024;
+		c = realloc( rb.cand, cap*sizeof(*c));
+		if ( c == NULL)
+		{
+			fprintf( stderr, "out of memory\n");
+			return -1;
+		}
+		rb.cand = c;
+	}
+	c = &rb.cand[rb.n_cand++];
+	c->line = line;
+	memcpy( c->K, v, sizeof(c->K));
+	c->Nbar = v[RB_NK];
+
+	return 0;
+}
+
+
+static int rb_read_cands( const char *path)
+{
+	char line[1024], *h;
+	double v[RB_NK + 1];
+	int n, ln = 0;
+	FILE *f = strcmp( path, "-") ? fopen( path, "r") : stdin;
+
+	if ( f == NULL)
+	{
+		perror( path);
+		return -1;
+	}
+	while ( fgets( line, sizeof(line), f))
+	{
+		ln++;
+		if ( (h = strchr( line, '#')) != NULL)
+			*h = 0;
+		n = rb_parse( line, v, RB_NK + 1);
+		if ( n == 0 && strspn( line, " \t\r\n") == strlen( line))
+			continue;
+		if ( n != RB_NK + 1 || rb_add_cand( ln, v))
+		{
+			fprintf( stderr, "%s:%d: expected K0 K1 K2 K3 K4 Nbar\n", path, ln);
+			if ( f != stdin)
+				fclose( f);
+			return -1;
+		}
+	}
+	if ( f != stdin)
+		fclose( f);
+
+	return 0;
+}
+
+
+static void rb_print_db( double k)
+{
+	printf( ",%.2f", 20*log10( k));
+}
+
+
+int main( int argc, char **argv)
+{
+	static const float k_rig[] = LQR_RIG_K;
+	double A[RB_NS][RB_NS], B[RB_NS], Ap[RB_NS][RB_NS], Bp[RB_NS], v[RB_NK + 1];
+	double delay = RB_DELAY, spread = RB_DELAY_SPREAD, unc = RB_UNC, dt;
+	double complex ev[RB_N_MAX], s;
+	long n_rnd = RB_PLANTS, top = RB_TOP;
+	uint64_t seed = 1;
+	pthread_t thr[RB_THR_MAX];
+	struct timespec t0, t1;
+	struct rb_res_type nom;
+	struct rb_cand_type *c;
+	void *ret;
+	const char *k_arg = NULL;
+	rb_mat_type H;
+	size_t i;
+	int opt, j, e, n;
+
+	rb.ts = RB_TS;
+	rb.q = RB_QUANT;
+	rb.n_thr = (int)sysconf( _SC_NPROCESSORS_ONLN);
+
+	while ( (opt = getopt( argc, argv, "T:d:D:u:n:q:s:j:t:k:")) != -1)
+	{
+		switch ( opt)
+		{
+		case 'T': rb.ts = atof( optarg); break;
+		case 'd': delay = atof( optarg); break;
+		case 'D': spread = atof( optarg); break;
+		case 'u': unc = atof( optarg); break;
+		case 'n': n_rnd = atol( optarg); break;
+		case 'q': rb.q = atof( optarg); break;
+		case 's': seed = strtoull( optarg, NULL, 0); break;
+		case 'j': rb.n_thr = atoi( optarg); break;
+		case 't': top = atol( optarg); break;
+		case 'k': k_arg = optarg; break;
+		default: goto usage;
+		}
+	}
+	if ( argc - optind < 1 || argc - optind > 2 || ( k_arg && argc - optind == 2) ||
+	     !( rb.ts > 0) || !( delay >= 0) || !( spread >= 0) || !( unc >= 0) ||
+	     !( rb.q > 0 && rb.q <= 1) ||
+	     n_rnd < 0 || n_rnd > 100000 || top < 0)
+		goto usage;
+	if ( rb.n_thr < 1)
+		rb.n_thr = 1;
+	if ( rb.n_thr > RB_THR_MAX)
+		rb.n_thr = RB_THR_MAX;
+	if ( seed == 0)
+		seed = 1;
+
+	if ( hm_read_model( argv[optind], A, B))
+		return 1;
+
+	if ( k_arg)
+	{
+		if ( rb_parse( k_arg, v, RB_NK + 1) != RB_NK + 1)
+			goto usage;
+		if ( rb_add_cand( 0, v))
+			return 1;
+	}
+	else if ( argc - optind == 2)
+	{
+		if ( rb_read_cands( argv[optind + 1]))
+			return 1;
+	}
+	else
+	{
+		for ( j = 0; j < RB_NK; j++)
+			v[j] = k_rig[j];
+		v[RB_NK] = LQR_RIG_NBAR;
+		if ( rb_add_cand( 0, v))
+			return 1;
+	}
+	if ( rb.n_cand == 0)
+	{
+		fprintf( stderr, "no candidates\n");
+		return 1;
+	}
+
+	/* logarithmic grid up to the Nyquist frequency */
+	for ( j = 0; j < RB_NW; j++)
+		rb.w[j] = RB_W_MIN*pow( M_PI/rb.ts/RB_W_MIN, (double)j/(RB_NW - 1));
+
+	/* nominal plant, then the perturbed ones */
+	rb.plant = malloc( ( n_rnd + 1)*sizeof(*rb.plant));
+	if ( rb.plant == NULL)
+	{
+		fprintf( stderr, "out of memory\n");
+		return 1;
+	}
+	for ( rb.n_plant = 0; rb.n_plant <= n_rnd; rb.n_plant++)
+	{
+		double d = delay;
+
+		memcpy( Ap, A, sizeof(Ap));
+		memcpy( Bp, B, sizeof(Bp));
+		if ( rb.n_plant > 0)
+		{
+			for ( j = 1; j < RB_NS; j += 2)
+			{
+				for ( e = 0; e < RB_NS; e++)
+					Ap[j][e] *= 1 + unc*rb_randn( &seed);
+				Bp[j] *= 1 + unc*rb_randn( &seed);
+			}
+			d = fmax( 0, delay + spread*( 2*rb_randu( &seed) - 1));
+		}
+		if ( rb_plant_init( &rb.plant[rb.n_plant], Ap, Bp, d))
+		{
+			fprintf( stderr, "delay %g s out of range (below %d control periods)\n", d, RB_M_MAX);
+			return 1;
+		}
+	}
+
+	clock_gettime( CLOCK_MONOTONIC, &t0);
+	for ( j = 0; j < rb.n_thr; j++)
+		if ( pthread_create( &thr[j], NULL, rb_worker, (void *)(intptr_t)j))
+		{
+			fprintf( stderr, "cannot start worker threads\n");
+			return 1;
+		}
+	for ( j = 0, e = 0; j < rb.n_thr; j++)
+	{
+		pthread_join( thr[j], &ret);
+		e |= ( ret != NULL);
+	}
+	if ( e)
+	{
+		fprintf( stderr, "out of memory\n");
+		return 1;
+	}
+	clock_gettime( CLOCK_MONOTONIC, &t1);
+	dt = ( t1.tv_sec - t0.tv_sec) + 1e-9*( t1.tv_nsec - t0.tv_nsec);
+
+	qsort( rb.cand, rb.n_cand, sizeof(*rb.cand), rb_rank);
+
+	printf( "# robustness check, Ts = %g s, delay %g +/- %g s, coefficients +/- %g %% (1 sd),"
+	        " margins held by %g %% of the plants\n", rb.ts, delay, spread, 100*unc, 100*rb.q);
+	printf( "# %zu candidates x %d plants on %d threads: %.3f s, %.0f candidates/s\n",
+	        rb.n_cand, rb.n_plant, rb.n_thr, dt, ( dt > 0) ? rb.n_cand/dt : 0.0);
+
+	/* nominal detail of the best candidate */
+	c = &rb.cand[0];
+	n = rb_closed_loop( &c->K[1], &rb.plant[0], H);
+	if ( rb_eig( H, n, ev))
+		printf( "# best candidate (line %d): eigenvalues did not converge\n", c->line);
+	else
+	{
+		printf( "# best candidate (line %d), nominal closed loop eigenvalues:\n", c->line);
+		printf( "#   z (re, im), |z|, continuous equivalent s = ln(z)/Ts (re 1/s, im rad/s)\n");
+		for ( j = 0; j < n; j++)
+		{
+			if ( fabs(cimag( ev[j])) <= 1e-12)
+				ev[j] = creal( ev[j]);
+			else if ( cimag( ev[j]) < 0)
+				continue;
+			if ( cabs( ev[j]) < 1e-9)
+			{
+				printf( "#   %12.9f %12.9f  %.9f  -\n", creal( ev[j]), cimag( ev[j]), cabs( ev[j]));
+				continue;
+			}
+			s = clog( ev[j])/rb.ts;
+			printf( "#   %12.9f %12.9f  %.9f  %10.3f %10.3f\n", creal( ev[j]), cimag( ev[j]),
+			        cabs( ev[j]), creal( s), cimag( s));
+		}
+		if ( c->r.rho < 1)
+		{
+			rb_margins( &c->K[1], &rb.plant[0], &nom);
+			printf( "# nominal: gain margin %.2f dB / +%.2f dB, phase margin %.1f deg,"
+			        " delay margin %.3f ms, Ms %.2f, Mt %.2f, DC gain %.4f\n",
+			        20*log10( nom.gm_lo), 20*log10( nom.gm_hi), nom.pm*180/M_PI, nom.dm*1e3,
+			        nom.ms, nom.mt, rb_dc( &c->K[1], c->Nbar, &rb.plant[0]));
+		}
+		else
+			printf( "# nominal: unstable (spectral radius %.9f)\n", c->r.rho);
+	}
+
+	printf( "rank,line,stable_pct,rho,gm_lo_db,gm_hi_db,pm_deg,dm_ms,ms,mt,dc,K0,K1,K2,K3,K4,Nbar\n");
+	for ( i = 0; i < rb.n_cand && ( top == 0 || (long)i < top); i++)
+	{
+		c = &rb.cand[i];
+		printf( "%zu,%d,%.1f,%.9f", i + 1, c->line, 100.0*c->r.n_stable/rb.n_plant, c->r.rho);
+		rb_print_db( c->r.gm_lo);
+		rb_print_db( c->r.gm_hi);
+		printf( ",%.1f,%.3f,%.3f,%.3f,%.4f", c->r.pm*180/M_PI, c->r.dm*1e3, c->r.ms, c->r.mt, c->r.dc);
+		for ( j = 0; j < RB_NK; j++)
+			printf( ",%.6g", c->K[j]);
+		printf( ",%.6g\n", c->Nbar);
+	}
+
+	free( rb.plant);
+	free( rb.cand);
+
+	return 0;
+
+usage:
+	fprintf( stderr, "usage: %s [-T ts] [-d delay] [-D spread] [-u unc] [-n plants] [-q quant]\n"
+	         "       [-s seed] [-j threads] [-t top] [-k k0,k1,k2,k3,k4,nbar] model.txt [candidates.txt|-]\n",
+	         argv[0]);
+	return 2;
+}
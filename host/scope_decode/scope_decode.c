@@ -0,0 +1,177 @@
+/*
+ * scope_decode.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Milos Lazic
+ *
+ *  Host tool for the scope capture (log/log_scope.c): builds the
+ *  eCMD_ID_SCOPE_ARM request frame and decodes a completed capture from a
+ *  raw capture of the serial command channel (UART0 bytes as received).
+ *  eCMD_ID_SCOPE frames with a valid CRC are reassembled by offset;
+ *  everything else in the capture is skipped.
+ *
+ *  Output (stdout): "# ..." header line, then CSV with the time relative
+ *  to the trigger sample (s) and one column per recorded channel, in the
+ *  units of LOG_sc_chan_type.
+ *
+ *  The image decoder (scope_image.h) is shared with host/telem_rec.
+ *
+ *  Build (from repository root):
+ *      gcc -std=c99 -O2 -o scope_decode host/scope_decode/scope_decode.c
+ *
+ *  Usage:
+ *      scope_decode arm mask trig chan arg level pre decim > /dev/ttyACM0
+ *          writes the request frame (see LOG_sc_cfg_type); e.g. pendulum
+ *          angle and power, 200 samples before the set point changes:
+ *          scope_decode arm 0x32 2 5 0 0 200 1
+ *      scope_decode capture.bin
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "scope_image.h"
+#include "../../cmd/cmd_defs.h"
+
+
+static uint8_t sd_crc8( uint8_t crc, const uint8_t *buf, size_t len)
+{
+	uint32_t bit;
+
+	while ( len--)
+	{
+		crc ^= *buf++;
+		for ( bit = 0; bit < 8; bit++)
+			crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+	}
+
+	return crc;
+}
+
+
+static int sd_arm( int argc, char **argv)
+{
+	uint8_t fr[3 + 1 + 10];
+	long v[7];
+	int i;
+
+	if ( argc != 9)
+	{
+		fprintf( stderr, "usage: %s arm mask trig chan arg level pre decim\n", argv[0]);
+		return 2;
+	}
+	for ( i = 0; i < 7; i++)
+		v[i] = strtol( argv[2 + i], NULL, 0);
+
+	fr[0] = CMD_FRAME_SOF;
+	fr[1] = 1 + 10;
+	fr[2] = eCMD_ID_SCOPE_ARM;
+	fr[3] = (uint8_t)v[0];
+	fr[4] = (uint8_t)v[1];
+	fr[5] = (uint8_t)v[2];
+	fr[6] = (uint8_t)v[3];
+	fr[7] = (uint8_t)v[4];
+	fr[8] = (uint8_t)(v[4] >> 8);
+	fr[9] = (uint8_t)v[5];
+	fr[10] = (uint8_t)(v[5] >> 8);
+	fr[11] = (uint8_t)v[6];
+	fr[12] = (uint8_t)(v[6] >> 8);
+	fr[13] = sd_crc8( 0, &fr[1], fr[1] + 1);
+
+	return ( fwrite( fr, 1, sizeof(fr), stdout) == sizeof(fr)) ? 0 : 1;
+}
+
+
+int main( int argc, char **argv)
+{
+	FILE *f;
+	uint8_t *cap, *img;
+	long cap_len;
+	struct sd_hdr_type hdr;
+	uint32_t i, ch, len, ofs, size = 0;
+	int rv;
+
+	if ( argc > 1 && strcmp( argv[1], "arm") == 0)
+		return sd_arm( argc, argv);
+
+	if ( argc != 2)
+	{
+		fprintf( stderr, "usage: %s capture.bin | arm ...\n", argv[0]);
+		return 2;
+	}
+
+	if ( (f = fopen( argv[1], "rb")) == NULL)
+	{
+		perror( argv[1]);
+		return 1;
+	}
+	fseek( f, 0, SEEK_END);
+	cap_len = ftell( f);
+	fseek( f, 0, SEEK_SET);
+	cap = malloc( cap_len > 0 ? cap_len : 1);
+	img = calloc( SD_IMAGE_MAX, 1);
+	if ( cap == NULL || img == NULL || fread( cap, 1, cap_len, f) != (size_t)cap_len)
+	{
+		fprintf( stderr, "cannot read %s\n", argv[1]);
+		return 1;
+	}
+	fclose( f);
+
+	/* frames: SOF | LEN | ID | PAYLOAD | CRC; the last complete capture
+	 * in the file wins (offset 0 starts a new one) */
+	for ( i = 0; i + 3 <= (uint32_t)cap_len; i++)
+	{
+		if ( cap[i] != CMD_FRAME_SOF)
+			continue;
+		len = cap[i + 1];
+		if ( len < 1 + 4 || i + 3 + len > (uint32_t)cap_len || cap[i + 2] != eCMD_ID_SCOPE)
+			continue;
+		if ( sd_crc8( 0, &cap[i + 1], len + 1) != cap[i + 2 + len])
+			continue;
+
+		ofs = sd_u32( &cap[i + 3]);
+		len -= 1 + 4;
+		if ( ofs + len > SD_IMAGE_MAX)
+			continue;
+		if ( ofs == 0)
+			size = 0;
+		memcpy( &img[ofs], &cap[i + 7], len);
+		if ( ofs == size)
+			size = ofs + len;
+		i += 2 + len + 4;
+	}
+
+	rv = sd_header( img, size, &hdr);
+	if ( rv == -1)
+	{
+		fprintf( stderr, "no scope capture in %s\n", argv[1]);
+		return 1;
+	}
+	if ( rv || hdr.size > size)
+	{
+		fprintf( stderr, "capture incomplete (%u bytes)\n", size);
+		return 1;
+	}
+
+	printf( "# trigger source %u at sample %u (t = %llu us), %u samples every %u control periods\n",
+	        hdr.trig, hdr.pre, (unsigned long long)hdr.t_us, hdr.depth, hdr.decim);
+	printf( "t");
+	for ( ch = 0; ch < eLOG_SC_CH_MAX; ch++)
+		if ( hdr.mask & (1u << ch))
+			printf( ",%s", sd_chan_name[ch]);
+	printf( "\n");
+
+	for ( i = 0; i < hdr.depth; i++)
+	{
+		printf( "%.4f", sd_time( &hdr, i));
+		for ( ch = 0; ch < hdr.n_ch; ch++)
+			printf( ",%d", sd_sample( img, &hdr, i, ch));
+		printf( "\n");
+	}
+
+	free( img);
+	free( cap);
+
+	return 0;
+}
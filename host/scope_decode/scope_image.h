@@ -0,0 +1,121 @@
+/*
+ * scope_image.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Milos Lazic
+ *
+ *  Scope capture image decoder (log/log_defs.h), shared by the host tools
+ *  that read scope captures (scope_decode, telem_rec). Header only: every
+ *  routine is static.
+ */
+
+#ifndef HOST_SCOPE_DECODE_SCOPE_IMAGE_H_
+#define HOST_SCOPE_DECODE_SCOPE_IMAGE_H_
+
+
+#include <stdint.h>
+#include "../../log/log_defs.h"
+
+
+#define SD_PERIOD     0.0001   /* control period (s); SysTick at 10 kHz */
+#define SD_IMAGE_MAX  (LOG_SC_HDR_SIZE + 2*LOG_SC_BUF)
+
+
+/* Name: sd_hdr_type
+ *
+ * Description: decoded scope image header
+ *
+ * Members: mask  - recorded channels (bit n: LOG_sc_chan_type n)
+ *          trig  - trigger source (LOG_sc_trig_type)
+ *          n_ch  - recorded channels
+ *          depth - samples per channel
+ *          pre   - trigger sample
+ *          decim - control periods per sample
+ *          t_us  - trigger time (us, SYSTIME_ToUs)
+ *          size  - image size (bytes)
+ *
+ * Notes:
+ *
+ */
+struct sd_hdr_type
+{
+	uint32_t mask;
+	uint32_t trig;
+	uint32_t n_ch;
+	uint32_t depth;
+	uint32_t pre;
+	uint32_t decim;
+	uint64_t t_us;
+	uint32_t size;
+};
+
+
+static const char *sd_chan_name[eLOG_SC_CH_MAX] =
+{
+	"x", "th", "x_vel", "th_vel", "power", "sp", "state", "lat",
+};
+
+
+static uint32_t sd_u16( const uint8_t *p)
+{
+	return (uint32_t)p[0] | ((uint32_t)p[1] << 8);
+}
+
+
+static uint32_t sd_u32( const uint8_t *p)
+{
+	return sd_u16( p) | (sd_u16( &p[2]) << 16);
+}
+
+
+/*
+ * Name: sd_header
+ *
+ * Descr: Decodes and checks the image header
+ *
+ * Args:     img - image bytes
+ *           len - bytes available in img
+ *           hdr - storage for the header
+ *
+ * Return:   0 on success, -1 if img does not start a scope image, -2 if the
+ *           header records no channel
+ *
+ * Notes: hdr->size is valid on success; the image is complete once len
+ *        reaches it
+ *
+ */
+static int sd_header( const uint8_t *img, uint32_t len, struct sd_hdr_type *hdr)
+{
+	if ( len < LOG_SC_HDR_SIZE || sd_u32( img) != LOG_SC_MAGIC || img[4] != LOG_SC_VERSION)
+		return -1;
+
+	hdr->mask = img[5];
+	hdr->trig = img[6];
+	hdr->n_ch = img[7];
+	hdr->depth = sd_u16( &img[8]);
+	hdr->pre = sd_u16( &img[10]);
+	hdr->decim = sd_u16( &img[12]);
+	hdr->t_us = (uint64_t)sd_u32( &img[16]) | ((uint64_t)sd_u32( &img[20]) << 32);
+	if ( hdr->n_ch == 0)
+		return -2;
+	hdr->size = LOG_SC_HDR_SIZE + 2*hdr->depth*hdr->n_ch;
+
+	return 0;
+}
+
+
+/* time of sample i relative to the trigger sample (s) */
+static double sd_time( const struct sd_hdr_type *hdr, uint32_t i)
+{
+	return ((double)i - (double)hdr->pre)*hdr->decim*SD_PERIOD;
+}
+
+
+/* sample i of the ch-th recorded channel (ascending channel order) */
+static int16_t sd_sample( const uint8_t *img, const struct sd_hdr_type *hdr, uint32_t i, uint32_t ch)
+{
+	return (int16_t)sd_u16( &img[LOG_SC_HDR_SIZE + 2*(i*hdr->n_ch + ch)]);
+}
+
+
+#endif /* HOST_SCOPE_DECODE_SCOPE_IMAGE_H_ */
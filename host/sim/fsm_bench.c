@@ -0,0 +1,168 @@
+/*
+ * fsm_bench.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Milos Lazic
+ *
+ *  Host benchmark for the complete power-on sequence: runs FSM_Init and
+ *  FSM_Run (calibration, swing-up, balance) against the simulated plant,
+ *  with the cart starting off-centre and the ultrasonic sensor polled as
+ *  in the firmware background loop. Reports the calibration error against
+ *  the simulated track and the time from power-on to balance.
+ *
+ *  Build (from repository root):
+ *      gcc -std=c99 -O2 -Ihost/sim -o fsm_bench host/sim/fsm_bench.c \
+ *          host/sim/sim_plant.c host/sim/sim_device.c \
+ *          fsm/fsm.c fsm/fsm_calib.c fsm/fsm_collision.c \
+ *          swingup/swu_ctrl.c swingup/swu_utils.c \
+ *          lqr/lqr_balance.c lqr/lqr_utils.c lqr/lqr_rig_filt.c \
+ *          dsp/dsp_biquad.c dsp/dsp_fir.c dsp/dsp_filt.c \
+ *          fl/fl_balance.c fl/fl_utils.c exc/exc_gen.c exc/exc_table.c \
+ *          traj/traj_gen.c ilc/ilc_ctrl.c sys/systime/systime.c -lm
+ *
+ *  Usage: fsm_bench [trials] [seed]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "../../fsm/fsm.h"
+#include "../../sys/device/device.h"
+#include "../../sys/systime/systime.h"
+#include "sim_plant.h"
+
+
+#define BENCH_PI        3.14159265358979323846
+#define BENCH_DT        0.0001   /* control period (s); SysTick at 10 kHz */
+#define BENCH_PRS_TICKS 660      /* background ultrasonic poll period (control periods) */
+#define BENCH_T_MAX     90.0     /* power-on to balance timeout (s) */
+#define BENCH_T_HOLD    5.0      /* balance hold time (s) */
+
+
+static double frand( double lo, double hi)
+{
+	return lo + (hi - lo)*((double)rand()/(double)RAND_MAX);
+}
+
+
+/*
+ * Name: bench_trial
+ *
+ * Descr: Runs one power-on to balance trial
+ *
+ * Args:     x0     - cart position at power-on (m, from track centre)
+ *           t_cal  - storage for calibration end time (s)
+ *           t_bal  - storage for balance start time (s)
+ *           e_len  - storage for track length error (m)
+ *           e_prs  - storage for worst ultrasonic mapping error over the
+ *                    track (m)
+ *
+ * Return:   0 if the pendulum was balanced for BENCH_T_HOLD seconds,
+ *           1 on timeout, 2 if calibration failed, 3 on a collision
+ *           warning (emergency braking) or track end collision after
+ *           calibration
+ *
+ * Notes:
+ */
+static int bench_trial( double x0, double *t_cal, double *t_bal,
+                        double *e_len, double *e_prs)
+{
+	struct SIM_param_type p;
+	struct SIM_plant_type plant;
+	const struct fsm_calib_type *cal;
+	double t_end = BENCH_T_MAX, x, x_est, e;
+	unsigned long tick = 0;
+	int calibrated = 0;
+
+	SIM_Plant_Defaults( &p);
+	SIM_Plant_Init( &plant, &p, x0, BENCH_PI);
+	sim_plant = &plant;
+
+	*t_cal = *t_bal = -1;
+	*e_len = *e_prs = 0;
+
+	FSM_Init();
+
+	while ( plant.t < t_end)
+	{
+		if ( tick++ % BENCH_PRS_TICKS == 0)
+			FSM_CW_PrsUpdate( dev_ioctl(eDEV_PRS0, ePRS_IOCTL_DISTMSR));
+
+		FSM_Run();
+
+		if ( FSM_GetState() == eFSM_STATE_CALIB && plant.t > 60.0)
+			return 2;
+
+		if ( !calibrated && FSM_GetState() == eFSM_STATE_SWINGUP)
+		{
+			calibrated = 1;
+			*t_cal = plant.t;
+			plant.collided = 0;
+
+			cal = FSM_Calib_Get();
+			*e_len = (cal->x_max - cal->x_min) - 2.0*p.x_end;
+			for ( x = -p.x_end; x <= p.x_end; x += 0.01)
+			{
+				x_est = cal->prs_x0 + cal->prs_scale*(p.x_end - x)*1000.0;
+				/* encoder frame: centre of the track, opposite sign */
+				e = fabs(x_est - (-x));
+				if ( e > *e_prs)
+					*e_prs = e;
+			}
+		}
+
+		if ( *t_bal < 0 && FSM_GetState() == eFSM_STATE_BALANCE)
+		{
+			*t_bal = plant.t;
+			t_end = plant.t + BENCH_T_HOLD;
+		}
+
+		SIM_Plant_Step( &plant, BENCH_DT);
+
+		if ( calibrated && (plant.collided || FSM_GetState() == eFSM_STATE_EMGBRAKE))
+			return 3;
+	}
+
+	return ( *t_bal >= 0 && FSM_GetState() == eFSM_STATE_BALANCE) ? 0 : 1;
+}
+
+
+int main( int argc, char **argv)
+{
+	int trials = (argc > 1) ? atoi(argv[1]) : 10;
+	unsigned seed = (argc > 2) ? (unsigned)atoi(argv[2]) : 1;
+	int i, rv, ok = 0, fails[4] = { 0 };
+	double t_cal, t_bal, e_len, e_prs, t_sum = 0, e_max = 0;
+
+	srand( seed);
+	(void) SYSTIME_Init();
+
+	printf("trial, x0 (m), result, calibrated (s), balancing (s), track length err (m), prs err (m)\n");
+	for ( i = 0; i < trials; i++)
+	{
+		double x0 = frand( -0.2, 0.2);
+
+		rv = bench_trial( x0, &t_cal, &t_bal, &e_len, &e_prs);
+		printf("%d, %+.4f, %d, %.3f, %.3f, %+.5f, %.5f\n", i, x0, rv, t_cal, t_bal, e_len, e_prs);
+
+		if ( rv == 0)
+		{
+			ok++;
+			t_sum += t_bal;
+			if ( fabs(e_len) > e_max) e_max = fabs(e_len);
+			if ( e_prs > e_max) e_max = e_prs;
+		}
+		else
+		{
+			fails[rv]++;
+		}
+	}
+
+	printf("\nsuccess: %d/%d (timeout %d, calibration failed %d, collision %d)\n",
+	       ok, trials, fails[1], fails[2], fails[3]);
+	if ( ok)
+		printf("power-on to balance: mean %.3f s; worst calibration error %.4f m\n",
+		       t_sum/ok, e_max);
+
+	return (ok == trials) ? 0 : 1;
+}
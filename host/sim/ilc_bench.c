@@ -0,0 +1,152 @@
+/*
+ * ilc_bench.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Milos Lazic
+ *
+ *  Host benchmark for the iterative learning control of repeated cart
+ *  moves: balances the simulated plant with LQR_Balance_CtrlRun and runs
+ *  the same sequence of set point targets as consecutive learning trials
+ *  (TRAJ_Run, ILC_Run), with ILC_Learn between trials as in the firmware
+ *  background loop. Reports the tracking error of every trial.
+ *
+ *  Build (from repository root):
+ *      gcc -std=c99 -O2 -Ihost/sim -o ilc_bench host/sim/ilc_bench.c \
+ *          host/sim/sim_plant.c host/sim/sim_device.c \
+ *          lqr/lqr_balance.c lqr/lqr_utils.c lqr/lqr_rig_filt.c \
+ *          dsp/dsp_biquad.c dsp/dsp_fir.c dsp/dsp_filt.c \
+ *          traj/traj_gen.c ilc/ilc_ctrl.c sys/systime/systime.c -lm
+ *
+ *  Usage: ilc_bench [trials]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "../../lqr/lqr.h"
+#include "../../traj/traj.h"
+#include "../../ilc/ilc.h"
+#include "../../sys/systime/systime.h"
+#include "sim_plant.h"
+
+
+#define BENCH_DT        0.0001   /* control period (s); SysTick at 10 kHz */
+#define BENCH_T_REST    1.0      /* balance between trials (s) */
+#define BENCH_TH_FALL   0.6      /* pendulum considered fallen beyond this angle (rad) */
+#define BENCH_LEN       600      /* trial length (samples, 6 s) */
+
+
+/* Name: bench_move_type
+ *
+ * Description: one move of the repeated sequence
+ *
+ * Members: t   - time from the trial start (s)
+ *          pos - set point target (m)
+ *
+ * Notes:
+ *
+ */
+struct bench_move_type
+{
+	double t;
+	float pos;
+};
+
+static const struct bench_move_type bench_seq[] =
+{
+		{ 0.0,  0.15f },
+		{ 2.0, -0.10f },
+		{ 4.0,  0.00f },
+};
+
+
+/*
+ * Name: bench_run
+ *
+ * Descr: Runs the balance loop for a number of control periods
+ *
+ * Args:     plant - simulated plant
+ *           n     - control periods
+ *           t0    - trial start time, for the target sequence (s); < 0
+ *                   outside trials
+ *
+ * Return:   0, 1 if the pendulum fell or the cart hit a track end
+ *
+ * Notes:
+ */
+static int bench_run( struct SIM_plant_type *plant, long n, double t0)
+{
+	size_t m = 0;
+
+	while ( n-- > 0)
+	{
+		while ( t0 >= 0 && m < sizeof(bench_seq)/sizeof(bench_seq[0]) &&
+		        plant->t - t0 >= bench_seq[m].t - 1e-9)
+			TRAJ_SetTarget( bench_seq[m++].pos);
+
+		TRAJ_Run();
+		LQR_Balance_CtrlRun();
+
+		SIM_Plant_Step( plant, BENCH_DT);
+
+		if ( fabs(plant->th) > BENCH_TH_FALL || plant->collided)
+			return 1;
+	}
+
+	return 0;
+}
+
+
+int main( int argc, char **argv)
+{
+	int trials = (argc > 1) ? atoi(argv[1]) : 10;
+	struct SIM_param_type p;
+	struct SIM_plant_type plant;
+	uint32_t n;
+	float e_rms, e_first = 0;
+	int i;
+
+	SIM_Plant_Defaults( &p);
+	SIM_Plant_Init( &plant, &p, 0, 0);
+	sim_plant = &plant;
+	(void) SYSTIME_Init();
+	LQR_Balance_Init();
+	LQR_Balance_Restart();
+
+	if ( bench_run( &plant, (long)(BENCH_T_REST/BENCH_DT), -1))
+	{
+		printf("fell before the first trial\n");
+		return 1;
+	}
+
+	printf("trial, RMS position error (mm)\n");
+	for ( i = 0; i < trials; i++)
+	{
+		if ( ILC_Start( BENCH_LEN))
+		{
+			printf("trial %d: start rejected\n", i);
+			return 1;
+		}
+		if ( bench_run( &plant, (long)BENCH_LEN*ILC_DECIM, plant.t))
+		{
+			printf("trial %d: fell\n", i);
+			return 1;
+		}
+		ILC_Learn();
+		ILC_GetStats( &n, &e_rms);
+		printf("%d, %.3f\n", i, e_rms*1e3);
+		if ( i == 0)
+			e_first = e_rms;
+
+		if ( bench_run( &plant, (long)(BENCH_T_REST/BENCH_DT), -1))
+		{
+			printf("trial %d: fell after the trial\n", i);
+			return 1;
+		}
+	}
+
+	printf("\nerror reduction: %.1f %% after %d trials\n",
+	       ( e_first > 0) ? 100.0*(1.0 - e_rms/e_first) : 0.0, trials);
+
+	return 0;
+}
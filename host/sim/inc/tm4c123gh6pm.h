@@ -0,0 +1,15 @@
+/*
+ * tm4c123gh6pm.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Milos Lazic
+ *
+ *  Host simulator stand-in for the TivaWare register definitions header.
+ *  Controller modules compiled into the simulator access hardware only
+ *  through dev_ioctl() (see sim_device.c), so no registers are defined.
+ */
+
+#ifndef HOST_SIM_TM4C123GH6PM_H_
+#define HOST_SIM_TM4C123GH6PM_H_
+
+#endif /* HOST_SIM_TM4C123GH6PM_H_ */
@@ -0,0 +1,611 @@
+/*
+ * mc_bench.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Milos Lazic
+ *
+ *  Host Monte-Carlo runner for the balance controllers: thousands of
+ *  independent closed loop runs of LQR_Balance_CtrlRun (or its
+ *  event-triggered variant, LQR_Balance_CtrlRunEvt) or flcBalance_Run
+ *  on the simulated plant, each with its own draw of the plant
+ *  parameters, spread over a pool of threads. Reports the failure rate
+ *  and the settling time percentiles, over all runs and per range of
+ *  each drawn parameter, and the throughput in runs per second per core.
+ *
+ *  Instances: the controller, timebase and device shim modules keep
+ *  their state in module variables of storage class DEV_STATE_CLASS
+ *  (sys/device/device.h), which this build defines thread local; every
+ *  worker thread has its own controller and plant, and runs its share
+ *  of the simulations one after the other (LQR_Balance_Restart between
+ *  runs), set up for the rig as on the target (LQR_Balance_Init). The
+ *  fuzzy controller recomputes all of its state every period.
+ *
+ *  Run: the plant starts at rest with the cart centred and the pendulum
+ *  at a random angle within +/- th0 of upright (encoders read zero
+ *  upright), and is balanced for the run length at the control period.
+ *  Drawn per run:
+ *    - pendulum mass, uniform within +/- the relative spread of the
+ *      nominal value (moment of inertia follows)
+ *    - belt stiffness, log-uniform over the range (elastic belt between
+ *      the motor pulley, which carries the cart encoder, and the cart);
+ *      0,0 for a rigid belt
+ *    - encoder noise, uniform from 0 to the maximum (1 sd, counts, both
+ *      encoders)
+ *    - motor torque constant, uniform within +/- the relative spread
+ *  Every run draws from its own generator (seed and run number), so the
+ *  results do not depend on the number of threads. The motor voltage
+ *  takes effect a fixed actuation delay after the controller sets it
+ *  (the rig applies it at the next PWM period boundary), which the LQR
+ *  measures and predicts the state over with the rig model; -M runs the
+ *  LQR without the model. An input bias adds a constant voltage to the
+ *  motor, which the disturbance observer of the LQR (LQR_RIG_DOB_BW,
+ *  or -o) estimates and cancels.
+ *
+ *  Outcome of a run: failed if the pendulum falls past MC_TH_FALL or
+ *  the cart hits a track end, or if it has not settled, i.e. stayed
+ *  within the angle and position tolerances over the last MC_T_HOLD of
+ *  the run; the settling time is the last time it was outside them.
+ *  Settling time percentiles count failed runs as never settled ("-").
+ *  The RMS pendulum angle over the last MC_T_HOLD of the settled runs
+ *  measures how still the pendulum is held, its mean cart position the
+ *  steady offset left by a bias; for the event-triggered
+ *  LQR, the fraction of the control periods that recomputed the output
+ *  (LQR_Balance_GetEventStats) how much it saves.
+ *
+ *  The fuzzy controller does not balance the simulated plant: every run
+ *  falls, even from 0.001 rad without noise (-a 0.001 -e 0). It pushes
+ *  the cart away from the pendulum tip in the sign conventions of the
+ *  rig (SIM_param_type), which the LQR gains balance. With its angle
+ *  and speed inputs negated it holds the pendulum up, but it has no
+ *  cart position input, and every run then ends at a track end. It is
+ *  benched as it stands, a reference for a retuned rule base.
+ *
+ *  Build (from repository root):
+ *      gcc -std=c99 -O2 -pthread -DDEV_STATE_CLASS=__thread -Ihost/sim \
+ *          -o mc_bench host/sim/mc_bench.c \
+ *          host/sim/sim_plant.c host/sim/sim_device.c \
+ *          lqr/lqr_balance.c lqr/lqr_utils.c lqr/lqr_rig_filt.c \
+ *          dsp/dsp_biquad.c dsp/dsp_fir.c dsp/dsp_filt.c \
+ *          fl/fl_balance.c fl/fl_utils.c sys/systime/systime.c -lm
+ *
+ *  Usage: mc_bench [-c lqr|evt|fl] [-n runs] [-T length] [-a th0] [-m mass]
+ *                  [-k kb_lo,kb_hi] [-e noise] [-K kt] [-A tol_th]
+ *                  [-X tol_x] [-d delay] [-M] [-v bias] [-o bw]
+ *                  [-b bins] [-s seed] [-j threads]
+ *      lqr, evt, fl - controller, default lqr
+ *      runs    - default MC_RUNS
+ *      length  - run length (s), default MC_T_RUN
+ *      th0     - initial pendulum angle spread, +/- (rad), default MC_TH0
+ *      mass    - pendulum mass spread, relative, default MC_M_UNC
+ *      kb      - belt stiffness range (N/m), default MC_KB_LO,MC_KB_HI
+ *      noise   - largest encoder noise (counts), default MC_QN
+ *      kt      - motor constant spread, relative, default MC_KT_UNC
+ *      tol_th  - settled pendulum angle (rad), default MC_TOL_TH
+ *      tol_x   - settled cart position (m), 0 for none, default MC_TOL_X
+ *      delay   - actuation delay (s), below MC_T_ACT_MAX, default 0
+ *      -M      - no plant model: the LQR does not predict the state over
+ *                the delay (nor estimate a disturbance, nor feed a moving
+ *                reference forward)
+ *      bias    - input bias (V), default 0
+ *      bw      - disturbance observer bandwidth (rad/s), 0 for none,
+ *                default LQR_RIG_DOB_BW
+ *      bins    - ranges per parameter in the tables, default MC_BINS
+ *      threads - default: all online processors
+ */
+
+#define _POSIX_C_SOURCE 200112L   /* not _DEFAULT_SOURCE: its dev_t clashes with device.h */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include "../../lqr/lqr.h"
+#include "../../fl/fl.h"
+#include "../../sys/systime/systime.h"
+#include "sim_plant.h"
+
+
+#define MC_DT        0.0001   /* control period (s); SysTick at 10 kHz */
+#define MC_RUNS      2000     /* runs */
+#define MC_T_RUN     5.0      /* run length (s) */
+#define MC_T_HOLD    1.0      /* settled over the end of the run (s) */
+#define MC_TH0       0.1      /* initial pendulum angle spread, +/- (rad) */
+#define MC_TH_FALL   0.6      /* pendulum considered fallen beyond this angle (rad) */
+#define MC_M_UNC     0.3      /* pendulum mass spread, relative */
+#define MC_KB_LO     5e3      /* belt stiffness range (N/m) */
+#define MC_KB_HI     1e5
+#define MC_CB        2.0      /* belt damping (N*s/m) */
+#define MC_QN        1.0      /* largest encoder noise, 1 sd (counts) */
+#define MC_KT_UNC    0.2      /* motor constant spread, relative */
+#define MC_TOL_TH    0.02     /* settled pendulum angle (rad) */
+#define MC_TOL_X     0.02     /* settled cart position (m) */
+#define MC_T_ACT_MAX 0.001    /* longest actuation delay (s); the LQR ignores longer latencies */
+#define MC_BINS      4        /* ranges per parameter in the tables */
+#define MC_BINS_MAX  16
+#define MC_THR_MAX   256      /* worker threads */
+#define MC_BLOCK     4        /* runs handed to a worker at a time */
+
+/* drawn parameters */
+#define MC_P_M       0        /* pendulum mass (kg) */
+#define MC_P_KB      1        /* belt stiffness (N/m) */
+#define MC_P_QN      2        /* encoder noise (counts) */
+#define MC_P_KT      3        /* motor constant (N*m/A) */
+#define MC_NP        4
+
+/* outcome of a run */
+#define MC_ST_OK     0
+#define MC_ST_FELL   1        /* pendulum fell */
+#define MC_ST_END    2        /* cart hit a track end */
+#define MC_ST_UNSET  3        /* not settled at the end of the run */
+#define MC_NST       4
+
+
+/* Name: mc_run_type
+ *
+ * Description: one simulation run
+ *
+ * Members: par  - drawn plant parameters (MC_P_*)
+ *          th0  - initial pendulum angle (rad)
+ *          seed - encoder noise generator seed
+ *          ts   - settling time (s)
+ *          rms  - RMS pendulum angle over the last MC_T_HOLD (rad)
+ *          x_m  - mean cart position over the last MC_T_HOLD (m)
+ *          upd  - fraction of the control periods that recomputed the
+ *                 output (event-triggered LQR)
+ *          st   - outcome (MC_ST_*)
+ *
+ * Notes:
+ *
+ */
+struct mc_run_type
+{
+	double par[MC_NP];
+	double th0;
+	uint64_t seed;
+	double ts;
+	double rms;
+	double x_m;
+	double upd;
+	int st;
+};
+
+
+static const char *mc_par_name[MC_NP] =
+{
+	"pendulum mass (kg)",
+	"belt stiffness (N/m)",
+	"encoder noise (counts)",
+	"motor constant (N*m/A)",
+};
+
+
+static struct
+{
+	int fl;
+	int evt;
+	int no_model;
+	double dob_bw;
+	double t_act;
+	double t_run;
+	double th0;
+	double tol_th;
+	double tol_x;
+	struct SIM_param_type p0;
+	double lo[MC_NP];
+	double hi[MC_NP];
+	int log[MC_NP];
+	struct mc_run_type *run;
+	long n_run;
+	long next;
+	pthread_mutex_t lock;
+	int n_thr;
+} mc;
+
+
+/* uniform deviate in (0, 1) (xorshift64*) */
+static double mc_randu( uint64_t *s)
+{
+	*s ^= *s >> 12;
+	*s ^= *s << 25;
+	*s ^= *s >> 27;
+
+	return ( ( *s*0x2545F4914F6CDD1Dull >> 11) + 0.5)*( 1.0/9007199254740992.0);
+}
+
+
+/* generator state of run i (splitmix64 of the seed and run number) */
+static uint64_t mc_mix( uint64_t seed, long i)
+{
+	uint64_t z = seed + ( (uint64_t)i + 1)*0x9E3779B97F4A7C15ull;
+
+	z = ( z ^ ( z >> 30))*0xBF58476D1CE4E5B9ull;
+	z = ( z ^ ( z >> 27))*0x94D049BB133111EBull;
+
+	return ( z ^ ( z >> 31)) | 1;
+}
+
+
+/* draws the parameters of run i */
+static void mc_draw( struct mc_run_type *r, uint64_t seed, long i)
+{
+	uint64_t s = mc_mix( seed, i);
+	double u;
+	int j;
+
+	for ( j = 0; j < MC_NP; j++)
+	{
+		u = mc_randu( &s);
+		if ( mc.log[j])
+			r->par[j] = mc.lo[j]*pow( mc.hi[j]/mc.lo[j], u);
+		else
+			r->par[j] = mc.lo[j] + ( mc.hi[j] - mc.lo[j])*u;
+	}
+	r->th0 = ( 2*mc_randu( &s) - 1)*mc.th0;
+	r->seed = s;
+}
+
+
+/* simulates one run on the calling thread's plant and controller */
+static void mc_run( struct SIM_plant_type *plant, struct mc_run_type *r)
+{
+	struct SIM_param_type p = mc.p0;
+	long n = (long)( mc.t_run/MC_DT + 0.5), k;
+	long n_hold = (long)( MC_T_HOLD/MC_DT + 0.5);
+	double t_out = 0, sq = 0, sx = 0;
+	uint32_t ticks0, upd0, ticks, upd;
+
+	p.m = r->par[MC_P_M];
+	p.J = p.m*p.l*p.l*(4.0/3.0);
+	p.kb = r->par[MC_P_KB];
+	p.qn = r->par[MC_P_QN];
+	p.Kt = r->par[MC_P_KT];
+	p.t_act = mc.t_act;
+
+	/* encoders zeroed upright, then the pendulum tilted */
+	SIM_Plant_Init( plant, &p, 0, 0);
+	plant->th = r->th0;
+	plant->qei_last[0] = SIM_Plant_QeiRaw( plant, 0);
+	plant->rng = r->seed;
+	if ( !mc.fl)
+		LQR_Balance_Restart();
+	LQR_Balance_GetEventStats( &ticks0, &upd0);
+
+	r->st = MC_ST_OK;
+	for ( k = 0; k < n; k++)
+	{
+		if ( mc.fl)
+			flcBalance_Run();
+		else if ( mc.evt)
+			LQR_Balance_CtrlRunEvt();
+		else
+			LQR_Balance_CtrlRun();
+
+		SIM_Plant_Step( plant, MC_DT);
+
+		if ( fabs(plant->th) > MC_TH_FALL)
+		{
+			r->st = MC_ST_FELL;
+			break;
+		}
+		if ( plant->collided)
+		{
+			r->st = MC_ST_END;
+			break;
+		}
+		if ( fabs(plant->th) > mc.tol_th || ( mc.tol_x > 0 && fabs(plant->x) > mc.tol_x))
+			t_out = plant->t;
+		if ( k >= n - n_hold)
+		{
+			sq += plant->th*plant->th;
+			sx += plant->x;
+		}
+	}
+
+	r->ts = t_out;
+	r->rms = sqrt( sq/n_hold);
+	r->x_m = sx/n_hold;
+	LQR_Balance_GetEventStats( &ticks, &upd);
+	r->upd = ( ticks != ticks0) ? (double)( upd - upd0)/( ticks - ticks0) : 1.0;
+	if ( r->st == MC_ST_OK && mc.t_run - t_out < MC_T_HOLD)
+		r->st = MC_ST_UNSET;
+}
+
+
+static const struct LQR_model_type mc_no_model = { { { 0 } }, { 0 } };
+
+
+static void *mc_worker( void *arg)
+{
+	struct SIM_plant_type plant;
+	long i, end;
+
+	/* thread local: the device shim of this thread drives this plant,
+	 * whose clock is the timebase of this thread's controller */
+	sim_plant = &plant;
+	SIM_Plant_Init( &plant, &mc.p0, 0, 0);
+	(void) SYSTIME_Init();
+	LQR_Balance_Init();
+	if ( mc.no_model)
+		LQR_Balance_SetModel( &mc_no_model);
+	if ( mc.dob_bw >= 0)
+		(void) LQR_Balance_SetObserver( (float)mc.dob_bw, LQR_Balance_GetParams()->dob.lim);
+
+	for ( ;;)
+	{
+		pthread_mutex_lock( &mc.lock);
+		i = mc.next;
+		mc.next += MC_BLOCK;
+		pthread_mutex_unlock( &mc.lock);
+		if ( i >= mc.n_run)
+			break;
+
+		for ( end = ( mc.n_run - i < MC_BLOCK) ? mc.n_run : i + MC_BLOCK; i < end; i++)
+			mc_run( &plant, &mc.run[i]);
+	}
+
+	return NULL;
+}
+
+
+static int mc_cmp_d( const void *a, const void *b)
+{
+	double x = *(const double *)a, y = *(const double *)b;
+
+	return ( x > y) - ( x < y);
+}
+
+
+/* table range of parameter j */
+static int mc_bin( int j, double v, int nb)
+{
+	int b;
+
+	if ( !( mc.hi[j] > mc.lo[j]))
+		return 0;
+	if ( mc.log[j])
+		b = (int)( log( v/mc.lo[j])/log( mc.hi[j]/mc.lo[j])*nb);
+	else
+		b = (int)( ( v - mc.lo[j])/( mc.hi[j] - mc.lo[j])*nb);
+
+	return ( b < 0) ? 0 : ( b >= nb) ? nb - 1 : b;
+}
+
+
+/* one table row: outcomes and settling time percentiles of the runs
+ * of parameter j in range b (j < 0: all runs); ts is scratch */
+static void mc_row( int j, int b, int nb, double *ts)
+{
+	static const double pct[] = { 0.5, 0.9, 0.95, 0.99 };
+	long n_st[MC_NST] = { 0 }, n = 0, i, k;
+	double lo, hi;
+	size_t q;
+
+	for ( i = 0; i < mc.n_run; i++)
+	{
+		if ( j >= 0 && mc_bin( j, mc.run[i].par[j], nb) != b)
+			continue;
+		n_st[mc.run[i].st]++;
+		ts[n++] = ( mc.run[i].st == MC_ST_OK) ? mc.run[i].ts : INFINITY;
+	}
+	qsort( ts, n, sizeof(*ts), mc_cmp_d);
+
+	if ( j < 0)
+		printf( "%-24s %-21s", "all", "");
+	else
+	{
+		if ( mc.log[j])
+		{
+			lo = mc.lo[j]*pow( mc.hi[j]/mc.lo[j], (double)b/nb);
+			hi = mc.lo[j]*pow( mc.hi[j]/mc.lo[j], (double)( b + 1)/nb);
+		}
+		else
+		{
+			lo = mc.lo[j] + ( mc.hi[j] - mc.lo[j])*b/nb;
+			hi = mc.lo[j] + ( mc.hi[j] - mc.lo[j])*( b + 1)/nb;
+		}
+		printf( "%-24s %9.4g - %-9.4g", ( b == 0) ? mc_par_name[j] : "", lo, hi);
+	}
+
+	printf( " %6ld", n);
+	if ( n == 0)
+	{
+		printf( "\n");
+		return;
+	}
+	printf( " %6.1f %6.1f %6.1f %6.1f", 100.0*( n - n_st[MC_ST_OK])/n, 100.0*n_st[MC_ST_FELL]/n,
+	        100.0*n_st[MC_ST_END]/n, 100.0*n_st[MC_ST_UNSET]/n);
+	for ( q = 0; q < sizeof(pct)/sizeof(pct[0]); q++)
+	{
+		k = (long)ceil( pct[q]*n) - 1;
+		if ( k < 0)
+			k = 0;
+		if ( isinf( ts[k]))
+			printf( " %7s", "-");
+		else
+			printf( " %7.3f", ts[k]);
+	}
+	printf( "\n");
+}
+
+
+int main( int argc, char **argv)
+{
+	double m_unc = MC_M_UNC, kt_unc = MC_KT_UNC, qn = MC_QN;
+	double kb_lo = MC_KB_LO, kb_hi = MC_KB_HI, v_bias = 0, wall, cpu;
+	uint64_t seed = 1;
+	pthread_t thr[MC_THR_MAX];
+	struct timespec w0, w1, c0, c1;
+	double *ts;
+	long i;
+	int opt, j, b, nb = MC_BINS;
+
+	mc.t_run = MC_T_RUN;
+	mc.th0 = MC_TH0;
+	mc.tol_th = MC_TOL_TH;
+	mc.tol_x = MC_TOL_X;
+	mc.n_run = MC_RUNS;
+	mc.n_thr = (int)sysconf( _SC_NPROCESSORS_ONLN);
+	mc.dob_bw = -1;
+
+	while ( (opt = getopt( argc, argv, "c:n:T:a:m:k:e:K:A:X:d:Mv:o:b:s:j:")) != -1)
+	{
+		switch ( opt)
+		{
+		case 'c':
+			mc.fl = mc.evt = 0;
+			if ( strcmp( optarg, "lqr") == 0)
+				;
+			else if ( strcmp( optarg, "evt") == 0)
+				mc.evt = 1;
+			else if ( strcmp( optarg, "fl") == 0)
+				mc.fl = 1;
+			else
+				goto usage;
+			break;
+		case 'n': mc.n_run = atol( optarg); break;
+		case 'T': mc.t_run = atof( optarg); break;
+		case 'a': mc.th0 = atof( optarg); break;
+		case 'm': m_unc = atof( optarg); break;
+		case 'k':
+			if ( sscanf( optarg, "%lf,%lf", &kb_lo, &kb_hi) != 2)
+				goto usage;
+			break;
+		case 'e': qn = atof( optarg); break;
+		case 'K': kt_unc = atof( optarg); break;
+		case 'A': mc.tol_th = atof( optarg); break;
+		case 'X': mc.tol_x = atof( optarg); break;
+		case 'd': mc.t_act = atof( optarg); break;
+		case 'M': mc.no_model = 1; break;
+		case 'v': v_bias = atof( optarg); break;
+		case 'o':
+			mc.dob_bw = atof( optarg);
+			if ( !( mc.dob_bw >= 0 && mc.dob_bw*MC_DT < 1))
+				goto usage;
+			break;
+		case 'b': nb = atoi( optarg); break;
+		case 's': seed = strtoull( optarg, NULL, 0); break;
+		case 'j': mc.n_thr = atoi( optarg); break;
+		default: goto usage;
+		}
+	}
+	if ( optind != argc || mc.n_run < 1 || !( mc.t_run > MC_T_HOLD) ||
+	     !( mc.th0 >= 0 && mc.th0 < MC_TH_FALL) || !( m_unc >= 0 && m_unc < 1) ||
+	     !( kt_unc >= 0 && kt_unc < 1) || !( qn >= 0) ||
+	     !( ( kb_lo == 0 && kb_hi == 0) || ( kb_lo > 0 && kb_hi >= kb_lo)) ||
+	     !( mc.tol_th > 0) || !( mc.tol_x >= 0) || !( mc.t_act >= 0 && mc.t_act < MC_T_ACT_MAX) ||
+	     nb < 1 || nb > MC_BINS_MAX)
+		goto usage;
+	if ( mc.n_thr < 1)
+		mc.n_thr = 1;
+	if ( mc.n_thr > MC_THR_MAX)
+		mc.n_thr = MC_THR_MAX;
+
+	SIM_Plant_Defaults( &mc.p0);
+	mc.p0.cb = MC_CB;
+	mc.p0.v_bias = v_bias;
+	mc.lo[MC_P_M] = mc.p0.m*( 1 - m_unc);
+	mc.hi[MC_P_M] = mc.p0.m*( 1 + m_unc);
+	mc.lo[MC_P_KB] = kb_lo;
+	mc.hi[MC_P_KB] = kb_hi;
+	mc.log[MC_P_KB] = ( kb_lo > 0);
+	mc.lo[MC_P_QN] = 0;
+	mc.hi[MC_P_QN] = qn;
+	mc.lo[MC_P_KT] = mc.p0.Kt*( 1 - kt_unc);
+	mc.hi[MC_P_KT] = mc.p0.Kt*( 1 + kt_unc);
+
+	mc.run = malloc( mc.n_run*sizeof(*mc.run));
+	ts = malloc( mc.n_run*sizeof(*ts));
+	if ( mc.run == NULL || ts == NULL)
+	{
+		fprintf( stderr, "out of memory\n");
+		return 1;
+	}
+	for ( i = 0; i < mc.n_run; i++)
+		mc_draw( &mc.run[i], seed, i);
+
+	pthread_mutex_init( &mc.lock, NULL);
+	clock_gettime( CLOCK_MONOTONIC, &w0);
+	clock_gettime( CLOCK_PROCESS_CPUTIME_ID, &c0);
+	for ( j = 0; j < mc.n_thr; j++)
+		if ( pthread_create( &thr[j], NULL, mc_worker, NULL))
+		{
+			fprintf( stderr, "cannot start worker threads\n");
+			return 1;
+		}
+	for ( j = 0; j < mc.n_thr; j++)
+		pthread_join( thr[j], NULL);
+	clock_gettime( CLOCK_MONOTONIC, &w1);
+	clock_gettime( CLOCK_PROCESS_CPUTIME_ID, &c1);
+	wall = ( w1.tv_sec - w0.tv_sec) + 1e-9*( w1.tv_nsec - w0.tv_nsec);
+	cpu = ( c1.tv_sec - c0.tv_sec) + 1e-9*( c1.tv_nsec - c0.tv_nsec);
+
+	printf( "controller %s%s, %ld runs of %g s, initial angle +/- %g rad, actuation delay %g us,"
+	        " seed %llu\n", mc.fl ? "flcBalance_Run" : mc.evt ? "LQR_Balance_CtrlRunEvt" : "LQR_Balance_CtrlRun",
+	        ( !mc.fl && mc.no_model) ? " without model" : "", mc.n_run, mc.t_run, mc.th0,
+	        1e6*mc.t_act, (unsigned long long)seed);
+	printf( "input bias %g V", mc.p0.v_bias);
+	if ( !mc.fl)
+		printf( ", disturbance observer bandwidth %g rad/s",
+		        ( mc.dob_bw >= 0) ? mc.dob_bw : (double)LQR_RIG_DOB_BW);
+	printf( "\nsettled: |th| <= %g rad", mc.tol_th);
+	if ( mc.tol_x > 0)
+		printf( ", |x| <= %g m", mc.tol_x);
+	printf( " over the last %g s\n", MC_T_HOLD);
+	printf( "%ld runs on %d threads: %.2f s wall, %.2f s CPU; %.1f runs/s, %.1f runs/s/core"
+	        " (%.0fx real time per core)\n\n", mc.n_run, mc.n_thr, wall, cpu,
+	        ( wall > 0) ? mc.n_run/wall : 0.0, ( cpu > 0) ? mc.n_run/cpu : 0.0,
+	        ( cpu > 0) ? mc.n_run*mc.t_run/cpu : 0.0);
+
+	for ( i = 0, b = 0; i < mc.n_run; i++)
+		if ( mc.run[i].st == MC_ST_OK)
+			ts[b++] = mc.run[i].rms;
+	qsort( ts, b, sizeof(*ts), mc_cmp_d);
+	if ( b > 0)
+		printf( "RMS angle over the last %g s of the settled runs: median %.3f mrad, 90 %% %.3f mrad\n\n",
+		        MC_T_HOLD, 1e3*ts[( b - 1)/2], 1e3*ts[(long)ceil( 0.9*b) - 1]);
+	for ( i = 0, b = 0; i < mc.n_run; i++)
+		if ( mc.run[i].st == MC_ST_OK || mc.run[i].st == MC_ST_UNSET)
+			ts[b++] = fabs( mc.run[i].x_m);
+	qsort( ts, b, sizeof(*ts), mc_cmp_d);
+	if ( b > 0)
+		printf( "cart offset (mean |x| over the last %g s of the runs still up): median %.2f mm, 90 %% %.2f mm\n\n",
+		        MC_T_HOLD, 1e3*ts[( b - 1)/2], 1e3*ts[(long)ceil( 0.9*b) - 1]);
+	if ( mc.evt)
+	{
+		for ( i = 0, b = 0; i < mc.n_run; i++)
+			if ( mc.run[i].st == MC_ST_OK)
+				ts[b++] = mc.run[i].upd;
+		qsort( ts, b, sizeof(*ts), mc_cmp_d);
+		if ( b > 0)
+			printf( "output recomputed in %.1f %% of the periods of the median settled run, %.1f %% at 90 %%\n\n",
+			        100*ts[( b - 1)/2], 100*ts[(long)ceil( 0.9*b) - 1]);
+	}
+
+	printf( "%-24s %-21s %6s %6s %6s %6s %6s %7s %7s %7s %7s\n", "parameter", "range", "runs",
+	        "fail%", "fell%", "end%", "unset%", "ts50", "ts90", "ts95", "ts99");
+	mc_row( -1, 0, nb, ts);
+	for ( j = 0; j < MC_NP; j++)
+	{
+		if ( !( mc.hi[j] > mc.lo[j]))
+			continue;
+		printf( "\n");
+		for ( b = 0; b < nb; b++)
+			mc_row( j, b, nb, ts);
+	}
+
+	free( ts);
+	free( mc.run);
+
+	return 0;
+
+usage:
+	fprintf( stderr, "usage: %s [-c lqr|evt|fl] [-n runs] [-T length] [-a th0] [-m mass] [-k kb_lo,kb_hi]\n"
+	         "       [-e noise] [-K kt] [-A tol_th] [-X tol_x] [-d delay] [-M] [-v bias] [-o bw]\n"
+	         "       [-b bins] [-s seed] [-j threads]\n",
+	         argv[0]);
+	return 2;
+}
@@ -0,0 +1,239 @@
+/*
+ * sim_device.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Milos Lazic
+ *
+ *  Host simulator replacement for sys/device/device.c; routes the device
+ *  interface used by the controller modules to the simulated plant.
+ */
+
+#include <math.h>
+#include "../../sys/device/device.h"
+#include "sim_plant.h"
+
+
+#define SIM_PI 3.14159265358979323846
+#define SIM_SYS_CLOCK 80000000.0   /* system clock (timer count rate), Hz */
+
+
+DEV_STATE_CLASS struct SIM_plant_type *sim_plant = NULL;
+
+/* simulation time (cycles) the latest power update takes effect */
+static DEV_STATE_CLASS uint64_t sim_t_act = 0;
+
+
+void dev_init(dev_t devno)
+{
+	/* nothing to initialize */
+}
+
+
+int dev_write(dev_t devno, const char *buf, size_t count)
+{
+	return -1;
+}
+
+
+int dev_read(dev_t devno, char *buf, size_t count)
+{
+	return -1;
+}
+
+
+int dev_lseek(dev_t devno, int offset, int whence)
+{
+	return -1;
+}
+
+
+static int sim_qei_ioctl(int idx, int request, va_list args)
+{
+	int rv = 0;
+	int32_t raw = SIM_Plant_QeiRaw( sim_plant, idx);
+	float *buf;
+
+	switch(request)
+	{
+	case eQEI_IOCTL_R_POS:
+		rv = raw + sim_plant->qei_ofs[idx];
+		break;
+
+	case eQEI_IOCTL_W_POS:
+		sim_plant->qei_ofs[idx] = va_arg(args, int) - raw;
+		break;
+
+	case eQEI_IOCTL_READ_SPEED:
+		rv = sim_plant->qei_vel[idx];
+		break;
+
+	case eQEI_IOCTL_R_POS_RAD:
+		buf = va_arg(args, float *);
+		*buf = (float)((double)(raw + sim_plant->qei_ofs[idx])/SIM_QEI_PPR*2.0*SIM_PI);
+		break;
+
+	case eQEI_IOCTL_R_VEL_RAD:
+		buf = va_arg(args, float *);
+		*buf = (float)(((double)sim_plant->qei_vel[idx]*2.0*SIM_PI/SIM_QEI_PPR)/SIM_QEI_VEL_PERIOD);
+		break;
+
+	default:
+		break;
+	}
+
+	return rv;
+}
+
+
+static int sim_esc_ioctl(int request, va_list args)
+{
+	double power;
+
+	switch(request)
+	{
+	case eESC_IOCTL_SET_POWER:
+		power = (double)va_arg(args, int);
+		break;
+
+	case eESC_IOCTL_SET_POWER_F:
+		power = va_arg(args, double);
+		break;
+
+	case eESC_IOCTL_SET_POWER_Q15:
+		power = (double)va_arg(args, int)*100.0/32768.0;
+		break;
+
+	case eESC_IOCTL_SET_FREQ:
+	case eESC_IOCTL_SET_DEADTIME:
+	case eESC_IOCTL_SYNC:
+		/* PWM is modelled as an averaged voltage */
+		return 0;
+
+	case eESC_IOCTL_GET_POWER_Q15:
+		*va_arg(args, int32_t *) = (int32_t)(sim_plant->volts/sim_plant->p.Vbus*32768.0);
+		return 0;
+
+	case eESC_IOCTL_GET_ACT_TIME:
+		/* power is applied p.t_act after it is staged */
+		*va_arg(args, uint64_t *) = sim_t_act;
+		return 0;
+
+	default:
+		return -1;
+	}
+
+	if ( power > 100.0)
+		power = 100.0;
+	else if ( power < -100.0)
+		power = -100.0;
+	sim_t_act = (uint64_t)(SIM_Plant_SetVolts( sim_plant, sim_plant->p.Vbus*power/100.0)*SIM_SYS_CLOCK);
+
+	return 0;
+}
+
+
+static int sim_prs_ioctl(int request, va_list args)
+{
+	switch(request)
+	{
+	case ePRS_IOCTL_DISTMSR:
+		/* sensor at the end stop towards positive motor power */
+		return (int)((sim_plant->p.x_end - sim_plant->x)*1000.0);
+
+	default:
+		break;
+	}
+
+	return -1;
+}
+
+
+/* timers count simulated time; allocation hands out modules in order */
+static DEV_STATE_CLASS int sim_timers_used = 0;
+static DEV_STATE_CLASS int sim_wtimers_used = 0;
+
+int timer_dev_alloc(uint32_t flags, const char *owner)
+{
+	if ( !(flags & TIMER_ALLOC_WIDE) && sim_timers_used < 6)
+		return eDEV_TIMER0 + sim_timers_used++;
+	if ( sim_wtimers_used < 6)
+		return eDEV_WTIMER0 + sim_wtimers_used++;
+
+	return -1;
+}
+
+
+void timer_dev_free(dev_t devno)
+{
+	/* modules are not reused */
+}
+
+
+static int sim_timer_ioctl(int request, va_list args)
+{
+	uint64_t cyc = sim_plant ? (uint64_t)(sim_plant->t*SIM_SYS_CLOCK) : 0;
+
+	switch(request)
+	{
+	case eTIMER_READ:
+		return (int)(uint32_t)cyc;
+
+	case eTIMER_READ64:
+		*va_arg(args, uint64_t *) = cyc;
+		return 0;
+
+	case eTIMER_CONFIG:
+	case eTIMER_ENABLE:
+	case eTIMER_DISABLE:
+	case eTIMER_RESET:
+		/* all timers read the simulation clock */
+		return 0;
+
+	case eTIMER_EVENT:
+		return 1;
+
+	default:
+		break;
+	}
+
+	return -1;
+}
+
+
+int dev_ioctl(dev_t devno, int request, ...)
+{
+	int rv = -1;
+
+	va_list args;
+	va_start(args, request);
+
+	switch(devno)
+	{
+	case eDEV_QEI0:
+		rv = sim_qei_ioctl(0, request, args);
+		break;
+	case eDEV_QEI1:
+		rv = sim_qei_ioctl(1, request, args);
+		break;
+	case eDEV_ESC0:
+		rv = sim_esc_ioctl(request, args);
+		break;
+	case eDEV_PRS0:
+		rv = sim_prs_ioctl(request, args);
+		break;
+	default:
+		if ( devno >= eDEV_TIMER0 && devno <= eDEV_WTIMER5)
+			rv = sim_timer_ioctl(request, args);
+		break;
+	}
+
+	va_end(args);
+
+	return rv;
+}
+
+
+void dev_deinit(dev_t devno)
+{
+	/* nothing to release */
+}
@@ -0,0 +1,353 @@
+/*
+ * sim_plant.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Milos Lazic
+ *
+ *  Nonlinear cart-pole model driven by a belt-coupled DC motor. Used by
+ *  the host benchmarks to close the loop around the controller modules.
+ */
+
+#include <math.h>
+#include <string.h>
+#include "sim_plant.h"
+
+
+#define SIM_PI 3.14159265358979323846
+#define SIM_NS 6    /* integrated states: x, x', th, th', xm, xm' */
+
+
+/*
+ * Name: SIM_Plant_Defaults
+ *
+ * Descr: Loads nominal model parameters of the rig
+ *
+ * Args:     p - parameter set to initialize
+ *
+ * Return:   none
+ *
+ * Notes: pulley radius from calibration (SHAFT_RADIUS in lqr_balance.c);
+ *        remaining values are estimates pending system identification;
+ *        rigid belt, noise-free encoders, no input bias
+ *
+ */
+void SIM_Plant_Defaults( struct SIM_param_type *p)
+{
+	p->M = 0.5;
+	p->m = 0.1;
+	p->l = 0.2;
+	p->J = p->m*p->l*p->l*(4.0/3.0);
+	p->g = 9.81;
+	p->r = 0.0069358;
+	p->Kt = 0.02;
+	p->Ra = 2.0;
+	p->bx = 0.0;
+	p->Fc = 0.0;
+	p->Vdb = 0.0;
+	p->bth = 0.0;
+	p->Vbus = 12.0;
+	p->x_end = 0.4;
+	p->kb = 0.0;
+	p->cb = 0.0;
+	p->Jm = 5e-6;
+	p->qn = 0.0;
+	p->t_act = 0.0;
+	p->v_bias = 0.0;
+}
+
+
+/*
+ * Name: SIM_Plant_Init
+ *
+ * Descr: Initializes a plant instance at rest
+ *
+ * Args:     plant - plant instance
+ *           p     - model parameters (copied)
+ *           x0    - initial cart position (m)
+ *           th0   - initial pendulum angle from upright (rad); pi is hanging
+ *
+ * Return:   none
+ *
+ * Notes: encoders read zero in the initial position
+ *
+ */
+void SIM_Plant_Init( struct SIM_plant_type *plant, const struct SIM_param_type *p,
+                     double x0, double th0)
+{
+	memset( plant, 0, sizeof(*plant));
+	plant->p = *p;
+	plant->x = x0;
+	plant->xm = x0;
+	plant->th = th0;
+	plant->rng = 0x9E3779B97F4A7C15ull;
+
+	plant->qei_ofs[0] = -SIM_Plant_QeiRaw( plant, 0);
+	plant->qei_ofs[1] = -SIM_Plant_QeiRaw( plant, 1);
+	plant->qei_last[0] = SIM_Plant_QeiRaw( plant, 0);
+	plant->qei_last[1] = SIM_Plant_QeiRaw( plant, 1);
+	plant->vel_t = SIM_QEI_VEL_PERIOD;
+}
+
+
+/*
+ * Name: SIM_Plant_Deriv
+ *
+ * Descr: Evaluates the equations of motion
+ *
+ * Args:     p - model parameters
+ *           s - state { x, x', th, th', xm, xm' }
+ *           v - motor voltage
+ *           d - storage for state derivative
+ *
+ * Return:   none
+ *
+ * Notes: (M+m)x'' + m*l*cos(th)*th'' - m*l*sin(th)*th'^2 = F
+ *        J*th'' + m*l*cos(th)*x'' - m*g*l*sin(th) = -bth*th'
+ *        elastic belt: F = kb*(xm - x) + cb*(xm' - x') less friction,
+ *        (Jm/r^2)*xm'' = motor force - kb*(xm - x) - cb*(xm' - x');
+ *        rigid belt: xm is not integrated
+ *
+ */
+static void SIM_Plant_Deriv( const struct SIM_param_type *p, const double *s, double v, double *d)
+{
+	double F, Fb, a11, a12, a22, b1, b2, det;
+	double c = cos(s[2]), sn = sin(s[2]);
+
+	/* driver offset, then dead band */
+	v += p->v_bias;
+	if ( v > p->Vdb)
+		v -= p->Vdb;
+	else if ( v < -p->Vdb)
+		v += p->Vdb;
+	else
+		v = 0;
+
+	if ( p->kb > 0)
+	{
+		/* belt force at the cart; motor force less back-emf drives the pulley side */
+		Fb = p->kb*(s[4] - s[0]) + p->cb*(s[5] - s[1]);
+		d[4] = s[5];
+		d[5] = ((p->Kt/(p->Ra*p->r))*v - (p->Kt*p->Kt/(p->Ra*p->r*p->r))*s[5] - Fb)*p->r*p->r/p->Jm;
+		F = Fb;
+	}
+	else
+	{
+		/* motor force at the belt less back-emf */
+		F = (p->Kt/(p->Ra*p->r))*v - (p->Kt*p->Kt/(p->Ra*p->r*p->r))*s[1];
+		d[4] = 0;
+		d[5] = 0;
+	}
+
+	/* cart friction */
+	F = F - p->bx*s[1] - p->Fc*tanh(s[1]/1e-3);
+
+	a11 = p->M + p->m;
+	a12 = p->m*p->l*c;
+	a22 = p->J;
+	b1 = F + p->m*p->l*sn*s[3]*s[3];
+	b2 = p->m*p->g*p->l*sn - p->bth*s[3];
+	det = a11*a22 - a12*a12;
+
+	d[0] = s[1];
+	d[1] = (b1*a22 - a12*b2)/det;
+	d[2] = s[3];
+	d[3] = (a11*b2 - a12*b1)/det;
+}
+
+
+/*
+ * Name: SIM_Plant_Randn
+ *
+ * Descr: Draws a standard normal deviate
+ *
+ * Args:     s - generator state (xorshift64*), not zero
+ *
+ * Return:   deviate
+ *
+ * Notes: Box-Muller
+ *
+ */
+static double SIM_Plant_Randn( uint64_t *s)
+{
+	double u[2];
+	int i;
+
+	for ( i = 0; i < 2; i++)
+	{
+		*s ^= *s >> 12;
+		*s ^= *s << 25;
+		*s ^= *s >> 27;
+		u[i] = ((*s*0x2545F4914F6CDD1Dull >> 11) + 0.5)*(1.0/9007199254740992.0);
+	}
+
+	return sqrt(-2.0*log(u[0]))*cos(2.0*SIM_PI*u[1]);
+}
+
+
+/* one RK4 step of the equations of motion, the voltage held */
+static void SIM_Plant_Rk4( struct SIM_plant_type *plant, double dt)
+{
+	double s[SIM_NS] = { plant->x, plant->xdot, plant->th, plant->thd, plant->xm, plant->xmd };
+	double k1[SIM_NS], k2[SIM_NS], k3[SIM_NS], k4[SIM_NS], t[SIM_NS];
+	int i;
+
+	SIM_Plant_Deriv( &plant->p, s, plant->volts, k1);
+	for ( i = 0; i < SIM_NS; i++) t[i] = s[i] + 0.5*dt*k1[i];
+	SIM_Plant_Deriv( &plant->p, t, plant->volts, k2);
+	for ( i = 0; i < SIM_NS; i++) t[i] = s[i] + 0.5*dt*k2[i];
+	SIM_Plant_Deriv( &plant->p, t, plant->volts, k3);
+	for ( i = 0; i < SIM_NS; i++) t[i] = s[i] + dt*k3[i];
+	SIM_Plant_Deriv( &plant->p, t, plant->volts, k4);
+
+	for ( i = 0; i < SIM_NS; i++)
+		s[i] += (dt/6.0)*(k1[i] + 2.0*k2[i] + 2.0*k3[i] + k4[i]);
+
+	plant->x = s[0];
+	plant->xdot = s[1];
+	plant->th = s[2];
+	plant->thd = s[3];
+	plant->xm = s[4];
+	plant->xmd = s[5];
+}
+
+
+/*
+ * Name: SIM_Plant_Step
+ *
+ * Descr: Advances the model by one integration step (RK4) and updates
+ *        the emulated QEI velocity registers
+ *
+ * Args:     plant - plant instance
+ *           dt    - step (s)
+ *
+ * Return:   none
+ *
+ * Notes: the motor voltage is held constant over the step, except that
+ *        pending voltages (SIM_Plant_SetVolts) take over at their times,
+ *        splitting the step
+ *
+ */
+void SIM_Plant_Step( struct SIM_plant_type *plant, double dt)
+{
+	double t = plant->t, left = dt, h;
+	int i;
+
+	while ( plant->pend_n > 0 && plant->t_pend[plant->pend_i] <= plant->t + dt)
+	{
+		h = plant->t_pend[plant->pend_i] - t;
+		if ( h > 0)
+		{
+			SIM_Plant_Rk4( plant, h);
+			t += h;
+			left -= h;
+		}
+		plant->volts = plant->v_pend[plant->pend_i];
+		plant->pend_i = ( plant->pend_i + 1) % SIM_ACT_Q;
+		plant->pend_n--;
+	}
+	if ( left > 0)
+		SIM_Plant_Rk4( plant, left);
+	plant->t += dt;
+
+	/* track end stops */
+	if ( plant->x > plant->p.x_end || plant->x < -plant->p.x_end)
+	{
+		plant->x = (plant->x > 0) ? plant->p.x_end : -plant->p.x_end;
+		plant->xdot = 0;
+		plant->collided = 1;
+	}
+	if ( plant->p.kb <= 0)
+	{
+		plant->xm = plant->x;
+		plant->xmd = plant->xdot;
+	}
+
+	/* encoder noise, held over the step */
+	if ( plant->p.qn > 0)
+		for ( i = 0; i < 2; i++)
+			plant->qei_err[i] = (int32_t)floor(plant->p.qn*SIM_Plant_Randn( &plant->rng) + 0.5);
+
+	/* QEI velocity capture: counts accumulated over one timer period */
+	plant->vel_t -= dt;
+	if ( plant->vel_t <= 0)
+	{
+		for ( i = 0; i < 2; i++)
+		{
+			int32_t raw = SIM_Plant_QeiRaw( plant, i);
+			plant->qei_vel[i] = raw - plant->qei_last[i];
+			plant->qei_last[i] = raw;
+		}
+		plant->vel_t += SIM_QEI_VEL_PERIOD;
+	}
+}
+
+
+/*
+ * Name: SIM_Plant_SetVolts
+ *
+ * Descr: Sets the motor voltage
+ *
+ * Args:     plant - plant instance
+ *           v     - voltage
+ *
+ * Return:   simulation time the voltage takes effect (s)
+ *
+ * Notes: with an actuation delay (p.t_act) the voltage waits for the step
+ *        that reaches its time; a voltage set at the same time as the
+ *        newest pending one replaces it, and the oldest is dropped when
+ *        SIM_ACT_Q are pending
+ *
+ */
+double SIM_Plant_SetVolts( struct SIM_plant_type *plant, double v)
+{
+	double t = plant->t + plant->p.t_act;
+	int i;
+
+	if ( plant->p.t_act <= 0)
+	{
+		plant->volts = v;
+		plant->pend_n = 0;
+		return plant->t;
+	}
+
+	i = ( plant->pend_i + plant->pend_n - 1) % SIM_ACT_Q;
+	if ( plant->pend_n == 0 || plant->t_pend[i] != t)
+	{
+		if ( plant->pend_n == SIM_ACT_Q)
+		{
+			plant->pend_i = ( plant->pend_i + 1) % SIM_ACT_Q;
+			plant->pend_n--;
+		}
+		i = ( plant->pend_i + plant->pend_n) % SIM_ACT_Q;
+		plant->pend_n++;
+	}
+	plant->v_pend[i] = v;
+	plant->t_pend[i] = t;
+
+	return t;
+}
+
+
+/*
+ * Name: SIM_Plant_QeiRaw
+ *
+ * Descr: Returns the raw (offset-free) count of an emulated encoder
+ *
+ * Args:     plant - plant instance
+ *           idx   - 0 for the pendulum encoder (QEI0), 1 for the
+ *                   cart encoder (QEI1)
+ *
+ * Return:   encoder count
+ *
+ * Notes: QEI0 counts zero with the pendulum hanging; QEI1 (on the motor
+ *        pulley) counts opposite to positive motor power; both include
+ *        the noise of the current step
+ *
+ */
+int32_t SIM_Plant_QeiRaw( const struct SIM_plant_type *plant, int idx)
+{
+	if ( idx == 0)
+		return (int32_t)floor((plant->th - SIM_PI)*SIM_QEI_PPR/(2.0*SIM_PI) + 0.5) + plant->qei_err[0];
+	else
+		return (int32_t)floor((-plant->xm/plant->p.r)*SIM_QEI_PPR/(2.0*SIM_PI) + 0.5) + plant->qei_err[1];
+}
@@ -0,0 +1,142 @@
+/*
+ * sim_plant.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Milos Lazic
+ */
+
+#ifndef HOST_SIM_SIM_PLANT_H_
+#define HOST_SIM_SIM_PLANT_H_
+
+#include <stdint.h>
+#include "../../sys/device/device.h"
+
+
+#define SIM_QEI_PPR        2400     /* encoder counts per revolution (both encoders) */
+#define SIM_QEI_VEL_PERIOD 0.05     /* QEI velocity timer period (s); QEIx_LOAD_R = 0x3D08FF */
+#define SIM_ACT_Q          16       /* voltages in flight during the actuation delay */
+
+
+/* Name: SIM_param_type
+ *
+ * Description: cart-pole and motor model parameters
+ *
+ * Members: M     - cart mass (kg)
+ *          m     - pendulum mass (kg)
+ *          l     - distance from pivot to pendulum centre of mass (m)
+ *          J     - pendulum moment of inertia about the pivot (kg*m^2)
+ *          g     - gravitational acceleration (m/s^2)
+ *          r     - belt pulley radius (m)
+ *          Kt    - motor torque (and back-emf) constant (N*m/A)
+ *          Ra    - armature resistance (ohm)
+ *          bx    - cart viscous friction (N*s/m)
+ *          Fc    - cart Coulomb friction (N)
+ *          Vdb   - motor driver dead band; voltage magnitude lost before
+ *                  the motor produces torque (V)
+ *          bth   - pivot viscous friction (N*m*s/rad)
+ *          Vbus  - motor supply voltage at 100 % power (V)
+ *          x_end - track half-length; cart hits an end stop at |x| = x_end (m)
+ *          kb    - belt stiffness between the motor pulley and the cart
+ *                  (N/m); 0 for a rigid belt
+ *          cb    - belt damping (N*s/m)
+ *          Jm    - motor rotor and pulley inertia (kg*m^2); used with an
+ *                  elastic belt (kb > 0) only
+ *          qn    - encoder noise; standard deviation of the count error
+ *                  added to both encoders every step (counts)
+ *          t_act - actuation delay; a voltage takes effect this long after
+ *                  it is set (s); at most SIM_ACT_Q voltages set within
+ *                  the delay
+ *          v_bias - input bias added to the motor voltage, e.g. a driver
+ *                  offset or a constant load on the cart (V)
+ *
+ * Notes: default values (SIM_Plant_Defaults) reproduce the sign conventions
+ *        of the rig: positive motor power accelerates the cart towards
+ *        negative encoder position, pendulum angle increases with
+ *        the pendulum tip moving in the direction of positive motor power.
+ */
+struct SIM_param_type
+{
+	double M;
+	double m;
+	double l;
+	double J;
+	double g;
+	double r;
+	double Kt;
+	double Ra;
+	double bx;
+	double Fc;
+	double Vdb;
+	double bth;
+	double Vbus;
+	double x_end;
+	double kb;
+	double cb;
+	double Jm;
+	double qn;
+	double t_act;
+	double v_bias;
+};
+
+
+/* Name: SIM_plant_type
+ *
+ * Description: simulated plant instance (model state and encoder emulation)
+ *
+ * Members: p        - model parameters
+ *          x, xdot  - cart position (m) and velocity (m/s)
+ *          xm, xmd  - belt position at the motor pulley (m) and velocity;
+ *                     equal to x, xdot with a rigid belt
+ *          th, thd  - pendulum angle from upright (rad) and angular velocity
+ *          volts    - voltage currently applied to the motor
+ *          v_pend   - voltages set, waiting for the actuation delay
+ *                     (oldest first, from index pend_i)
+ *          t_pend   - times the v_pend take effect (s)
+ *          pend_i   - oldest pending voltage
+ *          pend_n   - pending voltages
+ *          t        - simulation time (s)
+ *          qei_ofs  - encoder offsets (counts) set through eQEI_IOCTL_W_POS
+ *          qei_vel  - latched encoder velocities (counts per velocity period)
+ *          qei_last - encoder count at start of current velocity period
+ *          qei_err  - encoder count errors of the current step (noise)
+ *          rng      - noise generator state; SIM_Plant_Init seeds it with
+ *                     a fixed value, set it for independent noise
+ *          vel_t    - time left in the current velocity period
+ *          collided - set when the cart hits a track end
+ */
+struct SIM_plant_type
+{
+	struct SIM_param_type p;
+	double x, xdot;
+	double xm, xmd;
+	double th, thd;
+	double volts;
+	double v_pend[SIM_ACT_Q];
+	double t_pend[SIM_ACT_Q];
+	int pend_i;
+	int pend_n;
+	double t;
+
+	int32_t qei_ofs[2];
+	int32_t qei_vel[2];
+	int32_t qei_last[2];
+	int32_t qei_err[2];
+	uint64_t rng;
+	double vel_t;
+	int collided;
+};
+
+
+extern void SIM_Plant_Defaults( struct SIM_param_type *p);
+extern void SIM_Plant_Init( struct SIM_plant_type *plant, const struct SIM_param_type *p,
+                            double x0, double th0);
+extern void SIM_Plant_Step( struct SIM_plant_type *plant, double dt);
+extern int32_t SIM_Plant_QeiRaw( const struct SIM_plant_type *plant, int idx);
+extern double SIM_Plant_SetVolts( struct SIM_plant_type *plant, double v);
+
+/* plant driven by the device shim (sim_device.c); one per thread where
+ * DEV_STATE_CLASS is thread local */
+extern DEV_STATE_CLASS struct SIM_plant_type *sim_plant;
+
+
+#endif /* HOST_SIM_SIM_PLANT_H_ */
@@ -0,0 +1,144 @@
+/*
+ * swu_bench.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Milos Lazic
+ *
+ *  Host benchmark for the swing-up controller: closes the loop around
+ *  SWU_CtrlRun / LQR_Balance_CtrlRun with the simulated plant and reports
+ *  time-to-upright (swing-up start to capture) and balance hold success.
+ *
+ *  Build (from repository root):
+ *      gcc -std=c99 -O2 -Ihost/sim -o swu_bench host/sim/swu_bench.c \
+ *          host/sim/sim_plant.c host/sim/sim_device.c \
+ *          swingup/swu_ctrl.c swingup/swu_utils.c \
+ *          lqr/lqr_balance.c lqr/lqr_utils.c lqr/lqr_rig_filt.c \
+ *          dsp/dsp_biquad.c dsp/dsp_fir.c dsp/dsp_filt.c \
+ *          sys/systime/systime.c -lm
+ *
+ *  Usage: swu_bench [trials] [seed]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "../../swingup/swu.h"
+#include "../../lqr/lqr.h"
+#include "../../sys/systime/systime.h"
+#include "sim_plant.h"
+
+
+#define BENCH_PI        3.14159265358979323846
+#define BENCH_DT        0.0001   /* control period (s); SysTick at 10 kHz */
+#define BENCH_T_SWINGUP 20.0     /* swing-up timeout (s) */
+#define BENCH_T_HOLD    5.0      /* balance hold time after capture (s) */
+#define BENCH_TH_FALL   0.6      /* pendulum considered fallen beyond this angle (rad) */
+
+
+static double frand( double lo, double hi)
+{
+	return lo + (hi - lo)*((double)rand()/(double)RAND_MAX);
+}
+
+
+/*
+ * Name: bench_trial
+ *
+ * Descr: Runs one swing-up and balance trial
+ *
+ * Args:     th0       - initial pendulum angle offset from hanging (rad)
+ *           x0        - initial cart position (m)
+ *           t_capture - storage for time-to-upright (s)
+ *
+ * Return:   0 if the pendulum was captured and held upright for
+ *           BENCH_T_HOLD seconds without hitting a track end,
+ *           1 on swing-up timeout, 2 if the pendulum fell after
+ *           capture, 3 on a track end collision
+ *
+ * Notes:
+ */
+static int bench_trial( double th0, double x0, double *t_capture)
+{
+	struct SIM_param_type p;
+	struct SIM_plant_type plant;
+	double t_end;
+	int captured = 0;
+
+	SIM_Plant_Defaults( &p);
+	SIM_Plant_Init( &plant, &p, x0, BENCH_PI + th0);
+	sim_plant = &plant;
+
+	SWU_Reset();
+	LQR_Balance_SetPoint( 0);
+	*t_capture = -1;
+
+	t_end = BENCH_T_SWINGUP;
+	while ( plant.t < t_end)
+	{
+		if ( !captured)
+		{
+			if ( SWU_CtrlRun() == eSWU_STATUS_CAPTURED)
+			{
+				captured = 1;
+				*t_capture = plant.t;
+				t_end = plant.t + BENCH_T_HOLD;
+			}
+		}
+		else
+		{
+			LQR_Balance_CtrlRun();
+			if ( fabs(remainder(plant.th, 2.0*BENCH_PI)) > BENCH_TH_FALL)
+				return 2;
+		}
+
+		SIM_Plant_Step( &plant, BENCH_DT);
+
+		if ( plant.collided)
+			return 3;
+	}
+
+	return captured ? 0 : 1;
+}
+
+
+int main( int argc, char **argv)
+{
+	int trials = (argc > 1) ? atoi(argv[1]) : 20;
+	unsigned seed = (argc > 2) ? (unsigned)atoi(argv[2]) : 1;
+	int i, rv, ok = 0, fails[4] = { 0 };
+	double t_cap, t_sum = 0, t_min = 1e9, t_max = 0;
+
+	srand( seed);
+	(void) SYSTIME_Init();
+	LQR_Balance_Init();
+
+	printf("trial, th0 (rad), x0 (m), result, time-to-upright (s)\n");
+	for ( i = 0; i < trials; i++)
+	{
+		double th0 = frand( -0.05, 0.05);
+		double x0 = frand( -0.05, 0.05);
+
+		rv = bench_trial( th0, x0, &t_cap);
+		printf("%d, %+.4f, %+.4f, %d, %.4f\n", i, th0, x0, rv, t_cap);
+
+		if ( rv == 0)
+		{
+			ok++;
+			t_sum += t_cap;
+			if ( t_cap < t_min) t_min = t_cap;
+			if ( t_cap > t_max) t_max = t_cap;
+		}
+		else
+		{
+			fails[rv]++;
+		}
+	}
+
+	printf("\nsuccess: %d/%d (timeout %d, fell %d, collision %d)\n",
+	       ok, trials, fails[1], fails[2], fails[3]);
+	if ( ok)
+		printf("time-to-upright: mean %.3f s, min %.3f s, max %.3f s\n",
+		       t_sum/ok, t_min, t_max);
+
+	return (ok == trials) ? 0 : 1;
+}
@@ -0,0 +1,192 @@
+/*
+ * traj_bench.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Milos Lazic
+ *
+ *  Host benchmark for set point moves: balances the simulated plant with
+ *  LQR_Balance_CtrlRun and moves the cart by the same distance three
+ *  ways, each from rest across the centre of the track (-d/2 to d/2; set
+ *  points are limited to +/- CMD_SP_LIMIT, so 0.5 m is the longest move
+ *  commanded):
+ *    step  - the set point jumps to the target (LQR_Balance_SetPoint)
+ *    traj  - the trajectory generator moves the reference (TRAJ_Run),
+ *            without a plant model: the position alone is tracked
+ *    ff    - the same, with the rig model (LQR_Balance_Init), which adds
+ *            the reference feed-forward (LQR_ff_type)
+ *  Reports the peak pendulum angle and motor voltage of the move, and the
+ *  time the cart takes to settle within BENCH_TOL of the target, for one
+ *  distance or for each of BENCH_MOVES. The last of them is past the
+ *  command range: there the step overshoots into a track end, the
+ *  profiled moves do not.
+ *
+ *  Build (from repository root):
+ *      gcc -std=c99 -O2 -Ihost/sim -o traj_bench host/sim/traj_bench.c \
+ *          host/sim/sim_plant.c host/sim/sim_device.c \
+ *          lqr/lqr_balance.c lqr/lqr_utils.c lqr/lqr_rig_filt.c \
+ *          dsp/dsp_biquad.c dsp/dsp_fir.c dsp/dsp_filt.c \
+ *          traj/traj_gen.c ilc/ilc_ctrl.c sys/systime/systime.c -lm
+ *
+ *  Usage: traj_bench [distance [v_max a_max j_max]]
+ *      distance - move (m), default each of BENCH_MOVES
+ *      v_max, a_max, j_max - trajectory limits (TRAJ_lim_type), default
+ *               TRAJ_V_MAX, TRAJ_A_MAX, TRAJ_J_MAX
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "../../lqr/lqr.h"
+#include "../../traj/traj.h"
+#include "../../sys/systime/systime.h"
+#include "sim_plant.h"
+
+
+#define BENCH_DT        0.0001   /* control period (s); SysTick at 10 kHz */
+#define BENCH_T_REST    1.0      /* balance before the move (s) */
+#define BENCH_T_MOVE    5.0      /* move and settling window (s) */
+#define BENCH_MOVES     { 0.15, 0.25, 0.35, 0.5, 0.7 }  /* default moves (m) */
+#define BENCH_TOL       0.005    /* settled cart position error (m) */
+#define BENCH_TH_FALL   0.6      /* pendulum considered fallen beyond this angle (rad) */
+
+#define BENCH_STEP      0        /* set point step */
+#define BENCH_TRAJ      1        /* trajectory, no model */
+#define BENCH_FF        2        /* trajectory and feed-forward */
+
+
+static const char *bench_name[] = { "step", "traj", "ff" };
+
+static const double bench_moves[] = BENCH_MOVES;
+
+static const struct LQR_model_type bench_no_model = { { { 0 } }, { 0 } };
+
+
+/*
+ * Name: bench_move
+ *
+ * Descr: Runs one move
+ *
+ * Args:     plant - simulated plant
+ *           p     - plant parameters
+ *           rig   - plant model of the rig
+ *           mode  - BENCH_STEP, BENCH_TRAJ or BENCH_FF
+ *           d     - move (m)
+ *           th_pk - storage for the peak pendulum angle (rad)
+ *           v_pk  - storage for the peak motor voltage (V)
+ *           ts    - storage for the settling time (s), < 0 if the cart is
+ *                   not settled at the end of the window
+ *
+ * Return:   0, 1 if the pendulum fell, 2 if the cart hit a track end
+ *
+ * Notes: The set point is in the controller frame, the opposite of the
+ *        simulated cart position (see SIM_param_type); the encoders read
+ *        zero at the centre. The generator is left at rest on the target;
+ *        the next move starts it from there.
+ */
+static int bench_move( struct SIM_plant_type *plant, const struct SIM_param_type *p,
+                       const struct LQR_model_type *rig, int mode, double d,
+                       double *th_pk, double *v_pk, double *ts)
+{
+	long k, n = (long)(BENCH_T_REST/BENCH_DT + 0.5), n_move = (long)(BENCH_T_MOVE/BENCH_DT + 0.5);
+	double t0, t_out;
+
+	LQR_Balance_SetModel( ( mode == BENCH_FF) ? rig : &bench_no_model);
+
+	/* from rest at -d/2, the generator back on it */
+	SIM_Plant_Init( plant, p, 0, 0);
+	plant->x = plant->xm = d/2;
+	plant->qei_last[1] = SIM_Plant_QeiRaw( plant, 1);
+	TRAJ_SetTarget( (float)(-d/2));
+	for ( k = 0; k < n_move; k++)
+		TRAJ_Run();
+	LQR_Balance_SetPoint( (float)(-d/2));
+	LQR_Balance_Restart();
+	for ( k = 0; k < n; k++)
+	{
+		LQR_Balance_CtrlRun();
+		SIM_Plant_Step( plant, BENCH_DT);
+	}
+
+	if ( mode == BENCH_STEP)
+		LQR_Balance_SetPoint( (float)(d/2));
+	else
+		TRAJ_SetTarget( (float)(d/2));
+
+	*th_pk = *v_pk = 0;
+	t0 = t_out = plant->t;
+	for ( k = 0; k < n_move; k++)
+	{
+		if ( mode != BENCH_STEP)
+			TRAJ_Run();
+		LQR_Balance_CtrlRun();
+		SIM_Plant_Step( plant, BENCH_DT);
+
+		if ( fabs(plant->th) > BENCH_TH_FALL)
+			return 1;
+		if ( plant->collided)
+			return 2;
+		*th_pk = fmax( *th_pk, fabs(plant->th));
+		*v_pk = fmax( *v_pk, fabs(plant->volts));
+		if ( fabs( -plant->x - d/2) > BENCH_TOL)
+			t_out = plant->t;
+	}
+
+	*ts = ( plant->t - t_out < BENCH_DT) ? -1 : t_out - t0;
+
+	return 0;
+}
+
+
+int main( int argc, char **argv)
+{
+	const double *moves = bench_moves;
+	size_t n_moves = sizeof(bench_moves)/sizeof(bench_moves[0]), i;
+	double d;
+	struct TRAJ_lim_type lim = { TRAJ_V_MAX, TRAJ_A_MAX, TRAJ_J_MAX };
+	struct SIM_param_type p;
+	struct SIM_plant_type plant;
+	struct LQR_model_type rig;
+	double th_pk, v_pk, ts;
+	int mode, rv;
+
+	SIM_Plant_Defaults( &p);
+	SIM_Plant_Init( &plant, &p, 0, 0);
+	sim_plant = &plant;
+	(void) SYSTIME_Init();
+	LQR_Balance_Init();
+	rig = LQR_Balance_GetParams()->model;
+	if ( argc > 1)
+	{
+		d = atof(argv[1]);
+		moves = &d;
+		n_moves = 1;
+	}
+	if ( argc > 4)
+	{
+		lim.v_max = (float)atof(argv[2]);
+		lim.a_max = (float)atof(argv[3]);
+		lim.j_max = (float)atof(argv[4]);
+	}
+	if ( TRAJ_SetLimits( &lim))
+	{
+		fprintf( stderr, "invalid limits\n");
+		return 1;
+	}
+
+	printf("limits %g m/s, %g m/s^2, %g m/s^3; settled within %g m\n",
+	       lim.v_max, lim.a_max, lim.j_max, BENCH_TOL);
+	printf("move (m), mode, peak angle (rad), peak voltage (V), settling time (s)\n");
+	for ( i = 0; i < n_moves; i++)
+		for ( mode = BENCH_STEP; mode <= BENCH_FF; mode++)
+		{
+			rv = bench_move( &plant, &p, &rig, mode, moves[i], &th_pk, &v_pk, &ts);
+			if ( rv)
+				printf("%g, %s: %s\n", moves[i], bench_name[mode], ( rv == 1) ? "fell" : "track end");
+			else if ( ts < 0)
+				printf("%g, %s, %.4f, %.2f, -\n", moves[i], bench_name[mode], th_pk, v_pk);
+			else
+				printf("%g, %s, %.4f, %.2f, %.3f\n", moves[i], bench_name[mode], th_pk, v_pk, ts);
+		}
+
+	return 0;
+}
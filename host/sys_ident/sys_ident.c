@@ -0,0 +1,640 @@
+/*
+ * sys_ident.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Milos Lazic
+ *
+ *  Host tool identifying the linearized cart-pole and motor model from a
+ *  recorded trace, in one streaming pass, and printing the plant matrices
+ *  for LQR synthesis (state { x, x', th, th' }, input motor voltage) in
+ *  the encoder frames the controller uses (lqr_balance.c).
+ *
+ *  Trace: CSV lines "t,u,x,xdot,th,thdot" - time (s), motor input, cart
+ *  position (m), cart velocity (m/s), pendulum angle (rad) and angular
+ *  velocity (rad/s), angle measured from the equilibrium of the run (-e).
+ *  Lines that do not parse are skipped. A telem_rec table directory is
+ *  read in place instead; -c names its six columns. The input is scaled
+ *  to volts by -k (e.g. 0.12 for power in %).
+ *
+ *  Model (linearized about the equilibrium; s = +1 upright, -1 hanging):
+ *      (M+m)*x'' + s*m*l*th'' = kv*u - kb*x'
+ *      J*th'' + s*m*l*x''     = s*m*g*l*th - bth*th'
+ *  fitted as two regressions, each linear in its parameters:
+ *      x''  = a1*u + a2*x' + a3*(-s*th'') + a0
+ *      th'' = b1*(-s*x'') + b2*(s*th) + b3*th' + b0
+ *  a1 = kv/(M+m), a2 = -kb/(M+m), a3 = m*l/(M+m), b1 = m*l/J,
+ *  b2 = m*g*l/J, b3 = -bth/J; a0, b0 absorb offsets. The parameters do
+ *  not depend on s, so a run about the hanging (stable, safe) position
+ *  gives the upright model.
+ *
+ *  Derivatives come from a state variable filter: every signal passes
+ *  through F(s) = wf^3/(s + wf)^3, whose internal states are F*y, s*F*y
+ *  and s^2*F*y; both sides of each regression are filtered alike, so the
+ *  fit needs no numerical differentiation of noisy data. The recorded
+ *  velocities only serve as a consistency check on units and signs
+ *  (reported slope against the filtered position derivative).
+ *
+ *  Confidence: normal equations are accumulated per batch of -B seconds;
+ *  the spread of the batch estimates gives the 95 % intervals (the
+ *  classical least squares bound is far too optimistic for oversampled,
+ *  filtered data). Keep the swings small (warning beyond SI_TH_LIN RMS):
+ *  large angles bias the linear fit.
+ *
+ *  Build (from repository root):
+ *      gcc -std=c99 -O2 -o sys_ident host/sys_ident/sys_ident.c -lm
+ *
+ *  Usage: sys_ident [-e up|down] [-k scale] [-w wf] [-B batch] [-T ts]
+ *                   [-c t,u,x,xdot,th,thdot] trace.csv|tabledir
+ *      wf - filter bandwidth (rad/s), default SI_WF
+ *      ts - sample time of the discrete model (s), default SI_TS
+ */
+
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "../common/host_model.h"
+
+
+#define SI_WF        40.0     /* filter bandwidth (rad/s) */
+#define SI_TS        0.0001   /* discrete model sample time (s); 10 kHz */
+#define SI_BATCH     5.0      /* confidence batch length (s) */
+#define SI_NP        4        /* parameters per regression */
+#define SI_NS        HM_NS    /* model states */
+#define SI_SETTLE    6.0      /* filter settling (filter time constants) */
+#define SI_GAP       0.01     /* time gap restarting the filters (s) */
+#define SI_BATCH_MIN 4        /* batches needed for intervals */
+#define SI_T95       2.0      /* ~95 % two-sided factor */
+#define SI_TH_LIN    0.2      /* RMS angle beyond which sin(th) ~ th fails (rad) */
+#define SI_TBL_MAGIC 0x3158444952544C54ull   /* telem_rec index.bin */
+#define SI_TBL_HDR   64
+
+
+/* Name: si_ls_type
+ *
+ * Description: least squares accumulator (normal equations)
+ *
+ * Members: A  - Phi'Phi
+ *          b  - Phi'y
+ *          yy - y'y
+ *          n  - samples
+ *
+ * Notes:
+ *
+ */
+struct si_ls_type
+{
+	double A[SI_NP][SI_NP];
+	double b[SI_NP];
+	double yy;
+	unsigned long n;
+};
+
+
+/* Name: si_svf_type
+ *
+ * Description: state variable filter of one signal
+ *
+ * Members: z - F*y, s*F*y, s^2*F*y
+ *
+ * Notes:
+ *
+ */
+struct si_svf_type
+{
+	double z[3];
+};
+
+
+/* one batch: cart and pendulum regressions */
+struct si_batch_type
+{
+	struct si_ls_type ls[2];
+};
+
+
+enum { SI_T = 0, SI_U, SI_X, SI_XD, SI_TH, SI_THD, SI_NCOL };
+
+
+static const char *si_par_names[2][SI_NP] =
+{
+	{ "a1 (u)", "a2 (x')", "a3 (th'')", "a0" },
+	{ "b1 (x'')", "b2 (th)", "b3 (th')", "b0" },
+};
+
+
+/* run state */
+static struct
+{
+	double wf, k, sgn, batch_len, ts;
+	struct si_svf_type f[SI_NCOL];
+	double t_last, t_valid, t_batch;
+	int started;
+	struct si_batch_type *batch;
+	size_t n_batch, cap_batch;
+	struct si_ls_type total[2];
+	double vchk[2][2];   /* velocity check: sum F*v*sF*x, sum (sF*x)^2 */
+	double th2;          /* sum th^2 */
+	unsigned long n_in, n_used;
+} si;
+
+
+/*
+ * Name: si_solve
+ *
+ * Descr: Solves a SI_NP x SI_NP linear system by Gaussian elimination
+ *        with partial pivoting
+ *
+ * Args:     A - system matrix (destroyed)
+ *           b - right-hand side, replaced by the solution
+ *
+ * Return:   0 on success, -1 if A is singular
+ *
+ * Notes:
+ *
+ */
+static int si_solve( double A[SI_NP][SI_NP], double b[SI_NP])
+{
+	int i, j, k, p;
+	double t;
+
+	for ( k = 0; k < SI_NP; k++)
+	{
+		p = k;
+		for ( i = k + 1; i < SI_NP; i++)
+			if ( fabs(A[i][k]) > fabs(A[p][k]))
+				p = i;
+		if ( fabs(A[p][k]) < 1e-300)
+			return -1;
+		for ( j = 0; j < SI_NP; j++)
+		{
+			t = A[k][j]; A[k][j] = A[p][j]; A[p][j] = t;
+		}
+		t = b[k]; b[k] = b[p]; b[p] = t;
+
+		for ( i = k + 1; i < SI_NP; i++)
+		{
+			t = A[i][k]/A[k][k];
+			for ( j = k; j < SI_NP; j++)
+				A[i][j] -= t*A[k][j];
+			b[i] -= t*b[k];
+		}
+	}
+
+	for ( k = SI_NP - 1; k >= 0; k--)
+	{
+		for ( j = k + 1; j < SI_NP; j++)
+			b[k] -= A[k][j]*b[j];
+		b[k] /= A[k][k];
+	}
+
+	return 0;
+}
+
+
+static void si_ls_add( struct si_ls_type *ls, const double phi[SI_NP], double y)
+{
+	int j, k;
+
+	for ( j = 0; j < SI_NP; j++)
+	{
+		for ( k = j; k < SI_NP; k++)
+			ls->A[j][k] += phi[j]*phi[k];
+		ls->b[j] += phi[j]*y;
+	}
+	ls->yy += y*y;
+	ls->n++;
+}
+
+
+/*
+ * Name: si_ls_fit
+ *
+ * Descr: Solves an accumulator
+ *
+ * Args:     ls    - accumulator
+ *           theta - storage for the parameters
+ *           r2    - storage for the coefficient of determination (may be
+ *                   NULL)
+ *
+ * Return:   0 on success, -1 if the regressors are not excited
+ *
+ * Notes: R^2 is taken against zero mean (the filtered accelerations
+ *        average out)
+ *
+ */
+static int si_ls_fit( const struct si_ls_type *ls, double theta[SI_NP], double *r2)
+{
+	double A[SI_NP][SI_NP], rss;
+	int j, k;
+
+	for ( j = 0; j < SI_NP; j++)
+	{
+		for ( k = 0; k < SI_NP; k++)
+			A[j][k] = ( k >= j) ? ls->A[j][k] : ls->A[k][j];
+		theta[j] = ls->b[j];
+	}
+	if ( ls->n < 10*SI_NP || si_solve( A, theta))
+		return -1;
+
+	if ( r2)
+	{
+		for ( j = 0, rss = ls->yy; j < SI_NP; j++)
+			rss -= theta[j]*ls->b[j];
+		*r2 = ( ls->yy > 0) ? 1.0 - rss/ls->yy : 0;
+	}
+
+	return 0;
+}
+
+
+static void si_ls_merge( struct si_ls_type *dst, const struct si_ls_type *src)
+{
+	int j, k;
+
+	for ( j = 0; j < SI_NP; j++)
+	{
+		for ( k = 0; k < SI_NP; k++)
+			dst->A[j][k] += src->A[j][k];
+		dst->b[j] += src->b[j];
+	}
+	dst->yy += src->yy;
+	dst->n += src->n;
+}
+
+
+/*
+ * Name: si_svf_step
+ *
+ * Descr: Advances a state variable filter over dt with the input held
+ *
+ * Args:     f  - filter
+ *           y  - input
+ *           dt - step (s)
+ *
+ * Return:   none
+ *
+ * Notes: midpoint rule, sub-stepped so that wf*h <= 0.05
+ *
+ */
+static void si_svf_step( struct si_svf_type *f, double y, double dt)
+{
+	double w = si.wf, h, m[3];
+	int n = (int)ceil(dt*w/0.05), i;
+
+	if ( n < 1)
+		n = 1;
+	h = dt/n;
+
+	for ( i = 0; i < n; i++)
+	{
+		m[0] = f->z[0] + 0.5*h*f->z[1];
+		m[1] = f->z[1] + 0.5*h*f->z[2];
+		m[2] = f->z[2] + 0.5*h*(w*w*w*(y - f->z[0]) - 3*w*w*f->z[1] - 3*w*f->z[2]);
+		f->z[0] += h*m[1];
+		f->z[1] += h*m[2];
+		f->z[2] += h*(w*w*w*(y - m[0]) - 3*w*w*m[1] - 3*w*m[2]);
+	}
+}
+
+
+/*
+ * Name: si_sample
+ *
+ * Descr: Consumes one trace sample
+ *
+ * Args:     v - t, u, x, xdot, th, thdot
+ *
+ * Return:   none
+ *
+ * Notes: a time gap or step back restarts the filters; samples within
+ *        SI_SETTLE filter time constants of a restart are not fitted
+ *
+ */
+static void si_sample( const double v[SI_NCOL])
+{
+	double dt = v[SI_T] - si.t_last, phi[SI_NP], in;
+	struct si_ls_type *ls;
+	const double *x, *th;
+	int c;
+
+	si.n_in++;
+
+	if ( !si.started || dt <= 0 || dt > SI_GAP)
+	{
+		for ( c = SI_U; c < SI_NCOL; c++)
+		{
+			memset( &si.f[c], 0, sizeof(si.f[c]));
+			si.f[c].z[0] = ( c == SI_U) ? si.k*v[c] : v[c];
+		}
+		si.t_last = v[SI_T];
+		si.t_valid = v[SI_T] + SI_SETTLE/si.wf;
+		if ( !si.started)
+			si.t_batch = si.t_valid;
+		si.started = 1;
+		return;
+	}
+
+	for ( c = SI_U; c < SI_NCOL; c++)
+	{
+		in = ( c == SI_U) ? si.k*v[c] : v[c];
+		si_svf_step( &si.f[c], in, dt);
+	}
+	si.t_last = v[SI_T];
+
+	if ( v[SI_T] < si.t_valid)
+		return;
+
+	if ( si.n_batch == 0 || v[SI_T] >= si.t_batch + si.batch_len)
+	{
+		if ( si.n_batch == si.cap_batch)
+		{
+			si.cap_batch = si.cap_batch ? 2*si.cap_batch : 64;
+			si.batch = realloc( si.batch, si.cap_batch*sizeof(*si.batch));
+			if ( si.batch == NULL)
+			{
+				fprintf( stderr, "out of memory\n");
+				exit( 1);
+			}
+		}
+		memset( &si.batch[si.n_batch++], 0, sizeof(*si.batch));
+		si.t_batch = v[SI_T];
+	}
+	ls = si.batch[si.n_batch - 1].ls;
+
+	x = si.f[SI_X].z;
+	th = si.f[SI_TH].z;
+
+	/* cart: x'' = a1*u + a2*x' + a3*(-s*th'') + a0 */
+	phi[0] = si.f[SI_U].z[0];
+	phi[1] = x[1];
+	phi[2] = -si.sgn*th[2];
+	phi[3] = 1.0;
+	si_ls_add( &ls[0], phi, x[2]);
+
+	/* pendulum: th'' = b1*(-s*x'') + b2*(s*th) + b3*th' + b0 */
+	phi[0] = -si.sgn*x[2];
+	phi[1] = si.sgn*th[0];
+	phi[2] = th[1];
+	phi[3] = 1.0;
+	si_ls_add( &ls[1], phi, th[2]);
+
+	si.vchk[0][0] += si.f[SI_XD].z[0]*x[1];
+	si.vchk[0][1] += x[1]*x[1];
+	si.vchk[1][0] += si.f[SI_THD].z[0]*th[1];
+	si.vchk[1][1] += th[1]*th[1];
+	si.th2 += v[SI_TH]*v[SI_TH];
+	si.n_used++;
+}
+
+
+static int si_read_csv( const char *path)
+{
+	FILE *f = strcmp( path, "-") ? fopen( path, "r") : stdin;
+	char line[512], *s, *e;
+	double v[SI_NCOL];
+	int c;
+
+	if ( f == NULL)
+	{
+		perror( path);
+		return -1;
+	}
+
+	while ( fgets( line, sizeof(line), f))
+	{
+		for ( c = 0, s = line; c < SI_NCOL; c++, s = e + 1)
+		{
+			v[c] = strtod( s, &e);
+			if ( e == s || ( c < SI_NCOL - 1 && *e != ','))
+				break;
+		}
+		if ( c == SI_NCOL)
+			si_sample( v);
+	}
+
+	if ( f != stdin)
+		fclose( f);
+
+	return 0;
+}
+
+
+/* telem_rec table: columns mapped in place */
+static int si_read_table( const char *dir, char *names)
+{
+	char path[512], *name[SI_NCOL];
+	const double *col[SI_NCOL];
+	double v[SI_NCOL];
+	uint64_t hdr[3], r;
+	struct stat st;
+	int fd, c;
+
+	for ( c = 0; c < SI_NCOL; c++)
+	{
+		name[c] = strtok( c ? NULL : names, ",");
+		if ( name[c] == NULL)
+		{
+			fprintf( stderr, "-c needs %d column names\n", SI_NCOL);
+			return -1;
+		}
+	}
+
+	snprintf( path, sizeof(path), "%s/index.bin", dir);
+	if ( (fd = open( path, O_RDONLY)) < 0 || pread( fd, hdr, sizeof(hdr), 0) != sizeof(hdr) ||
+	     hdr[0] != SI_TBL_MAGIC)
+	{
+		fprintf( stderr, "%s: not a telem_rec table\n", dir);
+		return -1;
+	}
+	close( fd);
+	if ( hdr[1] == 0)
+		return 0;
+
+	for ( c = 0; c < SI_NCOL; c++)
+	{
+		snprintf( path, sizeof(path), "%s/%s.f64", dir, name[c]);
+		if ( (fd = open( path, O_RDONLY)) < 0 || fstat( fd, &st) ||
+		     (uint64_t)st.st_size < 8*hdr[1] ||
+		     (col[c] = mmap( NULL, 8*hdr[1], PROT_READ, MAP_SHARED, fd, 0)) == MAP_FAILED)
+		{
+			fprintf( stderr, "%s: missing or short\n", path);
+			return -1;
+		}
+		close( fd);
+	}
+
+	for ( r = 0; r < hdr[1]; r++)
+	{
+		for ( c = 0; c < SI_NCOL; c++)
+			v[c] = col[c][r];
+		si_sample( v);
+	}
+
+	return 0;
+}
+
+
+static void si_print_model( const char *an, double A[SI_NS][SI_NS], const char *bn, double B[SI_NS])
+{
+	int i, j;
+
+	printf( "%s = [", an);
+	for ( i = 0; i < SI_NS; i++)
+	{
+		for ( j = 0; j < SI_NS; j++)
+			printf( "%s%.6g", j ? " " : "", A[i][j]);
+		printf( "%s", ( i < SI_NS - 1) ? "; " : "];\n");
+	}
+	printf( "%s = [", bn);
+	for ( i = 0; i < SI_NS; i++)
+		printf( "%.6g%s", B[i], ( i < SI_NS - 1) ? "; " : "];\n");
+}
+
+
+int main( int argc, char **argv)
+{
+	char names[128] = "t,u,x,xdot,th,thdot";
+	double th[2][SI_NP], r2[2], mean[2][SI_NP] = {{ 0 }}, var[2][SI_NP] = {{ 0 }};
+	double A[SI_NS][SI_NS] = {{ 0 }}, B[SI_NS] = { 0 }, Ad[SI_NS][SI_NS], Bd[SI_NS];
+	double det, bt[SI_NP];
+	struct stat st;
+	size_t i, n_ok = 0;
+	int opt, e, j, rv;
+
+	si.wf = SI_WF;
+	si.k = 1.0;
+	si.sgn = -1.0;
+	si.batch_len = SI_BATCH;
+	si.ts = SI_TS;
+
+	while ( (opt = getopt( argc, argv, "e:k:w:B:T:c:")) != -1)
+	{
+		switch ( opt)
+		{
+		case 'e': si.sgn = ( strcmp( optarg, "up") == 0) ? 1.0 : -1.0; break;
+		case 'k': si.k = atof( optarg); break;
+		case 'w': si.wf = atof( optarg); break;
+		case 'B': si.batch_len = atof( optarg); break;
+		case 'T': si.ts = atof( optarg); break;
+		case 'c': snprintf( names, sizeof(names), "%s", optarg); break;
+		default: goto usage;
+		}
+	}
+	if ( argc - optind != 1 || si.wf <= 0 || si.batch_len <= 0 || si.ts <= 0)
+		goto usage;
+
+	if ( stat( argv[optind], &st) == 0 && S_ISDIR(st.st_mode))
+		rv = si_read_table( argv[optind], names);
+	else
+		rv = si_read_csv( argv[optind]);
+	if ( rv)
+		return 1;
+
+	for ( i = 0; i < si.n_batch; i++)
+		for ( e = 0; e < 2; e++)
+			si_ls_merge( &si.total[e], &si.batch[i].ls[e]);
+
+	for ( e = 0; e < 2; e++)
+	{
+		if ( si_ls_fit( &si.total[e], th[e], &r2[e]))
+		{
+			fprintf( stderr, "%s regression is singular; the trace does not excite the model\n",
+			         e ? "pendulum" : "cart");
+			return 1;
+		}
+	}
+
+	/* batch spread; batches with unexcited regressors are skipped */
+	for ( i = 0; i < si.n_batch; i++)
+	{
+		double b2[2][SI_NP];
+
+		if ( si_ls_fit( &si.batch[i].ls[0], b2[0], NULL) || si_ls_fit( &si.batch[i].ls[1], b2[1], NULL))
+			continue;
+		for ( e = 0; e < 2; e++)
+			for ( j = 0; j < SI_NP; j++)
+			{
+				mean[e][j] += b2[e][j];
+				var[e][j] += b2[e][j]*b2[e][j];
+			}
+		n_ok++;
+	}
+
+	printf( "# %lu samples, %lu fitted in %zu batches of %.1f s (%zu usable); wf %.1f rad/s, %s\n",
+	        si.n_in, si.n_used, si.n_batch, si.batch_len, n_ok, si.wf,
+	        ( si.sgn > 0) ? "upright" : "hanging");
+	for ( e = 0; e < 2; e++)
+	{
+		printf( "# %s fit: R^2 %.4f\n", e ? "pendulum" : "cart", r2[e]);
+		for ( j = 0; j < SI_NP; j++)
+		{
+			if ( n_ok >= SI_BATCH_MIN)
+			{
+				double m = mean[e][j]/n_ok;
+				double sd = sqrt( fmax( 0, var[e][j]/n_ok - m*m)*n_ok/(n_ok - 1));
+				double ci = SI_T95*sd/sqrt( (double)n_ok);
+
+				printf( "#   %-10s %12.6g +/- %-10.3g (%.1f %%)\n", si_par_names[e][j], th[e][j], ci,
+				        ( th[e][j] != 0) ? 100.0*ci/fabs(th[e][j]) : 0.0);
+			}
+			else
+			{
+				printf( "#   %-10s %12.6g (fewer than %d batches; no interval)\n",
+				        si_par_names[e][j], th[e][j], SI_BATCH_MIN);
+			}
+		}
+	}
+	if ( si.n_used && sqrt( si.th2/si.n_used) > SI_TH_LIN)
+		printf( "# warning: RMS angle %.2f rad; the linear model is biased, excite less\n",
+		        sqrt( si.th2/si.n_used));
+	for ( e = 0; e < 2; e++)
+		printf( "# %s velocity column / position derivative: slope %.4f\n",
+		        e ? "pendulum" : "cart",
+		        ( si.vchk[e][1] > 0) ? si.vchk[e][0]/si.vchk[e][1] : 0.0);
+
+	/* upright model: [1 a3; b1 1]*[x''; th''] = [a1*u + a2*x'; b2*th + b3*th'] */
+	det = 1.0 - th[0][2]*th[1][0];
+	if ( fabs(det) < 1e-6)
+	{
+		fprintf( stderr, "identified coupling is degenerate (1 - a3*b1 = %g)\n", det);
+		return 1;
+	}
+	bt[0] = th[0][0];
+	bt[1] = th[0][1];
+	bt[2] = th[1][1];
+	bt[3] = th[1][2];
+
+	A[0][1] = 1.0;
+	A[1][1] = bt[1]/det;
+	A[1][2] = -th[0][2]*bt[2]/det;
+	A[1][3] = -th[0][2]*bt[3]/det;
+	A[2][3] = 1.0;
+	A[3][1] = -th[1][0]*bt[1]/det;
+	A[3][2] = bt[2]/det;
+	A[3][3] = bt[3]/det;
+	B[1] = bt[0]/det;
+	B[3] = -th[1][0]*bt[0]/det;
+
+	printf( "# upright model, state [x; x'; th; th'] (m, m/s, rad, rad/s), input V\n");
+	si_print_model( "A", A, "B", B);
+	hm_expm_zoh( SI_NS, &A[0][0], B, si.ts, &Ad[0][0], Bd);
+	printf( "# zero order hold, Ts = %g s\n", si.ts);
+	si_print_model( "Ad", Ad, "Bd", Bd);
+
+	free( si.batch);
+
+	return 0;
+
+usage:
+	fprintf( stderr, "usage: %s [-e up|down] [-k scale] [-w wf] [-B batch] [-T ts]\n"
+	         "       [-c t,u,x,xdot,th,thdot] trace.csv|tabledir\n", argv[0]);
+	return 2;
+}
@@ -0,0 +1,996 @@
+/*
+ * telem_rec.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Milos Lazic
+ *
+ *  Host telemetry recorder: reads the UART0 stream (serial port, pty or a
+ *  file standing in for one), decodes records as they arrive and appends
+ *  them to memory-mapped column files, so that long recordings open at
+ *  once and can be sliced without parsing text again.
+ *
+ *  Records:
+ *      text  - lines of comma separated numbers, e.g. the __DEBUG__ build
+ *              "%u, %.4f, %.4f, %.4f, %.4f;" (a trailing ';' and CR are
+ *              ignored); the first line fixes the number of columns,
+ *              named c0, c1, ... unless -c gives names
+ *      stats - eCMD_ID_STATS replies (cmd/cmd_defs.h)
+ *      bbox  - black box dumps (eCMD_ID_BBOX frames): one record per
+ *              sample, t_trig_us (trigger time of the dump, us), sample,
+ *              x, th (encoder counts), u (motor power, Q15)
+ *      bbev  - the event records of the black box dumps: t_trig_us,
+ *              sample, type (LOG_ev_type), arg
+ *      scope - scope captures (eCMD_ID_SCOPE frames): one record per
+ *              sample, t_trig_us, t (s, relative to the trigger sample)
+ *              and one column per scope channel (LOG_sc_chan_type), NaN
+ *              where the capture did not record the channel
+ *  Image frames are reassembled by offset as they arrive, in order from
+ *  offset 0, and decoded once the image is complete (decoders shared with
+ *  host/bbox_decode and host/scope_decode); a gap drops the image. Other
+ *  frames and bytes that are neither are counted and skipped.
+ *
+ *  Output: one directory per record type under the output directory:
+ *      schema.txt  - column names, one per line
+ *      <name>.f64  - one column, native double per record
+ *      index.bin   - TR_IDX_HDR byte header (magic, committed record
+ *                    count, column count), then per record: double host
+ *                    receive time (s, Unix epoch), uint64 input byte
+ *                    offset of the record
+ *  Files grow in steps of TR_GROW records and are trimmed to the record
+ *  count on exit. A record is committed by the header count, which is
+ *  updated after its columns are written, so a reader never sees a
+ *  partial record. An existing table with the same columns is appended
+ *  to.
+ *
+ *  Build (from repository root):
+ *      gcc -std=c99 -O2 -o telem_rec host/telem_rec/telem_rec.c
+ *
+ *  Usage:
+ *      telem_rec [-b baud] [-c name,name,...] input outdir
+ *          input - serial port (set to raw 8N1 at baud, default
+ *                  TR_BAUD), pty, file or "-" for stdin; runs until end
+ *                  of input or SIGINT
+ *      telem_rec cat tabledir [first [count]]
+ *          prints records as CSV straight from the mapped files
+ *
+ *  MATLAB: n = rows from index.bin; x = memmapfile('text/c1.f64',
+ *  'Format', 'double'); x.Data(1:n).
+ */
+
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#include <signal.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <termios.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "../../cmd/cmd_defs.h"
+#include "../bbox_decode/bbox_image.h"
+#include "../scope_decode/scope_image.h"
+
+
+#define TR_BAUD       115200
+#define TR_MAX_COL    32
+#define TR_NAME_LEN   32
+#define TR_LINE_MAX   512
+#define TR_GROW       65536          /* records added per file extension */
+#define TR_IDX_MAGIC  0x3158444952544C54ull  /* "TLTRIDX1" */
+#define TR_IDX_HDR    64
+#define TR_STATS_LEN  (1 + 2 + 4*4 + 4 + 8 + 2*4 + 3*4)  /* eCMD_ID_STATS body */
+#define TR_STATS_COL  13
+#define TR_BBOX_COL   5
+#define TR_BBEV_COL   4
+#define TR_SCOPE_COL  (2 + eLOG_SC_CH_MAX)
+#define TR_IMG_IDLE   UINT32_MAX     /* tr_image_type.next: no image being received */
+
+
+/* Name: tr_table_type
+ *
+ * Description: one output table (record type)
+ *
+ * Members: dir   - table directory
+ *          n_col - number of columns
+ *          name  - column names
+ *          fd    - column files
+ *          col   - mapped columns
+ *          idx_fd, idx - mapped index file (header, then 2 words per record)
+ *          rows  - committed records
+ *          cap   - records the files can hold
+ *
+ * Notes:
+ *
+ */
+struct tr_table_type
+{
+	char dir[256];
+	int n_col;
+	char name[TR_MAX_COL][TR_NAME_LEN];
+	int fd[TR_MAX_COL];
+	double *col[TR_MAX_COL];
+	int idx_fd;
+	uint64_t *idx;
+	uint64_t rows;
+	uint64_t cap;
+};
+
+
+/* Name: tr_parse_type
+ *
+ * Description: incremental input parser
+ *
+ * Members: ofs   - input bytes consumed
+ *          line  - text line being received
+ *          n     - bytes in line
+ *          frame - binary frame being received (LEN, body, CRC)
+ *          f_n   - bytes in frame; 0 outside a frame
+ *          rec_ofs - input offset of the record being received
+ *
+ * Notes:
+ *
+ */
+struct tr_parse_type
+{
+	uint64_t ofs;
+	char line[TR_LINE_MAX];
+	size_t n;
+	uint8_t frame[1 + 255 + 1];
+	size_t f_n;
+	uint64_t rec_ofs;
+};
+
+
+/* Name: tr_image_type
+ *
+ * Description: chunked image (black box dump, scope capture) being
+ *              reassembled
+ *
+ * Members: buf  - image bytes
+ *          max  - size of buf
+ *          next - image offset of the next chunk expected; TR_IMG_IDLE
+ *                 until a chunk at offset 0 starts an image
+ *          ofs  - input offset of the first chunk
+ *
+ * Notes:
+ *
+ */
+struct tr_image_type
+{
+	uint8_t *buf;
+	uint32_t max;
+	uint32_t next;
+	uint64_t ofs;
+};
+
+
+static volatile sig_atomic_t tr_stop = 0;
+
+static const char *tr_stats_names[] =
+{
+	"state", "ctrl", "rx_frames", "rx_errors", "q_drops", "warn_count", "sp", "t_us",
+	"evt_ticks", "evt_updates", "ilc_trials", "ilc_e_rms", "ilc_refused",
+};
+
+static const char *tr_bbox_names[] = { "t_trig_us", "sample", "x", "th", "u" };
+static const char *tr_bbev_names[] = { "t_trig_us", "sample", "type", "arg" };
+
+static struct
+{
+	uint64_t text, stats, bbox, scope, frames, bad;
+} tr_count;
+
+
+static void tr_on_signal( int sig)
+{
+	(void)sig;
+	tr_stop = 1;
+}
+
+
+static double tr_now( void)
+{
+	struct timespec ts;
+
+	clock_gettime( CLOCK_REALTIME, &ts);
+	return (double)ts.tv_sec + 1e-9*(double)ts.tv_nsec;
+}
+
+
+static uint8_t tr_crc8( uint8_t crc, const uint8_t *buf, size_t len)
+{
+	uint32_t bit;
+
+	while ( len--)
+	{
+		crc ^= *buf++;
+		for ( bit = 0; bit < 8; bit++)
+			crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+	}
+
+	return crc;
+}
+
+
+static uint32_t tr_u32( const uint8_t *p)
+{
+	return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+
+/*
+ * Name: tr_map
+ *
+ * Descr: Sizes a table file for cap records and maps it
+ *
+ * Args:     fd    - file
+ *           old   - current mapping (NULL if none)
+ *           o_len - length of the current mapping
+ *           len   - new length
+ *
+ * Return:   new mapping, NULL on failure
+ *
+ * Notes:
+ *
+ */
+static void *tr_map( int fd, void *old, size_t o_len, size_t len)
+{
+	void *p;
+
+	if ( old)
+		munmap( old, o_len);
+	if ( ftruncate( fd, (off_t)len))
+		return NULL;
+	p = mmap( NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+	return ( p == MAP_FAILED) ? NULL : p;
+}
+
+
+static size_t tr_idx_len( uint64_t cap)
+{
+	return TR_IDX_HDR + 16*cap;
+}
+
+
+static int tr_grow( struct tr_table_type *t, uint64_t cap)
+{
+	int c;
+
+	for ( c = 0; c < t->n_col; c++)
+		if ( (t->col[c] = tr_map( t->fd[c], t->col[c], 8*t->cap, 8*cap)) == NULL)
+			return -1;
+	if ( (t->idx = tr_map( t->idx_fd, t->idx, tr_idx_len( t->cap), tr_idx_len( cap))) == NULL)
+		return -1;
+	t->cap = cap;
+
+	return 0;
+}
+
+
+/*
+ * Name: tr_open
+ *
+ * Descr: Creates a table, or reopens an existing one with the same columns
+ *        for appending
+ *
+ * Args:     t     - table
+ *           dir   - table directory
+ *           n_col - number of columns
+ *           names - column names
+ *
+ * Return:   0 on success, -1 on failure (reported)
+ *
+ * Notes:
+ *
+ */
+static int tr_open( struct tr_table_type *t, const char *dir, int n_col, char names[][TR_NAME_LEN])
+{
+	char path[512], line[TR_NAME_LEN + 2];
+	FILE *f;
+	struct stat st;
+	int c, exists;
+	uint64_t hdr[3];
+
+	memset( t, 0, sizeof(*t));
+	snprintf( t->dir, sizeof(t->dir), "%s", dir);
+	t->n_col = n_col;
+	memcpy( t->name, names, n_col*TR_NAME_LEN);
+
+	if ( mkdir( dir, 0777) && errno != EEXIST)
+	{
+		perror( dir);
+		return -1;
+	}
+
+	snprintf( path, sizeof(path), "%s/index.bin", dir);
+	exists = ( stat( path, &st) == 0 && st.st_size >= TR_IDX_HDR);
+	if ( (t->idx_fd = open( path, O_RDWR | O_CREAT, 0666)) < 0)
+	{
+		perror( path);
+		return -1;
+	}
+
+	if ( exists)
+	{
+		if ( pread( t->idx_fd, hdr, sizeof(hdr), 0) != sizeof(hdr) ||
+		     hdr[0] != TR_IDX_MAGIC || hdr[2] != (uint64_t)n_col)
+		{
+			fprintf( stderr, "%s: existing table has other columns\n", dir);
+			return -1;
+		}
+		snprintf( path, sizeof(path), "%s/schema.txt", dir);
+		if ( (f = fopen( path, "r")) == NULL)
+		{
+			perror( path);
+			return -1;
+		}
+		for ( c = 0; c < n_col; c++)
+		{
+			if ( fgets( line, sizeof(line), f) == NULL)
+				break;
+			line[strcspn( line, "\r\n")] = '\0';
+			if ( strcmp( line, names[c]))
+				break;
+		}
+		fclose( f);
+		if ( c != n_col)
+		{
+			fprintf( stderr, "%s: existing table has other columns\n", dir);
+			return -1;
+		}
+		t->rows = hdr[1];
+	}
+	else
+	{
+		snprintf( path, sizeof(path), "%s/schema.txt", dir);
+		if ( (f = fopen( path, "w")) == NULL)
+		{
+			perror( path);
+			return -1;
+		}
+		for ( c = 0; c < n_col; c++)
+			fprintf( f, "%s\n", names[c]);
+		fclose( f);
+	}
+
+	for ( c = 0; c < n_col; c++)
+	{
+		snprintf( path, sizeof(path), "%s/%s.f64", dir, names[c]);
+		if ( (t->fd[c] = open( path, O_RDWR | O_CREAT, 0666)) < 0)
+		{
+			perror( path);
+			return -1;
+		}
+	}
+
+	if ( tr_grow( t, t->rows + TR_GROW))
+	{
+		perror( dir);
+		return -1;
+	}
+	t->idx[0] = TR_IDX_MAGIC;
+	t->idx[1] = t->rows;
+	t->idx[2] = (uint64_t)n_col;
+
+	return 0;
+}
+
+
+/*
+ * Name: tr_append
+ *
+ * Descr: Appends one record
+ *
+ * Args:     t   - table
+ *           v   - column values
+ *           ofs - input byte offset of the record
+ *
+ * Return:   0 on success, -1 if the files cannot grow
+ *
+ * Notes: the record count is published last
+ *
+ */
+static int tr_append( struct tr_table_type *t, const double *v, uint64_t ofs)
+{
+	uint64_t r = t->rows;
+	double now = tr_now();
+	int c;
+
+	if ( r == t->cap && tr_grow( t, t->cap + TR_GROW))
+		return -1;
+
+	for ( c = 0; c < t->n_col; c++)
+		t->col[c][r] = v[c];
+	memcpy( &t->idx[TR_IDX_HDR/8 + 2*r], &now, 8);
+	t->idx[TR_IDX_HDR/8 + 2*r + 1] = ofs;
+
+	__sync_synchronize();
+	t->rows = r + 1;
+	t->idx[1] = t->rows;
+
+	return 0;
+}
+
+
+/* trims the files to the committed records */
+static void tr_close( struct tr_table_type *t)
+{
+	int c;
+
+	if ( t->n_col == 0)
+		return;
+
+	for ( c = 0; c < t->n_col; c++)
+	{
+		munmap( t->col[c], 8*t->cap);
+		if ( ftruncate( t->fd[c], (off_t)(8*t->rows)))
+			perror( t->name[c]);
+		close( t->fd[c]);
+	}
+	munmap( t->idx, tr_idx_len( t->cap));
+	if ( ftruncate( t->idx_fd, (off_t)tr_idx_len( t->rows)))
+		perror( t->dir);
+	close( t->idx_fd);
+	t->n_col = 0;
+}
+
+
+static struct tr_table_type tr_text, tr_stats, tr_bbox, tr_bbev, tr_scope;
+static uint8_t tr_bbox_buf[BD_IMAGE_MAX], tr_scope_buf[SD_IMAGE_MAX];
+static struct tr_image_type tr_bbox_img = { tr_bbox_buf, BD_IMAGE_MAX, TR_IMG_IDLE, 0 };
+static struct tr_image_type tr_scope_img = { tr_scope_buf, SD_IMAGE_MAX, TR_IMG_IDLE, 0 };
+static char tr_out[256];
+static char tr_text_names[TR_MAX_COL][TR_NAME_LEN];
+static int tr_text_named = 0;
+
+
+/* opens table sub of the output directory on first use */
+static void tr_use( struct tr_table_type *t, const char *sub, int n_col, const char **names)
+{
+	char dir[512], cols[TR_MAX_COL][TR_NAME_LEN];
+	int c;
+
+	if ( t->n_col)
+		return;
+
+	for ( c = 0; c < n_col; c++)
+		snprintf( cols[c], TR_NAME_LEN, "%s", names[c]);
+	snprintf( dir, sizeof(dir), "%s/%s", tr_out, sub);
+	if ( tr_open( t, dir, n_col, cols))
+		exit( 1);
+}
+
+
+/* appends a record to a table in use; a table that cannot grow ends the
+ * recording */
+static void tr_put( struct tr_table_type *t, const double *v, uint64_t ofs)
+{
+	if ( tr_append( t, v, ofs))
+	{
+		perror( t->dir);
+		exit( 1);
+	}
+}
+
+
+static void tr_text_line( struct tr_parse_type *p)
+{
+	double v[TR_MAX_COL];
+	char *s = p->line, *end;
+	char dir[512];
+	int n = 0, c;
+
+	p->line[p->n] = '\0';
+	p->line[strcspn( p->line, ";\r")] = '\0';
+
+	while ( *s)
+	{
+		if ( n == TR_MAX_COL)
+			goto bad;
+		v[n] = strtod( s, &end);
+		if ( end == s)
+			goto bad;
+		n++;
+		s = end + strspn( end, " \t");
+		if ( *s == ',')
+			s++;
+		else if ( *s)
+			goto bad;
+	}
+	if ( n == 0)
+		return;
+
+	if ( tr_text.n_col == 0)
+	{
+		if ( !tr_text_named)
+			for ( c = 0; c < n; c++)
+				snprintf( tr_text_names[c], TR_NAME_LEN, "c%d", c);
+		snprintf( dir, sizeof(dir), "%s/text", tr_out);
+		if ( tr_open( &tr_text, dir, n, tr_text_names))
+			exit( 1);
+	}
+	if ( n != tr_text.n_col)
+		goto bad;
+
+	if ( tr_append( &tr_text, v, p->rec_ofs))
+	{
+		perror( tr_text.dir);
+		exit( 1);
+	}
+	tr_count.text++;
+	return;
+
+bad:
+	tr_count.bad++;
+}
+
+
+static void tr_stats_frame( struct tr_parse_type *p)
+{
+	const uint8_t *b = &p->frame[1];
+	double v[TR_STATS_COL];
+	uint32_t u;
+	float sp, e_rms;
+
+	tr_use( &tr_stats, "stats", TR_STATS_COL, tr_stats_names);
+
+	v[0] = b[1];
+	v[1] = b[2];
+	v[2] = tr_u32( &b[3]);
+	v[3] = tr_u32( &b[7]);
+	v[4] = tr_u32( &b[11]);
+	v[5] = tr_u32( &b[15]);
+	u = tr_u32( &b[19]);
+	memcpy( &sp, &u, sizeof(sp));
+	v[6] = sp;
+	v[7] = (double)tr_u32( &b[23]) + 4294967296.0*(double)tr_u32( &b[27]);
+	v[8] = tr_u32( &b[31]);
+	v[9] = tr_u32( &b[35]);
+	v[10] = tr_u32( &b[39]);
+	u = tr_u32( &b[43]);
+	memcpy( &e_rms, &u, sizeof(e_rms));
+	v[11] = e_rms;
+	v[12] = tr_u32( &b[47]);
+
+	tr_put( &tr_stats, v, p->rec_ofs);
+	tr_count.stats++;
+}
+
+
+/*
+ * Name: tr_chunk
+ *
+ * Descr: Adds an image chunk frame (uint32 image offset, image bytes) to
+ *        the image being reassembled
+ *
+ * Args:     im  - image
+ *           p   - parser state holding the frame
+ *
+ * Return:   0 if the chunk was added, -1 if it was dropped
+ *
+ * Notes: an image starts at offset 0 and must arrive in order; a chunk
+ *        out of order drops the image until the next offset 0
+ *
+ */
+static int tr_chunk( struct tr_image_type *im, const struct tr_parse_type *p)
+{
+	const uint8_t *b = &p->frame[1];
+	uint32_t n = p->frame[0], ofs;
+
+	if ( n < 1 + 4)
+		return -1;
+	n -= 1 + 4;
+	ofs = tr_u32( &b[1]);
+
+	if ( ofs == 0)
+	{
+		im->next = 0;
+		im->ofs = p->rec_ofs;
+	}
+	if ( ofs != im->next || n > im->max - ofs)
+	{
+		if ( im->next != TR_IMG_IDLE)
+			tr_count.bad++;
+		im->next = TR_IMG_IDLE;
+		return -1;
+	}
+
+	memcpy( &im->buf[ofs], &b[5], n);
+	im->next += n;
+
+	return 0;
+}
+
+
+/* black box sample sink (bd_page); ctx is the trigger time of the dump */
+static void tr_bbox_sample( void *ctx, uint32_t t, int32_t x, int32_t th, int32_t u)
+{
+	double v[TR_BBOX_COL] = { *(const double *)ctx, t, x, th, u };
+
+	tr_put( &tr_bbox, v, tr_bbox_img.ofs);
+}
+
+
+/* decodes a black box dump once its last chunk is in */
+static void tr_bbox_frame( struct tr_parse_type *p)
+{
+	struct tr_image_type *im = &tr_bbox_img;
+	struct bd_hdr_type hdr;
+	double v[TR_BBEV_COL], t_trig;
+	const uint8_t *ev;
+	uint32_t i;
+
+	if ( tr_chunk( im, p) || im->next < LOG_BB_HDR_SIZE)
+		return;
+	if ( bd_header( im->buf, im->next, &hdr))
+	{
+		tr_count.bad++;
+		im->next = TR_IMG_IDLE;
+		return;
+	}
+	if ( im->next < hdr.size)
+		return;
+
+	tr_use( &tr_bbox, "bbox", TR_BBOX_COL, tr_bbox_names);
+	tr_use( &tr_bbev, "bbev", TR_BBEV_COL, tr_bbev_names);
+
+	t_trig = (double)hdr.t_us;
+	for ( i = 0; i < hdr.n_ev; i++)
+	{
+		ev = bd_event( im->buf, i);
+		v[0] = t_trig;
+		v[1] = bd_u32( ev);
+		v[2] = ev[4];
+		v[3] = ev[5];
+		tr_put( &tr_bbev, v, im->ofs);
+	}
+	for ( i = 0; i < hdr.n_pg; i++)
+		if ( bd_page( bd_page_ptr( im->buf, &hdr, i), hdr.pg_size, hdr.samples,
+		              tr_bbox_sample, &t_trig) < 0)
+			tr_count.bad++;
+
+	tr_count.bbox++;
+	im->next = TR_IMG_IDLE;
+}
+
+
+/* decodes a scope capture once its last chunk is in */
+static void tr_scope_frame( struct tr_parse_type *p)
+{
+	struct tr_image_type *im = &tr_scope_img;
+	struct sd_hdr_type hdr;
+	double v[TR_SCOPE_COL];
+	const char *names[TR_SCOPE_COL] = { "t_trig_us", "t" };
+	uint32_t i, ch, k;
+
+	if ( tr_chunk( im, p) || im->next < LOG_SC_HDR_SIZE)
+		return;
+	if ( sd_header( im->buf, im->next, &hdr))
+	{
+		tr_count.bad++;
+		im->next = TR_IMG_IDLE;
+		return;
+	}
+	if ( im->next < hdr.size)
+		return;
+
+	for ( ch = 0; ch < eLOG_SC_CH_MAX; ch++)
+		names[2 + ch] = sd_chan_name[ch];
+	tr_use( &tr_scope, "scope", TR_SCOPE_COL, names);
+
+	for ( i = 0; i < hdr.depth; i++)
+	{
+		v[0] = (double)hdr.t_us;
+		v[1] = sd_time( &hdr, i);
+		for ( ch = 0, k = 0; ch < eLOG_SC_CH_MAX; ch++)
+			v[2 + ch] = ( hdr.mask & (1u << ch)) ? sd_sample( im->buf, &hdr, i, k++) : NAN;
+		tr_put( &tr_scope, v, im->ofs);
+	}
+
+	tr_count.scope++;
+	im->next = TR_IMG_IDLE;
+}
+
+
+static void tr_frame( struct tr_parse_type *p)
+{
+	const uint8_t *b = &p->frame[1];
+
+	if ( b[0] == eCMD_ID_STATS && p->frame[0] == TR_STATS_LEN)
+		tr_stats_frame( p);
+	else if ( b[0] == eCMD_ID_BBOX)
+		tr_bbox_frame( p);
+	else if ( b[0] == eCMD_ID_SCOPE)
+		tr_scope_frame( p);
+	else
+		tr_count.frames++;
+}
+
+
+/*
+ * Name: tr_feed
+ *
+ * Descr: Parses a chunk of input; records are written as they complete
+ *
+ * Args:     p   - parser state (carries partial records across chunks)
+ *           buf - input bytes
+ *           len - number of bytes
+ *
+ * Return:   none
+ *
+ * Notes: CMD_FRAME_SOF never occurs in text, so it starts a binary frame
+ *        (LEN, body, CRC) anywhere; a frame failing its CRC is counted
+ *        and dropped.
+ *
+ */
+static void tr_feed( struct tr_parse_type *p, const uint8_t *buf, size_t len)
+{
+	size_t i;
+	uint8_t d;
+
+	for ( i = 0; i < len; i++, p->ofs++)
+	{
+		d = buf[i];
+
+		if ( p->f_n)
+		{
+			/* frame[0] = LEN; complete after LEN body bytes and CRC */
+			if ( p->f_n == 1 && d == 0)
+			{
+				p->f_n = 0;
+				tr_count.bad++;
+				continue;
+			}
+			p->frame[p->f_n - 1] = d;
+			if ( ++p->f_n < (size_t)p->frame[0] + 3)
+				continue;
+			p->f_n = 0;
+			if ( tr_crc8( 0, p->frame, p->frame[0] + 1) != p->frame[p->frame[0] + 1])
+				tr_count.bad++;
+			else
+				tr_frame( p);
+			continue;
+		}
+
+		if ( d == CMD_FRAME_SOF)
+		{
+			p->n = 0;
+			p->f_n = 1;
+			p->rec_ofs = p->ofs;
+			continue;
+		}
+
+		if ( d == '\n')
+		{
+			if ( p->n < TR_LINE_MAX)
+				tr_text_line( p);
+			else
+				tr_count.bad++;
+			p->n = 0;
+			continue;
+		}
+
+		if ( p->n == 0)
+			p->rec_ofs = p->ofs;
+		if ( p->n < TR_LINE_MAX - 1)
+			p->line[p->n] = (char)d;
+		if ( p->n < TR_LINE_MAX)
+			p->n++;
+	}
+}
+
+
+static speed_t tr_speed( long baud)
+{
+	switch ( baud)
+	{
+	case 9600:    return B9600;
+	case 19200:   return B19200;
+	case 38400:   return B38400;
+	case 57600:   return B57600;
+	case 115200:  return B115200;
+	case 230400:  return B230400;
+	default:      return B0;
+	}
+}
+
+
+/* raw 8N1 at baud; plain files and pipes are left alone */
+static int tr_serial( int fd, long baud)
+{
+	struct termios tio;
+	speed_t sp = tr_speed( baud);
+
+	if ( !isatty( fd))
+		return 0;
+	if ( sp == B0 || tcgetattr( fd, &tio))
+		return -1;
+
+	tio.c_iflag &= ~(IGNBRK | BRKINT | PARMRK | ISTRIP | INLCR | IGNCR | ICRNL | IXON);
+	tio.c_oflag &= ~OPOST;
+	tio.c_lflag &= ~(ECHO | ECHONL | ICANON | ISIG | IEXTEN);
+	tio.c_cflag &= ~(CSIZE | PARENB | CSTOPB | CRTSCTS);
+	tio.c_cflag |= CS8 | CREAD | CLOCAL;
+	tio.c_cc[VMIN] = 1;
+	tio.c_cc[VTIME] = 0;
+	cfsetispeed( &tio, sp);
+	cfsetospeed( &tio, sp);
+
+	return tcsetattr( fd, TCSANOW, &tio);
+}
+
+
+/*
+ * Name: tr_cat
+ *
+ * Descr: Prints records of a table as CSV from the mapped files
+ *
+ * Args:     dir   - table directory
+ *           first - first record
+ *           count - number of records (clamped to the table)
+ *
+ * Return:   0 on success, 1 on failure
+ *
+ * Notes: only the requested rows are touched; the column files are not
+ *        read as a whole
+ *
+ */
+static int tr_cat( const char *dir, uint64_t first, uint64_t count)
+{
+	char path[512], names[TR_MAX_COL][TR_NAME_LEN];
+	const double *col[TR_MAX_COL];
+	uint64_t hdr[3], r;
+	struct stat st;
+	FILE *f;
+	int fd, c, n_col;
+
+	snprintf( path, sizeof(path), "%s/index.bin", dir);
+	if ( (fd = open( path, O_RDONLY)) < 0 || pread( fd, hdr, sizeof(hdr), 0) != sizeof(hdr) ||
+	     hdr[0] != TR_IDX_MAGIC || hdr[2] > TR_MAX_COL)
+	{
+		fprintf( stderr, "%s: not a table\n", dir);
+		return 1;
+	}
+	close( fd);
+	n_col = (int)hdr[2];
+
+	snprintf( path, sizeof(path), "%s/schema.txt", dir);
+	if ( (f = fopen( path, "r")) == NULL)
+	{
+		perror( path);
+		return 1;
+	}
+	for ( c = 0; c < n_col && fgets( names[c], TR_NAME_LEN, f); c++)
+		names[c][strcspn( names[c], "\r\n")] = '\0';
+	fclose( f);
+	if ( c != n_col)
+	{
+		fprintf( stderr, "%s: schema does not match index\n", dir);
+		return 1;
+	}
+
+	if ( first > hdr[1])
+		first = hdr[1];
+	if ( count > hdr[1] - first)
+		count = hdr[1] - first;
+
+	for ( c = 0; c < n_col; c++)
+	{
+		snprintf( path, sizeof(path), "%s/%s.f64", dir, names[c]);
+		if ( (fd = open( path, O_RDONLY)) < 0 || fstat( fd, &st) ||
+		     (uint64_t)st.st_size < 8*hdr[1])
+		{
+			fprintf( stderr, "%s: missing or short\n", path);
+			return 1;
+		}
+		col[c] = ( hdr[1] == 0) ? NULL : mmap( NULL, 8*hdr[1], PROT_READ, MAP_SHARED, fd, 0);
+		close( fd);
+		if ( col[c] == MAP_FAILED)
+		{
+			perror( path);
+			return 1;
+		}
+	}
+
+	printf( "row");
+	for ( c = 0; c < n_col; c++)
+		printf( ",%s", names[c]);
+	printf( "\n");
+	for ( r = first; r < first + count; r++)
+	{
+		printf( "%llu", (unsigned long long)r);
+		for ( c = 0; c < n_col; c++)
+			printf( ",%.10g", col[c][r]);
+		printf( "\n");
+	}
+
+	return 0;
+}
+
+
+int main( int argc, char **argv)
+{
+	static struct tr_parse_type parse;
+	uint8_t buf[4096];
+	long baud = TR_BAUD;
+	ssize_t n;
+	char *s;
+	int fd, opt;
+
+	if ( argc >= 3 && strcmp( argv[1], "cat") == 0)
+		return tr_cat( argv[2], ( argc > 3) ? strtoull( argv[3], NULL, 0) : 0,
+		               ( argc > 4) ? strtoull( argv[4], NULL, 0) : UINT64_MAX);
+
+	while ( (opt = getopt( argc, argv, "b:c:")) != -1)
+	{
+		switch ( opt)
+		{
+		case 'b':
+			baud = strtol( optarg, NULL, 0);
+			break;
+
+		case 'c':
+			for ( s = strtok( optarg, ","); s && tr_text_named < TR_MAX_COL; s = strtok( NULL, ","))
+				snprintf( tr_text_names[tr_text_named++], TR_NAME_LEN, "%s", s);
+			break;
+
+		default:
+			goto usage;
+		}
+	}
+	if ( argc - optind != 2)
+		goto usage;
+
+	fd = strcmp( argv[optind], "-") ? open( argv[optind], O_RDONLY | O_NOCTTY) : 0;
+	if ( fd < 0 || tr_serial( fd, baud))
+	{
+		fprintf( stderr, "%s: cannot open as raw %ld baud input\n", argv[optind], baud);
+		return 1;
+	}
+	snprintf( tr_out, sizeof(tr_out), "%s", argv[optind + 1]);
+	if ( mkdir( tr_out, 0777) && errno != EEXIST)
+	{
+		perror( tr_out);
+		return 1;
+	}
+
+	signal( SIGINT, tr_on_signal);
+	signal( SIGTERM, tr_on_signal);
+
+	while ( !tr_stop)
+	{
+		n = read( fd, buf, sizeof(buf));
+		if ( n < 0 && errno == EINTR)
+			continue;
+		if ( n <= 0)
+			break;   /* end of file; EIO once a pty writer closes */
+		tr_feed( &parse, buf, (size_t)n);
+	}
+
+	tr_close( &tr_text);
+	tr_close( &tr_stats);
+	tr_close( &tr_bbox);
+	tr_close( &tr_bbev);
+	tr_close( &tr_scope);
+
+	fprintf( stderr, "%llu bytes: %llu text records, %llu stats records, "
+	         "%llu black box dumps, %llu scope captures, %llu other frames, %llu rejected\n",
+	         (unsigned long long)parse.ofs, (unsigned long long)tr_count.text,
+	         (unsigned long long)tr_count.stats, (unsigned long long)tr_count.bbox,
+	         (unsigned long long)tr_count.scope, (unsigned long long)tr_count.frames,
+	         (unsigned long long)tr_count.bad);
+
+	return 0;
+
+usage:
+	fprintf( stderr, "usage: %s [-b baud] [-c name,...] input outdir\n"
+	         "       %s cat tabledir [first [count]]\n", argv[0], argv[0]);
+	return 2;
+}
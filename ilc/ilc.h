@@ -0,0 +1,16 @@
+/*
+ * ilc.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Milos Lazic
+ */
+
+#ifndef ILC_ILC_H_
+#define ILC_ILC_H_
+
+#include "ilc_defs.h"
+#include "ilc_proto.h"
+
+
+
+#endif /* ILC_ILC_H_ */
@@ -0,0 +1,283 @@
+/*
+ * ilc_ctrl.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Milos Lazic
+ *
+ *  Iterative learning control of repeated cart moves (see ilc_defs.h).
+ *  ILC_Start, ILC_Stop, ILC_Reset and ILC_Run run in the control period
+ *  (commands from CMD_Drain, ILC_Run from the trajectory generator);
+ *  ILC_Learn runs in the background loop.
+ */
+
+#include <math.h>
+#include "ilc.h"
+#include "../lqr/lqr.h"
+
+
+static struct ILC_type ilc =
+{
+		.state = eILC_IDLE,
+		.len = 0,
+		.k = 0,
+		.tick = 0,
+		.trials = 0,
+		.e_rms = 0,
+		.e = { 0 },
+		.c = { 0 },
+};
+
+
+/*
+ * Name: ILC_q16
+ *
+ * Descr: Converts to the int16 storage of error and correction, rounding
+ *        and saturating
+ *
+ * Args:     val - value (ILC_LSB)
+ *           lim - largest magnitude (ILC_LSB, <= INT16_MAX)
+ *
+ * Return:   stored value
+ *
+ * Notes:
+ *
+ */
+static int16_t ILC_q16( float val, float lim)
+{
+	if ( val > lim)
+		val = lim;
+	else if ( val < -lim)
+		val = -lim;
+
+	return (int16_t)( ( val >= 0) ? val + 0.5f : val - 0.5f);
+}
+
+
+/*
+ * Name: ILC_Start
+ *
+ * Descr: Starts a trial
+ *
+ * Args:     len - trial length (samples of ILC_DECIM control periods, 2
+ *                 to ILC_MAX_SAMPLES)
+ *
+ * Return:   0 on success, -1 if a trial is running or being learned
+ *           from, or len is out of range
+ *
+ * Notes: Control period context (CMD_Drain); the first sample is taken
+ *        in the same period, so the first target of the sequence belongs
+ *        in the same command burst. A length other than that of the
+ *        previous trials starts the learning over.
+ *
+ */
+int ILC_Start( uint32_t len)
+{
+	uint32_t i;
+
+	if ( ilc.state != eILC_IDLE || len < 2 || len > ILC_MAX_SAMPLES)
+		return -1;
+
+	if ( len != ilc.len)
+	{
+		for ( i = 0; i < ILC_MAX_SAMPLES; i++)
+			ilc.c[i] = 0;
+		ilc.len = len;
+		ilc.trials = 0;
+	}
+	ilc.k = 0;
+	ilc.tick = 0;
+	ilc.state = eILC_RUN;
+
+	return 0;
+}
+
+
+/*
+ * Name: ILC_Stop
+ *
+ * Descr: Abandons the running trial; the correction is kept, nothing is
+ *        learned from the partial trial
+ *
+ * Args:     none
+ *
+ * Return:   none
+ *
+ * Notes: Control period context; by command, and by the FSM whenever
+ *        balancing (re)starts.
+ *
+ */
+void ILC_Stop( void)
+{
+	if ( ilc.state == eILC_RUN)
+		ilc.state = eILC_IDLE;
+}
+
+
+/*
+ * Name: ILC_Reset
+ *
+ * Descr: Discards the learned correction
+ *
+ * Args:     none
+ *
+ * Return:   0 on success, -1 if a trial is running or being learned from
+ *
+ * Notes: Control period context
+ *
+ */
+int ILC_Reset( void)
+{
+	if ( ilc.state != eILC_IDLE)
+		return -1;
+
+	ilc.len = 0;
+	ilc.trials = 0;
+	ilc.e_rms = 0;
+
+	return 0;
+}
+
+
+/*
+ * Name: ILC_Run
+ *
+ * Descr: Records the position error and applies the correction to the
+ *        position reference of the control period
+ *
+ * Args:     ref - position reference (m)
+ *
+ * Return:   corrected position reference (m)
+ *
+ * Notes: Called by TRAJ_Run every balance control period; a pass-through
+ *        outside trials. The error is taken against the cart position of
+ *        the latest LQR period (LQR_Balance_GetPosition): trials run
+ *        under the LQR controllers only (the FSM stops them under the
+ *        fuzzy controller, cmd_proc.c refuses to start them). The
+ *        correction is interpolated linearly between samples.
+ *
+ */
+float ILC_Run( float ref)
+{
+	float c0, c1;
+	uint32_t k = ilc.k;
+
+	if ( ilc.state != eILC_RUN)
+		return ref;
+
+	if ( ilc.tick == 0)
+		ilc.e[k] = ILC_q16( ( ref - LQR_Balance_GetPosition())*(1.0f/ILC_LSB), (float)INT16_MAX);
+
+	c0 = ilc.c[k];
+	c1 = ( k + 1 < ilc.len) ? ilc.c[k + 1] : c0;
+	ref += ( c0 + ( c1 - c0)*(float)ilc.tick*(1.0f/ILC_DECIM))*ILC_LSB;
+
+	if ( ++ilc.tick == ILC_DECIM)
+	{
+		ilc.tick = 0;
+		if ( ++ilc.k == ilc.len)
+			ilc.state = eILC_LEARN;
+	}
+
+	return ref;
+}
+
+
+/*
+ * Name: ILC_Learn
+ *
+ * Descr: Updates the correction from the error of the completed trial
+ *
+ * Args:     none
+ *
+ * Return:   none
+ *
+ * Notes: Background context; returns at once unless a trial has just
+ *        completed. Takes a few ms for the longest trial, well within
+ *        the pass of the background loop, which the next trial must wait
+ *        for.
+ *
+ */
+void ILC_Learn( void)
+{
+	uint32_t len = ilc.len;
+	float sum = 0, y, w;
+	uint32_t i, j;
+
+	if ( ilc.state != eILC_LEARN)
+		return;
+
+	for ( i = 0; i < len; i++)
+		sum += (float)ilc.e[i]*(float)ilc.e[i];
+	ilc.e_rms = sqrtf( sum/(float)len)*ILC_LSB;
+
+	/* learning update, the error taken ILC_LEAD samples ahead */
+	for ( i = 0; i < len; i++)
+	{
+		j = ( i + ILC_LEAD < len) ? i + ILC_LEAD : len - 1;
+		ilc.c[i] = ILC_q16( (float)ilc.c[i] + ILC_GAIN*(float)ilc.e[j], ILC_C_LIM/ILC_LSB);
+	}
+
+	/* zero-phase Q filter */
+	y = ilc.c[0];
+	for ( i = 0; i < len; i++)
+	{
+		y += ILC_Q_ALPHA*( (float)ilc.c[i] - y);
+		ilc.c[i] = ILC_q16( y, ILC_C_LIM/ILC_LSB);
+	}
+	y = ilc.c[len - 1];
+	for ( i = len; i-- > 0; )
+	{
+		y += ILC_Q_ALPHA*( (float)ilc.c[i] - y);
+		ilc.c[i] = ILC_q16( y, ILC_C_LIM/ILC_LSB);
+	}
+
+	/* taper both ends */
+	for ( i = 0; i < ILC_TAPER && i < len; i++)
+	{
+		w = (float)i*(1.0f/ILC_TAPER);
+		ilc.c[i] = ILC_q16( (float)ilc.c[i]*w, ILC_C_LIM/ILC_LSB);
+		ilc.c[len - 1 - i] = ILC_q16( (float)ilc.c[len - 1 - i]*w, ILC_C_LIM/ILC_LSB);
+	}
+
+	ilc.trials++;
+	ilc.state = eILC_IDLE;
+}
+
+
+/*
+ * Name: ILC_GetState
+ *
+ * Descr: Reads the learning controller state
+ *
+ * Args:     none
+ *
+ * Return:   ILC_state_type
+ *
+ * Notes:
+ *
+ */
+uint32_t ILC_GetState( void)
+{
+	return ilc.state;
+}
+
+
+/*
+ * Name: ILC_GetStats
+ *
+ * Descr: Reads the learning progress
+ *
+ * Args:     trials - storage for the number of trials learned from
+ *           e_rms  - storage for the RMS position error of the latest
+ *                    completed trial (m)
+ *
+ * Return:   none
+ *
+ * Notes: Trial to trial, e_rms falls as the correction converges
+ *
+ */
+void ILC_GetStats( uint32_t *trials, float *e_rms)
+{
+	*trials = ilc.trials;
+	*e_rms = ilc.e_rms;
+}
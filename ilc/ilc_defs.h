@@ -0,0 +1,96 @@
+/*
+ * ilc_defs.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Milos Lazic
+ *
+ *  Iterative learning control of repeated cart moves (ilc_ctrl.c). A trial
+ *  is a fixed window of balance control periods, started by command, over
+ *  which the same sequence of set point targets is repeated. During a
+ *  trial the cart position error against the trajectory reference is
+ *  recorded, one sample per ILC_DECIM control periods, and the correction
+ *  learned from the previous trials is added to the position reference.
+ *  Between trials the background loop updates the correction:
+ *
+ *      c(i) <- Q[ c(i) + gain*e(i + lead) ]
+ *
+ *  lead compensates the lag of the balance loop (the cart first backs off
+ *  to tilt the pendulum), Q is a zero-phase low-pass (first order, run
+ *  forwards then backwards) that keeps the learning from building up
+ *  content the loop cannot follow. Both ends of the correction are
+ *  tapered to zero so that trials start and end on the plain reference.
+ *
+ *  The control period work is a table lookup and an interpolation; error
+ *  and correction are stored as int16 (ILC_LSB), 4 bytes per sample.
+ */
+
+#ifndef ILC_ILC_DEFS_H_
+#define ILC_ILC_DEFS_H_
+
+
+#include <stdlib.h>
+#include <stdint.h>
+
+
+#define ILC_MAX_SAMPLES 640      /* longest trial (samples) */
+#define ILC_DECIM      100       /* control periods per sample (10 ms) */
+#define ILC_LSB        1e-5f     /* error and correction resolution (m) */
+#define ILC_GAIN       0.8f      /* learning gain */
+#define ILC_LEAD       40        /* learning lead (samples) */
+#define ILC_Q_ALPHA    0.2f      /* Q filter, per sample (cut-off ~3.5 Hz each way) */
+#define ILC_C_LIM      0.2f      /* largest correction magnitude (m) */
+#define ILC_TAPER      20        /* correction taper at both trial ends (samples) */
+
+
+/* Name: ILC_state_type
+ *
+ * Description: learning controller states
+ *
+ * Members: eILC_IDLE  - no trial; the correction may be replaced
+ *          eILC_RUN   - trial running (control period)
+ *          eILC_LEARN - trial complete; the background loop updates the
+ *                       correction from the recorded error
+ *
+ * Notes:
+ *
+ */
+typedef enum
+{
+	eILC_IDLE = 0,
+	eILC_RUN,
+	eILC_LEARN,
+} ILC_state_type;
+
+
+/* Name: ILC_type
+ *
+ * Description: learning controller state
+ *
+ * Members: state  - ILC_state_type; RUN is entered and left by the
+ *                   control period, LEARN left by the background loop
+ *          len    - trial length (samples)
+ *          k      - sample of the running trial
+ *          tick   - control period within the sample
+ *          trials - completed trials (learned from)
+ *          e_rms  - RMS position error of the latest completed trial (m)
+ *          e      - recorded position error (ILC_LSB)
+ *          c      - position reference correction (ILC_LSB)
+ *
+ * Notes: e and c belong to the control period during RUN only, to the
+ *        background loop during LEARN only.
+ *
+ */
+struct ILC_type
+{
+	volatile uint32_t state;
+	uint32_t len;
+	uint32_t k;
+	uint32_t tick;
+	volatile uint32_t trials;
+	volatile float e_rms;
+	int16_t e[ILC_MAX_SAMPLES];
+	int16_t c[ILC_MAX_SAMPLES];
+};
+
+
+#endif /* ILC_ILC_DEFS_H_ */
@@ -0,0 +1,26 @@
+/*
+ * ilc_proto.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Milos Lazic
+ */
+
+#ifndef ILC_ILC_PROTO_H_
+#define ILC_ILC_PROTO_H_
+
+
+#include <stdint.h>
+#include "ilc_defs.h"
+
+
+/* global scope routines */
+extern int ILC_Start( uint32_t len);
+extern void ILC_Stop( void);
+extern int ILC_Reset( void);
+extern float ILC_Run( float ref);
+extern void ILC_Learn( void);
+extern uint32_t ILC_GetState( void);
+extern void ILC_GetStats( uint32_t *trials, float *e_rms);
+
+
+#endif /* ILC_ILC_PROTO_H_ */
@@ -0,0 +1,16 @@
+/*
+ * log.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Milos Lazic
+ */
+
+#ifndef LOG_LOG_H_
+#define LOG_LOG_H_
+
+#include "log_defs.h"
+#include "log_proto.h"
+
+
+
+#endif /* LOG_LOG_H_ */
@@ -0,0 +1,483 @@
+/*
+ * log_bbox.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Milos Lazic
+ *
+ *  Black box recorder: compressed history of the last few seconds of the
+ *  control loop, frozen on a fault and dumped over the serial command
+ *  channel (see log_defs.h for the format, CMD_BBoxFrame for the dump).
+ *
+ *  With LOG_BB_PAGES x LOG_BB_PAGE_SIZE = 10 KB the ring holds about 4.4 s
+ *  of balancing, 2.5 s of swing-up or 4.5 s of calibration at 10 kHz
+ *  (simulated); a raw 32-bit record of the same three channels would last
+ *  under 0.1 s.
+ */
+
+#include <string.h>
+#include "log.h"
+#include "../fsm/fsm.h"
+#include "../sys/device/device.h"
+#include "../sys/systime/systime.h"
+
+
+static struct LOG_bb_type bb = { .pages = 0 };
+
+
+/*
+ * Name: LOG_bb_page_open
+ *
+ * Descr: Starts a new page, overwriting the oldest one once the ring is
+ *        full
+ *
+ * Args:     t0 - sample index of the first block of the page
+ *
+ * Return:   none
+ *
+ * Notes: the page header holds the predictor history (bb.prev) so that
+ *        every page decodes on its own
+ *
+ */
+static void LOG_bb_page_open( uint32_t t0)
+{
+	uint8_t *pg;
+	uint32_t ch;
+
+	if ( bb.pages == 0)
+		bb.head = 0;
+	else
+		bb.head = ( bb.head + 1) % LOG_BB_PAGES;
+	if ( bb.pages < LOG_BB_PAGES)
+		bb.pages++;
+
+	pg = bb.page[bb.head];
+	LOG_put_u32( &pg[0], t0);
+	LOG_put_u16( &pg[4], 0);
+	LOG_put_u16( &pg[6], 0);
+	LOG_put_u32( &pg[8], (uint32_t)bb.prev[0]);
+	LOG_put_u32( &pg[12], (uint32_t)bb.prev[1]);
+	LOG_put_u32( &pg[16], (uint32_t)bb.prev[2]);
+	LOG_put_u32( &pg[20], (uint32_t)bb.prev[3]);
+
+	for ( ch = 0; ch < LOG_BB_CH; ch++)
+		LOG_rice_reset( &bb.rice[ch]);
+	LOG_bits_init( &bb.bits, &pg[LOG_BB_PAGE_HDR], 8*(LOG_BB_PAGE_SIZE - LOG_BB_PAGE_HDR));
+}
+
+
+static void LOG_bb_block_put( int32_t r[LOG_BB_CH][LOG_BB_BLK])
+{
+	uint32_t ch, i, nz;
+
+	for ( ch = 0; ch < LOG_BB_CH; ch++)
+	{
+		for ( i = 0, nz = 0; i < LOG_BB_BLK; i++)
+			nz |= (uint32_t)r[ch][i];
+
+		LOG_bits_put( &bb.bits, nz ? 1 : 0, 1);
+		if ( nz == 0)
+			continue;
+		for ( i = 0; i < LOG_BB_BLK; i++)
+			LOG_rice_put( &bb.bits, &bb.rice[ch], r[ch][i]);
+	}
+}
+
+
+/*
+ * Name: LOG_bb_block
+ *
+ * Descr: Codes the collected block of samples into the current page,
+ *        moving to a new page if it does not fit
+ *
+ * Args:     t0 - sample index of bb.blk[0]
+ *
+ * Return:   none
+ *
+ * Notes: a block that overflows is dropped from the page it started in
+ *        (the page header bit count still excludes it) and coded again
+ *        at the start of the next page
+ *
+ */
+static void LOG_bb_block( uint32_t t0)
+{
+	int32_t r[LOG_BB_CH][LOG_BB_BLK];
+	int32_t x1 = bb.prev[0], x2 = bb.prev[1], th1 = bb.prev[2], u1 = bb.prev[3];
+	uint32_t i;
+
+	/* residuals: x - (2*x[-1] - x[-2]), th - th[-1], u - u[-1] */
+	for ( i = 0; i < LOG_BB_BLK; i++)
+	{
+		r[0][i] = bb.blk[i][0] - 2*x1 + x2;
+		r[1][i] = bb.blk[i][1] - th1;
+		r[2][i] = bb.blk[i][2] - u1;
+		x2 = x1;
+		x1 = bb.blk[i][0];
+		th1 = bb.blk[i][1];
+		u1 = bb.blk[i][2];
+	}
+
+	if ( bb.pages == 0)
+		LOG_bb_page_open( t0);
+
+	LOG_bb_block_put( r);
+	if ( bb.bits.overflow)
+	{
+		LOG_bb_page_open( t0);
+		LOG_bb_block_put( r);
+	}
+	LOG_put_u16( &bb.page[bb.head][4], bb.bits.pos);
+
+	bb.prev[0] = x1;
+	bb.prev[1] = x2;
+	bb.prev[2] = th1;
+	bb.prev[3] = u1;
+	bb.blk_n = 0;
+}
+
+
+/*
+ * Name: LOG_bb_freeze
+ *
+ * Descr: Codes the partial block and stops recording
+ *
+ * Args:     none
+ *
+ * Return:   none
+ *
+ * Notes: the partial block is padded with predicted samples (all-zero
+ *        residuals); the sample count in the image header excludes them
+ *
+ */
+static void LOG_bb_freeze( void)
+{
+	uint32_t n = bb.blk_n, i;
+	int32_t x1, x2;
+
+	if ( n)
+	{
+		x1 = ( n > 1) ? bb.blk[n - 2][0] : bb.prev[0];
+		for ( i = n; i < LOG_BB_BLK; i++)
+		{
+			x2 = x1;
+			x1 = bb.blk[i - 1][0];
+			bb.blk[i][0] = 2*x1 - x2;
+			bb.blk[i][1] = bb.blk[i - 1][1];
+			bb.blk[i][2] = bb.blk[i - 1][2];
+		}
+		LOG_bb_block( bb.samples - n);
+	}
+
+	bb.frozen = 1;
+	bb.dump_req = 1;
+}
+
+
+/*
+ * Name: LOG_BB_Rearm
+ *
+ * Descr: Discards the recorded history and restarts recording
+ *
+ * Args:     none
+ *
+ * Return:   none
+ *
+ * Notes: Control period context (CMD_Drain). A dump in progress is
+ *        abandoned.
+ *
+ */
+void LOG_BB_Rearm( void)
+{
+	bb.dump_req = 0;
+	bb.pages = 0;
+	bb.blk_n = 0;
+	bb.samples = 0;
+	bb.ev_head = 0;
+	bb.cause = eLOG_BB_CAUSE_NONE;
+	bb.post = 0;
+	bb.frozen = 0;
+}
+
+
+/*
+ * Name: LOG_BB_Event
+ *
+ * Descr: Records an event against the current sample
+ *
+ * Args:     type - LOG_ev_type
+ *           arg  - event argument
+ *
+ * Return:   none
+ *
+ * Notes: control period context; ignored while frozen
+ *
+ */
+void LOG_BB_Event( uint32_t type, uint32_t arg)
+{
+	struct LOG_bb_ev_type *ev;
+
+	if ( bb.frozen)
+		return;
+
+	ev = &bb.ev[bb.ev_head & (LOG_BB_EVENTS - 1)];
+	ev->sample = bb.samples;
+	ev->type = (uint8_t)type;
+	ev->arg = (uint8_t)arg;
+	bb.ev_head++;
+}
+
+
+/*
+ * Name: LOG_BB_Trigger
+ *
+ * Descr: Starts the post-trigger countdown
+ *
+ * Args:     cause - LOG_bb_cause_type
+ *
+ * Return:   none
+ *
+ * Notes: Control period context. Only the first trigger after arming
+ *        counts. A manual trigger freezes at the next sample, faults
+ *        after another LOG_BB_POST samples.
+ *
+ */
+void LOG_BB_Trigger( uint32_t cause)
+{
+	if ( bb.frozen || bb.cause != eLOG_BB_CAUSE_NONE)
+		return;
+
+	LOG_BB_Event( eLOG_EV_FAULT, cause);
+	bb.cause = cause;
+	bb.trig = bb.samples;
+	bb.trig_us = SYSTIME_ToUs(SYSTIME_Now());
+	bb.post = ( cause == eLOG_BB_CAUSE_MANUAL) ? 0 : LOG_BB_POST;
+}
+
+
+/*
+ * Name: LOG_BB_Tick
+ *
+ * Descr: Records one sample of the control loop
+ *
+ * Args:     none
+ *
+ * Return:   none
+ *
+ * Notes: Called once per control period after FSM_Run, so that the
+ *        recorded power is the one about to be applied. Detects state
+ *        changes and the trigger conditions.
+ *
+ */
+void LOG_BB_Tick( void)
+{
+	int32_t x, th, u = 0;
+	uint32_t state;
+
+	if ( bb.frozen)
+		return;
+
+	x = (int32_t)dev_ioctl(eDEV_QEI1, eQEI_IOCTL_R_POS);
+	th = (int32_t)dev_ioctl(eDEV_QEI0, eQEI_IOCTL_R_POS);
+	(void) dev_ioctl(eDEV_ESC0, eESC_IOCTL_GET_POWER_Q15, &u);
+	u >>= LOG_BB_U_SHIFT;
+	state = (uint32_t)FSM_GetState();
+
+	if ( bb.samples == 0)
+	{
+		/* predictor starts from the first sample */
+		bb.prev[0] = bb.prev[1] = x;
+		bb.prev[2] = th;
+		bb.prev[3] = u;
+		bb.state = eFSM_STATE_MAX;
+	}
+
+	if ( state != bb.state)
+	{
+		LOG_BB_Event( eLOG_EV_STATE, state);
+		bb.state = state;
+		if ( state == eFSM_STATE_EMGBRAKE)
+			LOG_BB_Trigger( eLOG_BB_CAUSE_BRAKE);
+	}
+	else if ( state == eFSM_STATE_BALANCE && ( th > LOG_BB_TH_LIMIT || th < -LOG_BB_TH_LIMIT))
+	{
+		LOG_BB_Trigger( eLOG_BB_CAUSE_FALL);
+	}
+
+	bb.blk[bb.blk_n][0] = x;
+	bb.blk[bb.blk_n][1] = th;
+	bb.blk[bb.blk_n][2] = u;
+	bb.samples++;
+	if ( ++bb.blk_n == LOG_BB_BLK)
+		LOG_bb_block( bb.samples - LOG_BB_BLK);
+
+	if ( bb.cause != eLOG_BB_CAUSE_NONE)
+	{
+		if ( bb.post == 0)
+			LOG_bb_freeze();
+		else
+			bb.post--;
+	}
+}
+
+
+/*
+ * Name: LOG_BB_Frozen
+ *
+ * Descr: Tells whether recording has stopped
+ *
+ * Args:     none
+ *
+ * Return:   non-zero once frozen, until LOG_BB_Rearm
+ *
+ * Notes:
+ *
+ */
+uint32_t LOG_BB_Frozen( void)
+{
+	return bb.frozen;
+}
+
+
+/*
+ * Name: LOG_BB_RequestDump
+ *
+ * Descr: Requests a dump of the frozen image, freezing first if still
+ *        recording
+ *
+ * Args:     none
+ *
+ * Return:   none
+ *
+ * Notes: control period context
+ *
+ */
+void LOG_BB_RequestDump( void)
+{
+	if ( bb.frozen)
+		bb.dump_req = 1;
+	else
+		LOG_BB_Trigger( eLOG_BB_CAUSE_MANUAL);
+}
+
+
+/*
+ * Name: LOG_BB_DumpPending
+ *
+ * Descr: Tells whether a frozen image waits to be dumped
+ *
+ * Args:     none
+ *
+ * Return:   non-zero while a dump is requested
+ *
+ * Notes: background context; the image stays frozen after the dump
+ *        until LOG_BB_Rearm so that it can be requested again
+ *
+ */
+uint32_t LOG_BB_DumpPending( void)
+{
+	return bb.frozen && bb.dump_req;
+}
+
+
+void LOG_BB_DumpDone( void)
+{
+	bb.dump_req = 0;
+}
+
+
+/*
+ * Name: LOG_BB_ImageSize
+ *
+ * Descr: Size of the dump image
+ *
+ * Args:     none
+ *
+ * Return:   image size in bytes, 0 if not frozen
+ *
+ * Notes:
+ *
+ */
+uint32_t LOG_BB_ImageSize( void)
+{
+	uint32_t n_ev = ( bb.ev_head < LOG_BB_EVENTS) ? bb.ev_head : LOG_BB_EVENTS;
+
+	if ( !bb.frozen)
+		return 0;
+
+	return LOG_BB_HDR_SIZE + n_ev*LOG_BB_EV_SIZE + bb.pages*LOG_BB_PAGE_SIZE;
+}
+
+
+/*
+ * Name: LOG_BB_ImageRead
+ *
+ * Descr: Copies part of the dump image (header, events oldest first,
+ *        pages oldest first; see log_defs.h)
+ *
+ * Args:     ofs - image offset
+ *           buf - destination
+ *           len - bytes requested
+ *
+ * Return:   bytes copied; 0 at the end of the image or if not frozen
+ *
+ * Notes: background context
+ *
+ */
+size_t LOG_BB_ImageRead( uint32_t ofs, uint8_t *buf, size_t len)
+{
+	uint8_t tmp[LOG_BB_HDR_SIZE];
+	uint32_t n_ev = ( bb.ev_head < LOG_BB_EVENTS) ? bb.ev_head : LOG_BB_EVENTS;
+	uint32_t ev_end = LOG_BB_HDR_SIZE + n_ev*LOG_BB_EV_SIZE;
+	uint32_t size = LOG_BB_ImageSize();
+	uint32_t i, n, pg;
+	const uint8_t *src;
+	const struct LOG_bb_ev_type *ev;
+	size_t done = 0;
+
+	while ( done < len && ofs < size)
+	{
+		if ( ofs < LOG_BB_HDR_SIZE)
+		{
+			LOG_put_u32( &tmp[0], LOG_BB_MAGIC);
+			tmp[4] = LOG_BB_VERSION;
+			tmp[5] = (uint8_t)bb.cause;
+			LOG_put_u16( &tmp[6], n_ev);
+			LOG_put_u16( &tmp[8], bb.pages);
+			LOG_put_u16( &tmp[10], LOG_BB_PAGE_SIZE);
+			LOG_put_u32( &tmp[12], bb.samples);
+			LOG_put_u32( &tmp[16], bb.trig);
+			LOG_put_u32( &tmp[20], (uint32_t)bb.trig_us);
+			LOG_put_u32( &tmp[24], (uint32_t)(bb.trig_us >> 32));
+			src = &tmp[ofs];
+			n = LOG_BB_HDR_SIZE - ofs;
+		}
+		else if ( ofs < ev_end)
+		{
+			i = ( ofs - LOG_BB_HDR_SIZE)/LOG_BB_EV_SIZE;
+			ev = &bb.ev[(bb.ev_head - n_ev + i) & (LOG_BB_EVENTS - 1)];
+			LOG_put_u32( &tmp[0], ev->sample);
+			tmp[4] = ev->type;
+			tmp[5] = ev->arg;
+			LOG_put_u16( &tmp[6], 0);
+			i = ( ofs - LOG_BB_HDR_SIZE) % LOG_BB_EV_SIZE;
+			src = &tmp[i];
+			n = LOG_BB_EV_SIZE - i;
+		}
+		else
+		{
+			i = ( ofs - ev_end)/LOG_BB_PAGE_SIZE;
+			/* oldest page follows head once the ring has wrapped */
+			pg = ( bb.pages < LOG_BB_PAGES) ? i : ( bb.head + 1 + i) % LOG_BB_PAGES;
+			i = ( ofs - ev_end) % LOG_BB_PAGE_SIZE;
+			src = &bb.page[pg][i];
+			n = LOG_BB_PAGE_SIZE - i;
+		}
+
+		if ( n > len - done)
+			n = len - done;
+		memcpy( &buf[done], src, n);
+		done += n;
+		ofs += n;
+	}
+
+	return done;
+}
@@ -0,0 +1,404 @@
+/*
+ * log_defs.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Milos Lazic
+ *
+ *  Black box recorder (log_bbox.c): every control period the cart and
+ *  pendulum encoder counts and the motor power are compressed into a
+ *  ring of LOG_BB_PAGES pages; events (state changes, commands, fault)
+ *  go to a separate ring. A fault freezes the recorder LOG_BB_POST
+ *  control periods later, and the frozen image is dumped over UART.
+ *
+ *  Sample channels and predictors:
+ *
+ *      x  - QEI1 position (counts), second difference
+ *      th - QEI0 position (counts), first difference
+ *      u  - motor power (Q15 >> LOG_BB_U_SHIFT), first difference
+ *
+ *  The QEI velocities are not recorded; they are the position change
+ *  over the QEI velocity timer period and are recomputed offline.
+ *
+ *  Samples are coded in blocks of LOG_BB_BLK control periods. For each
+ *  channel in turn a block holds one flag bit (0: all residuals zero)
+ *  followed, if set, by LOG_BB_BLK Rice codes of the zigzag-mapped
+ *  residuals. A Rice code of value v with parameter k is (v >> k) one
+ *  bits, a zero bit and the k low bits of v; a run of LOG_RICE_QMAX
+ *  ones is followed by v in 32 bits instead. k adapts per channel to
+ *  the running mean of v (LOG_rice_k). Bits are packed LSB first.
+ *
+ *  Dump image (little-endian; see LOG_BB_ImageRead):
+ *
+ *      header  - LOG_BB_HDR_SIZE bytes:
+ *                u32 magic (LOG_BB_MAGIC), u8 version, u8 cause
+ *                (LOG_bb_cause_type), u16 events, u16 pages, u16 page
+ *                size, u32 samples recorded, u32 trigger sample,
+ *                u64 trigger time (us, SYSTIME_ToUs)
+ *      events  - oldest first, LOG_BB_EV_SIZE bytes each:
+ *                u32 sample, u8 type (LOG_ev_type), u8 arg, u16 zero
+ *      pages   - oldest first, page size bytes each:
+ *                u32 first sample, u16 coded bits, u16 zero,
+ *                i32 x[-1], i32 x[-2], i32 th[-1], i32 u[-1],
+ *                coded blocks (Rice state reset at each page)
+ *
+ *  Scope (log_scope.c): on request, selected channels are sampled every
+ *  control period (or every decim-th) into a RAM ring of LOG_SC_BUF
+ *  16-bit samples until a trigger condition has been met and the ring
+ *  holds the requested pre-trigger depth; the capture is then streamed
+ *  out by the background loop, frames back to back between ultrasonic
+ *  measurements (~10 KB/s at 115200 baud, an 8 KB capture in under 1 s).
+ *
+ *  Scope image (little-endian; see LOG_SC_ImageRead):
+ *
+ *      header  - LOG_SC_HDR_SIZE bytes:
+ *                u32 magic (LOG_SC_MAGIC), u8 version, u8 channel mask
+ *                (bit n: LOG_sc_chan_type n), u8 trigger source
+ *                (LOG_sc_trig_type), u8 channels, u16 samples, u16
+ *                trigger sample, u16 decimation, u16 zero, u64 trigger
+ *                time (us, SYSTIME_ToUs)
+ *      samples - oldest first; per sample one i16 per selected channel in
+ *                ascending channel order
+ */
+
+#ifndef LOG_LOG_DEFS_H_
+#define LOG_LOG_DEFS_H_
+
+
+#include <stdlib.h>
+#include <stdint.h>
+
+
+#define LOG_BB_PAGE_SIZE  512     /* bytes per page, header included */
+#define LOG_BB_PAGES      20      /* pages in the ring (10 KB) */
+#define LOG_BB_PAGE_HDR   24      /* page header bytes */
+#define LOG_BB_BLK        8       /* control periods per coded block */
+#define LOG_BB_CH         3       /* recorded channels */
+#define LOG_BB_EVENTS     32      /* event ring depth; power of two */
+
+#define LOG_BB_U_SHIFT    7       /* power resolution: Q15 >> 7 (0.39 %) */
+#define LOG_BB_TH_LIMIT   229     /* pendulum fall while balancing (counts; 0.6 rad) */
+#define LOG_BB_POST       2000    /* control periods recorded after the fault */
+
+#define LOG_BB_MAGIC      0x31584242  /* "BBX1" */
+#define LOG_BB_VERSION    1
+#define LOG_BB_HDR_SIZE   28
+#define LOG_BB_EV_SIZE    8
+
+#define LOG_SC_BUF        4096    /* scope ring (16-bit samples; 8 KB) */
+#define LOG_SC_MAGIC      0x31504353  /* "SCP1" */
+#define LOG_SC_VERSION    1
+#define LOG_SC_HDR_SIZE   24
+#define LOG_SC_SP_SCALE   10000.0f    /* set point channel units per m (0.1 mm) */
+
+#define LOG_RICE_QMAX     16      /* unary length at which a code escapes to 32 raw bits */
+#define LOG_RICE_KMAX     24
+#define LOG_RICE_NMAX     32      /* adaptation window */
+
+
+/* Name: LOG_ev_type
+ *
+ * Description: black box event types
+ *
+ * Members: eLOG_EV_STATE - FSM state change; arg = new state
+ *          eLOG_EV_CMD   - serial command applied; arg = command ID
+ *          eLOG_EV_FAULT - recorder triggered; arg = LOG_bb_cause_type
+ *
+ * Notes:
+ *
+ */
+typedef enum
+{
+	eLOG_EV_STATE = 1,
+	eLOG_EV_CMD,
+	eLOG_EV_FAULT,
+} LOG_ev_type;
+
+
+/* Name: LOG_bb_cause_type
+ *
+ * Description: black box trigger causes
+ *
+ * Members: eLOG_BB_CAUSE_NONE   - not triggered
+ *          eLOG_BB_CAUSE_BRAKE  - emergency braking (collision warning)
+ *          eLOG_BB_CAUSE_FALL   - pendulum beyond LOG_BB_TH_LIMIT while
+ *                                 balancing
+ *          eLOG_BB_CAUSE_MANUAL - snapshot requested by command
+ *
+ * Notes:
+ *
+ */
+typedef enum
+{
+	eLOG_BB_CAUSE_NONE = 0,
+	eLOG_BB_CAUSE_BRAKE,
+	eLOG_BB_CAUSE_FALL,
+	eLOG_BB_CAUSE_MANUAL,
+} LOG_bb_cause_type;
+
+
+/* Name: LOG_bits_type
+ *
+ * Description: bounded bit writer
+ *
+ * Members: buf      - destination
+ *          pos      - bits written
+ *          cap      - capacity (bits)
+ *          overflow - set when a write did not fit; the writer then
+ *                     ignores further writes
+ *
+ * Notes:
+ *
+ */
+struct LOG_bits_type
+{
+	uint8_t *buf;
+	uint32_t pos;
+	uint32_t cap;
+	uint32_t overflow;
+};
+
+
+/* Name: LOG_rice_type
+ *
+ * Description: adaptive Rice coder state of one channel
+ *
+ * Members: A - sum of recent coded values
+ *          N - number of recent coded values
+ *
+ * Notes: reset to { LOG_RICE_A0, 1 } at every page
+ *
+ */
+struct LOG_rice_type
+{
+	uint32_t A;
+	uint32_t N;
+};
+
+#define LOG_RICE_A0 4
+
+
+/* Name: LOG_bb_ev_type
+ *
+ * Description: black box event record
+ *
+ * Members: sample - sample index at which the event occurred
+ *          type   - LOG_ev_type
+ *          arg    - event argument
+ *
+ * Notes:
+ *
+ */
+struct LOG_bb_ev_type
+{
+	uint32_t sample;
+	uint8_t type;
+	uint8_t arg;
+};
+
+
+/* Name: LOG_bb_type
+ *
+ * Description: black box recorder state
+ *
+ * Members: page      - page ring
+ *          head      - page being written
+ *          pages     - number of pages holding data (up to LOG_BB_PAGES)
+ *          bits      - writer of the current page
+ *          rice      - coder state per channel
+ *          blk       - samples of the block being collected
+ *          blk_n     - samples in blk
+ *          prev      - predictor history: x[-1], x[-2], th[-1], u[-1] of
+ *                      the sample before blk
+ *          samples   - samples recorded
+ *          ev        - event ring
+ *          ev_head   - events recorded (free-running)
+ *          state     - FSM state of the previous sample
+ *          cause     - trigger cause; eLOG_BB_CAUSE_NONE while armed
+ *          trig      - sample index of the trigger
+ *          trig_us   - trigger time (us)
+ *          post      - samples left to record after the trigger
+ *          frozen    - non-zero once recording has stopped
+ *          dump_req  - non-zero while a dump is requested
+ *
+ * Notes: written by the control period only; the background context reads
+ *        the image only while frozen
+ *
+ */
+struct LOG_bb_type
+{
+	uint8_t page[LOG_BB_PAGES][LOG_BB_PAGE_SIZE];
+	uint32_t head;
+	uint32_t pages;
+	struct LOG_bits_type bits;
+	struct LOG_rice_type rice[LOG_BB_CH];
+	int32_t blk[LOG_BB_BLK][LOG_BB_CH];
+	uint32_t blk_n;
+	int32_t prev[4];
+	uint32_t samples;
+	struct LOG_bb_ev_type ev[LOG_BB_EVENTS];
+	uint32_t ev_head;
+	uint32_t state;
+	uint32_t cause;
+	uint32_t trig;
+	uint64_t trig_us;
+	uint32_t post;
+	volatile uint32_t frozen;
+	volatile uint32_t dump_req;
+};
+
+
+/* Name: LOG_sc_chan_type
+ *
+ * Description: scope channels (all 16-bit, saturated)
+ *
+ * Members: eLOG_SC_CH_X      - cart position, QEI1 counts
+ *          eLOG_SC_CH_TH     - pendulum angle, QEI0 counts
+ *          eLOG_SC_CH_X_VEL  - cart velocity, QEI1 raw speed (signed)
+ *          eLOG_SC_CH_TH_VEL - pendulum velocity, QEI0 raw speed (signed)
+ *          eLOG_SC_CH_POWER  - staged motor power, Q15
+ *          eLOG_SC_CH_SP     - balance set point, 1/LOG_SC_SP_SCALE m
+ *          eLOG_SC_CH_STATE  - FSM state
+ *          eLOG_SC_CH_LAT    - LQR sample to actuation latency, cycles
+ *                              (LQR_Balance_GetLatency)
+ *
+ * Notes:
+ *
+ */
+typedef enum
+{
+	eLOG_SC_CH_X = 0,
+	eLOG_SC_CH_TH,
+	eLOG_SC_CH_X_VEL,
+	eLOG_SC_CH_TH_VEL,
+	eLOG_SC_CH_POWER,
+	eLOG_SC_CH_SP,
+	eLOG_SC_CH_STATE,
+	eLOG_SC_CH_LAT,
+	eLOG_SC_CH_MAX,
+} LOG_sc_chan_type;
+
+
+/* Name: LOG_sc_trig_type
+ *
+ * Description: scope trigger sources
+ *
+ * Members: eLOG_SC_TRIG_NOW    - as soon as the pre-trigger depth is
+ *                                recorded
+ *          eLOG_SC_TRIG_LEVEL  - trigger channel crosses level; arg
+ *                                selects the edge (LOG_SC_EDGE_x)
+ *          eLOG_SC_TRIG_CHANGE - trigger channel changes value (e.g. a
+ *                                set point step)
+ *          eLOG_SC_TRIG_CMD    - serial command applied; arg = command ID,
+ *                                0 for any
+ *
+ * Notes:
+ *
+ */
+typedef enum
+{
+	eLOG_SC_TRIG_NOW = 0,
+	eLOG_SC_TRIG_LEVEL,
+	eLOG_SC_TRIG_CHANGE,
+	eLOG_SC_TRIG_CMD,
+	eLOG_SC_TRIG_MAX,
+} LOG_sc_trig_type;
+
+#define LOG_SC_EDGE_RISE  0x01
+#define LOG_SC_EDGE_FALL  0x02
+
+
+/* Name: LOG_sc_cfg_type
+ *
+ * Description: scope capture request
+ *
+ * Members: mask  - channels to record (bit n: LOG_sc_chan_type n)
+ *          trig  - trigger source (LOG_sc_trig_type)
+ *          chan  - trigger channel (LEVEL, CHANGE); need not be recorded
+ *          arg   - edge (LEVEL) or command ID (CMD)
+ *          level - trigger level (LEVEL)
+ *          pre   - samples kept before the trigger (clamped to depth - 1)
+ *          decim - control periods per sample (1 = full rate)
+ *
+ * Notes: depth = LOG_SC_BUF / (number of channels) samples
+ *
+ */
+struct LOG_sc_cfg_type
+{
+	uint8_t mask;
+	uint8_t trig;
+	uint8_t chan;
+	uint8_t arg;
+	int16_t level;
+	uint16_t pre;
+	uint16_t decim;
+};
+
+/* every channel has its bit in mask: a channel past the eighth fails the
+ * build here (array of negative size) instead of overflowing the mask */
+typedef char LOG_sc_mask_check_type[( eLOG_SC_CH_MAX <= 8*sizeof(((struct LOG_sc_cfg_type *)0)->mask)) ? 1 : -1];
+
+
+/* Name: LOG_sc_state_type
+ *
+ * Description: scope states
+ *
+ * Members: eLOG_SC_IDLE  - not capturing; no capture held
+ *          eLOG_SC_ARMED - recording, waiting for pre-trigger depth and
+ *                          trigger
+ *          eLOG_SC_POST  - triggered, recording the post-trigger samples
+ *          eLOG_SC_DONE  - capture complete; held until streamed out
+ *
+ * Notes:
+ *
+ */
+typedef enum
+{
+	eLOG_SC_IDLE = 0,
+	eLOG_SC_ARMED,
+	eLOG_SC_POST,
+	eLOG_SC_DONE,
+} LOG_sc_state_type;
+
+
+/* Name: LOG_sc_type
+ *
+ * Description: scope state
+ *
+ * Members: buf     - sample ring
+ *          cfg     - capture request
+ *          state   - LOG_sc_state_type
+ *          n_ch    - channels recorded
+ *          depth   - ring depth (samples)
+ *          head    - ring index of the next sample
+ *          n       - samples recorded (saturates at depth)
+ *          left    - post-trigger samples still to record
+ *          div     - control periods until the next sample
+ *          last    - previous value of the trigger channel
+ *          cmd     - command ID seen this control period (0 if none)
+ *          trig_us - trigger time (us)
+ *          release - set by the background once the capture is streamed
+ *                    out
+ *
+ * Notes: written by the control period only (but release); the background
+ *        context reads the capture only in eLOG_SC_DONE
+ *
+ */
+struct LOG_sc_type
+{
+	int16_t buf[LOG_SC_BUF];
+	struct LOG_sc_cfg_type cfg;
+	volatile uint32_t state;
+	uint32_t n_ch;
+	uint32_t depth;
+	uint32_t head;
+	uint32_t n;
+	uint32_t left;
+	uint32_t div;
+	int32_t last;
+	uint32_t cmd;
+	uint64_t trig_us;
+	volatile uint32_t release;
+};
+
+
+#endif /* LOG_LOG_DEFS_H_ */
@@ -0,0 +1,44 @@
+/*
+ * log_proto.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Milos Lazic
+ */
+
+#ifndef LOG_LOG_PROTO_H_
+#define LOG_LOG_PROTO_H_
+
+
+#include <stdint.h>
+#include "log_defs.h"
+
+
+/* module scope routines */
+extern void LOG_bits_init( struct LOG_bits_type *b, uint8_t *buf, uint32_t cap);
+extern void LOG_bits_put( struct LOG_bits_type *b, uint32_t val, uint32_t n);
+extern void LOG_rice_reset( struct LOG_rice_type *r);
+extern void LOG_rice_put( struct LOG_bits_type *b, struct LOG_rice_type *r, int32_t v);
+extern void LOG_put_u16( uint8_t *buf, uint32_t v);
+extern void LOG_put_u32( uint8_t *buf, uint32_t v);
+
+/* global scope routines */
+extern void LOG_BB_Rearm( void);
+extern void LOG_BB_Tick( void);
+extern void LOG_BB_Event( uint32_t type, uint32_t arg);
+extern void LOG_BB_Trigger( uint32_t cause);
+extern uint32_t LOG_BB_DumpPending( void);
+extern void LOG_BB_DumpDone( void);
+extern void LOG_BB_RequestDump( void);
+extern uint32_t LOG_BB_Frozen( void);
+extern uint32_t LOG_BB_ImageSize( void);
+extern size_t LOG_BB_ImageRead( uint32_t ofs, uint8_t *buf, size_t len);
+extern int LOG_SC_Arm( const struct LOG_sc_cfg_type *cfg);
+extern void LOG_SC_Command( uint32_t id);
+extern void LOG_SC_Tick( void);
+extern uint32_t LOG_SC_Done( void);
+extern void LOG_SC_Release( void);
+extern uint32_t LOG_SC_ImageSize( void);
+extern size_t LOG_SC_ImageRead( uint32_t ofs, uint8_t *buf, size_t len);
+
+
+#endif /* LOG_LOG_PROTO_H_ */
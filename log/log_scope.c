@@ -0,0 +1,357 @@
+/*
+ * log_scope.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Milos Lazic
+ *
+ *  Triggered capture ("scope") at the control rate: selected channels are
+ *  recorded into RAM every control period and streamed out afterwards by
+ *  the background (CMD_ScopeFrame), so step responses and identification
+ *  runs are recorded at the real loop rate instead of what the UART can
+ *  carry live. See log_defs.h for the image format.
+ *
+ *  Depth: LOG_SC_BUF / channels samples, e.g. 1024 samples (102 ms at
+ *  10 kHz) of four channels; decimation trades rate for length.
+ */
+
+#include "log.h"
+#include "../fsm/fsm.h"
+#include "../lqr/lqr.h"
+#include "../sys/device/device.h"
+#include "../sys/systime/systime.h"
+
+
+static struct LOG_sc_type sc = { .state = eLOG_SC_IDLE };
+
+
+static int32_t LOG_sc_sat16( int32_t v)
+{
+	if ( v > 32767)
+		return 32767;
+	if ( v < -32768)
+		return -32768;
+	return v;
+}
+
+
+/*
+ * Name: LOG_sc_read
+ *
+ * Descr: Reads every scope channel
+ *
+ * Args:     v - storage for eLOG_SC_CH_MAX values (saturated to 16 bits)
+ *
+ * Return:   none
+ *
+ * Notes:
+ *
+ */
+static void LOG_sc_read( int32_t v[eLOG_SC_CH_MAX])
+{
+	int32_t u = 0;
+	uint32_t ch;
+
+	(void) dev_ioctl(eDEV_ESC0, eESC_IOCTL_GET_POWER_Q15, &u);
+
+	v[eLOG_SC_CH_X] = (int32_t)dev_ioctl(eDEV_QEI1, eQEI_IOCTL_R_POS);
+	v[eLOG_SC_CH_TH] = (int32_t)dev_ioctl(eDEV_QEI0, eQEI_IOCTL_R_POS);
+	v[eLOG_SC_CH_X_VEL] = (int32_t)dev_ioctl(eDEV_QEI1, eQEI_IOCTL_READ_SPEED);
+	v[eLOG_SC_CH_TH_VEL] = (int32_t)dev_ioctl(eDEV_QEI0, eQEI_IOCTL_READ_SPEED);
+	v[eLOG_SC_CH_POWER] = u;
+	v[eLOG_SC_CH_SP] = (int32_t)(LQR_Balance_GetSetPoint()*LOG_SC_SP_SCALE);
+	v[eLOG_SC_CH_STATE] = (int32_t)FSM_GetState();
+	v[eLOG_SC_CH_LAT] = (int32_t)LQR_Balance_GetLatency();
+
+	for ( ch = 0; ch < eLOG_SC_CH_MAX; ch++)
+		v[ch] = LOG_sc_sat16( v[ch]);
+}
+
+
+/*
+ * Name: LOG_sc_triggered
+ *
+ * Descr: Evaluates the trigger condition on the newest sample
+ *
+ * Args:     v - channel values of the newest sample
+ *
+ * Return:   non-zero if the trigger condition is met
+ *
+ * Notes: edges and changes need a previous sample; the first sample after
+ *        arming never triggers them
+ *
+ */
+static uint32_t LOG_sc_triggered( const int32_t v[eLOG_SC_CH_MAX])
+{
+	int32_t now = v[sc.cfg.chan], last = sc.last;
+	int32_t level = sc.cfg.level;
+
+	sc.last = now;
+
+	switch ( sc.cfg.trig)
+	{
+	case eLOG_SC_TRIG_NOW:
+		return 1;
+
+	case eLOG_SC_TRIG_LEVEL:
+		if ( sc.n < 2)
+			return 0;
+		return ( (sc.cfg.arg & LOG_SC_EDGE_RISE) && last < level && now >= level) ||
+		       ( (sc.cfg.arg & LOG_SC_EDGE_FALL) && last > level && now <= level);
+
+	case eLOG_SC_TRIG_CHANGE:
+		return ( sc.n >= 2 && now != last);
+
+	case eLOG_SC_TRIG_CMD:
+		return ( sc.cmd != 0 && ( sc.cfg.arg == 0 || sc.cfg.arg == sc.cmd));
+
+	default:
+		break;
+	}
+
+	return 0;
+}
+
+
+/*
+ * Name: LOG_SC_Arm
+ *
+ * Descr: Starts a capture, discarding any capture held
+ *
+ * Args:     cfg - capture request; mask 0 stops capturing
+ *
+ * Return:   0 on success, -1 if the request is invalid
+ *
+ * Notes: Control period context (CMD_Drain). The trigger is ignored until
+ *        the pre-trigger samples have been recorded, i.e. for pre*decim
+ *        control periods after arming.
+ *
+ */
+int LOG_SC_Arm( const struct LOG_sc_cfg_type *cfg)
+{
+	uint32_t ch;
+
+	if ( cfg->trig >= eLOG_SC_TRIG_MAX || cfg->chan >= eLOG_SC_CH_MAX ||
+	     cfg->decim == 0)
+		return -1;
+
+	sc.state = eLOG_SC_IDLE;
+	if ( cfg->mask == 0)
+		return 0;
+
+	sc.cfg = *cfg;
+	for ( ch = 0, sc.n_ch = 0; ch < eLOG_SC_CH_MAX; ch++)
+		sc.n_ch += ( cfg->mask >> ch) & 1;
+	sc.depth = LOG_SC_BUF/sc.n_ch;
+	if ( sc.cfg.pre >= sc.depth)
+		sc.cfg.pre = (uint16_t)(sc.depth - 1);
+
+	sc.head = 0;
+	sc.n = 0;
+	sc.div = 1;
+	sc.cmd = 0;
+	sc.release = 0;
+	sc.state = eLOG_SC_ARMED;
+
+	return 0;
+}
+
+
+/*
+ * Name: LOG_SC_Command
+ *
+ * Descr: Notes a serial command applied in this control period (command
+ *        trigger)
+ *
+ * Args:     id - command ID
+ *
+ * Return:   none
+ *
+ * Notes: control period context, before LOG_SC_Tick
+ *
+ */
+void LOG_SC_Command( uint32_t id)
+{
+	sc.cmd = id;
+}
+
+
+/*
+ * Name: LOG_SC_Tick
+ *
+ * Descr: Records one sample while capturing
+ *
+ * Args:     none
+ *
+ * Return:   none
+ *
+ * Notes: Called once per control period after FSM_Run, so that the
+ *        recorded power is the one about to be applied.
+ *
+ */
+void LOG_SC_Tick( void)
+{
+	int32_t v[eLOG_SC_CH_MAX];
+	int16_t *p;
+	uint32_t ch;
+
+	/* a stale release (capture re-armed while streaming) is dropped */
+	if ( sc.release)
+	{
+		if ( sc.state == eLOG_SC_DONE)
+			sc.state = eLOG_SC_IDLE;
+		sc.release = 0;
+	}
+
+	if ( sc.state != eLOG_SC_ARMED && sc.state != eLOG_SC_POST)
+	{
+		sc.cmd = 0;
+		return;
+	}
+
+	/* a command between two decimated samples triggers the next one */
+	if ( --sc.div)
+		return;
+	sc.div = sc.cfg.decim;
+
+	LOG_sc_read( v);
+
+	p = &sc.buf[sc.head*sc.n_ch];
+	for ( ch = 0; ch < eLOG_SC_CH_MAX; ch++)
+		if ( sc.cfg.mask & (1u << ch))
+			*p++ = (int16_t)v[ch];
+	if ( ++sc.head == sc.depth)
+		sc.head = 0;
+	if ( sc.n < sc.depth)
+		sc.n++;
+
+	if ( sc.state == eLOG_SC_ARMED)
+	{
+		/* the trigger sample lands at index pre of the capture */
+		if ( LOG_sc_triggered( v) && sc.n > sc.cfg.pre)
+		{
+			sc.trig_us = SYSTIME_ToUs(FSM_GetTickTime());
+			sc.left = sc.depth - 1 - sc.cfg.pre;
+			sc.state = eLOG_SC_POST;
+		}
+	}
+	else
+	{
+		sc.left--;
+	}
+
+	if ( sc.state == eLOG_SC_POST && sc.left == 0)
+		sc.state = eLOG_SC_DONE;
+
+	sc.cmd = 0;
+}
+
+
+/*
+ * Name: LOG_SC_Done
+ *
+ * Descr: Tells whether a complete capture waits to be streamed out
+ *
+ * Args:     none
+ *
+ * Return:   non-zero in eLOG_SC_DONE
+ *
+ * Notes: background context
+ *
+ */
+uint32_t LOG_SC_Done( void)
+{
+	return ( sc.state == eLOG_SC_DONE && !sc.release);
+}
+
+
+/*
+ * Name: LOG_SC_Release
+ *
+ * Descr: Releases the capture once streamed out
+ *
+ * Args:     none
+ *
+ * Return:   none
+ *
+ * Notes: background context; takes effect at the next control period
+ *
+ */
+void LOG_SC_Release( void)
+{
+	sc.release = 1;
+}
+
+
+/*
+ * Name: LOG_SC_ImageSize
+ *
+ * Descr: Size of the capture image
+ *
+ * Args:     none
+ *
+ * Return:   image size in bytes, 0 unless a capture is complete
+ *
+ * Notes:
+ *
+ */
+uint32_t LOG_SC_ImageSize( void)
+{
+	if ( sc.state != eLOG_SC_DONE)
+		return 0;
+
+	return LOG_SC_HDR_SIZE + 2*sc.depth*sc.n_ch;
+}
+
+
+/*
+ * Name: LOG_SC_ImageRead
+ *
+ * Descr: Copies part of the capture image (header, then samples oldest
+ *        first; see log_defs.h)
+ *
+ * Args:     ofs - image offset
+ *           buf - destination
+ *           len - bytes requested
+ *
+ * Return:   bytes copied; 0 at the end of the image or if no capture is
+ *           complete
+ *
+ * Notes: background context
+ *
+ */
+size_t LOG_SC_ImageRead( uint32_t ofs, uint8_t *buf, size_t len)
+{
+	uint8_t hdr[LOG_SC_HDR_SIZE];
+	uint32_t size = LOG_SC_ImageSize();
+	uint32_t i;
+	int16_t s;
+	size_t done = 0;
+
+	if ( ofs < LOG_SC_HDR_SIZE && size)
+	{
+		LOG_put_u32( &hdr[0], LOG_SC_MAGIC);
+		hdr[4] = LOG_SC_VERSION;
+		hdr[5] = sc.cfg.mask;
+		hdr[6] = sc.cfg.trig;
+		hdr[7] = (uint8_t)sc.n_ch;
+		LOG_put_u16( &hdr[8], sc.depth);
+		LOG_put_u16( &hdr[10], sc.cfg.pre);
+		LOG_put_u16( &hdr[12], sc.cfg.decim);
+		LOG_put_u16( &hdr[14], 0);
+		LOG_put_u32( &hdr[16], (uint32_t)sc.trig_us);
+		LOG_put_u32( &hdr[20], (uint32_t)(sc.trig_us >> 32));
+
+		while ( done < len && ofs < LOG_SC_HDR_SIZE)
+			buf[done++] = hdr[ofs++];
+	}
+
+	/* the ring is full once complete; the oldest sample is at head */
+	for ( ; done < len && ofs < size; ofs++)
+	{
+		i = ( ofs - LOG_SC_HDR_SIZE) >> 1;
+		s = sc.buf[((sc.head + i/sc.n_ch) % sc.depth)*sc.n_ch + i % sc.n_ch];
+		buf[done++] = ( ofs & 1) ? (uint8_t)((uint16_t)s >> 8) : (uint8_t)s;
+	}
+
+	return done;
+}
@@ -0,0 +1,163 @@
+/*
+ * log_utils.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Milos Lazic
+ *
+ *  Bit writer and adaptive Rice coder of the black box recorder; the code
+ *  format is described in log_defs.h.
+ */
+
+#include "log_defs.h"
+#include "log_proto.h"
+
+
+/*
+ * Name: LOG_bits_init
+ *
+ * Descr: Attaches a bit writer to an empty buffer
+ *
+ * Args:     b   - bit writer
+ *           buf - destination
+ *           cap - capacity (bits)
+ *
+ * Return:   none
+ *
+ * Notes:
+ *
+ */
+void LOG_bits_init( struct LOG_bits_type *b, uint8_t *buf, uint32_t cap)
+{
+	b->buf = buf;
+	b->pos = 0;
+	b->cap = cap;
+	b->overflow = 0;
+}
+
+
+/*
+ * Name: LOG_bits_put
+ *
+ * Descr: Appends the n low bits of val, least significant first
+ *
+ * Args:     b   - bit writer
+ *           val - bits to append
+ *           n   - number of bits (0..32)
+ *
+ * Return:   none
+ *
+ * Notes: A write that does not fit sets the overflow flag and is dropped.
+ *        Bytes are written on first touch, so the buffer need not be
+ *        cleared beforehand; bits beyond pos are undefined.
+ *
+ */
+void LOG_bits_put( struct LOG_bits_type *b, uint32_t val, uint32_t n)
+{
+	uint32_t sh, take;
+	uint8_t *p;
+
+	if ( b->overflow || b->cap - b->pos < n)
+	{
+		b->overflow = 1;
+		return;
+	}
+
+	while ( n)
+	{
+		p = &b->buf[b->pos >> 3];
+		sh = b->pos & 7;
+		take = 8 - sh;
+		if ( take > n)
+			take = n;
+
+		if ( sh == 0)
+			*p = (uint8_t)(val & ((1u << take) - 1));
+		else
+			*p |= (uint8_t)((val & ((1u << take) - 1)) << sh);
+
+		val >>= take;
+		n -= take;
+		b->pos += take;
+	}
+}
+
+
+/*
+ * Name: LOG_rice_reset
+ *
+ * Descr: Returns a Rice coder to its initial state
+ *
+ * Args:     r - coder state
+ *
+ * Return:   none
+ *
+ * Notes:
+ *
+ */
+void LOG_rice_reset( struct LOG_rice_type *r)
+{
+	r->A = LOG_RICE_A0;
+	r->N = 1;
+}
+
+
+/*
+ * Name: LOG_rice_put
+ *
+ * Descr: Appends one signed residual as an adaptive Rice code
+ *
+ * Args:     b - bit writer
+ *           r - coder state of the channel
+ *           v - residual
+ *
+ * Return:   none
+ *
+ * Notes: k is the smallest parameter with N*2^k >= A, i.e. about
+ *        log2 of the mean recent value; the decoder mirrors the update.
+ *
+ */
+void LOG_rice_put( struct LOG_bits_type *b, struct LOG_rice_type *r, int32_t v)
+{
+	uint32_t u = ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);   /* zigzag */
+	uint32_t k, q;
+
+	for ( k = 0; (r->N << k) < r->A && k < LOG_RICE_KMAX; k++)
+		;
+
+	q = u >> k;
+	if ( q < LOG_RICE_QMAX)
+	{
+		/* q ones and the terminating zero */
+		LOG_bits_put( b, (1u << q) - 1, q + 1);
+		if ( k)
+			LOG_bits_put( b, u & ((1u << k) - 1), k);
+	}
+	else
+	{
+		LOG_bits_put( b, (1u << LOG_RICE_QMAX) - 1, LOG_RICE_QMAX);
+		LOG_bits_put( b, u, 32);
+	}
+
+	r->A += ( u < 0xFFFF) ? u : 0xFFFF;
+	if ( ++r->N >= LOG_RICE_NMAX)
+	{
+		r->A >>= 1;
+		r->N >>= 1;
+	}
+}
+
+
+void LOG_put_u16( uint8_t *buf, uint32_t v)
+{
+	buf[0] = (uint8_t)v;
+	buf[1] = (uint8_t)(v >> 8);
+}
+
+
+void LOG_put_u32( uint8_t *buf, uint32_t v)
+{
+	buf[0] = (uint8_t)v;
+	buf[1] = (uint8_t)(v >> 8);
+	buf[2] = (uint8_t)(v >> 16);
+	buf[3] = (uint8_t)(v >> 24);
+}
@@ -7,124 +7,340 @@
 
 #include "lqr_defs.h"
 #include "lqr_proto.h"
+#include "../dsp/dsp.h"
 #include "../sys/device/device.h"
+#include "../sys/systime/systime.h"
+#include "../fsm/fsm_defs.h"
 #include <inc/tm4c123gh6pm.h>
 
 
-#define MAX_STATE 5              /* number of feedback states */
-
-#define SHAFT_RADIUS 0.0069358   /* shaft radius (m) */
-
-
 /*
  * LQR_Balance_CtrlIn calculates the voltage that should be applied
  * across motor terminals based on the current state measurements
  *
- * VOLTAGE_TO_POWER_MAP is a lookup table used to convert between
- * the caluclated voltage and the power (%) that should be output
- * to the motor. The corresponding power is decoded by the ESC driver
- * which calculates the appropriate duty cycle and direction signal
+ * The voltage to power map (pmap) of the active parameter bank is a lookup
+ * table used to convert between the caluclated voltage and the power (%)
+ * that should be output to the motor. The corresponding power is decoded
+ * by the ESC driver which calculates the appropriate duty cycle and
+ * direction signal
  */
-static const struct LQR_pt_type VOLTAGE_TO_POWER_MAP[] =
+#define LQR_DEFAULT_BANK \
+	{ \
+		.K = LQR_RIG_K, /* controller state feedback gains (lqr_rig.h) */ \
+		.Nbar = LQR_RIG_NBAR, \
+		.pmap = { \
+				/* voltage, input power to motor (%) */ \
+				{ -12.0,  -100.0 }, \
+				{  12.0,   100.0 }, \
+		}, \
+		.pmap_len = 2, \
+		.fric = LQR_RIG_FRIC, /* dead band and friction compensation (lqr_rig.h) */ \
+		.model = { /* plant model (lqr_rig.h) */ \
+				.A = LQR_RIG_MODEL_A, \
+				.B = LQR_RIG_MODEL_B, \
+		}, \
+		.evt = { /* derived from the model and K by LQR_Balance_Init */ \
+				.P = { { 0 } }, \
+				.on = 0, \
+				.sigma = LQR_EVT_SIGMA, \
+				.eps = LQR_EVT_EPS, \
+		}, \
+		.dob = { /* gains derived from the model by LQR_Balance_Init */ \
+				.bw = LQR_RIG_DOB_BW, \
+				.k_x = { 0 }, \
+				.h = { 0 }, \
+				.g = 0, \
+				.lim = LQR_RIG_DOB_LIM, \
+		}, \
+		.lqi = { \
+				.K = LQR_RIG_LQI_K, \
+				.Ki = LQR_RIG_LQI_KI, \
+				.Nbar = LQR_RIG_LQI_NBAR, \
+				.aw = LQR_RIG_LQI_AW, \
+		}, \
+		.ff = { 0 }, /* derived from the model by LQR_Balance_Init */ \
+	}
+
+
+// inverted pendulum LQR controller control block
+static DEV_STATE_CLASS struct LQR_ctrl_blk_type gcb =
 {
-		/* voltage, input power to motor (%) */
-		{ -12.0,  -100.0 },
-		{  12.0,   100.0 },
+		.bank = { LQR_DEFAULT_BANK, LQR_DEFAULT_BANK },
+		.active = 0,
+		.sp = 0, // intial set point (x position)
+		.ref_v = 0,
+		.ref_a = 0,
+		.ref_j = 0,
+		.filt = { NULL }, // no filters: states straight from the encoders
+		.filt_src = { LQR_STATE_TABLE( LQR_ST_INDEX, ~, ~) },
+		.restart = 1,
+		.t_sample = 0,
+		.lat = 0,
+		.tau = 0,
+		.u_prev = 0,
+		.x_last = { 0 },
+		.seq = 0,
+		.seq_last = 0,
+		.sp_last = 0,
+		.evt_hold = 0,
+		.n_ticks = 0,
+		.n_updates = 0,
+		.dob_x = { 0 },
+		.d_hat = 0,
+		.xi = 0,
 };
-#define VOLTAGE_TO_POWER_MAP_LEN (sizeof(VOLTAGE_TO_POWER_MAP)/sizeof(VOLTAGE_TO_POWER_MAP[0]))
 
 
+/* weights of the event trigger Lyapunov function (lqr_rig.h) */
+static const float lqr_evt_q[LQR_MAX_STATE] = LQR_RIG_EVT_Q;
 
-// controller state feedback gains
-static const float K_vec[MAX_STATE] = {0.0029, 20, 20.9179, -65.3129, -8};
 
+/*
+ * Name: LQR_Balance_Publish
+ *
+ * Descr: Subroutine of the parameter setters. Makes the written inactive
+ *        bank the active one.
+ *
+ * Args:     next - index of the written bank
+ *
+ * Return:   none
+ *
+ * Notes: The bank is switched with a single store; seq, counted after it,
+ *        tells the event-triggered controller that a bank was published
+ *        even when two publishes bring it back to the same slot.
+ *
+ */
+static void LQR_Balance_Publish( uint32_t next)
+{
+	gcb.active = next;
+	gcb.seq++;
+}
 
-// inverted pendulum LQR controller control block
-static struct LQR_ctrl_blk_type gcb =
+
+/*
+ * Name: LQR_Balance_FiltState
+ *
+ * Descr: Subroutine of LQR_Balance_ReadState. Filters one state channel.
+ *
+ * Args:     ch  - state channel
+ *           raw - unfiltered states
+ *
+ * Return:   state value
+ *
+ * Notes: Unfiltered channels pass their own raw state through.
+ *
+ */
+static float LQR_Balance_FiltState( uint32_t ch, const float *raw)
 {
-		.num_states = MAX_STATE,
-		.K = K_vec,
-		.Nbar = 20,
-		.sp = 0, // intial set point (x position)
-};
+	if ( gcb.filt[ch] == NULL)
+		return raw[ch];
+
+	if ( gcb.restart)
+		DSP_Prime( gcb.filt[ch], raw[gcb.filt_src[ch]]);
+	return DSP_Run( gcb.filt[ch], raw[gcb.filt_src[ch]]);
+}
 
 
 /*
- * Name: LQR_Balance_CtrlVIn
+ * Name: LQR_Balance_ReadState
  *
  * Descr: Subroutine of inverted pendulum balancing algorithm. Reads
- *        current state values and computes controller output (input to plant)
- *        through state feedback gain vector.
+ *        current state values and passes them through the state channel
+ *        filters.
  *
- * Args:     none
+ * Args:     x_vec - storage for the state vector (LQR_MAX_STATE entries)
+ *
+ * Return:   none
+ *
+ * Notes: State channels with a filter (LQR_Balance_SetFilter) get the
+ *        filtered value of their source state. Runs every control period
+ *        so that the filters see every sample.
+ *
+ */
+static void LQR_Balance_ReadState( float *x_vec)
+{
+	float raw[LQR_MAX_STATE];
+	float val;
+
+	/* read state variable values (order, sensor and scale: LQR_STATE_TABLE);
+	 * states without a sensor (eDEV_MAX, e.g. the armature current, assumed
+	 * negligible based on system dynamics analysis) read zero */
+#define LQR_READ_TERM(name, dev, req, scale, a, b) \
+	if ( (dev) == eDEV_MAX) \
+		raw[eLQR_ST_##name] = 0; \
+	else \
+	{ \
+		(void) dev_ioctl( (dev), (req), &val); \
+		raw[eLQR_ST_##name] = val * (float)(scale); \
+	}
+
+	LQR_STATE_TABLE( LQR_READ_TERM, ~, ~)
+
+	/* filter the state channels */
+#define LQR_FILT_TERM(name, dev, req, scale, a, b) \
+	x_vec[eLQR_ST_##name] = LQR_Balance_FiltState( eLQR_ST_##name, raw);
+
+	LQR_STATE_TABLE( LQR_FILT_TERM, ~, ~)
+
+#undef LQR_READ_TERM
+#undef LQR_FILT_TERM
+}
+
+
+/*
+ * Name: LQR_Balance_Observe
+ *
+ * Descr: Subroutine of inverted pendulum balancing algorithm. Updates the
+ *        input disturbance estimate with the state reading of the period.
+ *
+ * Args:     p     - active parameter bank
+ *           x_vec - state vector (LQR_Balance_ReadState)
+ *
+ * Return:   none
+ *
+ * Notes: Runs every control period, before the output is recomputed; the
+ *        output of the latest update is the one applied meanwhile (also
+ *        while the event-triggered controller holds it). A restart
+ *        clears the estimate.
+ *
+ */
+static void LQR_Balance_Observe( const struct LQR_param_bank_type *p, const float *x_vec)
+{
+	if ( gcb.restart)
+	{
+		LQR_COPY( gcb.dob_x, x_vec);
+		gcb.d_hat = 0;
+		return;
+	}
+
+	gcb.d_hat = LQR_dob_run( &p->dob, gcb.d_hat, gcb.dob_x, x_vec, gcb.u_prev);
+}
+
+
+/*
+ * Name: LQR_Balance_CtrlVIn
+ *
+ * Descr: Subroutine of inverted pendulum balancing algorithm. Computes
+ *        controller output (input to plant) through state feedback gain
+ *        vector.
+ *
+ * Args:     p     - active parameter bank
+ *           x_vec - state vector (LQR_Balance_ReadState); replaced by the
+ *                   state predicted at the time the output takes effect
+ *           lqi   - LQI gains, NULL for the LQR of the bank
  *
  * Return:   Controller output (input to plant)
  *
  * Notes: The input to the system being controlled is voltage
- *        (pulse width modulated) accross the motor terminals
+ *        (pulse width modulated) accross the motor terminals. See
+ *        LQR_Balance_CtrlRun for the prediction. The estimated input
+ *        disturbance (LQR_Balance_Observe) is cancelled, which removes
+ *        the steady cart offset a constant load would otherwise leave.
+ *        A moving reference (LQR_Balance_SetRef) adds the feedback of
+ *        the reference state and the model input along it (LQR_ff_type).
  *
  */
-static float LQR_Balance_CtrlVIn( void)
+static float LQR_Balance_CtrlVIn( const struct LQR_param_bank_type *p, float *x_vec,
+                                  const struct LQR_lqi_type *lqi)
 {
-	float x_vec[MAX_STATE];
-	float val;
+	const float *K = ( lqi != NULL) ? lqi->K : p->K;
+	float th_ff, thd_ff, u_ff;
+
+	/* advance the state to the PWM update; the previous output is applied
+	 * until then (unknown after a restart), on top of the disturbance */
+	if ( gcb.restart)
+	{
+		gcb.u_prev = 0;
+		gcb.xi = 0;
+	}
+	LQR_predict( x_vec, &p->model, gcb.tau, gcb.u_prev + gcb.d_hat);
+
+	/* moving reference: the velocity, and the angle, its rate and the
+	 * input the model needs to follow it; without a model the cart
+	 * velocity alone would drag the pendulum behind, so only the
+	 * position is tracked */
+	u_ff = 0;
+	if ( p->ff.th_a != 0)
+	{
+		th_ff = p->ff.th_v*gcb.ref_v + p->ff.th_a*gcb.ref_a;
+		thd_ff = p->ff.th_v*gcb.ref_a + p->ff.th_a*gcb.ref_j;
+		u_ff = p->ff.u_v*gcb.ref_v + p->ff.u_a*gcb.ref_a +
+		       K[eLQR_ST_XD]*gcb.ref_v + K[eLQR_ST_TH]*th_ff + K[eLQR_ST_THD]*thd_ff;
+	}
 
-	/* read state variable values
-	 *
-	 * x_vec(0) = i(t) [armature current] // NOTE: cannot be measured with available hardware; assume 0 for now...
-	 * x_vec(1) = x(t) [cart position]
-	 * x_vec(2) = x'(t) [cart velocity]
-	 * x_vec(3) = th(t) [pendulum angle]
-	 * x_vec(4) = th'(t) [pendulum angular velocity]
-	 */
-
-	/* get current value (assumed to be negligible based on system dynamics analysis) */
-	x_vec[0] = 0;
-
-	/* get position of the cart along the track */
-	(void) dev_ioctl(eDEV_QEI1, eQEI_IOCTL_R_POS_RAD, &val);
-	x_vec[1] = val * (float)SHAFT_RADIUS;
-	/* get velocity of the cart along the track */
-	(void) dev_ioctl(eDEV_QEI1, eQEI_IOCTL_R_VEL_RAD, &val);
-	x_vec[2] = val * (float)SHAFT_RADIUS;
-	/* get angular position of the pendulum */
-	(void) dev_ioctl(eDEV_QEI0, eQEI_IOCTL_R_POS_RAD, &x_vec[3]);
-	/* get angular velocity of the pendulum */
-	(void) dev_ioctl(eDEV_QEI0, eQEI_IOCTL_R_VEL_RAD, &x_vec[4]);
-
-
-	/* setpoint (XPOS * Nbar) - Kx */
+	/* setpoint (XPOS * Nbar) + u_ff - Kx - Ki*xi - d_hat */
 	/* returns a required input voltage */
-	return ((gcb.sp * gcb.Nbar) - LQR_dot_f( x_vec, gcb.K, gcb.num_states));
+	if ( lqi != NULL)
+		return ((gcb.sp * lqi->Nbar) + u_ff - LQR_DOT( x_vec, K) -
+		        lqi->Ki*gcb.xi - gcb.d_hat);
+
+	return ((gcb.sp * p->Nbar) + u_ff - LQR_DOT( x_vec, K) - gcb.d_hat);
 }
 
 
 /*
- * Name: LQR_Balance_CtrlRun
+ * Name: LQR_Balance_Update
  *
- * Descr: Main inverted pendulum controller wrapper function; computes
- *        required controller output (input to plant) and calls motor
- *        driver (DEV_ESC) routine to set required power level (driver
- *        handles power level to duty cycle conversion)
+ * Descr: Subroutine of inverted pendulum balancing algorithm. Computes
+ *        the controller output for a state reading and stages the
+ *        corresponding motor power.
  *
- * Args:     val - new value of set point
+ * Args:     p        - active parameter bank
+ *           x_vec    - state vector (LQR_Balance_ReadState); overwritten
+ *           t_sample - time the state was read (SYSTIME_Now, cycles)
+ *           lqi      - LQI gains, NULL for the LQR of the bank
  *
  * Return:   none
  *
- * Notes: In this context, the set point represents the physical
- *        position (x) of the cart along the tracks (relative to
- *        position at QEI initialization.
+ * Notes: See LQR_Balance_CtrlRun and LQR_Balance_CtrlRunLQI
  *
  */
-void LQR_Balance_CtrlRun( void)
+static void LQR_Balance_Update( const struct LQR_param_bank_type *p, float *x_vec, uint64_t t_sample,
+                                const struct LQR_lqi_type *lqi)
 {
-	float v_in, power_in;
+	float v_in, v_comp, v_sat, power_in;
+	uint64_t t_act;
+
+	// measure the latency of the previous update
+	(void) dev_ioctl(eDEV_ESC0, eESC_IOCTL_GET_ACT_TIME, &t_act);
+	if ( t_act >= gcb.t_sample && t_act - gcb.t_sample < LQR_LAT_MAX)
+	{
+		gcb.lat = (uint32_t)(t_act - gcb.t_sample);
+		gcb.tau += ((float)gcb.lat*(1.0f/SYSTIME_CLOCK_HZ) - gcb.tau)*LQR_LAT_GAIN;
+	}
+	gcb.t_sample = t_sample;
 
 	// calculate the voltage input to the controller
-	v_in = LQR_Balance_CtrlVIn();
+	v_in = LQR_Balance_CtrlVIn( p, x_vec, lqi);
+
+	// shape the controller output (e.g. notch out a belt resonance)
+	if ( gcb.filt[LQR_FILT_OUT] != NULL)
+	{
+		if ( gcb.restart)
+			DSP_Prime( gcb.filt[LQR_FILT_OUT], v_in);
+		v_in = DSP_Run( gcb.filt[LQR_FILT_OUT], v_in);
+	}
+	gcb.restart = 0;
+	gcb.u_prev = v_in;
+
+	// compensate motor dead band and cart friction
+	v_comp = LQR_fric_comp( v_in, (float)FSM_CART_POWER_DIR*x_vec[eLQR_ST_XD], &p->fric);
 
 	// convert voltage input to power input (%)
-	power_in = LQR_linmap( v_in, VOLTAGE_TO_POWER_MAP, VOLTAGE_TO_POWER_MAP_LEN);
+	power_in = LQR_linmap( v_comp, p->pmap, p->pmap_len);
+
+	// integrate the position error, backing off by what the map clipped
+	if ( lqi != NULL)
+	{
+		v_sat = v_comp;
+		if ( v_sat < p->pmap[0].x)
+			v_sat = p->pmap[0].x;
+		else if ( v_sat > p->pmap[p->pmap_len - 1].x)
+			v_sat = p->pmap[p->pmap_len - 1].x;
+		gcb.xi += LQR_TS*( ( x_vec[eLQR_ST_X] - gcb.sp) - lqi->aw*( v_sat - v_comp));
+	}
+	else
+		gcb.xi = 0;
 
 #if 0 // DEBUGGING: turn on GREEN LED if power to actuator equals
 	  //            or exceeds 100 percent (absolute value)
@@ -134,11 +350,173 @@ void LQR_Balance_CtrlRun( void)
 		GPIO_PORTF_DATA_R &= ~(0x00000008);
 #endif
 
-	dev_ioctl(eDEV_ESC0, eESC_IOCTL_SET_POWER, (int)power_in);
+	dev_ioctl(eDEV_ESC0, eESC_IOCTL_SET_POWER_F, power_in);
+}
+
+
+/*
+ * Name: LQR_Balance_CtrlRun
+ *
+ * Descr: Main inverted pendulum controller wrapper function; computes
+ *        required controller output (input to plant) and calls motor
+ *        driver (DEV_ESC) routine to set required power level (driver
+ *        handles power level to duty cycle conversion)
+ *
+ * Args:     none
+ *
+ * Return:   none
+ *
+ * Notes: In this context, the set point represents the physical
+ *        position (x) of the cart along the tracks (relative to
+ *        position at QEI initialization. The active parameter bank is
+ *        sampled once, so a bank published meanwhile takes effect on the
+ *        next call.
+ *
+ *        The output only takes effect at the PWM period boundary
+ *        following the end of the control period. The ESC driver reports
+ *        when that was for the previous output; its distance from the
+ *        previous state reading is the measured latency, averaged into
+ *        the prediction horizon. Latencies beyond LQR_LAT_MAX mean the
+ *        previous period did not run this controller and are ignored.
+ *
+ */
+void LQR_Balance_CtrlRun( void)
+{
+	const struct LQR_param_bank_type *p = &gcb.bank[gcb.active];
+	float x_vec[LQR_MAX_STATE];
+	uint64_t t_sample = SYSTIME_Now();
+
+	LQR_Balance_ReadState( x_vec);
+	LQR_Balance_Observe( p, x_vec);
+	LQR_Balance_Update( p, x_vec, t_sample, NULL);
+}
+
+
+/*
+ * Name: LQR_Balance_CtrlRunEvt
+ *
+ * Descr: Event-triggered variant of LQR_Balance_CtrlRun; samples the
+ *        state every control period but recomputes and restages the
+ *        output only when the state has moved away from the one the
+ *        output was computed for
+ *
+ * Args:     none
+ *
+ * Return:   none
+ *
+ * Notes: With V(z) = z'*P*z the closed loop Lyapunov function of the
+ *        active bank (LQR_evt_type) and e the deviation from the state of
+ *        the last update, the output is recomputed when
+ *            V(e) > sigma*V(x) + eps
+ *        i.e. when the held output is no longer guaranteed to make V
+ *        decrease, or the deviation leaves the encoder noise band near
+ *        the upright. A restart, a new parameter bank, a set point change
+ *        or LQR_EVT_HOLD_MAX held periods force an update; with the
+ *        trigger off (no P for the gains, see LQR_evt_design) every
+ *        period updates. Held periods
+ *        leave the PWM generator untouched (see esc_sync). The output
+ *        filter (LQR_FILT_OUT) runs on updates only.
+ *
+ */
+void LQR_Balance_CtrlRunEvt( void)
+{
+	const struct LQR_param_bank_type *p = &gcb.bank[gcb.active];
+	float x_vec[LQR_MAX_STATE], e[LQR_MAX_STATE];
+	uint64_t t_sample = SYSTIME_Now();
+
+	LQR_Balance_ReadState( x_vec);
+	LQR_Balance_Observe( p, x_vec);
+	gcb.n_ticks++;
+
+	if ( !gcb.restart && p->evt.on && gcb.seq == gcb.seq_last &&
+	     gcb.sp == gcb.sp_last && gcb.evt_hold < LQR_EVT_HOLD_MAX)
+	{
+		LQR_COPY( e, x_vec);
+		LQR_SUB( e, gcb.x_last);
+
+		if ( LQR_quad_f( e, p->evt.P) <=
+		     p->evt.sigma*LQR_quad_f( x_vec, p->evt.P) + p->evt.eps)
+		{
+			gcb.evt_hold++;
+			return;
+		}
+	}
+
+	LQR_COPY( gcb.x_last, x_vec);
+	gcb.seq_last = gcb.seq;
+	gcb.sp_last = gcb.sp;
+	gcb.evt_hold = 0;
+	gcb.n_updates++;
+
+	LQR_Balance_Update( p, x_vec, t_sample, NULL);
+}
+
+
+/*
+ * Name: LQR_Balance_CtrlRunLQI
+ *
+ * Descr: LQI variant of LQR_Balance_CtrlRun; adds integral action on the
+ *        cart position error, with its own gains (LQR_lqi_type)
+ *
+ * Args:     none
+ *
+ * Return:   none
+ *
+ * Notes: The integral removes the steady cart offset without relying on
+ *        a hand-picked Nbar. The power map clamps the output at its end
+ *        points (+/-12 V by default), which the gains do not know about;
+ *        the integrator is driven back by the amount clipped off the
+ *        output actually delivered (after the friction compensation), so
+ *        it does not wind up while the actuator saturates. The integral
+ *        starts from zero on a restart and on a switch from the other
+ *        LQR modes.
+ *
+ */
+void LQR_Balance_CtrlRunLQI( void)
+{
+	const struct LQR_param_bank_type *p = &gcb.bank[gcb.active];
+	float x_vec[LQR_MAX_STATE];
+	uint64_t t_sample = SYSTIME_Now();
+
+	LQR_Balance_ReadState( x_vec);
+	LQR_Balance_Observe( p, x_vec);
+	LQR_Balance_Update( p, x_vec, t_sample, &p->lqi);
 }
 
 
 
+/*
+ * Name: LQR_Balance_Init
+ *
+ * Descr: Routine to set the controller up for the rig (lqr_rig.h)
+ *
+ * Args:     none
+ *
+ * Return:   none
+ *
+ * Notes: Called once from FSM_Init, before the control period interrupt
+ *        is started. Derives the disturbance observer gains, the
+ *        reference feed-forward and the event trigger from the rig model
+ *        (LQR_RIG_MODEL_A, LQR_RIG_MODEL_B) and installs the rig filters (LQR_RIG_FILTERS);
+ *        a filter the table names for an invalid channel is left out.
+ *
+ */
+void LQR_Balance_Init( void)
+{
+	LQR_Balance_SetModel( &gcb.bank[gcb.active].model);
+
+#define LQR_FILT_ENTRY(ch, src, filt) \
+	{ \
+		extern struct DSP_filt_type filt; \
+		(void) LQR_Balance_SetFilter( (ch), (src), &filt); \
+	}
+
+	LQR_RIG_FILTERS( LQR_FILT_ENTRY)
+
+#undef LQR_FILT_ENTRY
+}
+
+
 /*
  * Name: LQR_Balance_SetPoint
  *
@@ -155,6 +533,439 @@ void LQR_Balance_CtrlRun( void)
  */
 void LQR_Balance_SetPoint( float val)
 {
-	gcb.sp = val;
+	LQR_Balance_SetRef( val, 0, 0, 0);
+}
+
+
+/*
+ * Name: LQR_Balance_GetSetPoint
+ *
+ * Descr: Routine to read controller reference (set point)
+ *
+ * Args:     none
+ *
+ * Return:   current set point
+ *
+ * Notes:
+ *
+ */
+float LQR_Balance_GetSetPoint( void)
+{
+	return gcb.sp;
+}
+
+
+/*
+ * Name: LQR_Balance_SetRef
+ *
+ * Descr: Routine to set a moving controller reference
+ *
+ * Args:     pos  - cart position (m), the set point
+ *           vel  - cart velocity (m/s)
+ *           acc  - cart acceleration (m/s^2)
+ *           jerk - cart jerk (m/s^3)
+ *
+ * Return:   none
+ *
+ * Notes: Called every control period, before the controller, by the
+ *        trajectory generator (traj/traj_gen.c). The derivatives must be
+ *        consistent with the positions of the successive calls; the
+ *        feed-forward (LQR_ff_type) then moves the cart along with the
+ *        reference instead of chasing it.
+ *
+ */
+void LQR_Balance_SetRef( float pos, float vel, float acc, float jerk)
+{
+	gcb.sp = pos;
+	gcb.ref_v = vel;
+	gcb.ref_a = acc;
+	gcb.ref_j = jerk;
+}
+
+
+/*
+ * Name: LQR_Balance_GetPosition
+ *
+ * Descr: Routine to read the cart position of the latest control period
+ *
+ * Args:     none
+ *
+ * Return:   cart position (m), as fed back (set point frame)
+ *
+ * Notes: Updated by every controller run, with the state readings
+ *
+ */
+float LQR_Balance_GetPosition( void)
+{
+	return gcb.dob_x[eLQR_ST_X];
+}
+
+
+/*
+ * Name: LQR_Balance_SetParams
+ *
+ * Descr: Routine to replace the controller parameters; writes the
+ *        inactive parameter bank and publishes it with a single store
+ *
+ * Args:     K        - new state feedback gains (LQR_MAX_STATE entries)
+ *           Nbar     - new pre-compensation constant
+ *           pmap     - new voltage to power map sorted by voltage, NULL to
+ *                      keep the current map
+ *           pmap_len - number of points in pmap (2 to LQR_PMAP_MAX)
+ *
+ * Return:   0 on success, -1 if the map is invalid (parameters unchanged)
+ *
+ * Notes: Single writer, background context (CMD_Apply): the control
+ *        period preempts it and keeps reading the active bank, and sees
+ *        only the publish. The event trigger is rederived for the new
+ *        gains (LQR_evt_design) in the inactive bank, before it is
+ *        published; the solve must never run in the control period.
+ *
+ */
+int LQR_Balance_SetParams( const float *K, float Nbar,
+                           const struct LQR_pt_type *pmap, size_t pmap_len)
+{
+	uint32_t cur = gcb.active;
+	uint32_t next = (cur + 1) % LQR_NUM_BANKS;
+	struct LQR_param_bank_type *p = &gcb.bank[next];
+	uint32_t i;
+
+	if ( pmap != NULL)
+	{
+		if ( pmap_len < 2 || pmap_len > LQR_PMAP_MAX)
+			return -1;
+		for ( i = 1; i < pmap_len; i++)
+			if ( pmap[i].x <= pmap[i-1].x)
+				return -1;
+	}
+	else
+	{
+		pmap = gcb.bank[cur].pmap;
+		pmap_len = gcb.bank[cur].pmap_len;
+	}
+
+	for ( i = 0; i < LQR_MAX_STATE; i++)
+		p->K[i] = K[i];
+	p->Nbar = Nbar;
+	for ( i = 0; i < pmap_len; i++)
+		p->pmap[i] = pmap[i];
+	p->pmap_len = pmap_len;
+	p->fric = gcb.bank[cur].fric;
+	p->model = gcb.bank[cur].model;
+	p->evt = gcb.bank[cur].evt;
+	LQR_evt_design( &p->evt, &p->model, p->K, lqr_evt_q);
+	p->dob = gcb.bank[cur].dob;
+	p->lqi = gcb.bank[cur].lqi;
+	p->ff = gcb.bank[cur].ff;
+
+	/* publish */
+	LQR_Balance_Publish( next);
+
+	return 0;
+}
+
+
+/*
+ * Name: LQR_Balance_SetGains
+ *
+ * Descr: Routine to replace the state feedback gains and the reference
+ *        pre-compensation constant, keeping the voltage to power map
+ *
+ * Args:     K    - new state feedback gains (LQR_MAX_STATE entries)
+ *           Nbar - new pre-compensation constant
+ *
+ * Return:   none
+ *
+ * Notes: See LQR_Balance_SetParams
+ *
+ */
+void LQR_Balance_SetGains( const float *K, float Nbar)
+{
+	(void) LQR_Balance_SetParams( K, Nbar, NULL, 0);
 }
 
+
+/*
+ * Name: LQR_Balance_GetParams
+ *
+ * Descr: Routine to read the active controller parameters
+ *
+ * Args:     none
+ *
+ * Return:   pointer to the active parameter bank
+ *
+ * Notes: The bank may be overwritten by the second LQR_Balance_SetParams
+ *        call after this one
+ *
+ */
+const struct LQR_param_bank_type *LQR_Balance_GetParams( void)
+{
+	return &gcb.bank[gcb.active];
+}
+
+
+/*
+ * Name: LQR_Balance_SetFriction
+ *
+ * Descr: Routine to replace the dead band and friction compensation
+ *        parameters; writes the inactive parameter bank and publishes it
+ *
+ * Args:     fric - new compensation parameters
+ *
+ * Return:   none
+ *
+ * Notes: See LQR_Balance_SetParams
+ *
+ */
+void LQR_Balance_SetFriction( const struct LQR_fric_type *fric)
+{
+	uint32_t cur = gcb.active;
+	uint32_t next = (cur + 1) % LQR_NUM_BANKS;
+
+	gcb.bank[next] = gcb.bank[cur];
+	gcb.bank[next].fric = *fric;
+
+	/* publish */
+	LQR_Balance_Publish( next);
+}
+
+
+/*
+ * Name: LQR_Balance_SetFilter
+ *
+ * Descr: Routine to plug a filter chain on a state channel or on the
+ *        controller output
+ *
+ * Args:     ch   - state channel (0 to LQR_MAX_STATE - 1) or LQR_FILT_OUT
+ *           src  - measured state filtered into a state channel (e.g. 1,
+ *                  cart position, for a differentiator on channel 2);
+ *                  ignored for LQR_FILT_OUT
+ *           filt - filter chain (see dsp_defs.h), NULL to remove
+ *
+ * Return:   0 on success, -1 if the channel or the source is invalid
+ *
+ * Notes: See LQR_Balance_SetParams. The filters are primed with the next
+ *        readings, as on every entry into STATE_BALANCE.
+ *
+ */
+int LQR_Balance_SetFilter( uint32_t ch, uint32_t src, struct DSP_filt_type *filt)
+{
+	if ( ch >= LQR_NUM_FILT || ( ch < LQR_MAX_STATE && src >= LQR_MAX_STATE))
+		return -1;
+
+	if ( ch < LQR_MAX_STATE)
+		gcb.filt_src[ch] = (uint8_t)src;
+	gcb.filt[ch] = filt;
+	gcb.restart = 1;
+
+	return 0;
+}
+
+
+/*
+ * Name: LQR_Balance_Restart
+ *
+ * Descr: Routine to restart the filters from the next state readings
+ *
+ * Args:     none
+ *
+ * Return:   none
+ *
+ * Notes: Called by the FSM whenever the controller takes over; the
+ *        filters otherwise hold stale samples from the last time it ran,
+ *        which a differentiator would turn into a velocity spike.
+ *
+ */
+void LQR_Balance_Restart( void)
+{
+	gcb.restart = 1;
+}
+
+
+/*
+ * Name: LQR_Balance_SetModel
+ *
+ * Descr: Routine to replace the plant model of the latency predictor;
+ *        writes the inactive parameter bank and publishes it
+ *
+ * Args:     model - new plant model (all zero disables the prediction)
+ *
+ * Return:   none
+ *
+ * Notes: See LQR_Balance_SetParams. The disturbance observer gains, the
+ *        reference feed-forward and the event trigger are rederived for
+ *        the new model, in the inactive bank before it is published.
+ *
+ */
+void LQR_Balance_SetModel( const struct LQR_model_type *model)
+{
+	uint32_t cur = gcb.active;
+	uint32_t next = (cur + 1) % LQR_NUM_BANKS;
+
+	gcb.bank[next] = gcb.bank[cur];
+	gcb.bank[next].model = *model;
+	LQR_dob_design( &gcb.bank[next].dob, model);
+	LQR_ff_design( &gcb.bank[next].ff, model);
+	LQR_evt_design( &gcb.bank[next].evt, model, gcb.bank[next].K, lqr_evt_q);
+
+	/* publish */
+	LQR_Balance_Publish( next);
+}
+
+
+/*
+ * Name: LQR_Balance_GetLatency
+ *
+ * Descr: Routine to read the latest measured latency, from the state
+ *        reading to the PWM update applying the resulting output
+ *
+ * Args:     none
+ *
+ * Return:   latency (cycles)
+ *
+ * Notes: Updated by every LQR_Balance_CtrlRun, for the period before
+ *
+ */
+uint32_t LQR_Balance_GetLatency( void)
+{
+	return gcb.lat;
+}
+
+
+/*
+ * Name: LQR_Balance_SetTrigger
+ *
+ * Descr: Routine to replace the event trigger of the event-triggered
+ *        controller; writes the inactive parameter bank and publishes it
+ *
+ * Args:     evt - new trigger parameters
+ *
+ * Return:   none
+ *
+ * Notes: See LQR_Balance_SetParams. The next change of the gains or of
+ *        the model rederives P from the rig weights (LQR_RIG_EVT_Q).
+ *
+ */
+void LQR_Balance_SetTrigger( const struct LQR_evt_type *evt)
+{
+	uint32_t cur = gcb.active;
+	uint32_t next = (cur + 1) % LQR_NUM_BANKS;
+
+	gcb.bank[next] = gcb.bank[cur];
+	gcb.bank[next].evt = *evt;
+
+	/* publish */
+	LQR_Balance_Publish( next);
+}
+
+
+/*
+ * Name: LQR_Balance_GetEventStats
+ *
+ * Descr: Routine to read the event-triggered controller counters
+ *
+ * Args:     ticks   - storage for the number of control periods run by
+ *                     LQR_Balance_CtrlRunEvt
+ *           updates - storage for the number of those that recomputed the
+ *                     output
+ *
+ * Return:   none
+ *
+ * Notes: The skipped fraction is 1 - updates/ticks; both counters wrap
+ *        (after ~5 days). Not atomic as a pair: a control period between
+ *        the two reads makes them differ by one.
+ *
+ */
+void LQR_Balance_GetEventStats( uint32_t *ticks, uint32_t *updates)
+{
+	*updates = gcb.n_updates;
+	*ticks = gcb.n_ticks;
+}
+
+
+/*
+ * Name: LQR_Balance_SetObserver
+ *
+ * Descr: Routine to configure the input disturbance observer; writes the
+ *        inactive parameter bank and publishes it
+ *
+ * Args:     bw  - observer bandwidth (rad/s), 0 disables the observer
+ *           lim - largest disturbance estimate magnitude (V)
+ *
+ * Return:   0 on success, -1 if bw or lim is out of range (parameters
+ *           unchanged)
+ *
+ * Notes: See LQR_Balance_SetParams. The gains come from the plant model
+ *        of the active bank (LQR_Balance_SetModel); without one the
+ *        estimate stays zero. bw must stay well below the bandwidth of
+ *        the velocity readings, which the observer differentiates
+ *        through the model: with the 50 ms QEI velocity period, limit
+ *        cycle from 4 rad/s in host/sim, and the pendulum held less still
+ *        the higher bw is (host/sim/mc_bench -o). The rig default
+ *        (LQR_RIG_DOB_BW) is loaded by LQR_Balance_Init.
+ *
+ */
+int LQR_Balance_SetObserver( float bw, float lim)
+{
+	uint32_t cur = gcb.active;
+	uint32_t next = (cur + 1) % LQR_NUM_BANKS;
+	struct LQR_dob_type *dob = &gcb.bank[next].dob;
+
+	if ( bw < 0 || bw*LQR_TS >= 1.0f || lim < 0)
+		return -1;
+
+	gcb.bank[next] = gcb.bank[cur];
+	dob->bw = bw;
+	dob->lim = lim;
+	LQR_dob_design( dob, &gcb.bank[next].model);
+
+	/* publish */
+	LQR_Balance_Publish( next);
+
+	return 0;
+}
+
+
+/*
+ * Name: LQR_Balance_GetDisturbance
+ *
+ * Descr: Routine to read the input disturbance estimate
+ *
+ * Args:     none
+ *
+ * Return:   disturbance estimate (V), as subtracted from the controller
+ *           output
+ *
+ * Notes:
+ *
+ */
+float LQR_Balance_GetDisturbance( void)
+{
+	return gcb.d_hat;
+}
+
+
+/*
+ * Name: LQR_Balance_SetLQI
+ *
+ * Descr: Routine to replace the gains of the LQI controller; writes the
+ *        inactive parameter bank and publishes it
+ *
+ * Args:     lqi - new gains (host/lqi_design)
+ *
+ * Return:   none
+ *
+ * Notes: See LQR_Balance_SetParams
+ *
+ */
+void LQR_Balance_SetLQI( const struct LQR_lqi_type *lqi)
+{
+	uint32_t cur = gcb.active;
+	uint32_t next = (cur + 1) % LQR_NUM_BANKS;
+
+	gcb.bank[next] = gcb.bank[cur];
+	gcb.bank[next].lqi = *lqi;
+
+	/* publish */
+	LQR_Balance_Publish( next);
+}
@@ -11,33 +11,53 @@
 
 #include <stdlib.h>
 #include <stdint.h>
+#include "../dsp/dsp_defs.h"
+#include "lqr_rig.h"
 
 
+#define LQR_MAX_STATE  eLQR_ST_MAX   /* number of feedback states (lqr_rig.h) */
+#define LQR_FILT_OUT   LQR_MAX_STATE   /* filter slot of the controller output */
+#define LQR_NUM_FILT   (LQR_MAX_STATE + 1)
+#define LQR_LAT_MAX    80000     /* longest credible latency (cycles, 1 ms) */
+#define LQR_LAT_GAIN   0.0625f   /* latency averaging gain (per control period) */
+#define LQR_EVT_SIGMA  0.0001f   /* default event trigger, relative (see LQR_evt_type) */
+#define LQR_EVT_EPS    3e-8f     /* default event trigger, absolute */
+#define LQR_EVT_HOLD_MAX 100     /* longest output hold of the event-triggered controller (control periods) */
+#define LQR_TS         0.0001f   /* control period (s); SysTick at 10 kHz */
+#define LQR_PMAP_MAX   8         /* largest voltage to power map (points) */
+#define LQR_EVT_NU     (LQR_MAX_STATE*(LQR_MAX_STATE + 1)/2)   /* unknowns of the event trigger design (LQR_evt_design) */
+#define LQR_NUM_BANKS  2         /* parameter banks (active + staging) */
 
-/* Name: LQR_ctrl_blk_type
+
+/* Name: LQR_state_type
  *
- * Description: LQR controller control block data type
+ * Description: state vector indices, eLQR_ST_<name> for every state of
+ *              LQR_STATE_TABLE (lqr_rig.h), in x_vec order
  *
- * Members: num_states - field contains number of states being monitored
- *                       by the LQR controller
- *          K          - pointer to array containing state feedback gains
- *                       (length of array must match value stored in num_states
- *                       field)
- *          Nbar       - field contains the pre-compensation constant to multiply
- *                       the reference input to the controller (for steady-state
- *                       error tracking)
- *          sp         - field contains the controller reference (set point)
+ * Members: eLQR_ST_MAX - number of states
  *
  * Notes:
  *
  */
-struct LQR_ctrl_blk_type
+#define LQR_ST_INDEX(name, dev, req, scale, a, b) eLQR_ST_##name,
+typedef enum
 {
-	uint32_t num_states;
-	const float *K; // controller state feedback gain vector
-	const float Nbar; // input precompensation coefficient (for steady-state error elimination)
-	float sp; // system input (set point);
-};
+	LQR_STATE_TABLE( LQR_ST_INDEX, ~, ~)
+	eLQR_ST_MAX,
+} LQR_state_type;
+
+
+/* straight-line kernels over the state vector, one term per state:
+ * LQR_DOT(v1, v2) is v1'*v2, LQR_COPY(dst, src), LQR_ADD(dst, src) and
+ * LQR_SUB(dst, src) assign, add and subtract element by element */
+#define LQR_DOT_TERM(name, dev, req, scale, v1, v2)  + (v1)[eLQR_ST_##name]*(v2)[eLQR_ST_##name]
+#define LQR_DOT(v1, v2)       ( 0.0f LQR_STATE_TABLE( LQR_DOT_TERM, v1, v2))
+#define LQR_COPY_TERM(name, dev, req, scale, dst, src) (dst)[eLQR_ST_##name] = (src)[eLQR_ST_##name];
+#define LQR_COPY(dst, src)    do { LQR_STATE_TABLE( LQR_COPY_TERM, dst, src) } while (0)
+#define LQR_ADD_TERM(name, dev, req, scale, dst, src)  (dst)[eLQR_ST_##name] += (src)[eLQR_ST_##name];
+#define LQR_ADD(dst, src)     do { LQR_STATE_TABLE( LQR_ADD_TERM, dst, src) } while (0)
+#define LQR_SUB_TERM(name, dev, req, scale, dst, src)  (dst)[eLQR_ST_##name] -= (src)[eLQR_ST_##name];
+#define LQR_SUB(dst, src)     do { LQR_STATE_TABLE( LQR_SUB_TERM, dst, src) } while (0)
 
 
 /* Name: LQR_pt_type
@@ -58,4 +78,284 @@ struct LQR_pt_type
 	float y;
 };
 
+
+/* Name: LQR_fric_type
+ *
+ * Description: dead band and friction compensation parameters (voltage
+ *              domain, see LQR_fric_comp)
+ *
+ * Members: v_db      - motor driver dead band inverse (V)
+ *          v_c       - Coulomb friction feed-forward; applied in the
+ *                      commanded direction while the cart is stuck and in
+ *                      the direction of motion once it moves (V)
+ *          b_v       - viscous friction feed-forward (V per m/s)
+ *          inv_v_eps - inverse of the speed band over which the Coulomb
+ *                      feed-forward follows the direction of motion (s/m)
+ *          inv_e_eps - inverse of the command band over which the
+ *                      command direction terms ramp in (1/V)
+ *
+ * Notes: all zero disables the stage; parameters are estimated by
+ *        host/fric_ident, the rig defaults are LQR_RIG_FRIC (lqr_rig.h)
+ *
+ */
+struct LQR_fric_type
+{
+	float v_db;
+	float v_c;
+	float b_v;
+	float inv_v_eps;
+	float inv_e_eps;
+};
+
+
+/* Name: LQR_model_type
+ *
+ * Description: continuous time plant model, x_vec' = A*x_vec + B*u, used
+ *              to predict the state over the sample to actuation latency
+ *
+ * Members: A - state matrix, in the coordinates of the state vector fed
+ *              to K (x_vec, LQR_Balance_CtrlVIn)
+ *          B - input vector, per V of controller output
+ *
+ * Notes: all zero disables the prediction; the rig model is
+ *        LQR_RIG_MODEL_A, LQR_RIG_MODEL_B (lqr_rig.h), e.g. the upright
+ *        A, B of host/sys_ident, with rows and columns negated where the
+ *        encoder sign conventions differ
+ *
+ */
+struct LQR_model_type
+{
+	float A[LQR_MAX_STATE][LQR_MAX_STATE];
+	float B[LQR_MAX_STATE];
+};
+
+
+/* Name: LQR_evt_type
+ *
+ * Description: event trigger of the event-triggered controller
+ *              (LQR_Balance_CtrlRunEvt)
+ *
+ * Members: P     - Lyapunov matrix of the closed loop, P > 0 solving
+ *                  (A - B*K)'*P + P*(A - B*K) = -Q, in the coordinates of
+ *                  K; V(z) = z'*P*z
+ *          on    - P is valid; off, the output is recomputed every period
+ *          sigma - relative threshold: the output is recomputed once
+ *                  V(e) > sigma*V(x) + eps, e being the deviation of the
+ *                  state from the one of the last update
+ *          eps   - absolute threshold; keeps encoder quantization from
+ *                  triggering updates near the upright
+ *
+ * Notes: the output held while V(e) <= sigma*V(x) keeps V decreasing for
+ *        sigma below (lambda_min(Q)/(2*|P*B*K|))^2 (relative to P); larger
+ *        values trade the guarantee for fewer updates. P must follow K:
+ *        LQR_evt_design derives it whenever the gains or the model change,
+ *        in the background (LQR_Balance_SetParams).
+ *
+ */
+struct LQR_evt_type
+{
+	float P[LQR_MAX_STATE][LQR_MAX_STATE];
+	uint32_t on;
+	float sigma;
+	float eps;
+};
+
+
+/* Name: LQR_dob_type
+ *
+ * Description: input disturbance observer; estimates the lumped voltage
+ *              d of x_vec' = A*x_vec + B*(u + d) (belt load, track tilt,
+ *              residual friction) from the plant model
+ *
+ * Members: bw  - observer bandwidth (rad/s); 0 disables the observer
+ *          k_x - bw*B'/(B'*B), gain of the state on the estimate
+ *          h   - B'*A/(B'*B), model drift projected on the input
+ *          g   - bw*LQR_TS, integrator gain per control period
+ *          lim - largest estimate magnitude (V)
+ *
+ * Notes: first order observer, d_hat = z + k_x*x_vec with
+ *        z' = -bw*(d_hat + h*x_vec + u), so that d_hat' = bw*(d - d_hat)
+ *        whatever the state trajectory. k_x, h and g are derived from bw
+ *        and the model (LQR_dob_design) when either changes; the control
+ *        period then costs two dot products (LQR_dob_run).
+ *
+ */
+struct LQR_dob_type
+{
+	float bw;
+	float k_x[LQR_MAX_STATE];
+	float h[LQR_MAX_STATE];
+	float g;
+	float lim;
+};
+
+
+/* Name: LQR_lqi_type
+ *
+ * Description: gains of the LQI controller (LQR_Balance_CtrlRunLQI), the
+ *              LQR of the plant augmented with xi, the integral of the
+ *              cart position error
+ *
+ * Members: K    - state feedback gain vector
+ *          Ki   - integral gain (V per m*s)
+ *          Nbar - set point feed-forward (V/m)
+ *          aw   - anti-windup back-calculation gain, 1/(Ki*Tt) with Tt
+ *                 the tracking time constant (m/V)
+ *
+ * Notes: u = Nbar*sp - K*x_vec - Ki*xi, with
+ *        xi' = (x - sp) - aw*(u_sat - u), u_sat the output the actuator
+ *        actually delivers (power map limits); designed offline by
+ *        host/lqi_design from the identified model.
+ *
+ */
+struct LQR_lqi_type
+{
+	float K[LQR_MAX_STATE];
+	float Ki;
+	float Nbar;
+	float aw;
+};
+
+
+/* Name: LQR_ff_type
+ *
+ * Description: model based feed-forward of a moving reference
+ *              (LQR_Balance_SetRef); the pendulum angle and the input
+ *              under which the plant model follows a cart velocity v and
+ *              acceleration a
+ *
+ * Members: th_v - angle per cart velocity (rad per m/s)
+ *          th_a - angle per cart acceleration (rad per m/s^2)
+ *          u_v  - input per cart velocity (V per m/s)
+ *          u_a  - input per cart acceleration (V per m/s^2)
+ *
+ * Notes: the cart and pendulum rows of the model (x_vec[2], x_vec[4])
+ *        solved for th and u with a = xdot' and thdot' = 0:
+ *            th = th_v*v + th_a*a,  u = u_v*v + u_a*a
+ *        the pendulum leans into the acceleration. Derived from the model
+ *        by LQR_ff_design; all zero (no model) restricts the reference
+ *        to the position.
+ *
+ */
+struct LQR_ff_type
+{
+	float th_v;
+	float th_a;
+	float u_v;
+	float u_a;
+};
+
+
+/* Name: LQR_param_bank_type
+ *
+ * Description: LQR controller parameter bank
+ *
+ * Members: K        - state feedback gain vector
+ *          Nbar     - pre-compensation constant to multiply the reference
+ *                     input to the controller (for steady-state error
+ *                     tracking)
+ *          pmap     - voltage to power (%) conversion map, sorted by
+ *                     voltage
+ *          pmap_len - number of valid points in pmap
+ *          fric     - dead band and friction compensation
+ *          model    - plant model of the latency predictor
+ *          evt      - event trigger
+ *          dob      - disturbance observer
+ *          lqi      - gains of the LQI controller
+ *          ff       - feed-forward of the moving reference
+ *
+ * Notes:
+ *
+ */
+struct LQR_param_bank_type
+{
+	float K[LQR_MAX_STATE];
+	float Nbar;
+	struct LQR_pt_type pmap[LQR_PMAP_MAX];
+	uint32_t pmap_len;
+	struct LQR_fric_type fric;
+	struct LQR_model_type model;
+	struct LQR_evt_type evt;
+	struct LQR_dob_type dob;
+	struct LQR_lqi_type lqi;
+	struct LQR_ff_type ff;
+};
+
+
+/* Name: LQR_ctrl_blk_type
+ *
+ * Description: LQR controller control block data type
+ *
+ * Members: bank       - parameter banks; the controller reads
+ *                       bank[active] only, the writer fills the other
+ *                       bank and publishes it by storing its index to
+ *                       active
+ *          active     - index of the bank in use (single 32-bit store)
+ *          sp         - field contains the controller reference (set point)
+ *          ref_v      - cart velocity reference (m/s)
+ *          ref_a      - cart acceleration reference (m/s^2)
+ *          ref_j      - cart jerk reference (m/s^3)
+ *          filt       - filter chains of the state channels and of the
+ *                       controller output (LQR_FILT_OUT); NULL passes the
+ *                       signal through
+ *          filt_src   - measured state each state channel filter reads
+ *                       (e.g. cart position for a differentiator feeding
+ *                       the cart velocity channel)
+ *          restart    - set to prime the filters with the next readings
+ *          t_sample   - time the state of the latest period was read
+ *                       (SYSTIME_Now, cycles)
+ *          lat        - latest measured latency, from the state reading
+ *                       to the PWM update applying the resulting output
+ *                       (cycles)
+ *          tau        - averaged latency (s); the prediction horizon
+ *          u_prev     - controller output of the latest period, applied
+ *                       over the latency of the current one (V)
+ *          x_last     - state of the latest update (event-triggered)
+ *          seq        - publish count of the parameter banks
+ *          seq_last   - publish count of the latest update
+ *          sp_last    - set point of the latest update
+ *          evt_hold   - control periods the output has been held
+ *          n_ticks    - control periods run event-triggered
+ *          n_updates  - of which recomputed the output
+ *          dob_x      - state of the latest period (disturbance
+ *                       observer, LQR_Balance_GetPosition)
+ *          d_hat      - disturbance estimate, subtracted from the
+ *                       controller output (V)
+ *          xi         - integral of the cart position error (LQI, m*s)
+ *
+ * Notes: there must be a single writer (LQR_Balance_SetParams, from the
+ *        background) and it must not preempt LQR_Balance_CtrlRun; the
+ *        controller then never sees a partially written bank. The same applies to the filters
+ *        (LQR_Balance_SetFilter). A publish stores active, then counts
+ *        seq; with two banks the active bank can come back to the same
+ *        slot between two control periods, seq cannot.
+ *
+ */
+struct LQR_ctrl_blk_type
+{
+	struct LQR_param_bank_type bank[LQR_NUM_BANKS];
+	volatile uint32_t active;
+	float sp; // system input (set point);
+	float ref_v;
+	float ref_a;
+	float ref_j;
+	struct DSP_filt_type *filt[LQR_NUM_FILT];
+	uint8_t filt_src[LQR_MAX_STATE];
+	volatile uint32_t restart;
+	uint64_t t_sample;
+	volatile uint32_t lat;
+	float tau;
+	float u_prev;
+	float x_last[LQR_MAX_STATE];
+	volatile uint32_t seq;
+	uint32_t seq_last;
+	float sp_last;
+	uint32_t evt_hold;
+	volatile uint32_t n_ticks;
+	volatile uint32_t n_updates;
+	float dob_x[LQR_MAX_STATE];
+	volatile float d_hat;
+	float xi;
+};
+
 #endif /* LQR_LQR_DEFS_H_ */
@@ -15,11 +15,40 @@
 
 /* module scope routines */
 extern float LQR_linmap( float input, const struct LQR_pt_type *p_map, const size_t map_len);
-extern float LQR_dot_f( const float *v1,  const float *v2, const uint32_t size);
+extern float LQR_dot_f( const float *v1,  const float *v2);
+extern float LQR_quad_f( const float *z, const float (*P)[LQR_MAX_STATE]);
+extern float LQR_fric_comp( float v, float xdot, const struct LQR_fric_type *f);
+extern void LQR_predict( float *x_vec, const struct LQR_model_type *m, float tau, float u);
+extern void LQR_dob_design( struct LQR_dob_type *dob, const struct LQR_model_type *m);
+extern void LQR_ff_design( struct LQR_ff_type *ff, const struct LQR_model_type *m);
+extern void LQR_evt_design( struct LQR_evt_type *evt, const struct LQR_model_type *m,
+                            const float *K, const float *q);
+extern float LQR_dob_run( const struct LQR_dob_type *dob, float d, float *x_prev,
+                          const float *x_vec, float u);
 
 /* global scope routines */
+extern void LQR_Balance_Init( void);
 extern void LQR_Balance_SetPoint( float val);
+extern float LQR_Balance_GetSetPoint( void);
+extern void LQR_Balance_SetRef( float pos, float vel, float acc, float jerk);
+extern float LQR_Balance_GetPosition( void);
+extern int LQR_Balance_SetParams( const float *K, float Nbar,
+                                  const struct LQR_pt_type *pmap, size_t pmap_len);
+extern void LQR_Balance_SetGains( const float *K, float Nbar);
+extern const struct LQR_param_bank_type *LQR_Balance_GetParams( void);
+extern void LQR_Balance_SetFriction( const struct LQR_fric_type *fric);
+extern int LQR_Balance_SetFilter( uint32_t ch, uint32_t src, struct DSP_filt_type *filt);
+extern void LQR_Balance_Restart( void);
+extern void LQR_Balance_SetModel( const struct LQR_model_type *model);
+extern uint32_t LQR_Balance_GetLatency( void);
 extern void LQR_Balance_CtrlRun( void);
+extern void LQR_Balance_CtrlRunEvt( void);
+extern void LQR_Balance_CtrlRunLQI( void);
+extern void LQR_Balance_SetTrigger( const struct LQR_evt_type *evt);
+extern void LQR_Balance_GetEventStats( uint32_t *ticks, uint32_t *updates);
+extern int LQR_Balance_SetObserver( float bw, float lim);
+extern float LQR_Balance_GetDisturbance( void);
+extern void LQR_Balance_SetLQI( const struct LQR_lqi_type *lqi);
 
 
 #endif /* LQR_LQR_PROTO_H_ */
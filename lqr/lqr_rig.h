@@ -0,0 +1,138 @@
+/*
+ * lqr_rig.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Milos Lazic
+ *
+ *  Compile-time description of the rig the balance controller runs on:
+ *  the state vector (order, sensor and scale of each state) and the
+ *  default gains. The single inverted pendulum is built by default;
+ *  defining LQR_RIG_DOUBLE (compiler command line) builds the double
+ *  inverted pendulum.
+ *
+ *  LQR_STATE_TABLE( ENTRY, a, b) expands ENTRY( name, dev, req, scale, a, b)
+ *  once per state, in x_vec order:
+ *      name  - state name; eLQR_ST_<name> is its index in x_vec
+ *      dev   - device read through dev_ioctl (eDEV_MAX: not measured,
+ *              reads zero)
+ *      req   - dev_ioctl request returning a float
+ *      scale - factor from the reading to the state (SI units)
+ *  a and b are passed through to ENTRY, so that the per-period kernels built
+ *  from the table (lqr_utils.c, lqr_balance.c) expand to straight-line
+ *  code for the state count; a state added here costs its own terms and
+ *  no loop.
+ *
+ *  Every rig has the X, XD, TH and THD states (cart, first link); the
+ *  set point, friction compensation and reference feed-forward use them.
+ */
+
+#ifndef LQR_LQR_RIG_H_
+#define LQR_LQR_RIG_H_
+
+
+#define LQR_SHAFT_RADIUS 0.0069358f  /* cart belt pulley radius (m) */
+
+/* dead band and friction compensation of the cart drive (LQR_fric_type:
+ * v_db, v_c, b_v, inv_v_eps, inv_e_eps), as printed by host/fric_ident;
+ * off until identified */
+#define LQR_RIG_FRIC     { 0, 0, 0, 100.0f, 10.0f }
+
+/* input disturbance observer (LQR_Balance_SetObserver): bandwidth (rad/s),
+ * 0 for none, and estimate limit (V); 0.1 rad/s leaves the RMS angle of
+ * host/sim/mc_bench within its spread, and removes a 0.5 V bias (25 mm
+ * cart offset) to 1.4 mm in 30 s */
+#define LQR_RIG_DOB_BW   0.1f
+#define LQR_RIG_DOB_LIM  3.0f
+
+/* state channel and output filters installed by LQR_Balance_Init:
+ * LQR_RIG_FILTERS( ENTRY) expands ENTRY( ch, src, filt) once per filter
+ * (see LQR_Balance_SetFilter), filt naming a struct DSP_filt_type of
+ * lqr_rig_filt.c; none by default */
+#define LQR_RIG_FILTERS(ENTRY)
+
+
+#ifndef LQR_RIG_DOUBLE
+
+/* single inverted pendulum on a cart */
+#define LQR_STATE_TABLE(ENTRY, a, b) \
+	ENTRY( I,    eDEV_MAX,  0,                    0.0f,             a, b) /* armature current; not measured (negligible) */ \
+	ENTRY( X,    eDEV_QEI1, eQEI_IOCTL_R_POS_RAD, LQR_SHAFT_RADIUS, a, b) /* cart position (m) */ \
+	ENTRY( XD,   eDEV_QEI1, eQEI_IOCTL_R_VEL_RAD, LQR_SHAFT_RADIUS, a, b) /* cart velocity (m/s) */ \
+	ENTRY( TH,   eDEV_QEI0, eQEI_IOCTL_R_POS_RAD, 1.0f,             a, b) /* pendulum angle (rad) */ \
+	ENTRY( THD,  eDEV_QEI0, eQEI_IOCTL_R_VEL_RAD, 1.0f,             a, b) /* pendulum angular velocity (rad/s) */
+
+#define LQR_RIG_K        { 0.0029, 20, 20.9179, -65.3129, -8 }
+#define LQR_RIG_NBAR     20
+
+/* diagonal of Q of the event trigger Lyapunov function (LQR_evt_design),
+ * 1/(tolerated deviation)^2: 0.1 m, 0.5 m/s, 0.05 rad, 0.5 rad/s; the
+ * armature current is left out */
+#define LQR_RIG_EVT_Q    { 0, 100.0f, 4.0f, 400.0f, 4.0f }
+
+/* upright plant model of the latency predictor, the disturbance observer
+ * and the reference feed-forward (LQR_model_type): the linearization of
+ * the simulated plant (host/sim defaults) in the controller frames, the
+ * cart states negated (QEI1 counts opposite to positive power); replace
+ * with the host/sys_ident A, B of the rig, transformed the same way */
+#define LQR_RIG_MODEL_A \
+	{ \
+		{ 0, 0,       0,       0,  0 }, \
+		{ 0, 0,       1,       0,  0 }, \
+		{ 0, 0,  -7.919,   1.401,  0 }, \
+		{ 0, 0,       0,       0,  1 }, \
+		{ 0, 0,  -29.70,   42.04,  0 }, \
+	}
+#define LQR_RIG_MODEL_B  { 0, 0, -2.746, 0, -10.30 }
+
+/* host/lqi_design on the simulated plant */
+#define LQR_RIG_LQI_K    { 0, 32.8347, 20.697, -50.7436, -8.35207 }
+#define LQR_RIG_LQI_KI   23.9655
+#define LQR_RIG_LQI_NBAR 32.8347
+#define LQR_RIG_LQI_AW   2.08633
+
+#else
+
+/* double inverted pendulum on a cart; the second link angle is read from
+ * the encoder device LQR_QEI_LINK2 */
+#ifndef LQR_QEI_LINK2
+#error "LQR_RIG_DOUBLE: define LQR_QEI_LINK2, the encoder device of the second link"
+#endif
+
+#define LQR_STATE_TABLE(ENTRY, a, b) \
+	ENTRY( I,    eDEV_MAX,      0,                    0.0f,             a, b) /* armature current; not measured */ \
+	ENTRY( X,    eDEV_QEI1,     eQEI_IOCTL_R_POS_RAD, LQR_SHAFT_RADIUS, a, b) /* cart position (m) */ \
+	ENTRY( XD,   eDEV_QEI1,     eQEI_IOCTL_R_VEL_RAD, LQR_SHAFT_RADIUS, a, b) /* cart velocity (m/s) */ \
+	ENTRY( TH,   eDEV_QEI0,     eQEI_IOCTL_R_POS_RAD, 1.0f,             a, b) /* first link angle (rad) */ \
+	ENTRY( THD,  eDEV_QEI0,     eQEI_IOCTL_R_VEL_RAD, 1.0f,             a, b) /* first link angular velocity (rad/s) */ \
+	ENTRY( TH2,  LQR_QEI_LINK2, eQEI_IOCTL_R_POS_RAD, 1.0f,             a, b) /* second link angle, relative (rad) */ \
+	ENTRY( THD2, LQR_QEI_LINK2, eQEI_IOCTL_R_VEL_RAD, 1.0f,             a, b) /* second link angular velocity (rad/s) */
+
+/* the plant model and the LQI gains have no command: designed for the rig
+ * (host/sys_ident, host/lqi_design), they are given on the compiler
+ * command line, e.g. -DLQR_RIG_MODEL_B="{ 0, 0, -2.7, 0, -10.3, 0, 4.1 }";
+ * the event trigger is derived from the model and the gains */
+#if !defined(LQR_RIG_MODEL_A) || !defined(LQR_RIG_MODEL_B)
+#error "LQR_RIG_DOUBLE: define LQR_RIG_MODEL_A and LQR_RIG_MODEL_B, the plant model of the rig"
+#endif
+#if !defined(LQR_RIG_LQI_K) || !defined(LQR_RIG_LQI_KI) || !defined(LQR_RIG_LQI_NBAR) || \
+    !defined(LQR_RIG_LQI_AW)
+#error "LQR_RIG_DOUBLE: define LQR_RIG_LQI_K, LQR_RIG_LQI_KI, LQR_RIG_LQI_NBAR and LQR_RIG_LQI_AW, the LQI gains of the rig"
+#endif
+
+/* state feedback gains: also loaded with eCMD_ID_SET_GAINS, none by
+ * default */
+#ifndef LQR_RIG_K
+#define LQR_RIG_K        { 0 }
+#endif
+#ifndef LQR_RIG_NBAR
+#define LQR_RIG_NBAR     0
+#endif
+
+/* event trigger weights (see the single pendulum); the second link as the
+ * first */
+#define LQR_RIG_EVT_Q    { 0, 100.0f, 4.0f, 400.0f, 4.0f, 400.0f, 4.0f }
+
+#endif /* LQR_RIG_DOUBLE */
+
+
+#endif /* LQR_LQR_RIG_H_ */
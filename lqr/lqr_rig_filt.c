@@ -0,0 +1,23 @@
+/*
+ * lqr_rig_filt.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Milos Lazic
+ *
+ *  Filter objects of the rig (LQR_RIG_FILTERS, lqr_rig.h), as printed by
+ *  host/dsp_design, e.g. a low-pass on the controller output:
+ *
+ *      dsp_design -f float -n vout_filt lp 500 >> lqr/lqr_rig_filt.c
+ *
+ *  and in lqr_rig.h
+ *
+ *      #define LQR_RIG_FILTERS(ENTRY) \
+ *          ENTRY( LQR_FILT_OUT, 0, vout_filt)
+ *
+ *  None by default: the states come straight from the encoders. The
+ *  default gains expect the QEI velocity readings; a differentiator on
+ *  the cart position (dsp_design sg) needs gains designed with it.
+ */
+
+#include "lqr_defs.h"
+#include "../dsp/dsp.h"
@@ -7,6 +7,16 @@
 
 #include "lqr_defs.h"
 #include "lqr_proto.h"
+#include "../sys/device/device.h"
+#include <math.h>
+
+
+#define LQR_EVT_PIV_MIN 1e-6f   /* smallest pivot of the event trigger design, relative */
+
+
+/* equations of LQR_evt_design: one row per unknown of P, right-hand side
+ * last; kept off the stack, which the control period shares */
+static DEV_STATE_CLASS float lqr_lyap[LQR_EVT_NU][LQR_EVT_NU + 1];
 
 
 /*
@@ -49,29 +59,363 @@ float LQR_linmap( float input, const struct LQR_pt_type *p_map, const size_t map
 /*
  * Name: LQR_dot_f
  *
- * Descr: Routine to compute the dot product of two equal-size
- *        vectors (vectors are represented as arrays of type float)
+ * Descr: Routine to compute the dot product of two state vectors
+ *        (vectors are represented as arrays of type float)
  *
  * Args:     v1 - field contains reference to vector (array) 1
  *           v2 - field contains reference to vector (array) 2
- *           size - length of vectors
  *
  * Return:   dot product of v1 and v2
  *
- * Notes:
+ * Notes: Unrolled for the state count (LQR_DOT)
+ *
+ */
+float LQR_dot_f( const float *v1,  const float *v2)
+{
+	return LQR_DOT( v1, v2);
+}
+
+
+/*
+ * Name: LQR_quad_f
+ *
+ * Descr: Routine to evaluate the quadratic form z'*P*z
+ *
+ * Args:     z - state vector
+ *           P - square matrix
+ *
+ * Return:   z'*P*z
+ *
+ * Notes: Unrolled for the state count, one LQR_dot_f per row
  *
  */
-float LQR_dot_f( const float *v1,  const float *v2, const uint32_t size)
+#define LQR_QUAD_TERM(name, dev, req, scale, z, P) \
+	+ (z)[eLQR_ST_##name]*LQR_dot_f( (P)[eLQR_ST_##name], (z))
+
+float LQR_quad_f( const float *z, const float (*P)[LQR_MAX_STATE])
 {
-	float res = 0.0;
-	int i = 0;
+	return ( 0.0f LQR_STATE_TABLE( LQR_QUAD_TERM, z, P));
+}
+
+
+/*
+ * Name: LQR_fric_comp
+ *
+ * Descr: Dead band and friction compensation stage; adds to a voltage
+ *        command the voltage lost to the motor driver dead band and to
+ *        cart friction
+ *
+ * Args:     v    - voltage command
+ *           xdot - cart velocity in the direction driven by positive
+ *                  voltage (m/s)
+ *           f    - compensation parameters
+ *
+ * Return:   compensated voltage command
+ *
+ * Notes: u = v + s_v*v_db + (s_x + (1 - |s_x|)*s_v)*v_c + b_v*xdot,
+ *        where s_x = sat(xdot/v_eps) and s_v = sat(v/e_eps); the stuck
+ *        cart gets the full breakaway voltage v_db + v_c in the commanded
+ *        direction, the moving cart gets the Coulomb term in the direction
+ *        of motion. The saturated ramps avoid chattering around zero
+ *        velocity and zero command.
+ *
+ */
+float LQR_fric_comp( float v, float xdot, const struct LQR_fric_type *f)
+{
+	float s_x = xdot * f->inv_v_eps;
+	float s_v = v * f->inv_e_eps;
+	float a_x;
+
+	if ( s_x > 1.0f)
+		s_x = 1.0f;
+	else if ( s_x < -1.0f)
+		s_x = -1.0f;
+
+	if ( s_v > 1.0f)
+		s_v = 1.0f;
+	else if ( s_v < -1.0f)
+		s_v = -1.0f;
 
-	for ( ; i < size; i++)
+	a_x = ( s_x < 0) ? -s_x : s_x;
+
+	return v + s_v*f->v_db + (s_x + (1.0f - a_x)*s_v)*f->v_c + f->b_v*xdot;
+}
+
+
+/*
+ * Name: LQR_predict
+ *
+ * Descr: Routine to advance the state vector over a short horizon with
+ *        the plant model, the input held constant
+ *
+ * Args:     x_vec - state vector; replaced by the prediction
+ *           m     - plant model
+ *           tau   - horizon (s)
+ *           u     - input applied over the horizon (V)
+ *
+ * Return:   none
+ *
+ * Notes: One Euler step, x + tau*(A*x + B*u); the horizon is a fraction
+ *        of a control period, far below the fastest plant time constant,
+ *        so the higher order terms of the exponential are negligible.
+ *        Unrolled for the state count, one LQR_dot_f per row.
+ *
+ */
+#define LQR_PRED_TERM(name, dev, req, scale, dx, x_vec) \
+	(dx)[eLQR_ST_##name] = tau*( LQR_dot_f( m->A[eLQR_ST_##name], (x_vec)) + m->B[eLQR_ST_##name]*u);
+
+void LQR_predict( float *x_vec, const struct LQR_model_type *m, float tau, float u)
+{
+	float dx[LQR_MAX_STATE];
+
+	LQR_STATE_TABLE( LQR_PRED_TERM, dx, x_vec)
+	LQR_ADD( x_vec, dx);
+}
+
+
+/*
+ * Name: LQR_dob_design
+ *
+ * Descr: Routine to derive the disturbance observer gains from its
+ *        bandwidth and the plant model
+ *
+ * Args:     dob  - observer; bw and lim set, gains replaced
+ *           m    - plant model
+ *
+ * Return:   none
+ *
+ * Notes: A model without input (B = 0) or a zero bandwidth zeroes the
+ *        gains, which holds the estimate at zero.
+ *
+ */
+void LQR_dob_design( struct LQR_dob_type *dob, const struct LQR_model_type *m)
+{
+	float bb = LQR_dot_f( m->B, m->B);
+	uint32_t i, j;
+
+	if ( dob->bw <= 0 || bb <= 0)
 	{
-		res += v1[i] * v2[i];
+		for ( i = 0; i < LQR_MAX_STATE; i++)
+			dob->k_x[i] = dob->h[i] = 0;
+		dob->g = 0;
+		return;
 	}
 
-	return res;
+	for ( i = 0; i < LQR_MAX_STATE; i++)
+	{
+		dob->k_x[i] = dob->bw*m->B[i]/bb;
+		dob->h[i] = 0;
+		for ( j = 0; j < LQR_MAX_STATE; j++)
+			dob->h[i] += m->B[j]*m->A[j][i];
+		dob->h[i] /= bb;
+	}
+	dob->g = dob->bw*LQR_TS;
 }
 
 
+/*
+ * Name: LQR_ff_design
+ *
+ * Descr: Routine to derive the feed-forward of a moving reference from
+ *        the plant model
+ *
+ * Args:     ff - feed-forward; replaced
+ *           m  - plant model
+ *
+ * Return:   none
+ *
+ * Notes: See LQR_ff_type. A model whose angle and input cannot be solved
+ *        for (e.g. all zero) zeroes the feed-forward.
+ *
+ */
+void LQR_ff_design( struct LQR_ff_type *ff, const struct LQR_model_type *m)
+{
+	const float *a_xd = m->A[eLQR_ST_XD], *a_thd = m->A[eLQR_ST_THD];
+	float b_xd = m->B[eLQR_ST_XD], b_thd = m->B[eLQR_ST_THD];
+	float det = a_xd[eLQR_ST_TH]*b_thd - a_thd[eLQR_ST_TH]*b_xd;
+
+	if ( det == 0)
+	{
+		ff->th_v = ff->th_a = ff->u_v = ff->u_a = 0;
+		return;
+	}
+
+	ff->th_a = b_thd/det;
+	ff->th_v = -( a_xd[eLQR_ST_XD]*b_thd - a_thd[eLQR_ST_XD]*b_xd)/det;
+	ff->u_a = -a_thd[eLQR_ST_TH]/det;
+	ff->u_v = ( a_thd[eLQR_ST_TH]*a_xd[eLQR_ST_XD] - a_xd[eLQR_ST_TH]*a_thd[eLQR_ST_XD])/det;
+}
+
+
+/* index of the unknown P(i,j) = P(j,i) among the n*(n+1)/2 of LQR_evt_design */
+static uint32_t LQR_evt_idx( uint32_t i, uint32_t j, uint32_t n)
+{
+	uint32_t t;
+
+	if ( i > j)
+	{
+		t = i;
+		i = j;
+		j = t;
+	}
+
+	return i*(2*n - i + 1)/2 + j - i;
+}
+
+
+/*
+ * Name: LQR_evt_design
+ *
+ * Descr: Routine to derive the Lyapunov matrix of the event trigger from
+ *        the state feedback gains and the plant model
+ *
+ * Args:     evt - trigger; sigma and eps set, P and on replaced
+ *           m   - plant model
+ *           K   - state feedback gains (LQR_MAX_STATE entries)
+ *           q   - diagonal of Q (LQR_MAX_STATE entries); states weighted
+ *                 zero are left out of V
+ *
+ * Return:   none
+ *
+ * Notes: Solves (A - B*K)'*P + P*(A - B*K) = -Q over the weighted states,
+ *        by Gaussian elimination on the n*(n + 1)/2 unknowns of the
+ *        symmetric P (10 for the single pendulum). A closed loop that is
+ *        not stable on the model (no model at all, or gains that do not
+ *        suit it) has no P > 0: the trigger is turned off (see
+ *        LQR_evt_type) rather than left with a P of other gains.
+ *        Background context only (LQR_Balance_Init, CMD_Apply): about
+ *        450 multiply-adds for the single pendulum and 3500 for the
+ *        double (21 unknowns), beyond the budget of a control period.
+ *
+ */
+void LQR_evt_design( struct LQR_evt_type *evt, const struct LQR_model_type *m,
+                     const float *K, const float *q)
+{
+	float Ac[LQR_MAX_STATE][LQR_MAX_STATE];
+	uint8_t s[LQR_MAX_STATE];
+	uint32_t n, nu, i, j, k, r, c;
+	float t, big;
+
+	evt->on = 0;
+	for ( i = 0; i < LQR_MAX_STATE; i++)
+		for ( j = 0; j < LQR_MAX_STATE; j++)
+			evt->P[i][j] = 0;
+
+	/* closed loop over the weighted states */
+	for ( i = 0, n = 0; i < LQR_MAX_STATE; i++)
+		if ( q[i] > 0)
+			s[n++] = (uint8_t)i;
+	for ( i = 0; i < n; i++)
+		for ( j = 0; j < n; j++)
+			Ac[i][j] = m->A[s[i]][s[j]] - m->B[s[i]]*K[s[j]];
+
+	/* row of P(i,j), i <= j:
+	 * sum_k Ac(k,i)*P(k,j) + P(i,k)*Ac(k,j) = -q(i) if i == j, else 0 */
+	nu = n*(n + 1)/2;
+	big = 0;
+	for ( i = 0, r = 0; i < n; i++)
+		for ( j = i; j < n; j++, r++)
+		{
+			for ( c = 0; c < nu; c++)
+				lqr_lyap[r][c] = 0;
+			for ( k = 0; k < n; k++)
+			{
+				lqr_lyap[r][LQR_evt_idx( k, j, n)] += Ac[k][i];
+				lqr_lyap[r][LQR_evt_idx( i, k, n)] += Ac[k][j];
+			}
+			for ( c = 0; c < nu; c++)
+				big = fmaxf( big, fabsf( lqr_lyap[r][c]));
+			lqr_lyap[r][nu] = ( i == j) ? -q[s[i]] : 0;
+		}
+
+	/* forward elimination, partial pivoting */
+	for ( c = 0; c < nu; c++)
+	{
+		for ( r = c + 1, k = c; r < nu; r++)
+			if ( fabsf( lqr_lyap[r][c]) > fabsf( lqr_lyap[k][c]))
+				k = r;
+		if ( !( fabsf( lqr_lyap[k][c]) > LQR_EVT_PIV_MIN*big))
+			return;
+		for ( j = c; j <= nu && k != c; j++)
+		{
+			t = lqr_lyap[c][j];
+			lqr_lyap[c][j] = lqr_lyap[k][j];
+			lqr_lyap[k][j] = t;
+		}
+		for ( r = c + 1; r < nu; r++)
+		{
+			t = lqr_lyap[r][c]/lqr_lyap[c][c];
+			for ( j = c; j <= nu; j++)
+				lqr_lyap[r][j] -= t*lqr_lyap[c][j];
+		}
+	}
+
+	/* back substitution, the solution replacing the right-hand side */
+	for ( c = nu; c-- > 0; )
+	{
+		t = lqr_lyap[c][nu];
+		for ( j = c + 1; j < nu; j++)
+			t -= lqr_lyap[c][j]*lqr_lyap[j][nu];
+		lqr_lyap[c][nu] = t/lqr_lyap[c][c];
+	}
+
+	/* P > 0: every pivot of its LDL' factorization positive (L, D
+	 * in Ac) */
+	for ( i = 0; i < n; i++)
+		for ( j = 0; j <= i; j++)
+		{
+			t = lqr_lyap[LQR_evt_idx( i, j, n)][nu];
+			for ( k = 0; k < j; k++)
+				t -= Ac[i][k]*Ac[j][k]*Ac[k][k];
+			if ( i == j && !( t > 0))
+				return;
+			Ac[i][j] = ( i == j) ? t : t/Ac[j][j];
+		}
+
+	for ( i = 0; i < n; i++)
+		for ( j = 0; j < n; j++)
+			evt->P[s[i]][s[j]] = lqr_lyap[LQR_evt_idx( i, j, n)][nu];
+	evt->on = 1;
+}
+
+
+/*
+ * Name: LQR_dob_run
+ *
+ * Descr: Routine to advance the disturbance observer by one control
+ *        period
+ *
+ * Args:     dob    - observer
+ *           d      - disturbance estimate of the last period (V)
+ *           x_prev - state vector of the last period; replaced by x_vec
+ *           x_vec  - state vector read this period
+ *           u      - controller output applied over the last period (V)
+ *
+ * Return:   disturbance estimate (V)
+ *
+ * Notes: d += k_x*(x_vec - x_prev) - g*(d + h*x_prev + u), the Euler step
+ *        of the observer (LQR_dob_type) written on the estimate itself,
+ *        so that new gains take effect without a jump. The estimate is
+ *        limited to +/-lim, which also keeps it from winding up on a
+ *        disturbance beyond the limit. Unrolled for the state count.
+ *
+ */
+float LQR_dob_run( const struct LQR_dob_type *dob, float d, float *x_prev, const float *x_vec,
+                   float u)
+{
+	float dx[LQR_MAX_STATE];
+
+	LQR_COPY( dx, x_vec);
+	LQR_SUB( dx, x_prev);
+
+	d += LQR_DOT( dob->k_x, dx) - dob->g*( d + LQR_DOT( dob->h, x_prev) + u);
+
+	LQR_COPY( x_prev, x_vec);
+
+	if ( d > dob->lim)
+		return dob->lim;
+	if ( d < -dob->lim)
+		return -dob->lim;
+
+	return d;
+}
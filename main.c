@@ -10,11 +10,19 @@
 
 #include "fl/fl.h"
 #include "lqr/lqr.h"
+#include "fsm/fsm.h"
+#include "cmd/cmd.h"
+#include "log/log.h"
+#include "ilc/ilc.h"
 #include "sys/device/device.h"
-#include "driverlib/sysctl.h"
+#include "sys/systime/systime.h"
 
 
 
+/* ultrasonic ranging period; the sensor requires >= 60 ms between
+ * measurements */
+#define PRS_PERIOD SYSTIME_SEC(0.066)
+
 #define container_of(ptr, type, member) ({  \
         const void *__mptr = (ptr);    \
         (type *)( (char *)__mptr - offsetof(type,member) );})
@@ -23,6 +31,20 @@
 static void UART_write(const char *buf);
 
 
+// free-running profiling timer (timer_dev_alloc); -1 if not allocated
+static int prof_timer = -1;
+
+// allocate and start the profiling timer
+static void Prof_Init(void)
+{
+	prof_timer = timer_dev_alloc(0, "prof");
+	if ( prof_timer < 0)
+		return;
+	dev_ioctl(prof_timer, eTIMER_CONFIG, eTIMER_MODE_FREERUN, 0);
+	dev_ioctl(prof_timer, eTIMER_ENABLE);
+}
+
+
 
 // enable FPU
 void FPU_enable(uint32_t s)
@@ -56,7 +78,16 @@ static void SysTick_Init( uint32_t period)
 void SysTick_Handler(void)
 {
 #ifndef __DEBUG__
-	LQR_Balance_CtrlRun();
+	/* apply queued serial commands at a fixed point of the period */
+	CMD_Drain();
+	FSM_Run();
+	/* black box: record this period's state and the staged power */
+	LOG_BB_Tick();
+	/* scope capture, when armed */
+	LOG_SC_Tick();
+	/* commit motor power (duty and direction together) and any PWM
+	 * period change at the next PWM period boundary */
+	dev_ioctl(eDEV_ESC0, eESC_IOCTL_SYNC);
 #else
 	/* The following code is used to record the system response
 	 * for system identification purposes. Data is serially transmitted
@@ -87,10 +118,11 @@ void SysTick_Handler(void)
 
 	if ( ++time_5ms == 150) // run for 1000 ms
 	{
-		time_val = TIMER0_TAR_R;
+		time_val = dev_ioctl(prof_timer, eTIMER_READ);
 		// disable
-		TIMER0_CTL_R &= ~(0x00000001);
+		dev_ioctl(prof_timer, eTIMER_DISABLE);
 		dev_ioctl(eDEV_ESC0, eESC_IOCTL_SET_POWER, 0);
+		dev_ioctl(eDEV_ESC0, eESC_IOCTL_SYNC);
 		while(1);
 	}
 #endif
@@ -112,30 +144,24 @@ static void UART_write(const char *buf)
 }
 
 
-// debugging
-volatile float setpoint = 0;
-void UART0_InterruptHandler(void)
+// transmit a binary buffer (blocking)
+static void UART_send(const uint8_t *buf, size_t len)
 {
-	uint8_t data;
-
-	while(!(UART0_FR_R & 0x00000010))
+	while(len--)
 	{
-		data = UART0_DR_R;
-		// echo data
-
-		if ( data == 'a')
-		{
-			setpoint = setpoint + 0.15;
-		}
-		else if ( data == 'd')
-		{
-			setpoint = setpoint - 0.15;
-		}
+		while(UART0_FR_R & 0x00000020) {}; // wait while TX FIFO is full
+		UART0_DR_R = *buf++;
+	}
+}
 
-		LQR_Balance_SetPoint(setpoint);
 
-		UART_write("\r\n RXd: ");
-		UART0_DR_R = data;
+// serial command channel receiver; frames are parsed here and queued
+// for the control period (see CMD_Drain)
+void UART0_InterruptHandler(void)
+{
+	while(!(UART0_FR_R & 0x00000010))
+	{
+		CMD_RxByte((uint8_t)UART0_DR_R);
 	}
 
 	/* acknowledge interrupt (clear interrupt flag */
@@ -219,6 +245,7 @@ static void sandbox(void)
 	dev_init(eDEV_QEI0);
 	dev_init(eDEV_QEI1);
 	dev_init(eDEV_ESC0);
+	Prof_Init();
 
 	FPU_enable(1);
 
@@ -228,6 +255,7 @@ static void sandbox(void)
 	dev_ioctl(eDEV_QEI1, eQEI_IOCTL_W_POS, 0); // zero the position
 
 	dev_ioctl(eDEV_ESC0, eESC_IOCTL_SET_POWER, -100);
+	dev_ioctl(eDEV_ESC0, eESC_IOCTL_SYNC);
 
 	//SysTick_Init(0x270FF); // send interrupt to NVIC every 2ms (500 Hz)
 	SysTick_Init(0x61A7F); // send interrupt to NVIC every 5ms (200 Hz)
@@ -237,38 +265,31 @@ static void sandbox(void)
 
 int main(void)
 {
+#ifndef __DEBUG__
+	uint8_t frame[CMD_TX_MAX_LEN + 3];
+	size_t len;
+	uint64_t t_prs = 0;
+#endif
 
 #ifdef __DEBUG__
 	sandbox();
 #else
-	int32_t val = 0;
-
 	dev_init(eDEV_PLL); // 80 MHz
+	SYSTIME_Init(); // 64-bit timestamps (wide timer)
 	dev_init(eDEV_QEI0);
 	dev_init(eDEV_QEI1);
 	dev_init(eDEV_ESC0);
-	dev_init(eDEV_PRS0);
-	dev_init(eDEV_TIMER0);
-
-
-	dev_ioctl(eDEV_QEI0, eQEI_IOCTL_W_POS, 0);
-	dev_ioctl(eDEV_QEI1, eQEI_IOCTL_W_POS, 0);
+	dev_init(eDEV_PRS0); // allocates its echo timer
+	Prof_Init();
 
 
 	FPU_enable(1);
 	UART_Init();
 
 
-	/* wait until pendulum is upright to start control algorithm */
-	/* TBD: will be replaced when swingup is implemented */
-	SysCtlDelay(SysCtlClockGet()/3); // delay ~ 1 second
-	dev_ioctl(eDEV_QEI0, eQEI_IOCTL_W_POS, 0x00000000);
-	val = dev_ioctl(eDEV_QEI0, eQEI_IOCTL_R_POS);
-	while( val <= 1199 && val >= -1199)
-	{
-		val = dev_ioctl(eDEV_QEI0, eQEI_IOCTL_R_POS);
-	}
-	dev_ioctl(eDEV_QEI0, eQEI_IOCTL_W_POS, 0x00000000);
+	/* motor off, encoders zeroed; the FSM then calibrates the track
+	 * (end stops, encoder zeros, ultrasonic fit) before swinging up */
+	FSM_Init();
 
 
 	/* initialize SysTick timer */
@@ -277,6 +298,39 @@ int main(void)
 
 	while(1)
 	{
-		// loop forever
+#ifndef __DEBUG__
+		/* background: ultrasonic ranging for the collision predictor
+		 * cross-check and the calibration fit, every PRS_PERIOD; the loop
+		 * runs freely in between, so that the frames below go out back
+		 * to back */
+		if ( SYSTIME_Now() - t_prs >= PRS_PERIOD)
+		{
+			t_prs = SYSTIME_Now();
+			FSM_CW_PrsUpdate(dev_ioctl(eDEV_PRS0, ePRS_IOCTL_DISTMSR));
+		}
+
+		/* new gains from the command channel; the control period keeps
+		 * the active bank until they are published */
+		CMD_Apply();
+
+		/* learning update after a completed trial */
+		ILC_Learn();
+
+		/* serial command channel statistics reply */
+		len = CMD_StatsFrame(frame, sizeof(frame));
+		if ( len)
+			UART_send(frame, len);
+
+		/* black box dump after a fault; one frame per pass, the UART
+		 * paces the loop */
+		len = CMD_BBoxFrame(frame, sizeof(frame));
+		if ( len)
+			UART_send(frame, len);
+
+		/* completed scope capture; as the black box dump */
+		len = CMD_ScopeFrame(frame, sizeof(frame));
+		if ( len)
+			UART_send(frame, len);
+#endif
 	}
 }
@@ -0,0 +1,16 @@
+/*
+ * swu.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Milos Lazic
+ */
+
+#ifndef SWINGUP_SWU_H_
+#define SWINGUP_SWU_H_
+
+#include "swu_defs.h"
+#include "swu_proto.h"
+
+
+
+#endif /* SWINGUP_SWU_H_ */
@@ -0,0 +1,268 @@
+/*
+ * swu_ctrl.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Milos Lazic
+ */
+
+#include "swu_defs.h"
+#include "swu_proto.h"
+#include "../sys/device/device.h"
+
+
+#define SHAFT_RADIUS 0.0069358   /* shaft radius (m) */
+#define SWU_QEI_PPR  2400        /* pendulum encoder counts per revolution */
+#define SWU_PI       3.14159265359f
+
+#define SWU_CTRL_PERIOD  0.0001f /* control period (s); SysTick runs at 10 kHz */
+
+/* pendulum natural frequency squared, m*g*l/J (rad^2/s^2); from pendulum
+ * geometry (l = 0.2 m to centre of mass, rod treated as a point mass plus
+ * uniform rod) */
+#define SWU_W0_SQ        36.8f
+#define SWU_W0           6.066f  /* sqrt(SWU_W0_SQ) (rad/s) */
+#define SWU_L_EQ         (9.81f/SWU_W0_SQ) /* equivalent point mass length (m) */
+
+/* energy reference; slightly above the upright energy (zero) so that the
+ * pendulum arrives at the top with some margin against friction losses */
+#define SWU_E_REF        (0.1f * SWU_W0_SQ)
+
+#define SWU_KE           0.3f    /* energy pumping gain (V per rad^2/s^2) */
+#define SWU_V_PUMP_MAX   5.0f    /* energy pumping voltage limit (V) */
+
+/* cart centering gains; NOTE: opposite sign to the LQR position gains since
+ * the swing-up controller is not stabilizing the upright (non-minimum phase)
+ * equilibrium */
+#define SWU_KX           2.0f    /* V/m */
+#define SWU_KXD          0.5f    /* V/(m/s) */
+
+/* default cart travel (m, either side of the track centre) beyond which
+ * energy pumping is suspended and only centering acts; replaced by
+ * SWU_SetXLimit once the track is calibrated */
+#define SWU_X_LIMIT      0.25f
+
+/* capture region; hand over to the balancing controller when the pendulum
+ * is within SWU_CAPTURE_ANGLE of upright and slower than SWU_CAPTURE_RATE,
+ * and the catch fits on the track: the capture point of the pendulum (the
+ * cart position above which it comes to rest upright), carried on by the
+ * cart over SWU_CAPTURE_T, must be inside the travel limit */
+#define SWU_CAPTURE_ANGLE 0.3f   /* rad */
+#define SWU_CAPTURE_RATE  4.0f   /* rad/s */
+#define SWU_CAPTURE_T     0.15f  /* s */
+#define SWU_CAPTURE_COUNTS ((int32_t)(SWU_CAPTURE_ANGLE*SWU_QEI_PPR/(2.0f*SWU_PI)))
+
+
+/* convert swing-up voltage to motor power (%); see VOLTAGE_TO_POWER_MAP
+ * in lqr_balance.c */
+static const struct SWU_pt_type VOLTAGE_TO_POWER_MAP[] =
+{
+		/* voltage, input power to motor (%) */
+		{ -12.0,  -100.0 },
+		{  12.0,   100.0 },
+};
+#define VOLTAGE_TO_POWER_MAP_LEN (sizeof(VOLTAGE_TO_POWER_MAP)/sizeof(VOLTAGE_TO_POWER_MAP[0]))
+
+
+// swing-up controller control block
+static struct SWU_ctrl_blk_type scb =
+{
+		.hist_idx = 0,
+		.primed = 0,
+		.status = eSWU_STATUS_PUMPING,
+		.energy = 0,
+		.x_limit = SWU_X_LIMIT,
+};
+
+
+/*
+ * Name: SWU_wrap_upright
+ *
+ * Descr: Converts a raw pendulum encoder count (zero with the pendulum
+ *        hanging at rest) to counts relative to the upright position
+ *
+ * Args:     counts - raw encoder count
+ *
+ * Return:   count relative to upright, in range [-PPR/2, PPR/2)
+ *
+ * Notes:
+ *
+ */
+static int32_t SWU_wrap_upright( int32_t counts)
+{
+	int32_t c = (counts - SWU_QEI_PPR/2) % SWU_QEI_PPR;
+
+	if ( c >= SWU_QEI_PPR/2)
+		c -= SWU_QEI_PPR;
+	else if ( c < -SWU_QEI_PPR/2)
+		c += SWU_QEI_PPR;
+
+	return c;
+}
+
+
+/*
+ * Name: SWU_Reset
+ *
+ * Descr: Re-arms the swing-up controller
+ *
+ * Args:     none
+ *
+ * Return:   none
+ *
+ * Notes: Must be called before re-entering swing-up after a hand over,
+ *        with the pendulum angle encoder zeroed in the hanging position
+ *
+ */
+void SWU_Reset( void)
+{
+	scb.hist_idx = 0;
+	scb.primed = 0;
+	scb.status = eSWU_STATUS_PUMPING;
+	scb.energy = 0;
+}
+
+
+/*
+ * Name: SWU_SetXLimit
+ *
+ * Descr: Sets the cart travel beyond which energy pumping is suspended
+ *
+ * Args:     x_limit - travel either side of the track centre (m)
+ *
+ * Return:   none
+ *
+ * Notes:
+ *
+ */
+void SWU_SetXLimit( float x_limit)
+{
+	scb.x_limit = x_limit;
+}
+
+
+/*
+ * Name: SWU_CtrlRun
+ *
+ * Descr: Energy-based swing-up controller; called once per control period.
+ *        Pumps pendulum energy towards the upright energy by accelerating
+ *        the cart in phase with th'cos(th), keeps the cart inside the
+ *        track limits and checks the capture region
+ *
+ * Args:     none
+ *
+ * Return:   eSWU_STATUS_CAPTURED on the control period in which the pendulum
+ *           enters the capture region, eSWU_STATUS_PUMPING otherwise
+ *
+ * Notes: The pendulum angle encoder (QEI0) must be zeroed with the pendulum
+ *        hanging at rest. On capture the encoder is re-zeroed to the upright
+ *        position (as expected by LQR_Balance_CtrlRun) and the motor
+ *        output is set to zero.
+ *
+ *        The angular velocity is differentiated over SWU_VEL_WIN control
+ *        periods rather than read from the QEI velocity timer (50 ms), whose
+ *        lag corrupts the energy estimate near the top of the swing.
+ *
+ */
+SWU_status_type SWU_CtrlRun( void)
+{
+	int32_t th_cnt, old_cnt, up_cnt;
+	float th, thdot, x, xdot, val;
+	float c, v_in, power_in, th_up, x_cp;
+
+	if ( scb.status == eSWU_STATUS_CAPTURED)
+		return scb.status;
+
+	/* get raw angular position of the pendulum (zero hanging) */
+	th_cnt = dev_ioctl(eDEV_QEI0, eQEI_IOCTL_R_POS);
+
+	if ( !scb.primed)
+	{
+		for ( scb.hist_idx = 0; scb.hist_idx < SWU_VEL_WIN; scb.hist_idx++)
+			scb.th_hist[scb.hist_idx] = th_cnt;
+		scb.hist_idx = 0;
+		scb.primed = 1;
+	}
+
+	/* differentiate angle over the window; replace oldest sample */
+	old_cnt = scb.th_hist[scb.hist_idx];
+	scb.th_hist[scb.hist_idx] = th_cnt;
+	if ( ++scb.hist_idx == SWU_VEL_WIN)
+		scb.hist_idx = 0;
+
+	th = (float)th_cnt * (2.0f*SWU_PI/SWU_QEI_PPR);
+	thdot = (float)(th_cnt - old_cnt) * (2.0f*SWU_PI/SWU_QEI_PPR) / (SWU_VEL_WIN*SWU_CTRL_PERIOD);
+
+	/* get position and velocity of the cart along the track */
+	(void) dev_ioctl(eDEV_QEI1, eQEI_IOCTL_R_POS_RAD, &val);
+	x = val * (float)SHAFT_RADIUS;
+	(void) dev_ioctl(eDEV_QEI1, eQEI_IOCTL_R_VEL_RAD, &val);
+	xdot = val * (float)SHAFT_RADIUS;
+
+	/* capture region check */
+	up_cnt = SWU_wrap_upright( th_cnt);
+	if ( up_cnt < SWU_CAPTURE_COUNTS && up_cnt > -SWU_CAPTURE_COUNTS &&
+		 thdot < SWU_CAPTURE_RATE && thdot > -SWU_CAPTURE_RATE &&
+		 x < scb.x_limit && x > -scb.x_limit)
+	{
+		/* capture point, x + l*sin(th) + (x' + l*th'*cos(th))/w0 with the
+		 * cart position counted positive in the direction of positive th;
+		 * the cart encoder counts the other way */
+		th_up = (float)up_cnt * (2.0f*SWU_PI/SWU_QEI_PPR);
+		x_cp = x + SWU_CAPTURE_T*xdot - SWU_L_EQ*SWU_sin( th_up) +
+			   (xdot - SWU_L_EQ*thdot*SWU_cos( th_up)) / SWU_W0;
+
+		if ( x_cp < scb.x_limit && x_cp > -scb.x_limit)
+		{
+			/* re-zero angle encoder to the upright position */
+			dev_ioctl(eDEV_QEI0, eQEI_IOCTL_W_POS, up_cnt);
+			dev_ioctl(eDEV_ESC0, eESC_IOCTL_SET_POWER, 0);
+
+			scb.status = eSWU_STATUS_CAPTURED;
+			return scb.status;
+		}
+	}
+
+	/* normalized pendulum energy; zero at upright rest, -2*w0^2 hanging */
+	c = SWU_cos( th);
+	scb.energy = 0.5f*thdot*thdot - SWU_W0_SQ*(c + 1.0f);
+
+	/* pump energy: d(E)/dt is proportional to u*th'*cos(th) */
+	v_in = 0;
+	if ( x < scb.x_limit && x > -scb.x_limit)
+	{
+		v_in = SWU_KE * (SWU_E_REF - scb.energy);
+		if ( v_in > SWU_V_PUMP_MAX)
+			v_in = SWU_V_PUMP_MAX;
+		else if ( v_in < -SWU_V_PUMP_MAX)
+			v_in = -SWU_V_PUMP_MAX;
+
+		if ( thdot*c < 0)
+			v_in = -v_in;
+	}
+
+	/* keep the cart near the centre of the track */
+	v_in += SWU_KX*x + SWU_KXD*xdot;
+
+	power_in = SWU_linmap( v_in, VOLTAGE_TO_POWER_MAP, VOLTAGE_TO_POWER_MAP_LEN);
+	dev_ioctl(eDEV_ESC0, eESC_IOCTL_SET_POWER_F, power_in);
+
+	return scb.status;
+}
+
+
+/*
+ * Name: SWU_GetStatus
+ *
+ * Descr: Routine to read the swing-up controller status
+ *
+ * Args:     none
+ *
+ * Return:   status reported on the most recent control period
+ *
+ * Notes:
+ *
+ */
+SWU_status_type SWU_GetStatus( void)
+{
+	return scb.status;
+}
@@ -0,0 +1,87 @@
+/*
+ * swu_defs.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Milos Lazic
+ */
+
+#ifndef SWINGUP_SWU_DEFS_H_
+#define SWINGUP_SWU_DEFS_H_
+
+
+#include <stdlib.h>
+#include <stdint.h>
+
+
+#define SWU_SIN_TBL_LEN 256      /* sine table entries per revolution (power of 2) */
+#define SWU_VEL_WIN     100      /* angular velocity window (control periods) */
+
+
+/* Name: SWU_status_type
+ *
+ * Description: status returned by the swing-up controller on every
+ *              control period
+ *
+ * Members: eSWU_STATUS_PUMPING  - pendulum energy is being pumped
+ *          eSWU_STATUS_CAPTURED - pendulum entered the capture region; the
+ *                                 angle encoder was re-zeroed to the upright
+ *                                 position and the balancing controller may
+ *                                 take over on the next control period
+ *
+ * Notes:
+ *
+ */
+typedef enum {
+	eSWU_STATUS_PUMPING = 0,
+	eSWU_STATUS_CAPTURED,
+} SWU_status_type;
+
+
+/* Name: SWU_ctrl_blk_type
+ *
+ * Description: swing-up controller control block data type
+ *
+ * Members: th_hist  - circular buffer of raw pendulum angle samples (counts);
+ *                     used to differentiate the angle over a short window
+ *          hist_idx - index of the oldest sample in th_hist
+ *          primed   - field is non-zero once th_hist is filled with valid
+ *                     samples
+ *          status   - status reported on the most recent control period
+ *          energy   - most recent estimate of the normalized pendulum energy
+ *                     (zero at upright rest, negative below)
+ *          x_limit  - cart travel either side of the track centre beyond
+ *                     which energy pumping is suspended (m)
+ *
+ * Notes:
+ *
+ */
+struct SWU_ctrl_blk_type
+{
+	int32_t th_hist[SWU_VEL_WIN];
+	uint32_t hist_idx;
+	uint32_t primed;
+	SWU_status_type status;
+	float energy;
+	float x_limit;
+};
+
+
+/* Name: SWU_pt_type
+ *
+ * Description: Data type used to represent individual points
+ *              in mapping arrays (i.e. conversion from voltage
+ *              input to power)
+ *
+ * Members: x - x coordinate
+ *          y - y coordinate
+ *
+ * Notes:
+ *
+ */
+struct SWU_pt_type
+{
+	float x;
+	float y;
+};
+
+#endif /* SWINGUP_SWU_DEFS_H_ */
@@ -0,0 +1,28 @@
+/*
+ * swu_proto.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Milos Lazic
+ */
+
+#ifndef SWINGUP_SWU_PROTO_H_
+#define SWINGUP_SWU_PROTO_H_
+
+
+#include <stdint.h>
+#include "swu_defs.h"
+
+
+/* module scope routines */
+extern float SWU_linmap( float input, const struct SWU_pt_type *p_map, const size_t map_len);
+extern float SWU_sin( float rad);
+extern float SWU_cos( float rad);
+
+/* global scope routines */
+extern void SWU_Reset( void);
+extern void SWU_SetXLimit( float x_limit);
+extern SWU_status_type SWU_CtrlRun( void);
+extern SWU_status_type SWU_GetStatus( void);
+
+
+#endif /* SWINGUP_SWU_PROTO_H_ */
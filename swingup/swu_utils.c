@@ -0,0 +1,170 @@
+/*
+ * swu_utils.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Milos Lazic
+ */
+
+#include "swu_defs.h"
+#include "swu_proto.h"
+
+
+#define SWU_PI            3.14159265359f
+#define SWU_SIN_TBL_SCALE ((float)SWU_SIN_TBL_LEN/(2.0f*SWU_PI))   /* table entries per radian */
+
+
+/* one period of sin(x) sampled at SWU_SIN_TBL_LEN points; the last
+ * entry repeats the first so that interpolation never wraps */
+static const float SIN_TBL[SWU_SIN_TBL_LEN + 1] =
+{
+		+0.0000000, +0.0245412, +0.0490677, +0.0735646,
+		+0.0980171, +0.1224107, +0.1467305, +0.1709619,
+		+0.1950903, +0.2191012, +0.2429802, +0.2667128,
+		+0.2902847, +0.3136817, +0.3368899, +0.3598950,
+		+0.3826834, +0.4052413, +0.4275551, +0.4496113,
+		+0.4713967, +0.4928982, +0.5141027, +0.5349976,
+		+0.5555702, +0.5758082, +0.5956993, +0.6152316,
+		+0.6343933, +0.6531728, +0.6715590, +0.6895405,
+		+0.7071068, +0.7242471, +0.7409511, +0.7572088,
+		+0.7730105, +0.7883464, +0.8032075, +0.8175848,
+		+0.8314696, +0.8448536, +0.8577286, +0.8700870,
+		+0.8819213, +0.8932243, +0.9039893, +0.9142098,
+		+0.9238795, +0.9329928, +0.9415441, +0.9495282,
+		+0.9569403, +0.9637761, +0.9700313, +0.9757021,
+		+0.9807853, +0.9852776, +0.9891765, +0.9924795,
+		+0.9951847, +0.9972905, +0.9987955, +0.9996988,
+		+1.0000000, +0.9996988, +0.9987955, +0.9972905,
+		+0.9951847, +0.9924795, +0.9891765, +0.9852776,
+		+0.9807853, +0.9757021, +0.9700313, +0.9637761,
+		+0.9569403, +0.9495282, +0.9415441, +0.9329928,
+		+0.9238795, +0.9142098, +0.9039893, +0.8932243,
+		+0.8819213, +0.8700870, +0.8577286, +0.8448536,
+		+0.8314696, +0.8175848, +0.8032075, +0.7883464,
+		+0.7730105, +0.7572088, +0.7409511, +0.7242471,
+		+0.7071068, +0.6895405, +0.6715590, +0.6531728,
+		+0.6343933, +0.6152316, +0.5956993, +0.5758082,
+		+0.5555702, +0.5349976, +0.5141027, +0.4928982,
+		+0.4713967, +0.4496113, +0.4275551, +0.4052413,
+		+0.3826834, +0.3598950, +0.3368899, +0.3136817,
+		+0.2902847, +0.2667128, +0.2429802, +0.2191012,
+		+0.1950903, +0.1709619, +0.1467305, +0.1224107,
+		+0.0980171, +0.0735646, +0.0490677, +0.0245412,
+		+0.0000000, -0.0245412, -0.0490677, -0.0735646,
+		-0.0980171, -0.1224107, -0.1467305, -0.1709619,
+		-0.1950903, -0.2191012, -0.2429802, -0.2667128,
+		-0.2902847, -0.3136817, -0.3368899, -0.3598950,
+		-0.3826834, -0.4052413, -0.4275551, -0.4496113,
+		-0.4713967, -0.4928982, -0.5141027, -0.5349976,
+		-0.5555702, -0.5758082, -0.5956993, -0.6152316,
+		-0.6343933, -0.6531728, -0.6715590, -0.6895405,
+		-0.7071068, -0.7242471, -0.7409511, -0.7572088,
+		-0.7730105, -0.7883464, -0.8032075, -0.8175848,
+		-0.8314696, -0.8448536, -0.8577286, -0.8700870,
+		-0.8819213, -0.8932243, -0.9039893, -0.9142098,
+		-0.9238795, -0.9329928, -0.9415441, -0.9495282,
+		-0.9569403, -0.9637761, -0.9700313, -0.9757021,
+		-0.9807853, -0.9852776, -0.9891765, -0.9924795,
+		-0.9951847, -0.9972905, -0.9987955, -0.9996988,
+		-1.0000000, -0.9996988, -0.9987955, -0.9972905,
+		-0.9951847, -0.9924795, -0.9891765, -0.9852776,
+		-0.9807853, -0.9757021, -0.9700313, -0.9637761,
+		-0.9569403, -0.9495282, -0.9415441, -0.9329928,
+		-0.9238795, -0.9142098, -0.9039893, -0.8932243,
+		-0.8819213, -0.8700870, -0.8577286, -0.8448536,
+		-0.8314696, -0.8175848, -0.8032075, -0.7883464,
+		-0.7730105, -0.7572088, -0.7409511, -0.7242471,
+		-0.7071068, -0.6895405, -0.6715590, -0.6531728,
+		-0.6343933, -0.6152316, -0.5956993, -0.5758082,
+		-0.5555702, -0.5349976, -0.5141027, -0.4928982,
+		-0.4713967, -0.4496113, -0.4275551, -0.4052413,
+		-0.3826834, -0.3598950, -0.3368899, -0.3136817,
+		-0.2902847, -0.2667128, -0.2429802, -0.2191012,
+		-0.1950903, -0.1709619, -0.1467305, -0.1224107,
+		-0.0980171, -0.0735646, -0.0490677, -0.0245412,
+		-0.0000000,
+};
+
+
+/*
+ * Name: SWU_linmap
+ *
+ * Descr: Routine to evaluate a piece-wise (array-mapped) function
+ *        by linear interpolation
+ *
+ * Args:     input - argument to function
+ *           p_map - pointer to function mapping (lookup table)
+ *           map_len - length of function mapping
+ *
+ * Return:   Function value at 'input'
+ *
+ * Notes: same as LQR_linmap
+ *
+ */
+float SWU_linmap( float input, const struct SWU_pt_type *p_map, const size_t map_len)
+{
+	int32_t i = 0;
+
+	while( i < map_len)
+	{
+		if ( input < p_map[i].x)
+			break;
+		i++;
+	}
+
+	if ( i == 0)
+		return p_map[i].y;
+	else if ( i == map_len)
+		return p_map[i-1].y;
+	else
+		return ( p_map[i-1].y +(((input - p_map[i-1].x)*(p_map[i].y - p_map[i-1].y))/(p_map[i].x - p_map[i-1].x)));
+}
+
+
+/*
+ * Name: SWU_sin
+ *
+ * Descr: Fast sine approximation; linear interpolation between
+ *        entries of a one-period lookup table
+ *
+ * Args:     rad - angle (radians); any magnitude that fits in
+ *                 an int32_t once scaled by SWU_SIN_TBL_SCALE
+ *
+ * Return:   sin(rad), absolute error below 1e-4
+ *
+ * Notes: constant execution time (no range reduction loop), suitable
+ *        for use inside the control period
+ *
+ */
+float SWU_sin( float rad)
+{
+	float idx = rad * SWU_SIN_TBL_SCALE;
+	int32_t i = (int32_t)idx;
+	float frac;
+
+	/* float to int conversion truncates towards zero; floor instead */
+	if ( idx < (float)i)
+		i--;
+
+	frac = idx - (float)i;
+	i &= (SWU_SIN_TBL_LEN - 1);
+
+	return SIN_TBL[i] + frac * (SIN_TBL[i+1] - SIN_TBL[i]);
+}
+
+
+/*
+ * Name: SWU_cos
+ *
+ * Descr: Fast cosine approximation (see SWU_sin)
+ *
+ * Args:     rad - angle (radians)
+ *
+ * Return:   cos(rad)
+ *
+ * Notes:
+ *
+ */
+float SWU_cos( float rad)
+{
+	return SWU_sin( rad + 0.5f*SWU_PI);
+}
@@ -18,6 +18,17 @@ extern struct device esc0_dev;
 extern struct device prs0_dev;
 extern struct device ssd1306_dev;
 extern struct device timer0_dev;
+extern struct device timer1_dev;
+extern struct device timer2_dev;
+extern struct device timer3_dev;
+extern struct device timer4_dev;
+extern struct device timer5_dev;
+extern struct device wtimer0_dev;
+extern struct device wtimer1_dev;
+extern struct device wtimer2_dev;
+extern struct device wtimer3_dev;
+extern struct device wtimer4_dev;
+extern struct device wtimer5_dev;
 
 
 /* NOTE: must be in same order as enumeration E_DEVICE in device.h */
@@ -30,6 +41,17 @@ static struct device *pdev[eDEV_MAX] =
 		&prs0_dev,
 		&ssd1306_dev,
 		&timer0_dev,
+		&timer1_dev,
+		&timer2_dev,
+		&timer3_dev,
+		&timer4_dev,
+		&timer5_dev,
+		&wtimer0_dev,
+		&wtimer1_dev,
+		&wtimer2_dev,
+		&wtimer3_dev,
+		&wtimer4_dev,
+		&wtimer5_dev,
 };
 
 
@@ -16,6 +16,15 @@
 
 #define DEV_MAX_NAME 8
 
+/* storage class of the module state of the controllers (control blocks,
+ * fuzzy sets, timebase); empty on the target. Host builds that run
+ * several simulated plants in parallel threads define it thread local
+ * (-DDEV_STATE_CLASS=__thread), so that every thread gets its own
+ * controller instance. */
+#ifndef DEV_STATE_CLASS
+#define DEV_STATE_CLASS
+#endif
+
 
 typedef uint32_t dev_t;
 
@@ -27,10 +36,23 @@ enum E_DEVICE
 	eDEV_ESC0,
 	eDEV_PRS0,
 	eDEV_SSD1306, // LCD
-	eDEV_TIMER0,
+	eDEV_TIMER0, // GPTM; allocate with timer_dev_alloc
+	eDEV_TIMER1,
+	eDEV_TIMER2,
+	eDEV_TIMER3,
+	eDEV_TIMER4,
+	eDEV_TIMER5,
+	eDEV_WTIMER0,
+	eDEV_WTIMER1,
+	eDEV_WTIMER2,
+	eDEV_WTIMER3,
+	eDEV_WTIMER4,
+	eDEV_WTIMER5,
 	eDEV_MAX,
 };
 
+#define TIMER_NUM (eDEV_WTIMER5 - eDEV_TIMER0 + 1)
+
 
 // device ioctl request enumeration
 enum E_IOCTL_REQ
@@ -43,7 +65,14 @@ enum E_IOCTL_REQ
 	eQEI_IOCTL_R_VEL_RAD,    /* read velocity (converted to radians/sec), signed */
 
 	/* ESC_DEV */
-	eESC_IOCTL_SET_POWER,
+	eESC_IOCTL_SET_POWER,      /* stage power, int (%) */
+	eESC_IOCTL_SET_POWER_F,    /* stage power, float (%) */
+	eESC_IOCTL_SET_POWER_Q15,  /* stage power, int Q15 (32768 = 100 %) */
+	eESC_IOCTL_SET_FREQ,       /* request PWM frequency, int (Hz) */
+	eESC_IOCTL_SET_DEADTIME,   /* direction change deadtime, int (control periods) */
+	eESC_IOCTL_SYNC,           /* end of control period; commits staged power and frequency */
+	eESC_IOCTL_GET_POWER_Q15,  /* read staged power, int32_t * Q15 */
+	eESC_IOCTL_GET_ACT_TIME,   /* time the last committed power takes effect, uint64_t * (cycles) */
 
 	/* PRS_DEV */
 	ePRS_IOCTL_DISTMSR,
@@ -55,7 +84,10 @@ enum E_IOCTL_REQ
 	eTIMER_DISABLE,
 	eTIMER_ENABLE,
 	eTIMER_RESET,
-	eTIMER_READ,
+	eTIMER_READ,             /* read counter (lower 32 bits) or captured count */
+	eTIMER_CONFIG,           /* set mode, uint32 (timer_mode_t), and period, uint32 (cycles); stops the timer */
+	eTIMER_EVENT,            /* poll and clear time-out (capture event in capture mode); returns 1 if set */
+	eTIMER_READ64,           /* read counter, uint64_t *; tear-free on wide timers */
 
 
 	eIOCTL_REQ_MAX,
@@ -63,6 +95,19 @@ enum E_IOCTL_REQ
 
 
 
+/* TIMER_DEV modes (eTIMER_CONFIG); all modes count up at the system clock */
+typedef enum
+{
+	eTIMER_MODE_ONESHOT = 0,  /* time-out once after period cycles */
+	eTIMER_MODE_PERIODIC,     /* time-out every period cycles */
+	eTIMER_MODE_CAPTURE,      /* edge-time capture, both edges, on the CCP pin */
+	eTIMER_MODE_FREERUN,      /* free running 32-bit (64-bit on wide timers) timebase */
+} timer_mode_t;
+
+/* TIMER_DEV allocation flags (timer_dev_alloc) */
+#define TIMER_ALLOC_WIDE 0x00000001  /* 32/64-bit wide timer required */
+
+
 /* DEV_LSEEK */
 #define DEV_SEEK_SET     0
 #define DEV_SEEK_CUR     1
@@ -97,6 +142,10 @@ extern int  dev_ioctl(dev_t devno, int request, ...);
 extern int  dev_lseek(dev_t devno, int offset, int whence);
 extern void dev_deinit(dev_t devno);
 
+/* TIMER_DEV allocation */
+extern int  timer_dev_alloc(uint32_t flags, const char *owner);
+extern void timer_dev_free(dev_t devno);
+
 
 
 
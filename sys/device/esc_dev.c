@@ -6,22 +6,41 @@
  */
 
 #include "device.h"
+#include "../systime/systime.h"
 
 
-/* macro for calculating the PWM generator load value for
- * SYS_CLOCK = 80 MHz and PWM_DIV = 16; the frequency parameter
- * specified refers to the PWM frequency in units of Hertz
+/* PWM clock; the PWM clock divider is bypassed (SYSCTL_RCC USEPWMDIV
+ * cleared) so the generator counts at SYS_CLOCK = 80 MHz */
+#define ESC_PWM_CLK      80000000
+
+/* default PWM frequency (Hz); 20 kHz gives 4000 counts per period */
+#define ESC_PWM_FREQ     20000
+#define ESC_PWM_FREQ_MIN 1250     /* LOAD must fit the 16-bit generator counter */
+#define ESC_PWM_FREQ_MAX 100000
+
+/* largest duty cycle (%) produced at full power */
+#define ESC_DUTY_MAX     99
+
+/* macro for calculating the PWM generator load value; the frequency
+ * parameter specified refers to the PWM frequency in units of Hertz
  */
 #define PWM_LOAD(frequency) \
-	((80000000/8)/frequency - 1)
+	(ESC_PWM_CLK/(frequency) - 1)
 
-/* macro for calculating the duty cycle based on the configured
- * PWM frequency; duty parameter specified is a duty cycle of
- * integral value from 0 to 100
- */
-#define PWM_CMP(duty) \
-		((PWM1_1_LOAD_R - 1) - ((duty*(PWM1_1_LOAD_R - 1))/100))
+/* full scale of the Q15 power interface */
+#define ESC_Q15_ONE      32768
+
+/* default deadtime on a direction change (control periods, in addition
+ * to the one control period the output is always held off) */
+#define ESC_DEADTIME     0
 
+#define ESC_DIR_PIN      0x00000004  /* PF2; low = positive power */
+
+/* PWMnCTL: defer LOAD and CMPA updates to the next global synchronization
+ * (LOADUPD, CMPAUPD) */
+#define ESC_PWMCTL_GLOBAL_UPD  (0x00000008 | 0x00000010)
+/* PWMCTL: global synchronization of generator 1 (GLOBALSYNC1) */
+#define ESC_PWMCTL_GLOBALSYNC1 0x00000002
 
 
 /* Device operations prototypes */
@@ -41,54 +60,184 @@ struct device_operations esc_devops = {
 };
 
 
-struct esc_pt_type
+/* Name: esc_attr
+ *
+ * Description: ESC device attributes
+ *
+ * Members: load         - PWM generator LOAD value in use
+ *          span         - compare counts between 0 and ESC_DUTY_MAX duty
+ *          load_pending - LOAD value requested by eESC_IOCTL_SET_FREQ;
+ *                         0 if none
+ *          cmp_tbl      - compare value for each integer power (%);
+ *                         rebuilt when the period changes
+ *          power        - requested power (Q15)
+ *          cmp          - compare value for the requested power
+ *          dir          - direction pin state in use (+1: positive power)
+ *          deadtime     - additional control periods the output is held
+ *                         off on a direction change
+ *          gap          - control periods left before the direction pin
+ *                         may change
+ *          t_act        - time the last committed power takes effect
+ *                         (SYSTIME_Now, cycles)
+ *          cmp_hw       - compare value last written to the generator
+ *
+ * Notes: power and cmp are staged by the SET_POWER requests and committed
+ *        to the generator by eESC_IOCTL_SYNC; load, span and cmp_tbl are
+ *        cached so that power updates neither read back the generator
+ *        registers nor divide
+ */
+struct esc_attr
 {
-	int32_t x;
-	int32_t y;
+	uint32_t load;
+	uint32_t span;
+	volatile uint32_t load_pending;
+	uint16_t cmp_tbl[101];
+	int32_t power;
+	uint32_t cmp;
+	int32_t dir;
+	uint32_t deadtime;
+	uint32_t gap;
+	uint64_t t_act;
+	uint32_t cmp_hw;
 };
 
-/* map power (%) to duty cycle */
-static const struct esc_pt_type ESC_MAP_POWER_TO_DUTY[] =
+struct esc_attr esc0_attr =
 {
-		/* power, duty cycle */
-		{ -100, 99 },
-		{    0, 0 },
-		{  100, 99 },
+		.load = PWM_LOAD(ESC_PWM_FREQ),
+		.span = (PWM_LOAD(ESC_PWM_FREQ) - 1)*ESC_DUTY_MAX/100,
+		.load_pending = 0,
+		.power = 0,
+		.cmp = PWM_LOAD(ESC_PWM_FREQ) - 1,
+		.dir = -1,
+		.deadtime = ESC_DEADTIME,
+		.gap = 0,
+		.t_act = 0,
+		.cmp_hw = PWM_LOAD(ESC_PWM_FREQ) - 1,
 };
-#define ESC_MAP_POWER_TO_DUTY_LEN (sizeof(ESC_MAP_POWER_TO_DUTY)/sizeof(ESC_MAP_POWER_TO_DUTY[0]))
 
 
-/* same as fl_linmap */
-static uint32_t esc_calculate_duty(int32_t input, const struct esc_pt_type *p_map, size_t map_len)
+// esc0 (motor driver) device structure
+struct device esc0_dev = {
+		.name = "esc0",
+		.self_attr = &esc0_attr,
+		.dev_ops = &esc_devops
+};
+
+
+/*
+ * Name: esc_set_period
+ * Descr: switch to a new PWM period; rebuilds the integer power to compare
+ *        value table
+ * Args:     attr - ESC attributes
+ *           load - new generator LOAD value
+ * Return:   none
+ * Notes:    the caller commits LOAD to the generator
+ */
+static void esc_set_period(struct esc_attr *attr, uint32_t load)
+{
+	uint32_t i;
+
+	attr->load = load;
+	attr->span = (load - 1)*ESC_DUTY_MAX/100;
+
+	for ( i = 0; i <= 100; i++)
+		attr->cmp_tbl[i] = (uint16_t)((load - 1) - (i*attr->span)/100);
+}
+
+
+/*
+ * Name: esc_stage_q15
+ * Descr: stage a motor power given in Q15
+ * Args:     attr  - ESC attributes
+ *           power - signed power, ESC_Q15_ONE = 100 % (clamped)
+ * Return:   none
+ * Notes:    zero power gives the same one count pulse as before (CMPA =
+ *           LOAD - 1)
+ */
+static void esc_stage_q15(struct esc_attr *attr, int32_t power)
 {
-	int32_t i = 0;
+	uint32_t mag;
+
+	if ( power > ESC_Q15_ONE)
+		power = ESC_Q15_ONE;
+	else if ( power < -ESC_Q15_ONE)
+		power = -ESC_Q15_ONE;
+
+	mag = (power < 0) ? (uint32_t)(-power) : (uint32_t)power;
 
-	while( i < map_len)
+	attr->power = power;
+	attr->cmp = (attr->load - 1) - ((mag*attr->span) >> 15);
+}
+
+
+/*
+ * Name: esc_sync
+ * Descr: commit the staged power (and period) to the generator
+ * Args:     attr - ESC attributes
+ * Return:   none
+ * Notes:    called at the end of each control period. The new LOAD and
+ *           CMPA take effect together at the next PWM period boundary
+ *           (global synchronization). The direction pin only changes
+ *           while the output has been held off for at least one control
+ *           period (plus the configured deadtime), so duty and direction
+ *           never change in the middle of an active pulse; zero duty on
+ *           the sign-magnitude driver brakes the motor during the gap.
+ *           The generator counts down at the timebase clock, so the
+ *           boundary is COUNT cycles away. Nothing is written when
+ *           neither the compare value nor the period change.
+ */
+static void esc_sync(struct esc_attr *attr)
+{
+	uint32_t load = attr->load_pending;
+	int32_t dir;
+
+	if ( load)
 	{
-		if ( input < p_map[i].x)
-			break;
-		i++;
+		attr->load_pending = 0;
+		esc_set_period(attr, load);
+		esc_stage_q15(attr, attr->power);
+		PWM1_1_LOAD_R = load;
 	}
 
-	if ( i == 0)
-		return p_map[i].y;
-	else if ( i == map_len)
-		return p_map[i-1].y;
-	else
-		return ( p_map[i-1].y + (((input - p_map[i-1].x)*(p_map[i].y - p_map[i-1].y))/(p_map[i].x - p_map[i-1].x)));
-}
+	/* zero power keeps the current direction */
+	dir = ( attr->power > 0) ? 1 : ( attr->power < 0) ? -1 : attr->dir;
 
+	if ( dir == attr->dir)
+	{
+		attr->gap = 0;
+		/* unchanged output */
+		if ( !load && attr->cmp == attr->cmp_hw)
+			return;
+		PWM1_1_CMPA_R = attr->cmp_hw = attr->cmp;
+	}
+	else if ( attr->gap == 0)
+	{
+		/* sign change: output off first */
+		attr->gap = attr->deadtime + 1;
+		PWM1_1_CMPA_R = attr->cmp_hw = attr->load - 1;
+	}
+	else if ( --attr->gap == 0)
+	{
+		/* output has been off since the previous period; switch the
+		 * direction, the new duty follows at the next PWM period */
+		/* MLAZIC_TBD: forward/reverse designation */
+		if ( dir > 0)
+			GPIO_PORTF_DATA_R &= ~(ESC_DIR_PIN);
+		else
+			GPIO_PORTF_DATA_R |= ESC_DIR_PIN;
+		attr->dir = dir;
+		PWM1_1_CMPA_R = attr->cmp_hw = attr->cmp;
+	}
 
-// esc0 (motor driver) device structure
-struct device esc0_dev = {
-		.name = "esc0",
-		.self_attr = NULL,
-		.dev_ops = &esc_devops
-};
+	PWM1_CTL_R |= ESC_PWMCTL_GLOBALSYNC1;
+	attr->t_act = SYSTIME_Now() + PWM1_1_COUNT_R;
+}
 
 
 void esc_dev_init (void *self_attr)
 {
+	struct esc_attr *attr = (struct esc_attr *) self_attr;
+
 	// enable system bus clock to GPIO Port A
 	SYSCTL_RCGCGPIO_R |= 0x00000001;
 	// wait until clock is stable
@@ -151,16 +300,16 @@ void esc_dev_init (void *self_attr)
 	// wait until PWM is ready for access
 	while((SYSCTL_PRPWM_R & 0x00000002) == 0) {};
 
-	// enable PWM clock divider
-	SYSCTL_RCC_R |= 0x00100000;
-	// set pwm divider to divide by 16 (80Mhz/8 = 10Mhz)
-	SYSCTL_RCC_R = (SYSCTL_RCC_R & ~(0x000E0000)) | (0x00000002 << 17);
+	// bypass PWM clock divider (PWM clock = SYS_CLOCK = 80 MHz)
+	SYSCTL_RCC_R &= ~(0x00100000);
 
 	// ===== START_CONFIG: PA6 as M1PWM2 =====
 	// reset PWM 1 GEN 1 control register
 	PWM1_1_CTL_R = 0x00000000;
 	// enable generator counter to run in Debug mode (required)
 	PWM1_1_CTL_R |= 0x00000004;
+	// defer LOAD and CMPA updates to global synchronization (see esc_sync)
+	PWM1_1_CTL_R |= ESC_PWMCTL_GLOBAL_UPD;
 	// configure PWM 1 GEN 1 Signal A Generation
 	// reset
 	PWM1_1_GENA_R = 0x00000000;
@@ -168,11 +317,19 @@ void esc_dev_init (void *self_attr)
 	PWM1_1_GENA_R |= 0x00000002 << 6;
 	// drive pwm output A high when counter matches LOAD value
 	PWM1_1_GENA_R |= 0x00000003 << 2;
-	// set PWM refresh rate (period) at 2000 Hz ( (SYS_CLK/PWMDIV)/PWM_FREQ ) - 1)
-	// (80MHz/8)/2000Hz - 1 = 2499 = 0x1387
-	PWM1_1_LOAD_R = PWM_LOAD(250); // set PWM frequency to 250 Hz
-	// initialize duty cycle to 0 (set CMPA value to maximum)
-	PWM1_1_CMPA_R = PWM_CMP(0); // set initial duty cycle to 0
+	// set PWM refresh rate (period) ( SYS_CLK/PWM_FREQ ) - 1)
+	// 80MHz/20kHz - 1 = 3999
+	esc_set_period(attr, PWM_LOAD(ESC_PWM_FREQ));
+	attr->load_pending = 0;
+	PWM1_1_LOAD_R = attr->load;
+	// initialize duty cycle to 0 (set CMPA value to maximum); direction
+	// pin initialized high (negative power) as before
+	esc_stage_q15(attr, 0);
+	attr->dir = -1;
+	attr->gap = 0;
+	GPIO_PORTF_DATA_R |= ESC_DIR_PIN;
+	PWM1_1_CMPA_R = attr->cmp_hw = attr->cmp;
+	PWM1_CTL_R |= ESC_PWMCTL_GLOBALSYNC1;
 	// enable PWM generator block
 	PWM1_1_CTL_R |= 0x00000001;
 	// enable PWM module
@@ -202,28 +359,78 @@ int esc_dev_read (void *self_attr, char *buf, size_t count)
 int esc_dev_ioctl (void *self_attr, int request, va_list args)
 {
 	int rv = -1;
-	int power = 0;
+	int32_t val;
+	float fval;
+
+	struct esc_attr *attr = (struct esc_attr *) self_attr;
 
 	switch(request)
 	{
 	case eESC_IOCTL_SET_POWER:
-		power = va_arg(args, int);
-		PWM1_1_CMPA_R = PWM_CMP(esc_calculate_duty( power,
-				ESC_MAP_POWER_TO_DUTY, ESC_MAP_POWER_TO_DUTY_LEN));
-
-		if ( power > 0)
-		{
-			// set motor direction
-			/* MLAZIC_TBD: forward/reverse designation */
-			GPIO_PORTF_DATA_R &= ~(0x00000004);
-		}
-		else
-		{
-			// set motor direction
-			/* MLAZIC_TBD: forward/reverse designation */
-			GPIO_PORTF_DATA_R |= 0x00000004;
-		}
+		/* integer power (%); compare value from the table */
+		val = va_arg(args, int);
+		if ( val > 100)
+			val = 100;
+		else if ( val < -100)
+			val = -100;
+		attr->power = (val*ESC_Q15_ONE)/100;
+		attr->cmp = attr->cmp_tbl[(val < 0) ? -val : val];
+		rv = 0;
+		break;
+
+	case eESC_IOCTL_SET_POWER_F:
+		/* float power (%); promoted to double by the variable argument
+		 * list */
+		fval = (float)va_arg(args, double);
+		if ( fval > 100.0f)
+			fval = 100.0f;
+		else if ( fval < -100.0f)
+			fval = -100.0f;
+		esc_stage_q15(attr, (int32_t)(fval*(ESC_Q15_ONE/100.0f)));
+		rv = 0;
+		break;
+
+	case eESC_IOCTL_SET_POWER_Q15:
+		/* Q15 power (ESC_Q15_ONE = 100 %) */
+		esc_stage_q15(attr, va_arg(args, int));
+		rv = 0;
+		break;
+
+	case eESC_IOCTL_SET_FREQ:
+		/* PWM frequency (Hz); applied by the next eESC_IOCTL_SYNC */
+		val = va_arg(args, int);
+		if ( val < ESC_PWM_FREQ_MIN || val > ESC_PWM_FREQ_MAX)
+			break;
+		attr->load_pending = PWM_LOAD(val);
+		rv = 0;
+		break;
+
+	case eESC_IOCTL_SET_DEADTIME:
+		/* additional control periods with the output off on a
+		 * direction change */
+		val = va_arg(args, int);
+		if ( val < 0)
+			break;
+		attr->deadtime = (uint32_t)val;
+		rv = 0;
+		break;
+
+	case eESC_IOCTL_SYNC:
+		/* end of control period; commit staged power and period */
+		esc_sync(attr);
+		rv = 0;
+		break;
+
+	case eESC_IOCTL_GET_POWER_Q15:
+		/* staged power (Q15); caller passes in int32_t * */
+		*va_arg(args, int32_t *) = attr->power;
+		rv = 0;
+		break;
 
+	case eESC_IOCTL_GET_ACT_TIME:
+		/* time the last committed power takes effect (cycles); caller
+		 * passes in uint64_t * */
+		*va_arg(args, uint64_t *) = attr->t_act;
 		rv = 0;
 		break;
 
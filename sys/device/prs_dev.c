@@ -32,9 +32,26 @@ struct device_operations prs_devops = {
 
 
 
+/* Name: prs_attr
+ *
+ * Description: PRS device attributes
+ *
+ * Members: timer - echo timing timer (device number), allocated at
+ *                  initialization; -1 if none could be allocated
+ *
+ * Notes:
+ */
+struct prs_attr
+{
+	int timer;
+};
+
+struct prs_attr prs0_attr = { .timer = -1 };
+
+
 struct device prs0_dev = {
 		.name = "prs0",
-		.self_attr = NULL,
+		.self_attr = &prs0_attr,
 		.dev_ops = &prs_devops
 };
 
@@ -43,14 +60,15 @@ struct device prs0_dev = {
  * Name: sensor_r
  * Descr: trigger module measurement and return
  *        proximity in mm
- * Args:     none
+ * Args:     attr - device attributes
  * Return:   proximity measurement in mm
  * Notes:    check datasheet for minimum object distance
  *           to get valid measurement
  */
-static uint32_t sensor_r( void)
+static uint32_t sensor_r( const struct prs_attr *attr)
 {
 	uint32_t distance = 0, count = 0;
+	dev_t tmr = (dev_t)attr->timer;
 
 	/* OPERATING PROCEDURE
 	 *  1) transmit at least 10 us high level pulse to module Trig pin
@@ -63,44 +81,34 @@ static uint32_t sensor_r( void)
 	 *  5) stop timer; read counter value
 	 */
 
-	// disable timer
-	TIMER0_CTL_R &= ~(0x00000001);
-	// set timeout value (10 us)
-	TIMER0_TAILR_R = TIMER_LR_USEC(10);
-	// reset timer counter
-	TIMER0_TAV_R = 0x00000000;
+	// set timeout value (10 us); resets and stops the timer
+	dev_ioctl(tmr, eTIMER_CONFIG, eTIMER_MODE_ONESHOT, TIMER_LR_USEC(10));
 
 	/* trigger measurement */
 	// assert high level to module Trig pin (connected to PE2)
 	GPIO_PORTE_DATA_R |= 0x00000004;
 	// start (enable) timer
-	TIMER0_CTL_R |= 0x00000001;
-	// wait until timeout
-	while ((TIMER0_RIS_R & 0x00000001) == 0) {};
+	dev_ioctl(tmr, eTIMER_ENABLE);
+	// wait until timeout (flag is cleared when read)
+	while (dev_ioctl(tmr, eTIMER_EVENT) == 0) {};
 	// assert low level to module Trig pin (connected to PE2)
 	GPIO_PORTE_DATA_R &= ~(0x00000004);
 
 
-	// disable timer
-	TIMER0_CTL_R &= ~(0x00000001);
-	// clear timeout flag (set in TIMER_RIS register bit 0)
-	TIMER0_ICR_R |= 0x00000001;
-	// reset timer counter
-	TIMER0_TAV_R = 0x00000000;
 	// set timeout value to maximum (for 32-bit timer, 80 MHz sysclock, this
-	// is approximately 53 seconds)
-	TIMER0_TAILR_R = 0xFFFFFFFF;
+	// is approximately 53 seconds); resets and stops the timer
+	dev_ioctl(tmr, eTIMER_CONFIG, eTIMER_MODE_ONESHOT, 0xFFFFFFFF);
 
 	// wait for module Echo port to assert rising edge
 	while ((GPIO_PORTE_DATA_R & 0x00000008) == 0) {};
 	// start timer
-	TIMER0_CTL_R |= 0x00000001;
+	dev_ioctl(tmr, eTIMER_ENABLE);
 	// wait for module Echo port to assert falling edge
 	while ((GPIO_PORTE_DATA_R & 0x00000008) == 0x000000008) {};
 	// read timer (counter value)
-	count = TIMER0_TAR_R;
+	count = (uint32_t)dev_ioctl(tmr, eTIMER_READ);
 	// disable timer
-	TIMER0_CTL_R &= ~(0x00000001);
+	dev_ioctl(tmr, eTIMER_DISABLE);
 
 
 	// conversion to distance units (mm)
@@ -115,17 +123,17 @@ static uint32_t sensor_r( void)
 
 void prs_dev_init (void *self_attr)
 {
-	// initialize timer0, PE2, PE3
+	struct prs_attr *attr = (struct prs_attr *) self_attr;
+
+	// initialize echo timer, PE2, PE3
 
 	// enable system peripheral GPIO Port E
 	SYSCTL_RCGCGPIO_R |= 0x00000010;
 	// wait until clock is stable
 	while((SYSCTL_PRGPIO_R & 0x00000010) == 0) {};
 
-	// enable system peripheral Timer 0 (GPTM)
-	SYSCTL_RCGCTIMER_R |= 0x00000001;
-	// wait until clock is stable
-	while ((SYSCTL_PRTIMER_R & 0x00000001) == 0) {};
+	// allocate a dedicated timer for echo timing (enables its clock)
+	attr->timer = timer_dev_alloc(0, "prs0");
 
 
 	// ===== START_CONFIG: PE2 as Digital Output =====
@@ -159,22 +167,6 @@ void prs_dev_init (void *self_attr)
 	// set PE3 to LOW
 	GPIO_PORTE_DATA_R &= ~(0x00000008);
 	// ===== STOP_CONFIG =====
-
-
-	// ===== START_CONFIG: GPTM 0 =====
-	// disable timer
-	TIMER0_CTL_R &= ~(0x00000001);
-	// select 32-bit timer configuration
-	TIMER0_CFG_R = 0x00000000;
-	// configure one-shot mode operation
-	TIMER0_TAMR_R |= 0x00000001;
-	//configure count-up mode operation
-	TIMER0_TAMR_R |= (0x00000001 << 4);
-#if 0 /* not needed */
-	// set timeout event upper bound
-	TIMER0_TAILR_R = 0xFFFFFFFF;
-#endif
-	// ===== STOP_CONFIG =====
 }
 
 
@@ -194,13 +186,15 @@ int  prs_dev_read (void *self_attr, char *buf, size_t count)
 
 int  prs_dev_ioctl (void *self_attr, int request, va_list args)
 {
+	struct prs_attr *attr = (struct prs_attr *) self_attr;
 	int rv = -1;
 
 	switch(request)
 	{
 	case ePRS_IOCTL_DISTMSR:
 		/* measure object proximity */
-		rv = sensor_r();
+		if ( attr->timer >= 0)
+			rv = sensor_r(attr);
 		break;
 
 	default:
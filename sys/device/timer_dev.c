@@ -3,12 +3,65 @@
  *
  *  Created on: Apr 1, 2018
  *      Author: Milos Lazic
+ *
+ *  General purpose timer (GPTM) driver; one device per timer module:
+ *  TIMER0-5 (16/32-bit, used concatenated as 32-bit timers) and
+ *  WTIMER0-5 (32/64-bit wide, used concatenated as 64-bit timers).
+ *  Modules are handed out by timer_dev_alloc so that each user owns
+ *  its timer; all timers count up at the system clock.
  */
 
 
 #include "device.h"
 
 
+#define TIMER0_BASE_ADDR     ((uint32_t *)0x40030000)
+#define TIMER1_BASE_ADDR     ((uint32_t *)0x40031000)
+#define TIMER2_BASE_ADDR     ((uint32_t *)0x40032000)
+#define TIMER3_BASE_ADDR     ((uint32_t *)0x40033000)
+#define TIMER4_BASE_ADDR     ((uint32_t *)0x40034000)
+#define TIMER5_BASE_ADDR     ((uint32_t *)0x40035000)
+#define WTIMER0_BASE_ADDR    ((uint32_t *)0x40036000)
+#define WTIMER1_BASE_ADDR    ((uint32_t *)0x40037000)
+#define WTIMER2_BASE_ADDR    ((uint32_t *)0x4004C000)
+#define WTIMER3_BASE_ADDR    ((uint32_t *)0x4004D000)
+#define WTIMER4_BASE_ADDR    ((uint32_t *)0x4004E000)
+#define WTIMER5_BASE_ADDR    ((uint32_t *)0x4004F000)
+
+#define GPTMCFG_REG_OFST     0x000
+#define GPTMTAMR_REG_OFST    0x004
+#define GPTMCTL_REG_OFST     0x00C
+#define GPTMIMR_REG_OFST     0x018
+#define GPTMRIS_REG_OFST     0x01C
+#define GPTMICR_REG_OFST     0x024
+#define GPTMTAILR_REG_OFST   0x028
+#define GPTMTBILR_REG_OFST   0x02C
+#define GPTMTAPR_REG_OFST    0x038
+#define GPTMTAR_REG_OFST     0x048
+#define GPTMTAV_REG_OFST     0x050
+#define GPTMTBV_REG_OFST     0x054
+
+/* GPTMCFG */
+#define GPTM_CFG_CONCAT      0x00000000  /* 32-bit (16/32) or 64-bit (wide) timer */
+#define GPTM_CFG_SPLIT       0x00000004  /* 16-bit (16/32) or 32-bit (wide) timers */
+/* GPTMTAMR */
+#define GPTM_TAMR_ONESHOT    0x00000001
+#define GPTM_TAMR_PERIODIC   0x00000002
+#define GPTM_TAMR_CAPTURE    0x00000003
+#define GPTM_TAMR_CMR        0x00000004  /* edge-time capture */
+#define GPTM_TAMR_CDIR       0x00000010  /* count up */
+/* GPTMCTL */
+#define GPTM_CTL_TAEN        0x00000001
+#define GPTM_CTL_TAEVENT_BOTH 0x0000000C /* capture both edges */
+/* GPTMRIS / GPTMICR */
+#define GPTM_RIS_TATO        0x00000001  /* time-out */
+#define GPTM_RIS_CAE         0x00000004  /* capture event */
+
+/* register access relative to the module base address */
+#define GPTM_REG(attr, ofst) \
+	(*((volatile uint32_t *)((uint8_t *)(attr)->BASE_ADDR + (ofst))))
+
+
 /* Device operations prototypes */
 void timer_dev_init(void *self_attr);
 int  timer_dev_write(void *self_attr, const char *buf, size_t count);
@@ -26,32 +79,259 @@ struct device_operations timer_devops = {
 };
 
 
-struct device timer0_dev = {
-		.name = "timer0",
-		.self_attr = NULL,
-		.dev_ops = &timer_devops,
+/* Name: timer_attr
+ *
+ * Description: GPTM device attributes
+ *
+ * Members: BASE_ADDR - module register base address
+ *          RCGC      - run mode clock gating register of the module
+ *          PR        - peripheral ready register of the module
+ *          bit       - module bit in RCGC and PR
+ *          wide      - non-zero for a 32/64-bit wide module
+ *          devno     - device number (E_DEVICE)
+ *          mode      - mode set by eTIMER_CONFIG (timer_mode_t)
+ *          owner     - name of the user the module is allocated to; NULL
+ *                      while the module is free
+ *
+ * Notes:
+ */
+struct timer_attr
+{
+	uint32_t *BASE_ADDR;
+	volatile uint32_t *RCGC;
+	volatile uint32_t *PR;
+	uint32_t bit;
+	uint32_t wide;
+	dev_t devno;
+	uint32_t mode;
+	const char *owner;
+};
+
+
+#define TIMER_ATTR(base, rcgc, pr, n, w, dev) \
+	{ \
+		.BASE_ADDR = (base), \
+		.RCGC = &(rcgc), \
+		.PR = &(pr), \
+		.bit = (0x00000001 << (n)), \
+		.wide = (w), \
+		.devno = (dev), \
+		.mode = eTIMER_MODE_ONESHOT, \
+		.owner = NULL, \
+	}
+
+/* NOTE: must be in same order as eDEV_TIMER0 ... eDEV_WTIMER5 in device.h */
+static struct timer_attr timer_attr_tbl[TIMER_NUM] =
+{
+		TIMER_ATTR(TIMER0_BASE_ADDR, SYSCTL_RCGCTIMER_R, SYSCTL_PRTIMER_R, 0, 0, eDEV_TIMER0),
+		TIMER_ATTR(TIMER1_BASE_ADDR, SYSCTL_RCGCTIMER_R, SYSCTL_PRTIMER_R, 1, 0, eDEV_TIMER1),
+		TIMER_ATTR(TIMER2_BASE_ADDR, SYSCTL_RCGCTIMER_R, SYSCTL_PRTIMER_R, 2, 0, eDEV_TIMER2),
+		TIMER_ATTR(TIMER3_BASE_ADDR, SYSCTL_RCGCTIMER_R, SYSCTL_PRTIMER_R, 3, 0, eDEV_TIMER3),
+		TIMER_ATTR(TIMER4_BASE_ADDR, SYSCTL_RCGCTIMER_R, SYSCTL_PRTIMER_R, 4, 0, eDEV_TIMER4),
+		TIMER_ATTR(TIMER5_BASE_ADDR, SYSCTL_RCGCTIMER_R, SYSCTL_PRTIMER_R, 5, 0, eDEV_TIMER5),
+		TIMER_ATTR(WTIMER0_BASE_ADDR, SYSCTL_RCGCWTIMER_R, SYSCTL_PRWTIMER_R, 0, 1, eDEV_WTIMER0),
+		TIMER_ATTR(WTIMER1_BASE_ADDR, SYSCTL_RCGCWTIMER_R, SYSCTL_PRWTIMER_R, 1, 1, eDEV_WTIMER1),
+		TIMER_ATTR(WTIMER2_BASE_ADDR, SYSCTL_RCGCWTIMER_R, SYSCTL_PRWTIMER_R, 2, 1, eDEV_WTIMER2),
+		TIMER_ATTR(WTIMER3_BASE_ADDR, SYSCTL_RCGCWTIMER_R, SYSCTL_PRWTIMER_R, 3, 1, eDEV_WTIMER3),
+		TIMER_ATTR(WTIMER4_BASE_ADDR, SYSCTL_RCGCWTIMER_R, SYSCTL_PRWTIMER_R, 4, 1, eDEV_WTIMER4),
+		TIMER_ATTR(WTIMER5_BASE_ADDR, SYSCTL_RCGCWTIMER_R, SYSCTL_PRWTIMER_R, 5, 1, eDEV_WTIMER5),
 };
 
 
+struct device timer0_dev = { .name = "timer0", .self_attr = &timer_attr_tbl[0], .dev_ops = &timer_devops };
+struct device timer1_dev = { .name = "timer1", .self_attr = &timer_attr_tbl[1], .dev_ops = &timer_devops };
+struct device timer2_dev = { .name = "timer2", .self_attr = &timer_attr_tbl[2], .dev_ops = &timer_devops };
+struct device timer3_dev = { .name = "timer3", .self_attr = &timer_attr_tbl[3], .dev_ops = &timer_devops };
+struct device timer4_dev = { .name = "timer4", .self_attr = &timer_attr_tbl[4], .dev_ops = &timer_devops };
+struct device timer5_dev = { .name = "timer5", .self_attr = &timer_attr_tbl[5], .dev_ops = &timer_devops };
+struct device wtimer0_dev = { .name = "wtimer0", .self_attr = &timer_attr_tbl[6], .dev_ops = &timer_devops };
+struct device wtimer1_dev = { .name = "wtimer1", .self_attr = &timer_attr_tbl[7], .dev_ops = &timer_devops };
+struct device wtimer2_dev = { .name = "wtimer2", .self_attr = &timer_attr_tbl[8], .dev_ops = &timer_devops };
+struct device wtimer3_dev = { .name = "wtimer3", .self_attr = &timer_attr_tbl[9], .dev_ops = &timer_devops };
+struct device wtimer4_dev = { .name = "wtimer4", .self_attr = &timer_attr_tbl[10], .dev_ops = &timer_devops };
+struct device wtimer5_dev = { .name = "wtimer5", .self_attr = &timer_attr_tbl[11], .dev_ops = &timer_devops };
+
+
+/*
+ * Name: timer_config
+ *
+ * Descr: Configures a (disabled) timer module for a mode of operation
+ *
+ * Args:     attr   - timer attributes
+ *           mode   - timer_mode_t
+ *           period - time-out period (system clock cycles) in periodic and
+ *                    one-shot modes; ignored otherwise
+ *
+ * Return:   0 on success, -1 on an unknown mode
+ *
+ * Notes: the counter is reset. Capture mode splits the module and uses
+ *        timer A with its prescaler as a 24-bit (16/32) or 48-bit (wide)
+ *        edge-time counter; the CCP pin is configured by the caller.
+ *
+ */
+static int timer_config( struct timer_attr *attr, uint32_t mode, uint32_t period)
+{
+	GPTM_REG(attr, GPTMCTL_REG_OFST) &= ~(GPTM_CTL_TAEN);
+	GPTM_REG(attr, GPTMIMR_REG_OFST) = 0x00000000;
+
+	switch(mode)
+	{
+	case eTIMER_MODE_PERIODIC:
+	case eTIMER_MODE_ONESHOT:
+	case eTIMER_MODE_FREERUN:
+		GPTM_REG(attr, GPTMCFG_REG_OFST) = GPTM_CFG_CONCAT;
+		GPTM_REG(attr, GPTMTAMR_REG_OFST) = GPTM_TAMR_CDIR |
+				(( mode == eTIMER_MODE_ONESHOT) ? GPTM_TAMR_ONESHOT : GPTM_TAMR_PERIODIC);
+		GPTM_REG(attr, GPTMCTL_REG_OFST) &= ~(GPTM_CTL_TAEVENT_BOTH);
+		if ( mode == eTIMER_MODE_FREERUN)
+		{
+			GPTM_REG(attr, GPTMTAILR_REG_OFST) = 0xFFFFFFFF;
+			/* upper half of the 64-bit load */
+			if ( attr->wide)
+				GPTM_REG(attr, GPTMTBILR_REG_OFST) = 0xFFFFFFFF;
+		}
+		else
+		{
+			GPTM_REG(attr, GPTMTAILR_REG_OFST) = period;
+			if ( attr->wide)
+				GPTM_REG(attr, GPTMTBILR_REG_OFST) = 0x00000000;
+		}
+		break;
+
+	case eTIMER_MODE_CAPTURE:
+		GPTM_REG(attr, GPTMCFG_REG_OFST) = GPTM_CFG_SPLIT;
+		GPTM_REG(attr, GPTMTAMR_REG_OFST) = GPTM_TAMR_CDIR | GPTM_TAMR_CMR | GPTM_TAMR_CAPTURE;
+		GPTM_REG(attr, GPTMCTL_REG_OFST) |= GPTM_CTL_TAEVENT_BOTH;
+		GPTM_REG(attr, GPTMTAILR_REG_OFST) = attr->wide ? 0xFFFFFFFF : 0x0000FFFF;
+		GPTM_REG(attr, GPTMTAPR_REG_OFST) = attr->wide ? 0x0000FFFF : 0x000000FF;
+		break;
+
+	default:
+		return -1;
+	}
+
+	attr->mode = mode;
+
+	/* clear stale events; reset counter */
+	GPTM_REG(attr, GPTMICR_REG_OFST) = (GPTM_RIS_TATO | GPTM_RIS_CAE);
+	GPTM_REG(attr, GPTMTAV_REG_OFST) = 0x00000000;
+	if ( attr->wide && mode != eTIMER_MODE_CAPTURE)
+		GPTM_REG(attr, GPTMTBV_REG_OFST) = 0x00000000;
+
+	return 0;
+}
+
+
+/*
+ * Name: timer_read64
+ *
+ * Descr: Reads the counter of a concatenated timer as a 64-bit value
+ *
+ * Args:     attr - timer attributes
+ *
+ * Return:   counter value
+ *
+ * Notes: the upper half of a wide timer is read before and after the
+ *        lower half and the read repeated if it changed, so that a
+ *        carry between the two reads cannot tear the value; safe from
+ *        any context. 16/32-bit timers return the 32-bit counter.
+ *
+ */
+static uint64_t timer_read64( const struct timer_attr *attr)
+{
+	uint32_t hi, lo;
+
+	if ( !attr->wide)
+		return GPTM_REG(attr, GPTMTAV_REG_OFST);
+
+	do
+	{
+		hi = GPTM_REG(attr, GPTMTBV_REG_OFST);
+		lo = GPTM_REG(attr, GPTMTAV_REG_OFST);
+	} while ( hi != GPTM_REG(attr, GPTMTBV_REG_OFST));
+
+	return ((uint64_t)hi << 32) | lo;
+}
+
+
+/*
+ * Name: timer_dev_alloc
+ *
+ * Descr: Allocates a free timer module
+ *
+ * Args:     flags - TIMER_ALLOC_WIDE to request a 32/64-bit wide module;
+ *                   otherwise a 16/32-bit module is preferred and a wide
+ *                   module is used only when none is free
+ *           owner - name of the user (kept for debugging)
+ *
+ * Return:   device number of the allocated timer, -1 if none is free
+ *
+ * Notes: the module is clocked and configured one-shot, disabled; call
+ *        from initialization code only (not reentrant)
+ *
+ */
+int timer_dev_alloc( uint32_t flags, const char *owner)
+{
+	uint32_t i, pass;
+
+	for ( pass = ( flags & TIMER_ALLOC_WIDE) ? 1 : 0; pass < 2; pass++)
+	{
+		for ( i = 0; i < TIMER_NUM; i++)
+		{
+			if ( timer_attr_tbl[i].owner != NULL || timer_attr_tbl[i].wide != pass)
+				continue;
+
+			timer_attr_tbl[i].owner = ( owner != NULL) ? owner : "?";
+			timer_dev_init( &timer_attr_tbl[i]);
+
+			return (int)timer_attr_tbl[i].devno;
+		}
+	}
+
+	return -1;
+}
+
+
+/*
+ * Name: timer_dev_free
+ *
+ * Descr: Stops a timer module and returns it to the free pool
+ *
+ * Args:     devno - device number returned by timer_dev_alloc
+ *
+ * Return:   none
+ *
+ * Notes:
+ *
+ */
+void timer_dev_free( dev_t devno)
+{
+	uint32_t i;
+
+	for ( i = 0; i < TIMER_NUM; i++)
+	{
+		if ( timer_attr_tbl[i].devno == devno)
+		{
+			timer_dev_deinit( &timer_attr_tbl[i]);
+			timer_attr_tbl[i].owner = NULL;
+		}
+	}
+}
+
+
 
 void timer_dev_init(void *self_attr)
 {
+	struct timer_attr *attr = (struct timer_attr *) self_attr;
+
 	/* General Purpose Timer Module Configuration */
-	// enable GPTM0
-	SYSCTL_RCGCTIMER_R |= 0x00000001;
+	// enable GPTM module
+	*attr->RCGC |= attr->bit;
 	// wait until peripheral is ready
-	while ((SYSCTL_PRTIMER_R & 0x00000001) == 0) {};
-
-	// disable GPTM_0 A
-	TIMER0_CTL_R &= ~(0x00000001);
-	// select 32-bit timer configuration
-	TIMER0_CFG_R = 0x00000000;
-	// select one-shot mode
-	TIMER0_TAMR_R |= 0x00000001;
-	// set count-up mode
-	TIMER0_TAMR_R |= (0x00000001 << 4);
-	// set timeout event upper bound (maximum)
-	TIMER0_TAILR_R = 0xFFFFFFFF;
+	while ((*attr->PR & attr->bit) == 0) {};
+
+	// one-shot, count-up, maximum period; disabled
+	(void) timer_config( attr, eTIMER_MODE_ONESHOT, 0xFFFFFFFF);
 }
 
 
@@ -71,26 +351,51 @@ int  timer_dev_read(void *self_attr, char *buf, size_t count)
 
 int  timer_dev_ioctl(void *self_attr, int request, va_list args)
 {
+	struct timer_attr *attr = (struct timer_attr *) self_attr;
+	uint32_t mode, mask;
 	int rv = 0;
 
 	switch(request)
 	{
 	case eTIMER_DISABLE: //stop timer
-		TIMER0_CTL_R &= ~(0x00000001);
+		GPTM_REG(attr, GPTMCTL_REG_OFST) &= ~(GPTM_CTL_TAEN);
 		break;
 
 	case eTIMER_ENABLE: // start timer
-		TIMER0_CTL_R |= 0x00000001;
+		GPTM_REG(attr, GPTMCTL_REG_OFST) |= GPTM_CTL_TAEN;
 		break;
 
 	case eTIMER_RESET:
-		TIMER0_TAV_R = 0x00000000;
+		GPTM_REG(attr, GPTMTAV_REG_OFST) = 0x00000000;
+		if ( attr->wide && attr->mode != eTIMER_MODE_CAPTURE)
+			GPTM_REG(attr, GPTMTBV_REG_OFST) = 0x00000000;
 		break;
 
 	case eTIMER_READ:
-		rv = TIMER0_TAV_R;
+		/* counter (lower 32 bits); captured count in capture mode */
+		rv = ( attr->mode == eTIMER_MODE_CAPTURE) ?
+				GPTM_REG(attr, GPTMTAR_REG_OFST) : GPTM_REG(attr, GPTMTAV_REG_OFST);
+		break;
+
+	case eTIMER_CONFIG:
+		mode = va_arg(args, uint32_t);
+		rv = timer_config( attr, mode, va_arg(args, uint32_t));
+		break;
+
+	case eTIMER_EVENT:
+		/* poll and acknowledge time-out (capture event in capture mode) */
+		mask = ( attr->mode == eTIMER_MODE_CAPTURE) ? GPTM_RIS_CAE : GPTM_RIS_TATO;
+		rv = ( GPTM_REG(attr, GPTMRIS_REG_OFST) & mask) ? 1 : 0;
+		if ( rv)
+			GPTM_REG(attr, GPTMICR_REG_OFST) = mask;
+		break;
+
+	case eTIMER_READ64:
+		*va_arg(args, uint64_t *) = timer_read64( attr);
 		break;
+
 	default:
+		rv = -1;
 		break;
 	}
 
@@ -100,7 +405,8 @@ int  timer_dev_ioctl(void *self_attr, int request, va_list args)
 
 void timer_dev_deinit(void *self_attr)
 {
-	// not implemented
-}
-
+	struct timer_attr *attr = (struct timer_attr *) self_attr;
 
+	// stop timer; module clock is left enabled
+	GPTM_REG(attr, GPTMCTL_REG_OFST) &= ~(GPTM_CTL_TAEN);
+}
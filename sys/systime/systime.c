@@ -0,0 +1,99 @@
+/*
+ * systime.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Milos Lazic
+ */
+
+#include "systime.h"
+#include "../device/device.h"
+
+
+// timebase timer (device number); -1 until SYSTIME_Init
+static DEV_STATE_CLASS int systime_timer = -1;
+
+
+/*
+ * Name: SYSTIME_Init
+ *
+ * Descr: Allocates a wide timer and starts it as the free-running 64-bit
+ *        system timebase
+ *
+ * Args:     none
+ *
+ * Return:   0 on success, -1 if no wide timer is free
+ *
+ * Notes: call once during initialization, after the PLL is configured;
+ *        SYSTIME_Now returns 0 until then
+ *
+ */
+int SYSTIME_Init(void)
+{
+	int tmr = timer_dev_alloc(TIMER_ALLOC_WIDE, "systime");
+
+	if ( tmr < 0)
+		return -1;
+
+	dev_ioctl(tmr, eTIMER_CONFIG, eTIMER_MODE_FREERUN, 0);
+	dev_ioctl(tmr, eTIMER_ENABLE);
+	systime_timer = tmr;
+
+	return 0;
+}
+
+
+/*
+ * Name: SYSTIME_Now
+ *
+ * Descr: Reads the current timestamp
+ *
+ * Args:     none
+ *
+ * Return:   system clock cycles since SYSTIME_Init
+ *
+ * Notes: monotonic; safe from any context (the 64-bit counter is read
+ *        high/low/high, see eTIMER_READ64)
+ *
+ */
+uint64_t SYSTIME_Now(void)
+{
+	uint64_t t = 0;
+
+	if ( systime_timer >= 0)
+		(void) dev_ioctl(systime_timer, eTIMER_READ64, &t);
+
+	return t;
+}
+
+
+/*
+ * Name: SYSTIME_ToUs
+ *
+ * Descr: Converts a timestamp to microseconds
+ *
+ * Args:     cyc - timestamp or span (cycles)
+ *
+ * Return:   microseconds (truncated)
+ *
+ * Notes: long division by SYSTIME_CYC_PER_US in 16-bit digits, so that
+ *        every step is a 32-bit hardware divide (no 64-bit division
+ *        library call); each partial remainder is below the divisor, so
+ *        the partial dividends fit in 32 bits. Use SYSTIME_SPAN_TO_US
+ *        for spans below 2^32 cycles.
+ *
+ */
+uint64_t SYSTIME_ToUs(uint64_t cyc)
+{
+	uint64_t q = 0;
+	uint32_t r = 0, d;
+	int shift;
+
+	for ( shift = 48; shift >= 0; shift -= 16)
+	{
+		d = (r << 16) | (uint32_t)((cyc >> shift) & 0xFFFF);
+		q = (q << 16) | (d / SYSTIME_CYC_PER_US);
+		r = d % SYSTIME_CYC_PER_US;
+	}
+
+	return q;
+}
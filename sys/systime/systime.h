@@ -0,0 +1,40 @@
+/*
+ * systime.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Milos Lazic
+ *
+ *  Monotonic 64-bit system timebase: a wide GPTM counting system clock
+ *  cycles from SYSTIME_Init (wraps after ~7300 years at 80 MHz).
+ */
+
+#ifndef SYS_SYSTIME_SYSTIME_H_
+#define SYS_SYSTIME_SYSTIME_H_
+
+#include <stdint.h>
+
+
+#define SYSTIME_CLOCK_HZ   80000000  /* timebase clock (system clock), Hz */
+#define SYSTIME_CYC_PER_US 80        /* SYSTIME_CLOCK_HZ/1000000 */
+
+/* timestamp (cycles) to nanoseconds; exact at 80 MHz (12.5 ns per cycle),
+ * valid for timestamps below ~290 years */
+#define SYSTIME_CYC_TO_NS(cyc) \
+	(((uint64_t)(cyc)*25) >> 1)
+
+/* span below 2^32 cycles (~53 s) to microseconds; single 32-bit divide */
+#define SYSTIME_SPAN_TO_US(cyc) \
+	((uint32_t)(cyc)/SYSTIME_CYC_PER_US)
+
+/* seconds to cycles (compile-time constants) */
+#define SYSTIME_SEC(s) \
+	((uint64_t)((s)*(double)SYSTIME_CLOCK_HZ))
+
+
+/* function prototypes */
+extern int      SYSTIME_Init(void);
+extern uint64_t SYSTIME_Now(void);
+extern uint64_t SYSTIME_ToUs(uint64_t cyc);
+
+
+#endif /* SYS_SYSTIME_SYSTIME_H_ */
@@ -0,0 +1,16 @@
+/*
+ * traj.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Milos Lazic
+ */
+
+#ifndef TRAJ_TRAJ_H_
+#define TRAJ_TRAJ_H_
+
+#include "traj_defs.h"
+#include "traj_proto.h"
+
+
+
+#endif /* TRAJ_TRAJ_H_ */
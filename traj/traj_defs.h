@@ -0,0 +1,96 @@
+/*
+ * traj_defs.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Milos Lazic
+ *
+ *  Jerk-limited set point trajectory generator (traj_gen.c): turns set
+ *  point targets into S-curve cart position, velocity and acceleration
+ *  references for the balance controller, advanced once per control
+ *  period.
+ *
+ *  The generator is a cascade of braking curves. The velocity reference
+ *  is the largest from which a jerk-limited stop still fits in the
+ *  distance left, capped at v_max; the acceleration follows the velocity
+ *  error by the curve of a jerk-limited approach, capped at a_max; the
+ *  jerk moves the acceleration towards it, capped at j_max. Both curves
+ *  are evaluated at the state reached once the current acceleration is
+ *  ramped to zero, so the moves end without overshoot. A new target is
+ *  taken at any time, mid-move included, with no replanning.
+ */
+
+#ifndef TRAJ_TRAJ_DEFS_H_
+#define TRAJ_TRAJ_DEFS_H_
+
+
+#include <stdlib.h>
+#include <stdint.h>
+
+
+#define TRAJ_TS        0.0001f   /* control period (s); SysTick at 10 kHz */
+
+/* default limits: smooth moves (peak angle and voltage of a 0.35 m move a
+ * third and a quarter of a set point step's, host/sim/traj_bench), not
+ * fast ones: within the command range a step settles sooner, and no
+ * limits beat it at equal peak voltage with the feed-forward as it is */
+#define TRAJ_V_MAX     0.2f      /* default velocity limit (m/s) */
+#define TRAJ_A_MAX     0.4f      /* default acceleration limit (m/s^2) */
+#define TRAJ_J_MAX     1.0f      /* default jerk limit (m/s^3) */
+#define TRAJ_LIM_MAX   1000.0f   /* largest limit accepted (any unit) */
+#define TRAJ_SNAP      1e-5f     /* end of move: distance left (m) ... */
+#define TRAJ_SNAP_V    1e-3f     /* ... and velocity (m/s) below which the
+                                    reference lands on the target */
+
+
+/* Name: TRAJ_lim_type
+ *
+ * Description: trajectory limits
+ *
+ * Members: v_max - velocity limit (m/s)
+ *          a_max - acceleration limit (m/s^2)
+ *          j_max - jerk limit (m/s^3)
+ *
+ * Notes:
+ *
+ */
+struct TRAJ_lim_type
+{
+	float v_max;
+	float a_max;
+	float j_max;
+};
+
+
+/* Name: TRAJ_type
+ *
+ * Description: trajectory generator state
+ *
+ * Members: lim    - limits
+ *          c_trap - a_max^2/(2*j_max), velocity gained while the
+ *                   acceleration ramps from a_max to zero (m/s)
+ *          d_tri  - a_max^3/j_max^2, longest stop that never reaches
+ *                   a_max (m)
+ *          target - position the reference moves to (m)
+ *          p      - position reference (m)
+ *          v      - velocity reference (m/s)
+ *          a      - acceleration reference (m/s^2)
+ *          j      - jerk of the latest period (m/s^3)
+ *
+ * Notes: c_trap and d_tri are derived from lim by TRAJ_SetLimits, so
+ *        that TRAJ_Run evaluates one cube root and two square roots.
+ *
+ */
+struct TRAJ_type
+{
+	struct TRAJ_lim_type lim;
+	float c_trap;
+	float d_tri;
+	volatile float target;
+	float p;
+	float v;
+	float a;
+	float j;
+};
+
+
+#endif /* TRAJ_TRAJ_DEFS_H_ */
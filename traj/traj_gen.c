@@ -0,0 +1,188 @@
+/*
+ * traj_gen.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Milos Lazic
+ *
+ *  Set point trajectory generator run in STATE_BALANCE (see
+ *  traj_defs.h). Targets come from the command channel (CMD_Drain), in
+ *  the same control period context as TRAJ_Run; the references go to the
+ *  balance controller through LQR_Balance_SetRef, which adds the model
+ *  based feed-forward of the acceleration, the position by way of the
+ *  learning controller (ilc/).
+ */
+
+#include <math.h>
+#include "traj.h"
+#include "../lqr/lqr.h"
+#include "../ilc/ilc.h"
+
+
+static struct TRAJ_type traj =
+{
+		.lim = { .v_max = TRAJ_V_MAX, .a_max = TRAJ_A_MAX, .j_max = TRAJ_J_MAX },
+		.c_trap = TRAJ_A_MAX*TRAJ_A_MAX/(2.0f*TRAJ_J_MAX),
+		.d_tri = TRAJ_A_MAX*TRAJ_A_MAX*TRAJ_A_MAX/(TRAJ_J_MAX*TRAJ_J_MAX),
+		.target = 0,
+		.p = 0,
+		.v = 0,
+		.a = 0,
+		.j = 0,
+};
+
+
+static float TRAJ_sgn( float x)
+{
+	return ( x > 0) ? 1.0f : ( x < 0) ? -1.0f : 0.0f;
+}
+
+
+/*
+ * Name: TRAJ_v_brake
+ *
+ * Descr: Braking curve; largest velocity from which a jerk-limited stop,
+ *        starting at zero acceleration, fits in a distance
+ *
+ * Args:     d - distance (m, >= 0)
+ *
+ * Return:   velocity (m/s)
+ *
+ * Notes: A stop from v that never reaches a_max takes v*sqrt(v/j_max);
+ *        a longer one v*(v/a_max + a_max/j_max)/2. The two meet at
+ *        d_tri, v = a_max^2/j_max.
+ *
+ */
+static float TRAJ_v_brake( float d)
+{
+	if ( d <= traj.d_tri)
+		return cbrtf( d*d*traj.lim.j_max);
+
+	return sqrtf( traj.c_trap*traj.c_trap + 2.0f*traj.lim.a_max*d) - traj.c_trap;
+}
+
+
+/*
+ * Name: TRAJ_SetLimits
+ *
+ * Descr: Replaces the trajectory limits
+ *
+ * Args:     lim - new limits
+ *
+ * Return:   0 on success, -1 if a limit is not in (0, TRAJ_LIM_MAX]
+ *           (limits unchanged)
+ *
+ * Notes: Control period context (CMD_Drain). A move in progress faster
+ *        than the new velocity limit slows down within the new
+ *        acceleration and jerk limits.
+ *
+ */
+int TRAJ_SetLimits( const struct TRAJ_lim_type *lim)
+{
+	/* rejects NaN as well */
+	if ( !( lim->v_max > 0 && lim->v_max <= TRAJ_LIM_MAX) ||
+	     !( lim->a_max > 0 && lim->a_max <= TRAJ_LIM_MAX) ||
+	     !( lim->j_max > 0 && lim->j_max <= TRAJ_LIM_MAX))
+		return -1;
+
+	traj.lim = *lim;
+	traj.c_trap = lim->a_max*lim->a_max/(2.0f*lim->j_max);
+	traj.d_tri = lim->a_max*traj.c_trap*2.0f/lim->j_max;
+
+	return 0;
+}
+
+
+/*
+ * Name: TRAJ_SetTarget
+ *
+ * Descr: Sets the position the reference moves to
+ *
+ * Args:     pos - target cart position (m, balance set point frame)
+ *
+ * Return:   none
+ *
+ * Notes: Control period context (CMD_Drain); the caller limits pos
+ *
+ */
+void TRAJ_SetTarget( float pos)
+{
+	traj.target = pos;
+}
+
+
+/*
+ * Name: TRAJ_GetTarget
+ *
+ * Descr: Reads the position the reference moves to
+ *
+ * Args:     none
+ *
+ * Return:   target cart position (m)
+ *
+ * Notes:
+ *
+ */
+float TRAJ_GetTarget( void)
+{
+	return traj.target;
+}
+
+
+/*
+ * Name: TRAJ_Run
+ *
+ * Descr: Advances the references by one control period and passes them
+ *        to the balance controller
+ *
+ * Args:     none
+ *
+ * Return:   none
+ *
+ * Notes: Called from STATE_BALANCE, before the controller; the references
+ *        hold while the pendulum is not balanced.
+ *
+ */
+void TRAJ_Run( void)
+{
+	float e = traj.target - traj.p;
+	float t, e_la, v_la, v_d, a_d, j, a0, v0;
+
+	if ( e < TRAJ_SNAP && e > -TRAJ_SNAP &&
+	     traj.v < TRAJ_SNAP_V && traj.v > -TRAJ_SNAP_V &&
+	     traj.a <= traj.lim.j_max*TRAJ_TS && traj.a >= -traj.lim.j_max*TRAJ_TS)
+	{
+		/* landed; the last steps stay within the jerk limit */
+		traj.p = traj.target;
+		traj.v = traj.a = traj.j = 0;
+	}
+	else
+	{
+		/* look ahead to where the acceleration is back to zero */
+		t = fabsf( traj.a)/traj.lim.j_max;
+		v_la = traj.v + 0.5f*traj.a*t;
+		e_la = e - t*( traj.v + 0.5f*traj.a*t -
+		               TRAJ_sgn( traj.a)*traj.lim.j_max*t*t*(1.0f/6.0f));
+
+		/* velocity from the braking curve, acceleration from the
+		 * approach curve of the velocity error, jerk to get there */
+		v_d = TRAJ_sgn( e_la)*fminf( traj.lim.v_max, TRAJ_v_brake( fabsf( e_la)));
+		a_d = TRAJ_sgn( v_d - v_la)*
+		      fminf( traj.lim.a_max, sqrtf( 2.0f*traj.lim.j_max*fabsf( v_d - traj.v)));
+		j = ( a_d - traj.a)*(1.0f/TRAJ_TS);
+		if ( j > traj.lim.j_max)
+			j = traj.lim.j_max;
+		else if ( j < -traj.lim.j_max)
+			j = -traj.lim.j_max;
+
+		/* exact integration over the period (constant jerk) */
+		a0 = traj.a;
+		v0 = traj.v;
+		traj.a += j*TRAJ_TS;
+		traj.v += 0.5f*( a0 + traj.a)*TRAJ_TS;
+		traj.p += ( v0 + ( 0.5f*a0 + j*TRAJ_TS*(1.0f/6.0f))*TRAJ_TS)*TRAJ_TS;
+		traj.j = j;
+	}
+
+	/* learned correction of repeated moves on the position */
+	LQR_Balance_SetRef( ILC_Run( traj.p), traj.v, traj.a, traj.j);
+}
@@ -0,0 +1,23 @@
+/*
+ * traj_proto.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Milos Lazic
+ */
+
+#ifndef TRAJ_TRAJ_PROTO_H_
+#define TRAJ_TRAJ_PROTO_H_
+
+
+#include <stdint.h>
+#include "traj_defs.h"
+
+
+/* global scope routines */
+extern int TRAJ_SetLimits( const struct TRAJ_lim_type *lim);
+extern void TRAJ_SetTarget( float pos);
+extern float TRAJ_GetTarget( void);
+extern void TRAJ_Run( void);
+
+
+#endif /* TRAJ_TRAJ_PROTO_H_ */